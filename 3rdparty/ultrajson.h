@@ -73,6 +73,11 @@ tree doesn't have cyclic references.
 #define JSON_MAX_OBJECT_DEPTH 1024
 #endif
 
+// Containers the iterative decoder keeps on the C stack before moving its stack to the heap
+#ifndef JSON_ITERATIVE_STACK_FRAMES
+#define JSON_ITERATIVE_STACK_FRAMES 32
+#endif
+
 /*
 Dictates and limits how much stack space for buffers UltraJSON will use before resorting to provided heap functions */
 #ifndef JSON_MAX_STACK_BUFFER_SIZE
@@ -157,6 +162,18 @@ enum JSTYPES
   JT_INVALID,    // Internal, do not return nor expect
 };
 
+/*
+Events reported by JSON_DecodeEvents */
+enum JSEVENTS
+{
+  JE_BEGIN_OBJECT,
+  JE_END_OBJECT,
+  JE_BEGIN_ARRAY,
+  JE_END_ARRAY,
+  JE_KEY,
+  JE_VALUE,
+};
+
 typedef void * JSOBJ;
 typedef void * JSITER;
 
@@ -299,12 +316,128 @@ typedef struct __JSONObjectDecoder
   JSPFN_MALLOC malloc;
   JSPFN_FREE free;
   JSPFN_REALLOC realloc;
+
+  /*
+  Set on error. Callbacks that return nothing, like arrayAddItem, may set errorStr when they fail, for
+  instance out of memory. Decoding then goes on but its result is released and NULL returned */
   char *errorStr;
   char *errorOffset;
+
+  /*
+  Kept for compatibility. Doubles are always decoded correctly rounded, see decode_double */
   int preciseFloat;
   void *prv;
+
+  /*
+  Optional. When set, strings are kept as UTF-8 and handed over as byte ranges through this callback
+  instead of being converted to wide characters and passed to newString. Escapes are resolved and the
+  range is validated UTF-8 but not null terminated. The range is only valid for the duration of the call */
+  JSOBJ (*newUTF8String)(void *prv, char *start, char *end);
+
+  /*
+  Only used together with newUTF8String. If true the buffer passed to JSON_DecodeObject is writable and
+  strings are unescaped in place. Every range handed to newUTF8String then lies within the buffer and is
+  followed by a null terminator written over the closing quote. The buffer contents are destroyed */
+  int inSitu;
+
+  /*
+  Optional. When set, numbers are not converted and newInt, newLong and newDouble are not called. Instead
+  the range of the number in the input is handed over together with the type it would have been decoded
+  as, JT_INT, JT_LONG or JT_DOUBLE. Out of range numbers are still reported as errors. Convert the range
+  later with JSON_DecodeRawInteger or JSON_DecodeRawDouble */
+  JSOBJ (*newRawNumber)(void *prv, char *start, char *end, int type);
+
+  /*
+  If true no stack buffer is reserved for unescaping strings. escBuffer is used instead, holding escBufferLen
+  wchar_t. It is grown with realloc when needed and left in place for the next call, initialize both to
+  NULL and 0 and free escBuffer with free once the decoder is no longer used */
+  int heapEscBuffer;
+  wchar_t *escBuffer;
+  size_t escBufferLen;
+
+  /*
+  Configuration for max nesting depth of arrays and objects, set to 0 to use default (see JSON_MAX_OBJECT_DEPTH) */
+  int objectDepthMax;
+
+  /*
+  If true documents are decoded by a single loop keeping open arrays and objects on a heap allocated
+  stack, instead of recursing once per nesting level. Use it for deep documents and small thread stacks,
+  the recursive decoder needs a C stack frame per level and only objectDepthMax keeps it from overflowing */
+  int iterative;
+
+  /*
+  If true documents are decoded in two stages. A SIMD scan first indexes the structural characters, opening
+  quotes and value starts of the whole input, then a loop like that of iterative walks the index and only
+  reads the bytes of the tokens. The index takes 4 bytes per token and at most 4 bytes per input byte, it is
+  allocated with malloc for each call unless heapEscBuffer is set. It is then kept in indexBuffer, holding
+  indexBufferLen entries, for the next call, initialize both to NULL and 0 and free indexBuffer like escBuffer.
+  Inputs of 4 GB or more are decoded as if this was false */
+  int structuralIndex;
+  JSUINT32 *indexBuffer;
+  size_t indexBufferLen;
+
+  /*
+  Only used by JSON_DecodeEvents. Called with one of JSEVENTS and the key, value or container it is about,
+  return non-zero to stop decoding */
+  int (*event)(void *prv, int type, JSOBJ obj);
+
+  /*
+  Optional. Called when an array is complete, after its last arrayAddItem and before it is added to its
+  parent, so that the elements can be collected while it is open and stored once it closes */
+  void (*endArray)(void *prv, JSOBJ obj);
+
+  /*
+  Optional. Called like endArray when an object is complete */
+  void (*endObject)(void *prv, JSOBJ obj);
+
+  /*
+  Optional. Called with every object key right after it is decoded, so it is the last object created. The
+  returned object is used as the key instead, which lets equal keys share one object */
+  JSOBJ (*objectKey)(void *prv, JSOBJ name);
 } JSONObjectDecoder;
 
 EXPORTFUNCTION JSOBJ JSON_DecodeObject(JSONObjectDecoder *dec, const char *buffer, size_t cbBuffer);
 
+/*
+Decodes the elements of an array without the enclosing brackets, one or more values separated by commas
+that must end exactly at the end of the buffer, and returns them as a new array. Used to decode slices of
+a large array separately. Always uses the recursive or iterative decoder */
+EXPORTFUNCTION JSOBJ JSON_DecodeElements(JSONObjectDecoder *dec, const char *buffer, size_t cbBuffer);
+
+/*
+Decodes like JSON_DecodeObject but reports the document to event in document order instead of building it.
+Containers, keys and values are still created by the callbacks, which may return placeholders, then passed
+to event: JE_BEGIN_OBJECT or JE_BEGIN_ARRAY when a container opens, JE_KEY for each key, JE_VALUE for each
+other value and JE_END_OBJECT or JE_END_ARRAY when a container closes. objectAddKey and arrayAddItem are
+never called and releaseObject only for the returned root if trailing data follows it. Arrays and objects
+are not nested on the C stack. Returns the root, or NULL on error or if event stopped decoding, in which
+case errorStr is "Decoding stopped by event handler" */
+EXPORTFUNCTION JSOBJ JSON_DecodeEvents(JSONObjectDecoder *dec, const char *buffer, size_t cbBuffer);
+
+/*
+Push decoding of a document that arrives in pieces. Create the stream with a decoder set up as for
+JSON_DecodeObject, feed it the pieces in order, which don't have to be kept alive after each call, and
+finish it to get the root object. newRawNumber must not be set and newUTF8String ranges are only valid for
+the duration of the call, like for JSON_DecodeObject. Arrays and objects are never nested on the C stack,
+the depth is only limited by objectDepthMax.
+
+JSON_StreamFeed returns 1 once the document is complete, 0 if more input is needed and -1 on error.
+JSON_StreamFinish must always be called, it returns NULL on error or incomplete input and frees the stream.
+errorStr is set on error, errorOffset is not meaningful */
+typedef struct __JSONStreamDecoder JSONStreamDecoder;
+
+EXPORTFUNCTION JSONStreamDecoder *JSON_StreamCreate(JSONObjectDecoder *dec);
+EXPORTFUNCTION int JSON_StreamFeed(JSONStreamDecoder *stream, const char *buffer, size_t cbBuffer);
+EXPORTFUNCTION JSOBJ JSON_StreamFinish(JSONStreamDecoder *stream);
+
+/*
+Returns one past the end of the value starting at start, or NULL if it doesn't end before end. Arrays and
+objects are skipped by matching brackets outside of strings, nothing is decoded or validated */
+EXPORTFUNCTION const char *JSON_SkipValue(const char *start, const char *end);
+
+/*
+Convert a number range previously handed to newRawNumber */
+EXPORTFUNCTION JSINT64 JSON_DecodeRawInteger(const char *start, const char *end);
+EXPORTFUNCTION double JSON_DecodeRawDouble(const char *start, const char *end);
+
 #endif
@@ -43,6 +43,7 @@ http://www.opensource.apple.com/source/tcl/tcl-14/tcl/license.terms
 #include <wchar.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <float.h>
 
 #ifndef TRUE
 #define TRUE 1
@@ -52,6 +53,100 @@ http://www.opensource.apple.com/source/tcl/tcl-14/tcl/license.terms
 #define NULL 0
 #endif
 
+/*
+SIMD support. SSE2 is part of the x86-64 baseline and is used whenever the compiler targets it,
+AVX2 is picked at runtime on x86-64 CPUs that support it. Define JSON_NO_SIMD to build the scalar code paths only */
+#if !defined(JSON_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define JSON_SSE2
+#include <emmintrin.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define JSON_AVX2
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define JSON_TARGET_AVX2
+#else
+#define JSON_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#endif
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define JSON_NOINLINE __declspec(noinline)
+#else
+#define JSON_NOINLINE __attribute__((noinline))
+#endif
+
+static INLINE_PREFIX int CountTrailingZeros(JSUINT32 mask)
+{
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return (int) index;
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+
+static INLINE_PREFIX int CountTrailingZeros64(JSUINT64 mask)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+  unsigned long index;
+  _BitScanForward64(&index, mask);
+  return (int) index;
+#elif defined(_MSC_VER)
+  JSUINT32 low = (JSUINT32) mask;
+  return low ? CountTrailingZeros(low) : 32 + CountTrailingZeros((JSUINT32) (mask >> 32));
+#else
+  return __builtin_ctzll(mask);
+#endif
+}
+
+#ifdef JSON_AVX2
+/*
+Result of the CPUID probe. Written once on first use, a racing write stores the same value */
+static volatile int g_hasAVX2 = -1;
+
+static int HasAVX2(void)
+{
+  int ret = g_hasAVX2;
+
+  if (ret != -1)
+  {
+    return ret;
+  }
+
+#ifdef _MSC_VER
+  {
+    int info[4];
+    ret = 0;
+    __cpuid(info, 0);
+
+    if (info[0] >= 7)
+    {
+      __cpuid(info, 1);
+
+      // AVX and OSXSAVE, then check that the OS preserves the YMM registers
+      if ((info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6)
+      {
+        __cpuidex(info, 7, 0);
+        ret = (info[1] & (1 << 5)) ? 1 : 0;
+      }
+    }
+  }
+#else
+  ret = __builtin_cpu_supports("avx2") ? 1 : 0;
+#endif
+
+  g_hasAVX2 = ret;
+  return ret;
+}
+#endif
+
 struct DecoderState
 {
   char *start;
@@ -61,6 +156,7 @@ struct DecoderState
   int escHeap;
   int lastType;
   JSUINT32 objDepth;
+  JSUINT32 objDepthMax;
   void *prv;
   JSONObjectDecoder *dec;
 };
@@ -75,805 +171,4555 @@ static JSOBJ SetError( struct DecoderState *ds, int offset, const char *message)
   return NULL;
 }
 
-double createDouble(double intNeg, double intValue, double frcValue, int frcDecimalCount)
+/*
+Decimal to double conversion, correctly rounded to nearest even.
+
+Numbers with up to 19 significant digits are handled by the Clinger fast path when the decimal
+mantissa and the power of ten are both exact doubles, and otherwise by the Eisel-Lemire algorithm.
+It multiplies the normalized mantissa with a 128 bit truncated power of five and reads the binary
+mantissa off the high bits of the product. Numbers with more significant digits are converted with
+their first 19 digits and with that mantissa plus one, if both agree the result is exact. Otherwise
+the conversion falls back to a big decimal which is shifted by powers of two until the binary
+mantissa can be read off its integer part.
+
+See "Number Parsing at a Gigabyte per Second", Daniel Lemire, 2021 */
+
+#define POW5_MIN_EXPONENT -342
+#define POW5_MAX_EXPONENT 308
+
+static const JSUINT64 g_pow5[POW5_MAX_EXPONENT - POW5_MIN_EXPONENT + 1][2] =
+{
+  {0xeef453d6923bd65aULL, 0x113faa2906a13b3fULL},
+  {0x9558b4661b6565f8ULL, 0x4ac7ca59a424c507ULL},
+  {0xbaaee17fa23ebf76ULL, 0x5d79bcf00d2df649ULL},
+  {0xe95a99df8ace6f53ULL, 0xf4d82c2c107973dcULL},
+  {0x91d8a02bb6c10594ULL, 0x79071b9b8a4be869ULL},
+  {0xb64ec836a47146f9ULL, 0x9748e2826cdee284ULL},
+  {0xe3e27a444d8d98b7ULL, 0xfd1b1b2308169b25ULL},
+  {0x8e6d8c6ab0787f72ULL, 0xfe30f0f5e50e20f7ULL},
+  {0xb208ef855c969f4fULL, 0xbdbd2d335e51a935ULL},
+  {0xde8b2b66b3bc4723ULL, 0xad2c788035e61382ULL},
+  {0x8b16fb203055ac76ULL, 0x4c3bcb5021afcc31ULL},
+  {0xaddcb9e83c6b1793ULL, 0xdf4abe242a1bbf3dULL},
+  {0xd953e8624b85dd78ULL, 0xd71d6dad34a2af0dULL},
+  {0x87d4713d6f33aa6bULL, 0x8672648c40e5ad68ULL},
+  {0xa9c98d8ccb009506ULL, 0x680efdaf511f18c2ULL},
+  {0xd43bf0effdc0ba48ULL, 0x0212bd1b2566def2ULL},
+  {0x84a57695fe98746dULL, 0x014bb630f7604b57ULL},
+  {0xa5ced43b7e3e9188ULL, 0x419ea3bd35385e2dULL},
+  {0xcf42894a5dce35eaULL, 0x52064cac828675b9ULL},
+  {0x818995ce7aa0e1b2ULL, 0x7343efebd1940993ULL},
+  {0xa1ebfb4219491a1fULL, 0x1014ebe6c5f90bf8ULL},
+  {0xca66fa129f9b60a6ULL, 0xd41a26e077774ef6ULL},
+  {0xfd00b897478238d0ULL, 0x8920b098955522b4ULL},
+  {0x9e20735e8cb16382ULL, 0x55b46e5f5d5535b0ULL},
+  {0xc5a890362fddbc62ULL, 0xeb2189f734aa831dULL},
+  {0xf712b443bbd52b7bULL, 0xa5e9ec7501d523e4ULL},
+  {0x9a6bb0aa55653b2dULL, 0x47b233c92125366eULL},
+  {0xc1069cd4eabe89f8ULL, 0x999ec0bb696e840aULL},
+  {0xf148440a256e2c76ULL, 0xc00670ea43ca250dULL},
+  {0x96cd2a865764dbcaULL, 0x380406926a5e5728ULL},
+  {0xbc807527ed3e12bcULL, 0xc605083704f5ecf2ULL},
+  {0xeba09271e88d976bULL, 0xf7864a44c633682eULL},
+  {0x93445b8731587ea3ULL, 0x7ab3ee6afbe0211dULL},
+  {0xb8157268fdae9e4cULL, 0x5960ea05bad82964ULL},
+  {0xe61acf033d1a45dfULL, 0x6fb92487298e33bdULL},
+  {0x8fd0c16206306babULL, 0xa5d3b6d479f8e056ULL},
+  {0xb3c4f1ba87bc8696ULL, 0x8f48a4899877186cULL},
+  {0xe0b62e2929aba83cULL, 0x331acdabfe94de87ULL},
+  {0x8c71dcd9ba0b4925ULL, 0x9ff0c08b7f1d0b14ULL},
+  {0xaf8e5410288e1b6fULL, 0x07ecf0ae5ee44dd9ULL},
+  {0xdb71e91432b1a24aULL, 0xc9e82cd9f69d6150ULL},
+  {0x892731ac9faf056eULL, 0xbe311c083a225cd2ULL},
+  {0xab70fe17c79ac6caULL, 0x6dbd630a48aaf406ULL},
+  {0xd64d3d9db981787dULL, 0x092cbbccdad5b108ULL},
+  {0x85f0468293f0eb4eULL, 0x25bbf56008c58ea5ULL},
+  {0xa76c582338ed2621ULL, 0xaf2af2b80af6f24eULL},
+  {0xd1476e2c07286faaULL, 0x1af5af660db4aee1ULL},
+  {0x82cca4db847945caULL, 0x50d98d9fc890ed4dULL},
+  {0xa37fce126597973cULL, 0xe50ff107bab528a0ULL},
+  {0xcc5fc196fefd7d0cULL, 0x1e53ed49a96272c8ULL},
+  {0xff77b1fcbebcdc4fULL, 0x25e8e89c13bb0f7aULL},
+  {0x9faacf3df73609b1ULL, 0x77b191618c54e9acULL},
+  {0xc795830d75038c1dULL, 0xd59df5b9ef6a2417ULL},
+  {0xf97ae3d0d2446f25ULL, 0x4b0573286b44ad1dULL},
+  {0x9becce62836ac577ULL, 0x4ee367f9430aec32ULL},
+  {0xc2e801fb244576d5ULL, 0x229c41f793cda73fULL},
+  {0xf3a20279ed56d48aULL, 0x6b43527578c1110fULL},
+  {0x9845418c345644d6ULL, 0x830a13896b78aaa9ULL},
+  {0xbe5691ef416bd60cULL, 0x23cc986bc656d553ULL},
+  {0xedec366b11c6cb8fULL, 0x2cbfbe86b7ec8aa8ULL},
+  {0x94b3a202eb1c3f39ULL, 0x7bf7d71432f3d6a9ULL},
+  {0xb9e08a83a5e34f07ULL, 0xdaf5ccd93fb0cc53ULL},
+  {0xe858ad248f5c22c9ULL, 0xd1b3400f8f9cff68ULL},
+  {0x91376c36d99995beULL, 0x23100809b9c21fa1ULL},
+  {0xb58547448ffffb2dULL, 0xabd40a0c2832a78aULL},
+  {0xe2e69915b3fff9f9ULL, 0x16c90c8f323f516cULL},
+  {0x8dd01fad907ffc3bULL, 0xae3da7d97f6792e3ULL},
+  {0xb1442798f49ffb4aULL, 0x99cd11cfdf41779cULL},
+  {0xdd95317f31c7fa1dULL, 0x40405643d711d583ULL},
+  {0x8a7d3eef7f1cfc52ULL, 0x482835ea666b2572ULL},
+  {0xad1c8eab5ee43b66ULL, 0xda3243650005eecfULL},
+  {0xd863b256369d4a40ULL, 0x90bed43e40076a82ULL},
+  {0x873e4f75e2224e68ULL, 0x5a7744a6e804a291ULL},
+  {0xa90de3535aaae202ULL, 0x711515d0a205cb36ULL},
+  {0xd3515c2831559a83ULL, 0x0d5a5b44ca873e03ULL},
+  {0x8412d9991ed58091ULL, 0xe858790afe9486c2ULL},
+  {0xa5178fff668ae0b6ULL, 0x626e974dbe39a872ULL},
+  {0xce5d73ff402d98e3ULL, 0xfb0a3d212dc8128fULL},
+  {0x80fa687f881c7f8eULL, 0x7ce66634bc9d0b99ULL},
+  {0xa139029f6a239f72ULL, 0x1c1fffc1ebc44e80ULL},
+  {0xc987434744ac874eULL, 0xa327ffb266b56220ULL},
+  {0xfbe9141915d7a922ULL, 0x4bf1ff9f0062baa8ULL},
+  {0x9d71ac8fada6c9b5ULL, 0x6f773fc3603db4a9ULL},
+  {0xc4ce17b399107c22ULL, 0xcb550fb4384d21d3ULL},
+  {0xf6019da07f549b2bULL, 0x7e2a53a146606a48ULL},
+  {0x99c102844f94e0fbULL, 0x2eda7444cbfc426dULL},
+  {0xc0314325637a1939ULL, 0xfa911155fefb5308ULL},
+  {0xf03d93eebc589f88ULL, 0x793555ab7eba27caULL},
+  {0x96267c7535b763b5ULL, 0x4bc1558b2f3458deULL},
+  {0xbbb01b9283253ca2ULL, 0x9eb1aaedfb016f16ULL},
+  {0xea9c227723ee8bcbULL, 0x465e15a979c1cadcULL},
+  {0x92a1958a7675175fULL, 0x0bfacd89ec191ec9ULL},
+  {0xb749faed14125d36ULL, 0xcef980ec671f667bULL},
+  {0xe51c79a85916f484ULL, 0x82b7e12780e7401aULL},
+  {0x8f31cc0937ae58d2ULL, 0xd1b2ecb8b0908810ULL},
+  {0xb2fe3f0b8599ef07ULL, 0x861fa7e6dcb4aa15ULL},
+  {0xdfbdcece67006ac9ULL, 0x67a791e093e1d49aULL},
+  {0x8bd6a141006042bdULL, 0xe0c8bb2c5c6d24e0ULL},
+  {0xaecc49914078536dULL, 0x58fae9f773886e18ULL},
+  {0xda7f5bf590966848ULL, 0xaf39a475506a899eULL},
+  {0x888f99797a5e012dULL, 0x6d8406c952429603ULL},
+  {0xaab37fd7d8f58178ULL, 0xc8e5087ba6d33b83ULL},
+  {0xd5605fcdcf32e1d6ULL, 0xfb1e4a9a90880a64ULL},
+  {0x855c3be0a17fcd26ULL, 0x5cf2eea09a55067fULL},
+  {0xa6b34ad8c9dfc06fULL, 0xf42faa48c0ea481eULL},
+  {0xd0601d8efc57b08bULL, 0xf13b94daf124da26ULL},
+  {0x823c12795db6ce57ULL, 0x76c53d08d6b70858ULL},
+  {0xa2cb1717b52481edULL, 0x54768c4b0c64ca6eULL},
+  {0xcb7ddcdda26da268ULL, 0xa9942f5dcf7dfd09ULL},
+  {0xfe5d54150b090b02ULL, 0xd3f93b35435d7c4cULL},
+  {0x9efa548d26e5a6e1ULL, 0xc47bc5014a1a6dafULL},
+  {0xc6b8e9b0709f109aULL, 0x359ab6419ca1091bULL},
+  {0xf867241c8cc6d4c0ULL, 0xc30163d203c94b62ULL},
+  {0x9b407691d7fc44f8ULL, 0x79e0de63425dcf1dULL},
+  {0xc21094364dfb5636ULL, 0x985915fc12f542e4ULL},
+  {0xf294b943e17a2bc4ULL, 0x3e6f5b7b17b2939dULL},
+  {0x979cf3ca6cec5b5aULL, 0xa705992ceecf9c42ULL},
+  {0xbd8430bd08277231ULL, 0x50c6ff782a838353ULL},
+  {0xece53cec4a314ebdULL, 0xa4f8bf5635246428ULL},
+  {0x940f4613ae5ed136ULL, 0x871b7795e136be99ULL},
+  {0xb913179899f68584ULL, 0x28e2557b59846e3fULL},
+  {0xe757dd7ec07426e5ULL, 0x331aeada2fe589cfULL},
+  {0x9096ea6f3848984fULL, 0x3ff0d2c85def7621ULL},
+  {0xb4bca50b065abe63ULL, 0x0fed077a756b53a9ULL},
+  {0xe1ebce4dc7f16dfbULL, 0xd3e8495912c62894ULL},
+  {0x8d3360f09cf6e4bdULL, 0x64712dd7abbbd95cULL},
+  {0xb080392cc4349decULL, 0xbd8d794d96aacfb3ULL},
+  {0xdca04777f541c567ULL, 0xecf0d7a0fc5583a0ULL},
+  {0x89e42caaf9491b60ULL, 0xf41686c49db57244ULL},
+  {0xac5d37d5b79b6239ULL, 0x311c2875c522ced5ULL},
+  {0xd77485cb25823ac7ULL, 0x7d633293366b828bULL},
+  {0x86a8d39ef77164bcULL, 0xae5dff9c02033197ULL},
+  {0xa8530886b54dbdebULL, 0xd9f57f830283fdfcULL},
+  {0xd267caa862a12d66ULL, 0xd072df63c324fd7bULL},
+  {0x8380dea93da4bc60ULL, 0x4247cb9e59f71e6dULL},
+  {0xa46116538d0deb78ULL, 0x52d9be85f074e608ULL},
+  {0xcd795be870516656ULL, 0x67902e276c921f8bULL},
+  {0x806bd9714632dff6ULL, 0x00ba1cd8a3db53b6ULL},
+  {0xa086cfcd97bf97f3ULL, 0x80e8a40eccd228a4ULL},
+  {0xc8a883c0fdaf7df0ULL, 0x6122cd128006b2cdULL},
+  {0xfad2a4b13d1b5d6cULL, 0x796b805720085f81ULL},
+  {0x9cc3a6eec6311a63ULL, 0xcbe3303674053bb0ULL},
+  {0xc3f490aa77bd60fcULL, 0xbedbfc4411068a9cULL},
+  {0xf4f1b4d515acb93bULL, 0xee92fb5515482d44ULL},
+  {0x991711052d8bf3c5ULL, 0x751bdd152d4d1c4aULL},
+  {0xbf5cd54678eef0b6ULL, 0xd262d45a78a0635dULL},
+  {0xef340a98172aace4ULL, 0x86fb897116c87c34ULL},
+  {0x9580869f0e7aac0eULL, 0xd45d35e6ae3d4da0ULL},
+  {0xbae0a846d2195712ULL, 0x8974836059cca109ULL},
+  {0xe998d258869facd7ULL, 0x2bd1a438703fc94bULL},
+  {0x91ff83775423cc06ULL, 0x7b6306a34627ddcfULL},
+  {0xb67f6455292cbf08ULL, 0x1a3bc84c17b1d542ULL},
+  {0xe41f3d6a7377eecaULL, 0x20caba5f1d9e4a93ULL},
+  {0x8e938662882af53eULL, 0x547eb47b7282ee9cULL},
+  {0xb23867fb2a35b28dULL, 0xe99e619a4f23aa43ULL},
+  {0xdec681f9f4c31f31ULL, 0x6405fa00e2ec94d4ULL},
+  {0x8b3c113c38f9f37eULL, 0xde83bc408dd3dd04ULL},
+  {0xae0b158b4738705eULL, 0x9624ab50b148d445ULL},
+  {0xd98ddaee19068c76ULL, 0x3badd624dd9b0957ULL},
+  {0x87f8a8d4cfa417c9ULL, 0xe54ca5d70a80e5d6ULL},
+  {0xa9f6d30a038d1dbcULL, 0x5e9fcf4ccd211f4cULL},
+  {0xd47487cc8470652bULL, 0x7647c3200069671fULL},
+  {0x84c8d4dfd2c63f3bULL, 0x29ecd9f40041e073ULL},
+  {0xa5fb0a17c777cf09ULL, 0xf468107100525890ULL},
+  {0xcf79cc9db955c2ccULL, 0x7182148d4066eeb4ULL},
+  {0x81ac1fe293d599bfULL, 0xc6f14cd848405530ULL},
+  {0xa21727db38cb002fULL, 0xb8ada00e5a506a7cULL},
+  {0xca9cf1d206fdc03bULL, 0xa6d90811f0e4851cULL},
+  {0xfd442e4688bd304aULL, 0x908f4a166d1da663ULL},
+  {0x9e4a9cec15763e2eULL, 0x9a598e4e043287feULL},
+  {0xc5dd44271ad3cdbaULL, 0x40eff1e1853f29fdULL},
+  {0xf7549530e188c128ULL, 0xd12bee59e68ef47cULL},
+  {0x9a94dd3e8cf578b9ULL, 0x82bb74f8301958ceULL},
+  {0xc13a148e3032d6e7ULL, 0xe36a52363c1faf01ULL},
+  {0xf18899b1bc3f8ca1ULL, 0xdc44e6c3cb279ac1ULL},
+  {0x96f5600f15a7b7e5ULL, 0x29ab103a5ef8c0b9ULL},
+  {0xbcb2b812db11a5deULL, 0x7415d448f6b6f0e7ULL},
+  {0xebdf661791d60f56ULL, 0x111b495b3464ad21ULL},
+  {0x936b9fcebb25c995ULL, 0xcab10dd900beec34ULL},
+  {0xb84687c269ef3bfbULL, 0x3d5d514f40eea742ULL},
+  {0xe65829b3046b0afaULL, 0x0cb4a5a3112a5112ULL},
+  {0x8ff71a0fe2c2e6dcULL, 0x47f0e785eaba72abULL},
+  {0xb3f4e093db73a093ULL, 0x59ed216765690f56ULL},
+  {0xe0f218b8d25088b8ULL, 0x306869c13ec3532cULL},
+  {0x8c974f7383725573ULL, 0x1e414218c73a13fbULL},
+  {0xafbd2350644eeacfULL, 0xe5d1929ef90898faULL},
+  {0xdbac6c247d62a583ULL, 0xdf45f746b74abf39ULL},
+  {0x894bc396ce5da772ULL, 0x6b8bba8c328eb783ULL},
+  {0xab9eb47c81f5114fULL, 0x066ea92f3f326564ULL},
+  {0xd686619ba27255a2ULL, 0xc80a537b0efefebdULL},
+  {0x8613fd0145877585ULL, 0xbd06742ce95f5f36ULL},
+  {0xa798fc4196e952e7ULL, 0x2c48113823b73704ULL},
+  {0xd17f3b51fca3a7a0ULL, 0xf75a15862ca504c5ULL},
+  {0x82ef85133de648c4ULL, 0x9a984d73dbe722fbULL},
+  {0xa3ab66580d5fdaf5ULL, 0xc13e60d0d2e0ebbaULL},
+  {0xcc963fee10b7d1b3ULL, 0x318df905079926a8ULL},
+  {0xffbbcfe994e5c61fULL, 0xfdf17746497f7052ULL},
+  {0x9fd561f1fd0f9bd3ULL, 0xfeb6ea8bedefa633ULL},
+  {0xc7caba6e7c5382c8ULL, 0xfe64a52ee96b8fc0ULL},
+  {0xf9bd690a1b68637bULL, 0x3dfdce7aa3c673b0ULL},
+  {0x9c1661a651213e2dULL, 0x06bea10ca65c084eULL},
+  {0xc31bfa0fe5698db8ULL, 0x486e494fcff30a62ULL},
+  {0xf3e2f893dec3f126ULL, 0x5a89dba3c3efccfaULL},
+  {0x986ddb5c6b3a76b7ULL, 0xf89629465a75e01cULL},
+  {0xbe89523386091465ULL, 0xf6bbb397f1135823ULL},
+  {0xee2ba6c0678b597fULL, 0x746aa07ded582e2cULL},
+  {0x94db483840b717efULL, 0xa8c2a44eb4571cdcULL},
+  {0xba121a4650e4ddebULL, 0x92f34d62616ce413ULL},
+  {0xe896a0d7e51e1566ULL, 0x77b020baf9c81d17ULL},
+  {0x915e2486ef32cd60ULL, 0x0ace1474dc1d122eULL},
+  {0xb5b5ada8aaff80b8ULL, 0x0d819992132456baULL},
+  {0xe3231912d5bf60e6ULL, 0x10e1fff697ed6c69ULL},
+  {0x8df5efabc5979c8fULL, 0xca8d3ffa1ef463c1ULL},
+  {0xb1736b96b6fd83b3ULL, 0xbd308ff8a6b17cb2ULL},
+  {0xddd0467c64bce4a0ULL, 0xac7cb3f6d05ddbdeULL},
+  {0x8aa22c0dbef60ee4ULL, 0x6bcdf07a423aa96bULL},
+  {0xad4ab7112eb3929dULL, 0x86c16c98d2c953c6ULL},
+  {0xd89d64d57a607744ULL, 0xe871c7bf077ba8b7ULL},
+  {0x87625f056c7c4a8bULL, 0x11471cd764ad4972ULL},
+  {0xa93af6c6c79b5d2dULL, 0xd598e40d3dd89bcfULL},
+  {0xd389b47879823479ULL, 0x4aff1d108d4ec2c3ULL},
+  {0x843610cb4bf160cbULL, 0xcedf722a585139baULL},
+  {0xa54394fe1eedb8feULL, 0xc2974eb4ee658828ULL},
+  {0xce947a3da6a9273eULL, 0x733d226229feea32ULL},
+  {0x811ccc668829b887ULL, 0x0806357d5a3f525fULL},
+  {0xa163ff802a3426a8ULL, 0xca07c2dcb0cf26f7ULL},
+  {0xc9bcff6034c13052ULL, 0xfc89b393dd02f0b5ULL},
+  {0xfc2c3f3841f17c67ULL, 0xbbac2078d443ace2ULL},
+  {0x9d9ba7832936edc0ULL, 0xd54b944b84aa4c0dULL},
+  {0xc5029163f384a931ULL, 0x0a9e795e65d4df11ULL},
+  {0xf64335bcf065d37dULL, 0x4d4617b5ff4a16d5ULL},
+  {0x99ea0196163fa42eULL, 0x504bced1bf8e4e45ULL},
+  {0xc06481fb9bcf8d39ULL, 0xe45ec2862f71e1d6ULL},
+  {0xf07da27a82c37088ULL, 0x5d767327bb4e5a4cULL},
+  {0x964e858c91ba2655ULL, 0x3a6a07f8d510f86fULL},
+  {0xbbe226efb628afeaULL, 0x890489f70a55368bULL},
+  {0xeadab0aba3b2dbe5ULL, 0x2b45ac74ccea842eULL},
+  {0x92c8ae6b464fc96fULL, 0x3b0b8bc90012929dULL},
+  {0xb77ada0617e3bbcbULL, 0x09ce6ebb40173744ULL},
+  {0xe55990879ddcaabdULL, 0xcc420a6a101d0515ULL},
+  {0x8f57fa54c2a9eab6ULL, 0x9fa946824a12232dULL},
+  {0xb32df8e9f3546564ULL, 0x47939822dc96abf9ULL},
+  {0xdff9772470297ebdULL, 0x59787e2b93bc56f7ULL},
+  {0x8bfbea76c619ef36ULL, 0x57eb4edb3c55b65aULL},
+  {0xaefae51477a06b03ULL, 0xede622920b6b23f1ULL},
+  {0xdab99e59958885c4ULL, 0xe95fab368e45ecedULL},
+  {0x88b402f7fd75539bULL, 0x11dbcb0218ebb414ULL},
+  {0xaae103b5fcd2a881ULL, 0xd652bdc29f26a119ULL},
+  {0xd59944a37c0752a2ULL, 0x4be76d3346f0495fULL},
+  {0x857fcae62d8493a5ULL, 0x6f70a4400c562ddbULL},
+  {0xa6dfbd9fb8e5b88eULL, 0xcb4ccd500f6bb952ULL},
+  {0xd097ad07a71f26b2ULL, 0x7e2000a41346a7a7ULL},
+  {0x825ecc24c873782fULL, 0x8ed400668c0c28c8ULL},
+  {0xa2f67f2dfa90563bULL, 0x728900802f0f32faULL},
+  {0xcbb41ef979346bcaULL, 0x4f2b40a03ad2ffb9ULL},
+  {0xfea126b7d78186bcULL, 0xe2f610c84987bfa8ULL},
+  {0x9f24b832e6b0f436ULL, 0x0dd9ca7d2df4d7c9ULL},
+  {0xc6ede63fa05d3143ULL, 0x91503d1c79720dbbULL},
+  {0xf8a95fcf88747d94ULL, 0x75a44c6397ce912aULL},
+  {0x9b69dbe1b548ce7cULL, 0xc986afbe3ee11abaULL},
+  {0xc24452da229b021bULL, 0xfbe85badce996168ULL},
+  {0xf2d56790ab41c2a2ULL, 0xfae27299423fb9c3ULL},
+  {0x97c560ba6b0919a5ULL, 0xdccd879fc967d41aULL},
+  {0xbdb6b8e905cb600fULL, 0x5400e987bbc1c920ULL},
+  {0xed246723473e3813ULL, 0x290123e9aab23b68ULL},
+  {0x9436c0760c86e30bULL, 0xf9a0b6720aaf6521ULL},
+  {0xb94470938fa89bceULL, 0xf808e40e8d5b3e69ULL},
+  {0xe7958cb87392c2c2ULL, 0xb60b1d1230b20e04ULL},
+  {0x90bd77f3483bb9b9ULL, 0xb1c6f22b5e6f48c2ULL},
+  {0xb4ecd5f01a4aa828ULL, 0x1e38aeb6360b1af3ULL},
+  {0xe2280b6c20dd5232ULL, 0x25c6da63c38de1b0ULL},
+  {0x8d590723948a535fULL, 0x579c487e5a38ad0eULL},
+  {0xb0af48ec79ace837ULL, 0x2d835a9df0c6d851ULL},
+  {0xdcdb1b2798182244ULL, 0xf8e431456cf88e65ULL},
+  {0x8a08f0f8bf0f156bULL, 0x1b8e9ecb641b58ffULL},
+  {0xac8b2d36eed2dac5ULL, 0xe272467e3d222f3fULL},
+  {0xd7adf884aa879177ULL, 0x5b0ed81dcc6abb0fULL},
+  {0x86ccbb52ea94baeaULL, 0x98e947129fc2b4e9ULL},
+  {0xa87fea27a539e9a5ULL, 0x3f2398d747b36224ULL},
+  {0xd29fe4b18e88640eULL, 0x8eec7f0d19a03aadULL},
+  {0x83a3eeeef9153e89ULL, 0x1953cf68300424acULL},
+  {0xa48ceaaab75a8e2bULL, 0x5fa8c3423c052dd7ULL},
+  {0xcdb02555653131b6ULL, 0x3792f412cb06794dULL},
+  {0x808e17555f3ebf11ULL, 0xe2bbd88bbee40bd0ULL},
+  {0xa0b19d2ab70e6ed6ULL, 0x5b6aceaeae9d0ec4ULL},
+  {0xc8de047564d20a8bULL, 0xf245825a5a445275ULL},
+  {0xfb158592be068d2eULL, 0xeed6e2f0f0d56712ULL},
+  {0x9ced737bb6c4183dULL, 0x55464dd69685606bULL},
+  {0xc428d05aa4751e4cULL, 0xaa97e14c3c26b886ULL},
+  {0xf53304714d9265dfULL, 0xd53dd99f4b3066a8ULL},
+  {0x993fe2c6d07b7fabULL, 0xe546a8038efe4029ULL},
+  {0xbf8fdb78849a5f96ULL, 0xde98520472bdd033ULL},
+  {0xef73d256a5c0f77cULL, 0x963e66858f6d4440ULL},
+  {0x95a8637627989aadULL, 0xdde7001379a44aa8ULL},
+  {0xbb127c53b17ec159ULL, 0x5560c018580d5d52ULL},
+  {0xe9d71b689dde71afULL, 0xaab8f01e6e10b4a6ULL},
+  {0x9226712162ab070dULL, 0xcab3961304ca70e8ULL},
+  {0xb6b00d69bb55c8d1ULL, 0x3d607b97c5fd0d22ULL},
+  {0xe45c10c42a2b3b05ULL, 0x8cb89a7db77c506aULL},
+  {0x8eb98a7a9a5b04e3ULL, 0x77f3608e92adb242ULL},
+  {0xb267ed1940f1c61cULL, 0x55f038b237591ed3ULL},
+  {0xdf01e85f912e37a3ULL, 0x6b6c46dec52f6688ULL},
+  {0x8b61313bbabce2c6ULL, 0x2323ac4b3b3da015ULL},
+  {0xae397d8aa96c1b77ULL, 0xabec975e0a0d081aULL},
+  {0xd9c7dced53c72255ULL, 0x96e7bd358c904a21ULL},
+  {0x881cea14545c7575ULL, 0x7e50d64177da2e54ULL},
+  {0xaa242499697392d2ULL, 0xdde50bd1d5d0b9e9ULL},
+  {0xd4ad2dbfc3d07787ULL, 0x955e4ec64b44e864ULL},
+  {0x84ec3c97da624ab4ULL, 0xbd5af13bef0b113eULL},
+  {0xa6274bbdd0fadd61ULL, 0xecb1ad8aeacdd58eULL},
+  {0xcfb11ead453994baULL, 0x67de18eda5814af2ULL},
+  {0x81ceb32c4b43fcf4ULL, 0x80eacf948770ced7ULL},
+  {0xa2425ff75e14fc31ULL, 0xa1258379a94d028dULL},
+  {0xcad2f7f5359a3b3eULL, 0x096ee45813a04330ULL},
+  {0xfd87b5f28300ca0dULL, 0x8bca9d6e188853fcULL},
+  {0x9e74d1b791e07e48ULL, 0x775ea264cf55347eULL},
+  {0xc612062576589ddaULL, 0x95364afe032a819eULL},
+  {0xf79687aed3eec551ULL, 0x3a83ddbd83f52205ULL},
+  {0x9abe14cd44753b52ULL, 0xc4926a9672793543ULL},
+  {0xc16d9a0095928a27ULL, 0x75b7053c0f178294ULL},
+  {0xf1c90080baf72cb1ULL, 0x5324c68b12dd6339ULL},
+  {0x971da05074da7beeULL, 0xd3f6fc16ebca5e04ULL},
+  {0xbce5086492111aeaULL, 0x88f4bb1ca6bcf585ULL},
+  {0xec1e4a7db69561a5ULL, 0x2b31e9e3d06c32e6ULL},
+  {0x9392ee8e921d5d07ULL, 0x3aff322e62439fd0ULL},
+  {0xb877aa3236a4b449ULL, 0x09befeb9fad487c3ULL},
+  {0xe69594bec44de15bULL, 0x4c2ebe687989a9b4ULL},
+  {0x901d7cf73ab0acd9ULL, 0x0f9d37014bf60a11ULL},
+  {0xb424dc35095cd80fULL, 0x538484c19ef38c95ULL},
+  {0xe12e13424bb40e13ULL, 0x2865a5f206b06fbaULL},
+  {0x8cbccc096f5088cbULL, 0xf93f87b7442e45d4ULL},
+  {0xafebff0bcb24aafeULL, 0xf78f69a51539d749ULL},
+  {0xdbe6fecebdedd5beULL, 0xb573440e5a884d1cULL},
+  {0x89705f4136b4a597ULL, 0x31680a88f8953031ULL},
+  {0xabcc77118461cefcULL, 0xfdc20d2b36ba7c3eULL},
+  {0xd6bf94d5e57a42bcULL, 0x3d32907604691b4dULL},
+  {0x8637bd05af6c69b5ULL, 0xa63f9a49c2c1b110ULL},
+  {0xa7c5ac471b478423ULL, 0x0fcf80dc33721d54ULL},
+  {0xd1b71758e219652bULL, 0xd3c36113404ea4a9ULL},
+  {0x83126e978d4fdf3bULL, 0x645a1cac083126eaULL},
+  {0xa3d70a3d70a3d70aULL, 0x3d70a3d70a3d70a4ULL},
+  {0xccccccccccccccccULL, 0xcccccccccccccccdULL},
+  {0x8000000000000000ULL, 0x0000000000000000ULL},
+  {0xa000000000000000ULL, 0x0000000000000000ULL},
+  {0xc800000000000000ULL, 0x0000000000000000ULL},
+  {0xfa00000000000000ULL, 0x0000000000000000ULL},
+  {0x9c40000000000000ULL, 0x0000000000000000ULL},
+  {0xc350000000000000ULL, 0x0000000000000000ULL},
+  {0xf424000000000000ULL, 0x0000000000000000ULL},
+  {0x9896800000000000ULL, 0x0000000000000000ULL},
+  {0xbebc200000000000ULL, 0x0000000000000000ULL},
+  {0xee6b280000000000ULL, 0x0000000000000000ULL},
+  {0x9502f90000000000ULL, 0x0000000000000000ULL},
+  {0xba43b74000000000ULL, 0x0000000000000000ULL},
+  {0xe8d4a51000000000ULL, 0x0000000000000000ULL},
+  {0x9184e72a00000000ULL, 0x0000000000000000ULL},
+  {0xb5e620f480000000ULL, 0x0000000000000000ULL},
+  {0xe35fa931a0000000ULL, 0x0000000000000000ULL},
+  {0x8e1bc9bf04000000ULL, 0x0000000000000000ULL},
+  {0xb1a2bc2ec5000000ULL, 0x0000000000000000ULL},
+  {0xde0b6b3a76400000ULL, 0x0000000000000000ULL},
+  {0x8ac7230489e80000ULL, 0x0000000000000000ULL},
+  {0xad78ebc5ac620000ULL, 0x0000000000000000ULL},
+  {0xd8d726b7177a8000ULL, 0x0000000000000000ULL},
+  {0x878678326eac9000ULL, 0x0000000000000000ULL},
+  {0xa968163f0a57b400ULL, 0x0000000000000000ULL},
+  {0xd3c21bcecceda100ULL, 0x0000000000000000ULL},
+  {0x84595161401484a0ULL, 0x0000000000000000ULL},
+  {0xa56fa5b99019a5c8ULL, 0x0000000000000000ULL},
+  {0xcecb8f27f4200f3aULL, 0x0000000000000000ULL},
+  {0x813f3978f8940984ULL, 0x4000000000000000ULL},
+  {0xa18f07d736b90be5ULL, 0x5000000000000000ULL},
+  {0xc9f2c9cd04674edeULL, 0xa400000000000000ULL},
+  {0xfc6f7c4045812296ULL, 0x4d00000000000000ULL},
+  {0x9dc5ada82b70b59dULL, 0xf020000000000000ULL},
+  {0xc5371912364ce305ULL, 0x6c28000000000000ULL},
+  {0xf684df56c3e01bc6ULL, 0xc732000000000000ULL},
+  {0x9a130b963a6c115cULL, 0x3c7f400000000000ULL},
+  {0xc097ce7bc90715b3ULL, 0x4b9f100000000000ULL},
+  {0xf0bdc21abb48db20ULL, 0x1e86d40000000000ULL},
+  {0x96769950b50d88f4ULL, 0x1314448000000000ULL},
+  {0xbc143fa4e250eb31ULL, 0x17d955a000000000ULL},
+  {0xeb194f8e1ae525fdULL, 0x5dcfab0800000000ULL},
+  {0x92efd1b8d0cf37beULL, 0x5aa1cae500000000ULL},
+  {0xb7abc627050305adULL, 0xf14a3d9e40000000ULL},
+  {0xe596b7b0c643c719ULL, 0x6d9ccd05d0000000ULL},
+  {0x8f7e32ce7bea5c6fULL, 0xe4820023a2000000ULL},
+  {0xb35dbf821ae4f38bULL, 0xdda2802c8a800000ULL},
+  {0xe0352f62a19e306eULL, 0xd50b2037ad200000ULL},
+  {0x8c213d9da502de45ULL, 0x4526f422cc340000ULL},
+  {0xaf298d050e4395d6ULL, 0x9670b12b7f410000ULL},
+  {0xdaf3f04651d47b4cULL, 0x3c0cdd765f114000ULL},
+  {0x88d8762bf324cd0fULL, 0xa5880a69fb6ac800ULL},
+  {0xab0e93b6efee0053ULL, 0x8eea0d047a457a00ULL},
+  {0xd5d238a4abe98068ULL, 0x72a4904598d6d880ULL},
+  {0x85a36366eb71f041ULL, 0x47a6da2b7f864750ULL},
+  {0xa70c3c40a64e6c51ULL, 0x999090b65f67d924ULL},
+  {0xd0cf4b50cfe20765ULL, 0xfff4b4e3f741cf6dULL},
+  {0x82818f1281ed449fULL, 0xbff8f10e7a8921a4ULL},
+  {0xa321f2d7226895c7ULL, 0xaff72d52192b6a0dULL},
+  {0xcbea6f8ceb02bb39ULL, 0x9bf4f8a69f764490ULL},
+  {0xfee50b7025c36a08ULL, 0x02f236d04753d5b4ULL},
+  {0x9f4f2726179a2245ULL, 0x01d762422c946590ULL},
+  {0xc722f0ef9d80aad6ULL, 0x424d3ad2b7b97ef5ULL},
+  {0xf8ebad2b84e0d58bULL, 0xd2e0898765a7deb2ULL},
+  {0x9b934c3b330c8577ULL, 0x63cc55f49f88eb2fULL},
+  {0xc2781f49ffcfa6d5ULL, 0x3cbf6b71c76b25fbULL},
+  {0xf316271c7fc3908aULL, 0x8bef464e3945ef7aULL},
+  {0x97edd871cfda3a56ULL, 0x97758bf0e3cbb5acULL},
+  {0xbde94e8e43d0c8ecULL, 0x3d52eeed1cbea317ULL},
+  {0xed63a231d4c4fb27ULL, 0x4ca7aaa863ee4bddULL},
+  {0x945e455f24fb1cf8ULL, 0x8fe8caa93e74ef6aULL},
+  {0xb975d6b6ee39e436ULL, 0xb3e2fd538e122b44ULL},
+  {0xe7d34c64a9c85d44ULL, 0x60dbbca87196b616ULL},
+  {0x90e40fbeea1d3a4aULL, 0xbc8955e946fe31cdULL},
+  {0xb51d13aea4a488ddULL, 0x6babab6398bdbe41ULL},
+  {0xe264589a4dcdab14ULL, 0xc696963c7eed2dd1ULL},
+  {0x8d7eb76070a08aecULL, 0xfc1e1de5cf543ca2ULL},
+  {0xb0de65388cc8ada8ULL, 0x3b25a55f43294bcbULL},
+  {0xdd15fe86affad912ULL, 0x49ef0eb713f39ebeULL},
+  {0x8a2dbf142dfcc7abULL, 0x6e3569326c784337ULL},
+  {0xacb92ed9397bf996ULL, 0x49c2c37f07965404ULL},
+  {0xd7e77a8f87daf7fbULL, 0xdc33745ec97be906ULL},
+  {0x86f0ac99b4e8dafdULL, 0x69a028bb3ded71a3ULL},
+  {0xa8acd7c0222311bcULL, 0xc40832ea0d68ce0cULL},
+  {0xd2d80db02aabd62bULL, 0xf50a3fa490c30190ULL},
+  {0x83c7088e1aab65dbULL, 0x792667c6da79e0faULL},
+  {0xa4b8cab1a1563f52ULL, 0x577001b891185938ULL},
+  {0xcde6fd5e09abcf26ULL, 0xed4c0226b55e6f86ULL},
+  {0x80b05e5ac60b6178ULL, 0x544f8158315b05b4ULL},
+  {0xa0dc75f1778e39d6ULL, 0x696361ae3db1c721ULL},
+  {0xc913936dd571c84cULL, 0x03bc3a19cd1e38e9ULL},
+  {0xfb5878494ace3a5fULL, 0x04ab48a04065c723ULL},
+  {0x9d174b2dcec0e47bULL, 0x62eb0d64283f9c76ULL},
+  {0xc45d1df942711d9aULL, 0x3ba5d0bd324f8394ULL},
+  {0xf5746577930d6500ULL, 0xca8f44ec7ee36479ULL},
+  {0x9968bf6abbe85f20ULL, 0x7e998b13cf4e1ecbULL},
+  {0xbfc2ef456ae276e8ULL, 0x9e3fedd8c321a67eULL},
+  {0xefb3ab16c59b14a2ULL, 0xc5cfe94ef3ea101eULL},
+  {0x95d04aee3b80ece5ULL, 0xbba1f1d158724a12ULL},
+  {0xbb445da9ca61281fULL, 0x2a8a6e45ae8edc97ULL},
+  {0xea1575143cf97226ULL, 0xf52d09d71a3293bdULL},
+  {0x924d692ca61be758ULL, 0x593c2626705f9c56ULL},
+  {0xb6e0c377cfa2e12eULL, 0x6f8b2fb00c77836cULL},
+  {0xe498f455c38b997aULL, 0x0b6dfb9c0f956447ULL},
+  {0x8edf98b59a373fecULL, 0x4724bd4189bd5eacULL},
+  {0xb2977ee300c50fe7ULL, 0x58edec91ec2cb657ULL},
+  {0xdf3d5e9bc0f653e1ULL, 0x2f2967b66737e3edULL},
+  {0x8b865b215899f46cULL, 0xbd79e0d20082ee74ULL},
+  {0xae67f1e9aec07187ULL, 0xecd8590680a3aa11ULL},
+  {0xda01ee641a708de9ULL, 0xe80e6f4820cc9495ULL},
+  {0x884134fe908658b2ULL, 0x3109058d147fdcddULL},
+  {0xaa51823e34a7eedeULL, 0xbd4b46f0599fd415ULL},
+  {0xd4e5e2cdc1d1ea96ULL, 0x6c9e18ac7007c91aULL},
+  {0x850fadc09923329eULL, 0x03e2cf6bc604ddb0ULL},
+  {0xa6539930bf6bff45ULL, 0x84db8346b786151cULL},
+  {0xcfe87f7cef46ff16ULL, 0xe612641865679a63ULL},
+  {0x81f14fae158c5f6eULL, 0x4fcb7e8f3f60c07eULL},
+  {0xa26da3999aef7749ULL, 0xe3be5e330f38f09dULL},
+  {0xcb090c8001ab551cULL, 0x5cadf5bfd3072cc5ULL},
+  {0xfdcb4fa002162a63ULL, 0x73d9732fc7c8f7f6ULL},
+  {0x9e9f11c4014dda7eULL, 0x2867e7fddcdd9afaULL},
+  {0xc646d63501a1511dULL, 0xb281e1fd541501b8ULL},
+  {0xf7d88bc24209a565ULL, 0x1f225a7ca91a4226ULL},
+  {0x9ae757596946075fULL, 0x3375788de9b06958ULL},
+  {0xc1a12d2fc3978937ULL, 0x0052d6b1641c83aeULL},
+  {0xf209787bb47d6b84ULL, 0xc0678c5dbd23a49aULL},
+  {0x9745eb4d50ce6332ULL, 0xf840b7ba963646e0ULL},
+  {0xbd176620a501fbffULL, 0xb650e5a93bc3d898ULL},
+  {0xec5d3fa8ce427affULL, 0xa3e51f138ab4cebeULL},
+  {0x93ba47c980e98cdfULL, 0xc66f336c36b10137ULL},
+  {0xb8a8d9bbe123f017ULL, 0xb80b0047445d4184ULL},
+  {0xe6d3102ad96cec1dULL, 0xa60dc059157491e5ULL},
+  {0x9043ea1ac7e41392ULL, 0x87c89837ad68db2fULL},
+  {0xb454e4a179dd1877ULL, 0x29babe4598c311fbULL},
+  {0xe16a1dc9d8545e94ULL, 0xf4296dd6fef3d67aULL},
+  {0x8ce2529e2734bb1dULL, 0x1899e4a65f58660cULL},
+  {0xb01ae745b101e9e4ULL, 0x5ec05dcff72e7f8fULL},
+  {0xdc21a1171d42645dULL, 0x76707543f4fa1f73ULL},
+  {0x899504ae72497ebaULL, 0x6a06494a791c53a8ULL},
+  {0xabfa45da0edbde69ULL, 0x0487db9d17636892ULL},
+  {0xd6f8d7509292d603ULL, 0x45a9d2845d3c42b6ULL},
+  {0x865b86925b9bc5c2ULL, 0x0b8a2392ba45a9b2ULL},
+  {0xa7f26836f282b732ULL, 0x8e6cac7768d7141eULL},
+  {0xd1ef0244af2364ffULL, 0x3207d795430cd926ULL},
+  {0x8335616aed761f1fULL, 0x7f44e6bd49e807b8ULL},
+  {0xa402b9c5a8d3a6e7ULL, 0x5f16206c9c6209a6ULL},
+  {0xcd036837130890a1ULL, 0x36dba887c37a8c0fULL},
+  {0x802221226be55a64ULL, 0xc2494954da2c9789ULL},
+  {0xa02aa96b06deb0fdULL, 0xf2db9baa10b7bd6cULL},
+  {0xc83553c5c8965d3dULL, 0x6f92829494e5acc7ULL},
+  {0xfa42a8b73abbf48cULL, 0xcb772339ba1f17f9ULL},
+  {0x9c69a97284b578d7ULL, 0xff2a760414536efbULL},
+  {0xc38413cf25e2d70dULL, 0xfef5138519684abaULL},
+  {0xf46518c2ef5b8cd1ULL, 0x7eb258665fc25d69ULL},
+  {0x98bf2f79d5993802ULL, 0xef2f773ffbd97a61ULL},
+  {0xbeeefb584aff8603ULL, 0xaafb550ffacfd8faULL},
+  {0xeeaaba2e5dbf6784ULL, 0x95ba2a53f983cf38ULL},
+  {0x952ab45cfa97a0b2ULL, 0xdd945a747bf26183ULL},
+  {0xba756174393d88dfULL, 0x94f971119aeef9e4ULL},
+  {0xe912b9d1478ceb17ULL, 0x7a37cd5601aab85dULL},
+  {0x91abb422ccb812eeULL, 0xac62e055c10ab33aULL},
+  {0xb616a12b7fe617aaULL, 0x577b986b314d6009ULL},
+  {0xe39c49765fdf9d94ULL, 0xed5a7e85fda0b80bULL},
+  {0x8e41ade9fbebc27dULL, 0x14588f13be847307ULL},
+  {0xb1d219647ae6b31cULL, 0x596eb2d8ae258fc8ULL},
+  {0xde469fbd99a05fe3ULL, 0x6fca5f8ed9aef3bbULL},
+  {0x8aec23d680043beeULL, 0x25de7bb9480d5854ULL},
+  {0xada72ccc20054ae9ULL, 0xaf561aa79a10ae6aULL},
+  {0xd910f7ff28069da4ULL, 0x1b2ba1518094da04ULL},
+  {0x87aa9aff79042286ULL, 0x90fb44d2f05d0842ULL},
+  {0xa99541bf57452b28ULL, 0x353a1607ac744a53ULL},
+  {0xd3fa922f2d1675f2ULL, 0x42889b8997915ce8ULL},
+  {0x847c9b5d7c2e09b7ULL, 0x69956135febada11ULL},
+  {0xa59bc234db398c25ULL, 0x43fab9837e699095ULL},
+  {0xcf02b2c21207ef2eULL, 0x94f967e45e03f4bbULL},
+  {0x8161afb94b44f57dULL, 0x1d1be0eebac278f5ULL},
+  {0xa1ba1ba79e1632dcULL, 0x6462d92a69731732ULL},
+  {0xca28a291859bbf93ULL, 0x7d7b8f7503cfdcfeULL},
+  {0xfcb2cb35e702af78ULL, 0x5cda735244c3d43eULL},
+  {0x9defbf01b061adabULL, 0x3a0888136afa64a7ULL},
+  {0xc56baec21c7a1916ULL, 0x088aaa1845b8fdd0ULL},
+  {0xf6c69a72a3989f5bULL, 0x8aad549e57273d45ULL},
+  {0x9a3c2087a63f6399ULL, 0x36ac54e2f678864bULL},
+  {0xc0cb28a98fcf3c7fULL, 0x84576a1bb416a7ddULL},
+  {0xf0fdf2d3f3c30b9fULL, 0x656d44a2a11c51d5ULL},
+  {0x969eb7c47859e743ULL, 0x9f644ae5a4b1b325ULL},
+  {0xbc4665b596706114ULL, 0x873d5d9f0dde1feeULL},
+  {0xeb57ff22fc0c7959ULL, 0xa90cb506d155a7eaULL},
+  {0x9316ff75dd87cbd8ULL, 0x09a7f12442d588f2ULL},
+  {0xb7dcbf5354e9beceULL, 0x0c11ed6d538aeb2fULL},
+  {0xe5d3ef282a242e81ULL, 0x8f1668c8a86da5faULL},
+  {0x8fa475791a569d10ULL, 0xf96e017d694487bcULL},
+  {0xb38d92d760ec4455ULL, 0x37c981dcc395a9acULL},
+  {0xe070f78d3927556aULL, 0x85bbe253f47b1417ULL},
+  {0x8c469ab843b89562ULL, 0x93956d7478ccec8eULL},
+  {0xaf58416654a6babbULL, 0x387ac8d1970027b2ULL},
+  {0xdb2e51bfe9d0696aULL, 0x06997b05fcc0319eULL},
+  {0x88fcf317f22241e2ULL, 0x441fece3bdf81f03ULL},
+  {0xab3c2fddeeaad25aULL, 0xd527e81cad7626c3ULL},
+  {0xd60b3bd56a5586f1ULL, 0x8a71e223d8d3b074ULL},
+  {0x85c7056562757456ULL, 0xf6872d5667844e49ULL},
+  {0xa738c6bebb12d16cULL, 0xb428f8ac016561dbULL},
+  {0xd106f86e69d785c7ULL, 0xe13336d701beba52ULL},
+  {0x82a45b450226b39cULL, 0xecc0024661173473ULL},
+  {0xa34d721642b06084ULL, 0x27f002d7f95d0190ULL},
+  {0xcc20ce9bd35c78a5ULL, 0x31ec038df7b441f4ULL},
+  {0xff290242c83396ceULL, 0x7e67047175a15271ULL},
+  {0x9f79a169bd203e41ULL, 0x0f0062c6e984d386ULL},
+  {0xc75809c42c684dd1ULL, 0x52c07b78a3e60868ULL},
+  {0xf92e0c3537826145ULL, 0xa7709a56ccdf8a82ULL},
+  {0x9bbcc7a142b17ccbULL, 0x88a66076400bb691ULL},
+  {0xc2abf989935ddbfeULL, 0x6acff893d00ea435ULL},
+  {0xf356f7ebf83552feULL, 0x0583f6b8c4124d43ULL},
+  {0x98165af37b2153deULL, 0xc3727a337a8b704aULL},
+  {0xbe1bf1b059e9a8d6ULL, 0x744f18c0592e4c5cULL},
+  {0xeda2ee1c7064130cULL, 0x1162def06f79df73ULL},
+  {0x9485d4d1c63e8be7ULL, 0x8addcb5645ac2ba8ULL},
+  {0xb9a74a0637ce2ee1ULL, 0x6d953e2bd7173692ULL},
+  {0xe8111c87c5c1ba99ULL, 0xc8fa8db6ccdd0437ULL},
+  {0x910ab1d4db9914a0ULL, 0x1d9c9892400a22a2ULL},
+  {0xb54d5e4a127f59c8ULL, 0x2503beb6d00cab4bULL},
+  {0xe2a0b5dc971f303aULL, 0x2e44ae64840fd61dULL},
+  {0x8da471a9de737e24ULL, 0x5ceaecfed289e5d2ULL},
+  {0xb10d8e1456105dadULL, 0x7425a83e872c5f47ULL},
+  {0xdd50f1996b947518ULL, 0xd12f124e28f77719ULL},
+  {0x8a5296ffe33cc92fULL, 0x82bd6b70d99aaa6fULL},
+  {0xace73cbfdc0bfb7bULL, 0x636cc64d1001550bULL},
+  {0xd8210befd30efa5aULL, 0x3c47f7e05401aa4eULL},
+  {0x8714a775e3e95c78ULL, 0x65acfaec34810a71ULL},
+  {0xa8d9d1535ce3b396ULL, 0x7f1839a741a14d0dULL},
+  {0xd31045a8341ca07cULL, 0x1ede48111209a050ULL},
+  {0x83ea2b892091e44dULL, 0x934aed0aab460432ULL},
+  {0xa4e4b66b68b65d60ULL, 0xf81da84d5617853fULL},
+  {0xce1de40642e3f4b9ULL, 0x36251260ab9d668eULL},
+  {0x80d2ae83e9ce78f3ULL, 0xc1d72b7c6b426019ULL},
+  {0xa1075a24e4421730ULL, 0xb24cf65b8612f81fULL},
+  {0xc94930ae1d529cfcULL, 0xdee033f26797b627ULL},
+  {0xfb9b7cd9a4a7443cULL, 0x169840ef017da3b1ULL},
+  {0x9d412e0806e88aa5ULL, 0x8e1f289560ee864eULL},
+  {0xc491798a08a2ad4eULL, 0xf1a6f2bab92a27e2ULL},
+  {0xf5b5d7ec8acb58a2ULL, 0xae10af696774b1dbULL},
+  {0x9991a6f3d6bf1765ULL, 0xacca6da1e0a8ef29ULL},
+  {0xbff610b0cc6edd3fULL, 0x17fd090a58d32af3ULL},
+  {0xeff394dcff8a948eULL, 0xddfc4b4cef07f5b0ULL},
+  {0x95f83d0a1fb69cd9ULL, 0x4abdaf101564f98eULL},
+  {0xbb764c4ca7a4440fULL, 0x9d6d1ad41abe37f1ULL},
+  {0xea53df5fd18d5513ULL, 0x84c86189216dc5edULL},
+  {0x92746b9be2f8552cULL, 0x32fd3cf5b4e49bb4ULL},
+  {0xb7118682dbb66a77ULL, 0x3fbc8c33221dc2a1ULL},
+  {0xe4d5e82392a40515ULL, 0x0fabaf3feaa5334aULL},
+  {0x8f05b1163ba6832dULL, 0x29cb4d87f2a7400eULL},
+  {0xb2c71d5bca9023f8ULL, 0x743e20e9ef511012ULL},
+  {0xdf78e4b2bd342cf6ULL, 0x914da9246b255416ULL},
+  {0x8bab8eefb6409c1aULL, 0x1ad089b6c2f7548eULL},
+  {0xae9672aba3d0c320ULL, 0xa184ac2473b529b1ULL},
+  {0xda3c0f568cc4f3e8ULL, 0xc9e5d72d90a2741eULL},
+  {0x8865899617fb1871ULL, 0x7e2fa67c7a658892ULL},
+  {0xaa7eebfb9df9de8dULL, 0xddbb901b98feeab7ULL},
+  {0xd51ea6fa85785631ULL, 0x552a74227f3ea565ULL},
+  {0x8533285c936b35deULL, 0xd53a88958f87275fULL},
+  {0xa67ff273b8460356ULL, 0x8a892abaf368f137ULL},
+  {0xd01fef10a657842cULL, 0x2d2b7569b0432d85ULL},
+  {0x8213f56a67f6b29bULL, 0x9c3b29620e29fc73ULL},
+  {0xa298f2c501f45f42ULL, 0x8349f3ba91b47b8fULL},
+  {0xcb3f2f7642717713ULL, 0x241c70a936219a73ULL},
+  {0xfe0efb53d30dd4d7ULL, 0xed238cd383aa0110ULL},
+  {0x9ec95d1463e8a506ULL, 0xf4363804324a40aaULL},
+  {0xc67bb4597ce2ce48ULL, 0xb143c6053edcd0d5ULL},
+  {0xf81aa16fdc1b81daULL, 0xdd94b7868e94050aULL},
+  {0x9b10a4e5e9913128ULL, 0xca7cf2b4191c8326ULL},
+  {0xc1d4ce1f63f57d72ULL, 0xfd1c2f611f63a3f0ULL},
+  {0xf24a01a73cf2dccfULL, 0xbc633b39673c8cecULL},
+  {0x976e41088617ca01ULL, 0xd5be0503e085d813ULL},
+  {0xbd49d14aa79dbc82ULL, 0x4b2d8644d8a74e18ULL},
+  {0xec9c459d51852ba2ULL, 0xddf8e7d60ed1219eULL},
+  {0x93e1ab8252f33b45ULL, 0xcabb90e5c942b503ULL},
+  {0xb8da1662e7b00a17ULL, 0x3d6a751f3b936243ULL},
+  {0xe7109bfba19c0c9dULL, 0x0cc512670a783ad4ULL},
+  {0x906a617d450187e2ULL, 0x27fb2b80668b24c5ULL},
+  {0xb484f9dc9641e9daULL, 0xb1f9f660802dedf6ULL},
+  {0xe1a63853bbd26451ULL, 0x5e7873f8a0396973ULL},
+  {0x8d07e33455637eb2ULL, 0xdb0b487b6423e1e8ULL},
+  {0xb049dc016abc5e5fULL, 0x91ce1a9a3d2cda62ULL},
+  {0xdc5c5301c56b75f7ULL, 0x7641a140cc7810fbULL},
+  {0x89b9b3e11b6329baULL, 0xa9e904c87fcb0a9dULL},
+  {0xac2820d9623bf429ULL, 0x546345fa9fbdcd44ULL},
+  {0xd732290fbacaf133ULL, 0xa97c177947ad4095ULL},
+  {0x867f59a9d4bed6c0ULL, 0x49ed8eabcccc485dULL},
+  {0xa81f301449ee8c70ULL, 0x5c68f256bfff5a74ULL},
+  {0xd226fc195c6a2f8cULL, 0x73832eec6fff3111ULL},
+  {0x83585d8fd9c25db7ULL, 0xc831fd53c5ff7eabULL},
+  {0xa42e74f3d032f525ULL, 0xba3e7ca8b77f5e55ULL},
+  {0xcd3a1230c43fb26fULL, 0x28ce1bd2e55f35ebULL},
+  {0x80444b5e7aa7cf85ULL, 0x7980d163cf5b81b3ULL},
+  {0xa0555e361951c366ULL, 0xd7e105bcc332621fULL},
+  {0xc86ab5c39fa63440ULL, 0x8dd9472bf3fefaa7ULL},
+  {0xfa856334878fc150ULL, 0xb14f98f6f0feb951ULL},
+  {0x9c935e00d4b9d8d2ULL, 0x6ed1bf9a569f33d3ULL},
+  {0xc3b8358109e84f07ULL, 0x0a862f80ec4700c8ULL},
+  {0xf4a642e14c6262c8ULL, 0xcd27bb612758c0faULL},
+  {0x98e7e9cccfbd7dbdULL, 0x8038d51cb897789cULL},
+  {0xbf21e44003acdd2cULL, 0xe0470a63e6bd56c3ULL},
+  {0xeeea5d5004981478ULL, 0x1858ccfce06cac74ULL},
+  {0x95527a5202df0ccbULL, 0x0f37801e0c43ebc8ULL},
+  {0xbaa718e68396cffdULL, 0xd30560258f54e6baULL},
+  {0xe950df20247c83fdULL, 0x47c6b82ef32a2069ULL},
+  {0x91d28b7416cdd27eULL, 0x4cdc331d57fa5441ULL},
+  {0xb6472e511c81471dULL, 0xe0133fe4adf8e952ULL},
+  {0xe3d8f9e563a198e5ULL, 0x58180fddd97723a6ULL},
+  {0x8e679c2f5e44ff8fULL, 0x570f09eaa7ea7648ULL}
+};
+
+static const double g_exactPow10[] =
+{
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static INLINE_PREFIX int CountLeadingZeros64(JSUINT64 value)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+  unsigned long index;
+  _BitScanReverse64(&index, value);
+  return 63 - (int) index;
+#elif defined(_MSC_VER)
+  unsigned long index;
+  if (value >> 32)
+  {
+    _BitScanReverse(&index, (unsigned long) (value >> 32));
+    return 31 - (int) index;
+  }
+  _BitScanReverse(&index, (unsigned long) value);
+  return 63 - (int) index;
+#else
+  return __builtin_clzll(value);
+#endif
+}
+
+static INLINE_PREFIX JSUINT64 Multiply128(JSUINT64 a, JSUINT64 b, JSUINT64 *outHigh)
 {
-  static const double g_pow10[] = {1.0, 0.1, 0.01, 0.001, 0.0001, 0.00001, 0.000001,0.0000001, 0.00000001, 0.000000001, 0.0000000001, 0.00000000001, 0.000000000001, 0.0000000000001, 0.00000000000001, 0.000000000000001};
-  return (intValue + (frcValue * g_pow10[frcDecimalCount])) * intNeg;
+#if defined(__SIZEOF_INT128__)
+  unsigned __int128 product = (unsigned __int128) a * b;
+  *outHigh = (JSUINT64) (product >> 64);
+  return (JSUINT64) product;
+#elif defined(_MSC_VER) && defined(_M_X64)
+  return _umul128(a, b, outHigh);
+#else
+  JSUINT64 aLow = (JSUINT32) a, aHigh = a >> 32;
+  JSUINT64 bLow = (JSUINT32) b, bHigh = b >> 32;
+  JSUINT64 ll = aLow * bLow;
+  JSUINT64 lh = aLow * bHigh;
+  JSUINT64 hl = aHigh * bLow;
+  JSUINT64 mid = (ll >> 32) + (JSUINT32) lh + (JSUINT32) hl;
+  *outHigh = aHigh * bHigh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+  return (mid << 32) | (JSUINT32) ll;
+#endif
 }
 
-FASTCALL_ATTR JSOBJ FASTCALL_MSVC decodePreciseFloat(struct DecoderState *ds)
+static INLINE_PREFIX double AssembleDouble(JSUINT64 mantissa, int power2, int negative)
 {
-  char *end;
+  JSUINT64 bits = mantissa | ((JSUINT64) power2 << 52);
   double value;
-  errno = 0;
-
-  value = strtod(ds->start, &end);
 
-  if (errno == ERANGE)
+  if (negative)
   {
-    return SetError(ds, -1, "Range error when decoding numeric as double");
+    bits |= 1ULL << 63;
   }
 
-  ds->start = end;
-  return ds->dec->newDouble(ds->prv, value);
+  memcpy(&value, &bits, sizeof(value));
+  return value;
 }
 
-FASTCALL_ATTR JSOBJ FASTCALL_MSVC decode_numeric (struct DecoderState *ds)
+/*
+Eisel-Lemire. Computes the biased exponent and 52 bit mantissa of mantissa * 10^exponent,
+mantissa must not be zero */
+static void ComputeDouble(JSUINT64 mantissa, int exponent, JSUINT64 *outMantissa, int *outPower2)
 {
-  int intNeg = 1;
-  int mantSize = 0;
-  JSUINT64 intValue;
-  int chr;
-  int decimalCount = 0;
-  double frcValue = 0.0;
-  double expNeg;
-  double expValue;
-  char *offset = ds->start;
+  JSUINT64 low, high, secondHigh;
+  int leadingZeros, upperBit, shift, power2;
 
-  JSUINT64 overflowLimit = LLONG_MAX;
+  if (exponent < POW5_MIN_EXPONENT)
+  {
+    *outMantissa = 0;
+    *outPower2 = 0;
+    return;
+  }
 
-  if (*(offset) == '-')
+  if (exponent > POW5_MAX_EXPONENT)
   {
-    offset ++;
-    intNeg = -1;
-    overflowLimit = LLONG_MIN;
+    *outMantissa = 0;
+    *outPower2 = 0x7ff;
+    return;
   }
 
-  // Scan integer part
-  intValue = 0;
+  leadingZeros = CountLeadingZeros64(mantissa);
+  mantissa <<= leadingZeros;
 
-  while (1)
+  low = Multiply128(mantissa, g_pow5[exponent - POW5_MIN_EXPONENT][0], &high);
+
+  // The lower bits of the high word are all ones, the truncated power may be too small so refine with the low word
+  if ((high & 0x1ff) == 0x1ff)
   {
-    chr = (int) (unsigned char) *(offset);
+    Multiply128(mantissa, g_pow5[exponent - POW5_MIN_EXPONENT][1], &secondHigh);
+    low += secondHigh;
 
-    switch (chr)
+    if (secondHigh > low)
     {
-      case '0':
-      case '1':
-      case '2':
-      case '3':
-      case '4':
-      case '5':
-      case '6':
-      case '7':
-      case '8':
-      case '9':
-      {
-        //FIXME: Check for arithemtic overflow here
-        //PERF: Don't do 64-bit arithmetic here unless we know we have to
-        intValue = intValue * 10ULL + (JSLONG) (chr - 48);
-
-        if (intValue > overflowLimit)
-        {
-          return SetError(ds, -1, overflowLimit == LLONG_MAX ? "Value is too big" : "Value is too small");
-        }
+      high ++;
+    }
+  }
 
-        offset ++;
-        mantSize ++;
-        break;
-      }
-      case '.':
-      {
-        offset ++;
-        goto DECODE_FRACTION;
-        break;
-      }
-      case 'e':
-      case 'E':
-      {
-        offset ++;
-        goto DECODE_EXPONENT;
-        break;
-      }
+  upperBit = (int) (high >> 63);
+  shift = upperBit + 64 - 52 - 3;
+  mantissa = high >> shift;
+  power2 = (((152170 + 65536) * exponent) >> 16) + 63 + upperBit - leadingZeros + 1023;
 
-      default:
-      {
-        goto BREAK_INT_LOOP;
-        break;
-      }
+  if (power2 <= 0)
+  {
+    // Subnormal, exact halfway cases can not occur here
+    if (-power2 + 1 >= 64)
+    {
+      *outMantissa = 0;
+      *outPower2 = 0;
+      return;
     }
+
+    mantissa >>= -power2 + 1;
+    mantissa += (mantissa & 1);
+    mantissa >>= 1;
+    *outPower2 = (mantissa < (1ULL << 52)) ? 0 : 1;
+    *outMantissa = mantissa & ((1ULL << 52) - 1);
+    return;
   }
 
-BREAK_INT_LOOP:
+  // Exactly halfway between two doubles, which is only possible for small powers of ten. Round to even
+  if (low <= 1 && exponent >= -4 && exponent <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == high)
+  {
+    mantissa &= ~1ULL;
+  }
 
-  ds->lastType = JT_INT;
-  ds->start = offset;
+  mantissa += (mantissa & 1);
+  mantissa >>= 1;
 
-  if ((intValue >> 31))
+  if (mantissa >= (2ULL << 52))
   {
-    return ds->dec->newLong(ds->prv, (JSINT64) (intValue * (JSINT64) intNeg));
+    mantissa = (1ULL << 52);
+    power2 ++;
   }
-  else
+
+  if (power2 >= 0x7ff)
   {
-    return ds->dec->newInt(ds->prv, (JSINT32) (intValue * intNeg));
+    *outMantissa = 0;
+    *outPower2 = 0x7ff;
+    return;
   }
 
-DECODE_FRACTION:
+  *outMantissa = mantissa & ((1ULL << 52) - 1);
+  *outPower2 = power2;
+}
+
+/*
+Big decimal fallback, 0.d[0]d[1]...d[count - 1] * 10^point */
+#define BIGDECIMAL_MAX_DIGITS 800
+
+struct BigDecimal
+{
+  int count;
+  int point;
+  int truncated;
+  JSUINT8 digits[BIGDECIMAL_MAX_DIGITS];
+};
 
-  if (ds->dec->preciseFloat)
+static void BigDecimalTrim(struct BigDecimal *bd)
+{
+  while (bd->count > 0 && bd->digits[bd->count - 1] == 0)
   {
-    return decodePreciseFloat(ds);
+    bd->count --;
   }
 
-  // Scan fraction part
-  frcValue = 0.0;
-  for (;;)
+  if (bd->count == 0)
   {
-    chr = (int) (unsigned char) *(offset);
+    bd->point = 0;
+  }
+}
 
-    switch (chr)
+static void BigDecimalShiftLeft(struct BigDecimal *bd, int shift)
+{
+  JSUINT64 carry = 0;
+  int read;
+  int extra = 0;
+  JSUINT8 head[20];
+
+  for (read = bd->count - 1; read >= 0; read --)
+  {
+    JSUINT64 value = ((JSUINT64) bd->digits[read] << shift) + carry;
+    carry = value / 10;
+    bd->digits[read] = (JSUINT8) (value - carry * 10);
+  }
+
+  while (carry > 0)
+  {
+    JSUINT64 quotient = carry / 10;
+    head[extra++] = (JSUINT8) (carry - quotient * 10);
+    carry = quotient;
+  }
+
+  if (extra > 0)
+  {
+    int keep = bd->count;
+    int index;
+
+    if (keep + extra > BIGDECIMAL_MAX_DIGITS)
     {
-      case '0':
-      case '1':
-      case '2':
-      case '3':
-      case '4':
-      case '5':
-      case '6':
-      case '7':
-      case '8':
-      case '9':
+      int dropped;
+      keep = BIGDECIMAL_MAX_DIGITS - extra;
+
+      for (dropped = keep; dropped < bd->count; dropped ++)
       {
-        if (decimalCount < JSON_DOUBLE_MAX_DECIMALS)
+        if (bd->digits[dropped])
         {
-          frcValue = frcValue * 10.0 + (double) (chr - 48);
-          decimalCount ++;
+          bd->truncated = 1;
         }
-        offset ++;
-        break;
       }
-      case 'e':
-      case 'E':
+    }
+
+    memmove(bd->digits + extra, bd->digits, keep);
+
+    for (index = 0; index < extra; index ++)
+    {
+      bd->digits[index] = head[extra - 1 - index];
+    }
+
+    bd->count = keep + extra;
+    bd->point += extra;
+  }
+
+  BigDecimalTrim(bd);
+}
+
+static void BigDecimalShiftRight(struct BigDecimal *bd, int shift)
+{
+  int read = 0;
+  int write = 0;
+  JSUINT64 value = 0;
+  JSUINT64 mask = (1ULL << shift) - 1;
+
+  // Pick up enough leading digits to cover the first shift
+  while ((value >> shift) == 0)
+  {
+    if (read >= bd->count)
+    {
+      if (value == 0)
       {
-        offset ++;
-        goto DECODE_EXPONENT;
-        break;
+        bd->count = 0;
+        bd->point = 0;
+        return;
       }
-      default:
+
+      while ((value >> shift) == 0)
       {
-        goto BREAK_FRC_LOOP;
+        value *= 10;
+        read ++;
       }
+      break;
     }
+
+    value = value * 10 + bd->digits[read++];
   }
 
-BREAK_FRC_LOOP:
-  //FIXME: Check for arithemtic overflow here
-  ds->lastType = JT_DOUBLE;
-  ds->start = offset;
-  return ds->dec->newDouble (ds->prv, createDouble( (double) intNeg, (double) intValue, frcValue, decimalCount));
+  bd->point -= read - 1;
 
-DECODE_EXPONENT:
-  if (ds->dec->preciseFloat)
+  for (; read < bd->count; read ++)
   {
-    return decodePreciseFloat(ds);
+    bd->digits[write++] = (JSUINT8) (value >> shift);
+    value = (value & mask) * 10 + bd->digits[read];
   }
 
-  expNeg = 1.0;
+  while (value > 0)
+  {
+    JSUINT8 digit = (JSUINT8) (value >> shift);
 
-  if (*(offset) == '-')
+    if (write < BIGDECIMAL_MAX_DIGITS)
+    {
+      bd->digits[write++] = digit;
+    }
+    else
+    if (digit > 0)
+    {
+      bd->truncated = 1;
+    }
+
+    value = (value & mask) * 10;
+  }
+
+  bd->count = write;
+  BigDecimalTrim(bd);
+}
+
+static void BigDecimalShift(struct BigDecimal *bd, int shift)
+{
+  if (bd->count == 0)
   {
-    expNeg = -1.0;
-    offset ++;
+    return;
+  }
+
+  for (; shift > 60; shift -= 60)
+  {
+    BigDecimalShiftLeft(bd, 60);
+  }
+
+  for (; shift < -60; shift += 60)
+  {
+    BigDecimalShiftRight(bd, 60);
+  }
+
+  if (shift > 0)
+  {
+    BigDecimalShiftLeft(bd, shift);
   }
   else
-  if (*(offset) == '+')
+  if (shift < 0)
   {
-    expNeg = +1.0;
-    offset ++;
+    BigDecimalShiftRight(bd, -shift);
   }
+}
+
+static JSUINT64 BigDecimalRoundedInteger(struct BigDecimal *bd)
+{
+  JSUINT64 value = 0;
+  int index;
+  int roundUp = 0;
 
-  expValue = 0.0;
+  for (index = 0; index < bd->point && index < bd->count; index ++)
+  {
+    value = value * 10 + bd->digits[index];
+  }
 
-  for (;;)
+  for (; index < bd->point; index ++)
   {
-    chr = (int) (unsigned char) *(offset);
+    value *= 10;
+  }
 
-    switch (chr)
+  if (bd->point >= 0 && bd->point < bd->count)
+  {
+    if (bd->digits[bd->point] == 5 && bd->point + 1 == bd->count)
     {
-      case '0':
-      case '1':
-      case '2':
-      case '3':
-      case '4':
-      case '5':
-      case '6':
-      case '7':
-      case '8':
-      case '9':
-      {
-        expValue = expValue * 10.0 + (double) (chr - 48);
-        offset ++;
-        break;
-      }
-      default:
-      {
-        goto BREAK_EXP_LOOP;
-      }
+      // Exactly halfway unless digits were dropped, round to even
+      roundUp = bd->truncated || (bd->point > 0 && (bd->digits[bd->point - 1] & 1));
+    }
+    else
+    {
+      roundUp = bd->digits[bd->point] >= 5;
     }
   }
 
-BREAK_EXP_LOOP:
-  //FIXME: Check for arithemtic overflow here
-  ds->lastType = JT_DOUBLE;
-  ds->start = offset;
-  return ds->dec->newDouble (ds->prv, createDouble( (double) intNeg, (double) intValue , frcValue, decimalCount) * pow(10.0, expValue * expNeg));
+  return value + roundUp;
 }
 
-FASTCALL_ATTR JSOBJ FASTCALL_MSVC decode_true ( struct DecoderState *ds)
+static double BigDecimalToDouble(struct BigDecimal *bd, int negative)
 {
-  char *offset = ds->start;
-  offset ++;
-
-  if (*(offset++) != 'r')
-    goto SETERROR;
-  if (*(offset++) != 'u')
-    goto SETERROR;
-  if (*(offset++) != 'e')
-    goto SETERROR;
+  static const int powerShift[] = { 1, 3, 6, 9, 13, 16, 19, 23, 26 };
+  int power2 = 0;
+  JSUINT64 mantissa;
 
-  ds->lastType = JT_TRUE;
-  ds->start = offset;
-  return ds->dec->newTrue(ds->prv);
+  if (bd->count == 0 || bd->point < -330)
+  {
+    return AssembleDouble(0, 0, negative);
+  }
 
-SETERROR:
-  return SetError(ds, -1, "Unexpected character found when decoding 'true'");
-}
+  if (bd->point > 310)
+  {
+    return AssembleDouble(0, 0x7ff, negative);
+  }
 
-FASTCALL_ATTR JSOBJ FASTCALL_MSVC decode_false ( struct DecoderState *ds)
-{
-  char *offset = ds->start;
-  offset ++;
+  // Scale into [0.5, 1)
+  while (bd->point > 0)
+  {
+    int shift = bd->point >= 9 ? 27 : powerShift[bd->point];
+    BigDecimalShift(bd, -shift);
+    power2 += shift;
+  }
 
-  if (*(offset++) != 'a')
-    goto SETERROR;
-  if (*(offset++) != 'l')
-    goto SETERROR;
-  if (*(offset++) != 's')
-    goto SETERROR;
-  if (*(offset++) != 'e')
-    goto SETERROR;
+  while (bd->point < 0 || (bd->point == 0 && bd->digits[0] < 5))
+  {
+    int shift = -bd->point >= 9 ? 27 : powerShift[-bd->point];
+    BigDecimalShift(bd, shift);
+    power2 -= shift;
+  }
 
-  ds->lastType = JT_FALSE;
-  ds->start = offset;
-  return ds->dec->newFalse(ds->prv);
+  // Binary exponent of [1, 2) and room for subnormals
+  power2 --;
 
-SETERROR:
-  return SetError(ds, -1, "Unexpected character found when decoding 'false'");
-}
+  if (power2 < -1022)
+  {
+    BigDecimalShift(bd, -(-1022 - power2));
+    power2 = -1022;
+  }
 
-FASTCALL_ATTR JSOBJ FASTCALL_MSVC decode_null ( struct DecoderState *ds)
-{
-  char *offset = ds->start;
-  offset ++;
+  if (power2 + 1023 >= 0x7ff)
+  {
+    return AssembleDouble(0, 0x7ff, negative);
+  }
 
-  if (*(offset++) != 'u')
-    goto SETERROR;
-  if (*(offset++) != 'l')
-    goto SETERROR;
-  if (*(offset++) != 'l')
-    goto SETERROR;
+  BigDecimalShift(bd, 53);
+  mantissa = BigDecimalRoundedInteger(bd);
 
-  ds->lastType = JT_NULL;
-  ds->start = offset;
-  return ds->dec->newNull(ds->prv);
+  if (mantissa == (2ULL << 52))
+  {
+    mantissa >>= 1;
+    power2 ++;
 
-SETERROR:
-  return SetError(ds, -1, "Unexpected character found when decoding 'null'");
+    if (power2 + 1023 >= 0x7ff)
+    {
+      return AssembleDouble(0, 0x7ff, negative);
+    }
+  }
+
+  if (!(mantissa & (1ULL << 52)))
+  {
+    // Subnormal
+    return AssembleDouble(mantissa, 0, negative);
+  }
+
+  return AssembleDouble(mantissa & ((1ULL << 52) - 1), power2 + 1023, negative);
 }
 
-FASTCALL_ATTR void FASTCALL_MSVC SkipWhitespace(struct DecoderState *ds)
+static double ParseBigDecimal(const char *start, int negative)
 {
-  char *offset = ds->start;
+  struct BigDecimal bd;
+  const char *offset = start;
+  int sawPoint = 0;
+  int exponent = 0;
+  int expNeg = 0;
 
-  for (;;)
+  bd.count = 0;
+  bd.point = 0;
+  bd.truncated = 0;
+
+  for (;; offset ++)
   {
-    switch (*offset)
+    if (*offset == '.' && !sawPoint)
     {
-      case ' ':
-      case '\t':
-      case '\r':
-      case '\n':
-        offset ++;
-        break;
+      sawPoint = 1;
+      bd.point = bd.count;
+      continue;
+    }
 
-      default:
-        ds->start = offset;
-        return;
+    if (*offset < '0' || *offset > '9')
+    {
+      break;
+    }
+
+    if (*offset == '0' && bd.count == 0)
+    {
+      // Leading zero
+      bd.point --;
+      continue;
+    }
+
+    if (bd.count < BIGDECIMAL_MAX_DIGITS)
+    {
+      bd.digits[bd.count++] = (JSUINT8) (*offset - '0');
+    }
+    else
+    if (*offset != '0')
+    {
+      bd.truncated = 1;
     }
   }
-}
 
-enum DECODESTRINGSTATE
-{
-  DS_ISNULL = 0x32,
-  DS_ISQUOTE,
-  DS_ISESCAPE,
-  DS_UTFLENERROR,
+  if (!sawPoint)
+  {
+    bd.point = bd.count;
+  }
 
-};
+  if (*offset == 'e' || *offset == 'E')
+  {
+    offset ++;
 
-static const JSUINT8 g_decoderLookup[256] =
-{
-  /* 0x00 */ DS_ISNULL, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-  /* 0x10 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-  /* 0x20 */ 1, 1, DS_ISQUOTE, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-  /* 0x30 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-  /* 0x40 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-  /* 0x50 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, DS_ISESCAPE, 1, 1, 1,
-  /* 0x60 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-  /* 0x70 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-  /* 0x80 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-  /* 0x90 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-  /* 0xa0 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-  /* 0xb0 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-  /* 0xc0 */ 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
-  /* 0xd0 */ 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
-  /* 0xe0 */ 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
-  /* 0xf0 */ 4, 4, 4, 4, 4, 4, 4, 4, DS_UTFLENERROR, DS_UTFLENERROR, DS_UTFLENERROR, DS_UTFLENERROR, DS_UTFLENERROR, DS_UTFLENERROR, DS_UTFLENERROR, DS_UTFLENERROR,
-};
+    if (*offset == '-' || *offset == '+')
+    {
+      expNeg = *offset == '-';
+      offset ++;
+    }
 
-FASTCALL_ATTR JSOBJ FASTCALL_MSVC decode_string ( struct DecoderState *ds)
+    for (; *offset >= '0' && *offset <= '9'; offset ++)
+    {
+      if (exponent < 100000)
+      {
+        exponent = exponent * 10 + (*offset - '0');
+      }
+    }
+  }
+
+  bd.point += expNeg ? -exponent : exponent;
+  BigDecimalTrim(&bd);
+  return BigDecimalToDouble(&bd, negative);
+}
+
+/*
+Parses a number with a fraction and/or an exponent, starting at the sign. Returns an infinity when
+the number is out of range */
+static double ParseDouble(const char *offset, const char **outEnd)
 {
-  JSUTF16 sur[2] = { 0 };
-  int iSur = 0;
-  int index;
-  wchar_t *escOffset;
-  wchar_t *escStart;
-  size_t escLen = (ds->escEnd - ds->escStart);
-  JSUINT8 *inputOffset;
-  JSUINT8 oct;
-  JSUTF32 ucs;
-  ds->lastType = JT_INVALID;
-  ds->start ++;
+  const char *digitsStart;
+  JSUINT64 mantissa = 0;
+  JSUINT64 resultMantissa;
+  int resultPower2;
+  int digits = 0;
+  int exponent = 0;
+  int truncated = 0;
+  int negative = 0;
+  int chr;
+  double value;
 
-  if ( (size_t) (ds->end - ds->start) > escLen)
+  if (*offset == '-')
   {
-    size_t newSize = (ds->end - ds->start);
+    negative = 1;
+    offset ++;
+  }
 
-    if (ds->escHeap)
+  digitsStart = offset;
+
+  // Integer part, the first 19 significant digits are kept in the mantissa
+  for (; (chr = (unsigned char) *offset) >= '0' && chr <= '9'; offset ++)
+  {
+    if (digits < 19)
     {
-      if (newSize > (UINT_MAX / sizeof(wchar_t)))
+      if (mantissa || chr != '0')
       {
-        return SetError(ds, -1, "Could not reserve memory block");
+        mantissa = mantissa * 10 + (chr - '0');
+        digits ++;
       }
-      escStart = (wchar_t *)ds->dec->realloc(ds->escStart, newSize * sizeof(wchar_t));
-      if (!escStart)
-      {
-        ds->dec->free(ds->escStart);
-        return SetError(ds, -1, "Could not reserve memory block");
-      }
-      ds->escStart = escStart;
     }
     else
     {
-      wchar_t *oldStart = ds->escStart;
-      ds->escHeap = 1;
-      if (newSize > (UINT_MAX / sizeof(wchar_t)))
-      {
-        return SetError(ds, -1, "Could not reserve memory block");
-      }
-      ds->escStart = (wchar_t *) ds->dec->malloc(newSize * sizeof(wchar_t));
-      if (!ds->escStart)
-      {
-        return SetError(ds, -1, "Could not reserve memory block");
-      }
-      memcpy(ds->escStart, oldStart, escLen * sizeof(wchar_t));
+      exponent ++;
+      truncated |= (chr != '0');
     }
-
-    ds->escEnd = ds->escStart + newSize;
   }
 
-  escOffset = ds->escStart;
-  inputOffset = (JSUINT8 *) ds->start;
-
-  for (;;)
+  if (*offset == '.')
   {
-    switch (g_decoderLookup[(JSUINT8)(*inputOffset)])
+    offset ++;
+
+    for (; (chr = (unsigned char) *offset) >= '0' && chr <= '9'; offset ++)
     {
-      case DS_ISNULL:
+      if (digits < 19)
       {
-        return SetError(ds, -1, "Unmatched ''\"' when when decoding 'string'");
+        if (mantissa || chr != '0')
+        {
+          mantissa = mantissa * 10 + (chr - '0');
+          digits ++;
+        }
+        exponent --;
       }
-      case DS_ISQUOTE:
+      else
       {
-        ds->lastType = JT_UTF8;
-        inputOffset ++;
-        ds->start += ( (char *) inputOffset - (ds->start));
-        return ds->dec->newString(ds->prv, ds->escStart, escOffset);
+        truncated |= (chr != '0');
       }
-      case DS_UTFLENERROR:
+    }
+  }
+
+  if (*offset == 'e' || *offset == 'E')
+  {
+    int expNeg = 0;
+    int expValue = 0;
+    offset ++;
+
+    if (*offset == '-' || *offset == '+')
+    {
+      expNeg = (*offset == '-');
+      offset ++;
+    }
+
+    for (; (chr = (unsigned char) *offset) >= '0' && chr <= '9'; offset ++)
+    {
+      if (expValue < 100000)
       {
-        return SetError (ds, -1, "Invalid UTF-8 sequence length when decoding 'string'");
+        expValue = expValue * 10 + (chr - '0');
       }
-      case DS_ISESCAPE:
-        inputOffset ++;
-        switch (*inputOffset)
-        {
-          case '\\': *(escOffset++) = L'\\'; inputOffset++; continue;
-          case '\"': *(escOffset++) = L'\"'; inputOffset++; continue;
-          case '/':  *(escOffset++) = L'/';  inputOffset++; continue;
-          case 'b':  *(escOffset++) = L'\b'; inputOffset++; continue;
-          case 'f':  *(escOffset++) = L'\f'; inputOffset++; continue;
-          case 'n':  *(escOffset++) = L'\n'; inputOffset++; continue;
-          case 'r':  *(escOffset++) = L'\r'; inputOffset++; continue;
-          case 't':  *(escOffset++) = L'\t'; inputOffset++; continue;
+    }
 
-          case 'u':
-          {
-            int index;
-            inputOffset ++;
+    exponent += expNeg ? -expValue : expValue;
+  }
 
-            for (index = 0; index < 4; index ++)
-            {
-              switch (*inputOffset)
-              {
-                case '\0': return SetError (ds, -1, "Unterminated unicode escape sequence when decoding 'string'");
-                default: return SetError (ds, -1, "Unexpected character in unicode escape sequence when decoding 'string'");
+  *outEnd = offset;
 
-                case '0':
-                case '1':
-                case '2':
-                case '3':
-                case '4':
-                case '5':
-                case '6':
-                case '7':
-                case '8':
-                case '9':
-                  sur[iSur] = (sur[iSur] << 4) + (JSUTF16) (*inputOffset - '0');
-                  break;
+  if (mantissa == 0)
+  {
+    return negative ? -0.0 : 0.0;
+  }
 
-                case 'a':
-                case 'b':
-                case 'c':
-                case 'd':
-                case 'e':
-                case 'f':
-                  sur[iSur] = (sur[iSur] << 4) + 10 + (JSUTF16) (*inputOffset - 'a');
-                  break;
+#if (defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0) || defined(_M_X64)
+  // Clinger, both operands are exact and the single rounding of the operation is correct
+  if (!truncated && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22)
+  {
+    value = (double) mantissa;
+    value = exponent < 0 ? value / g_exactPow10[-exponent] : value * g_exactPow10[exponent];
+    return negative ? -value : value;
+  }
+#endif
 
-                case 'A':
-                case 'B':
-                case 'C':
-                case 'D':
-                case 'E':
-                case 'F':
-                  sur[iSur] = (sur[iSur] << 4) + 10 + (JSUTF16) (*inputOffset - 'A');
-                  break;
-              }
+  ComputeDouble(mantissa, exponent, &resultMantissa, &resultPower2);
 
-              inputOffset ++;
-            }
+  if (truncated)
+  {
+    JSUINT64 upperMantissa;
+    int upperPower2;
 
-            if (iSur == 0)
-            {
-              if((sur[iSur] & 0xfc00) == 0xd800)
-              {
-                // First of a surrogate pair, continue parsing
-                iSur ++;
-                break;
-              }
-              (*escOffset++) = (wchar_t) sur[iSur];
-              iSur = 0;
-            }
-            else
-            {
-              // Decode pair
-              if ((sur[1] & 0xfc00) != 0xdc00)
-              {
-                return SetError (ds, -1, "Unpaired high surrogate when decoding 'string'");
-              }
-#if WCHAR_MAX == 0xffff
-              (*escOffset++) = (wchar_t) sur[0];
-              (*escOffset++) = (wchar_t) sur[1];
-#else
-              (*escOffset++) = (wchar_t) 0x10000 + (((sur[0] - 0xd800) << 10) | (sur[1] - 0xdc00));
+    ComputeDouble(mantissa + 1, exponent, &upperMantissa, &upperPower2);
+
+    if (upperMantissa != resultMantissa || upperPower2 != resultPower2)
+    {
+      return ParseBigDecimal(digitsStart, negative);
+    }
+  }
+
+  return AssembleDouble(resultMantissa, resultPower2, negative);
+}
+
+/*
+Decodes a number with a fraction and/or an exponent. Starts over at the sign */
+static JSOBJ decode_double(struct DecoderState *ds)
+{
+  const char *end;
+  double value = ParseDouble(ds->start, &end);
+
+  ds->lastType = JT_DOUBLE;
+  ds->start = (char *) end;
+
+  if (value - value != 0.0)
+  {
+    return SetError(ds, -1, "Range error when decoding numeric as double");
+  }
+
+  return ds->dec->newDouble (ds->prv, value);
+}
+
+#ifdef __LITTLE_ENDIAN__
+/*
+True when all eight bytes of a little endian load are '0'..'9' */
+static INLINE_PREFIX int IsEightDigits(JSUINT64 word)
+{
+  return ((word & 0xf0f0f0f0f0f0f0f0ULL) |
+    (((word + 0x0606060606060606ULL) & 0xf0f0f0f0f0f0f0f0ULL) >> 4)) == 0x3333333333333333ULL;
+}
+
+/*
+Folds eight ASCII digits into their value, pairs first, then quads, then the two halves */
+static INLINE_PREFIX JSUINT32 ParseEightDigits(JSUINT64 word)
+{
+  word -= 0x3030303030303030ULL;
+  word = (word * 10) + (word >> 8);
+  word = (((word & 0x000000ff000000ffULL) * (100 + (1000000ULL << 32))) +
+    (((word >> 16) & 0x000000ff000000ffULL) * (1 + (10000ULL << 32)))) >> 32;
+  return (JSUINT32) word;
+}
 #endif
-              iSur = 0;
-            }
-          break;
-        }
 
-        case '\0': return SetError(ds, -1, "Unterminated escape sequence when decoding 'string'");
-        default: return SetError(ds, -1, "Unrecognized escape sequence when decoding 'string'");
-      }
+/*
+LLONG_MAX / 10, the same for the magnitude of LLONG_MIN */
+#define INT64_CUTOFF 922337203685477580ULL
+
+/*
+Compares a run of digits without leading zeros against the decimal string of a limit of the same length */
+static INLINE_PREFIX int DigitsExceed(const char *digits, size_t count, const char *limit, size_t cchLimit)
+{
+  return count != cchLimit ? count > cchLimit : memcmp(digits, limit, count) > 0;
+}
+
+/*
+Lazy variant used when the decoder has newRawNumber. Only the bounds of the number are scanned and
+it is classified the way decode_numeric would, without converting it. Out of range values still fail here */
+static JSOBJ decode_raw_numeric(struct DecoderState *ds)
+{
+  char *start = ds->start;
+  char *offset = start;
+  char *digits;
+  size_t count;
+  int negative = 0;
+  int type = JT_INT;
+
+  if (*offset == '-')
+  {
+    offset ++;
+    negative = 1;
+  }
+
+  while (*offset == '0')
+  {
+    offset ++;
+  }
+
+  digits = offset;
+
+#ifdef __LITTLE_ENDIAN__
+  while (ds->end - offset >= 8)
+  {
+    JSUINT64 word;
+    memcpy(&word, offset, sizeof(word));
+
+    if (!IsEightDigits(word))
+    {
       break;
+    }
 
-      case 1:
+    offset += 8;
+  }
+#endif
+
+  while (*offset >= '0' && *offset <= '9')
+  {
+    offset ++;
+  }
+
+  count = (size_t) (offset - digits);
+
+  if (*offset == '.' || *offset == 'e' || *offset == 'E')
+  {
+    int expNeg = 0;
+    int expValue = 0;
+
+    if (*offset == '.')
+    {
+      offset ++;
+
+      while (*offset >= '0' && *offset <= '9')
       {
-        *(escOffset++) = (wchar_t) (*inputOffset++);
-        break;
+        offset ++;
       }
+    }
 
-      case 2:
+    if (*offset == 'e' || *offset == 'E')
+    {
+      offset ++;
+
+      if (*offset == '-' || *offset == '+')
       {
-        ucs = (*inputOffset++) & 0x1f;
-        ucs <<= 6;
-        if (((*inputOffset) & 0x80) != 0x80)
+        expNeg = (*offset == '-');
+        offset ++;
+      }
+
+      for (; *offset >= '0' && *offset <= '9'; offset ++)
+      {
+        if (expValue < 100000)
         {
-          return SetError(ds, -1, "Invalid octet in UTF-8 sequence when decoding 'string'");
+          expValue = expValue * 10 + (*offset - '0');
         }
-        ucs |= (*inputOffset++) & 0x3f;
-        if (ucs < 0x80) return SetError (ds, -1, "Overlong 2 byte UTF-8 sequence detected when decoding 'string'");
-        *(escOffset++) = (wchar_t) ucs;
-        break;
       }
+    }
 
-      case 3:
+    // Below 10^308 it can't overflow, otherwise find out the hard way. A negative exponent only
+    // brings a long integer part back into range when it is large enough
+    if ((JSINT64) count + (expNeg ? -expValue : expValue) > DBL_MAX_10_EXP)
+    {
+      const char *end;
+      double value = ParseDouble(start, &end);
+
+      if (value - value != 0.0)
       {
-        JSUTF32 ucs = 0;
-        ucs |= (*inputOffset++) & 0x0f;
+        return SetError(ds, -1, "Range error when decoding numeric as double");
+      }
+    }
 
-        for (index = 0; index < 2; index ++)
+    type = JT_DOUBLE;
+  }
+  else
+  if (count >= 10)
+  {
+    if (DigitsExceed(digits, count, negative ? "9223372036854775808" : "9223372036854775807", 19))
+    {
+      return SetError(ds, -1, negative ? "Value is too small" : "Value is too big");
+    }
+
+    if (DigitsExceed(digits, count, "2147483647", 10))
+    {
+      type = JT_LONG;
+    }
+  }
+
+  ds->lastType = type;
+  ds->start = offset;
+  return ds->dec->newRawNumber(ds->prv, start, offset, type);
+}
+
+JSINT64 JSON_DecodeRawInteger(const char *start, const char *end)
+{
+  JSUINT64 value = 0;
+  int negative = 0;
+
+  if (start < end && *start == '-')
+  {
+    negative = 1;
+    start ++;
+  }
+
+  for (; start < end; start ++)
+  {
+    value = value * 10 + (JSUINT64) (*start - '0');
+  }
+
+  return (JSINT64) (negative ? 0 - value : value);
+}
+
+double JSON_DecodeRawDouble(const char *start, const char *end)
+{
+  const char *parsedEnd;
+  (void) end;
+  return ParseDouble(start, &parsedEnd);
+}
+
+FASTCALL_ATTR JSOBJ FASTCALL_MSVC decode_numeric (struct DecoderState *ds)
+{
+  int intNeg = 1;
+  JSUINT64 intValue;
+  int chr;
+  char *offset = ds->start;
+  char *digitsStart;
+  int maxLastDigit = 7;
+
+  if (ds->dec->newRawNumber)
+  {
+    return decode_raw_numeric(ds);
+  }
+
+  if (*(offset) == '-')
+  {
+    offset ++;
+    intNeg = -1;
+    maxLastDigit = 8;
+  }
+
+  digitsStart = offset;
+  intValue = 0;
+
+#ifdef __LITTLE_ENDIAN__
+  // Eight digits at a time while at most 18 digits are consumed, which can't overflow
+  while (offset - digitsStart <= 10 && ds->end - offset >= 8)
+  {
+    JSUINT64 word;
+    memcpy(&word, offset, sizeof(word));
+
+    if (!IsEightDigits(word))
+    {
+      break;
+    }
+
+    intValue = intValue * 100000000ULL + ParseEightDigits(word);
+    offset += 8;
+  }
+#endif
+
+  // Scan the rest of the integer part
+  while (1)
+  {
+    chr = (int) (unsigned char) *(offset);
+
+    switch (chr)
+    {
+      case '0':
+      case '1':
+      case '2':
+      case '3':
+      case '4':
+      case '5':
+      case '6':
+      case '7':
+      case '8':
+      case '9':
+      {
+        chr -= '0';
+
+        if (intValue >= INT64_CUTOFF && (intValue > INT64_CUTOFF || chr > maxLastDigit))
         {
-          ucs <<= 6;
-          oct = (*inputOffset++);
+          // Too big for an integer but fine as the integer part of a double
+          while (*offset >= '0' && *offset <= '9')
+          {
+            offset ++;
+          }
 
-          if ((oct & 0x80) != 0x80)
+          if (*offset == '.' || *offset == 'e' || *offset == 'E')
           {
-            return SetError(ds, -1, "Invalid octet in UTF-8 sequence when decoding 'string'");
+            return decode_double(ds);
           }
 
-          ucs |= oct & 0x3f;
+          return SetError(ds, -1, intNeg == 1 ? "Value is too big" : "Value is too small");
         }
 
-        if (ucs < 0x800) return SetError (ds, -1, "Overlong 3 byte UTF-8 sequence detected when encoding string");
-        *(escOffset++) = (wchar_t) ucs;
+        intValue = intValue * 10ULL + (JSUINT64) chr;
+        offset ++;
         break;
       }
+      case '.':
+      case 'e':
+      case 'E':
+      {
+        return decode_double(ds);
+      }
 
-      case 4:
+      default:
       {
-        JSUTF32 ucs = 0;
-        ucs |= (*inputOffset++) & 0x07;
+        goto BREAK_INT_LOOP;
+        break;
+      }
+    }
+  }
 
-        for (index = 0; index < 3; index ++)
-        {
-          ucs <<= 6;
-          oct = (*inputOffset++);
+BREAK_INT_LOOP:
 
-          if ((oct & 0x80) != 0x80)
-          {
-            return SetError(ds, -1, "Invalid octet in UTF-8 sequence when decoding 'string'");
-          }
+  ds->lastType = JT_INT;
+  ds->start = offset;
+
+  if ((intValue >> 31))
+  {
+    return ds->dec->newLong(ds->prv, (JSINT64) (intValue * (JSINT64) intNeg));
+  }
+  else
+  {
+    return ds->dec->newInt(ds->prv, (JSINT32) (intValue * intNeg));
+  }
+}
+
+FASTCALL_ATTR JSOBJ FASTCALL_MSVC decode_true ( struct DecoderState *ds)
+{
+  char *offset = ds->start;
+  offset ++;
+
+  if (*(offset++) != 'r')
+    goto SETERROR;
+  if (*(offset++) != 'u')
+    goto SETERROR;
+  if (*(offset++) != 'e')
+    goto SETERROR;
+
+  ds->lastType = JT_TRUE;
+  ds->start = offset;
+  return ds->dec->newTrue(ds->prv);
+
+SETERROR:
+  return SetError(ds, -1, "Unexpected character found when decoding 'true'");
+}
+
+FASTCALL_ATTR JSOBJ FASTCALL_MSVC decode_false ( struct DecoderState *ds)
+{
+  char *offset = ds->start;
+  offset ++;
+
+  if (*(offset++) != 'a')
+    goto SETERROR;
+  if (*(offset++) != 'l')
+    goto SETERROR;
+  if (*(offset++) != 's')
+    goto SETERROR;
+  if (*(offset++) != 'e')
+    goto SETERROR;
+
+  ds->lastType = JT_FALSE;
+  ds->start = offset;
+  return ds->dec->newFalse(ds->prv);
+
+SETERROR:
+  return SetError(ds, -1, "Unexpected character found when decoding 'false'");
+}
+
+FASTCALL_ATTR JSOBJ FASTCALL_MSVC decode_null ( struct DecoderState *ds)
+{
+  char *offset = ds->start;
+  offset ++;
+
+  if (*(offset++) != 'u')
+    goto SETERROR;
+  if (*(offset++) != 'l')
+    goto SETERROR;
+  if (*(offset++) != 'l')
+    goto SETERROR;
+
+  ds->lastType = JT_NULL;
+  ds->start = offset;
+  return ds->dec->newNull(ds->prv);
+
+SETERROR:
+  return SetError(ds, -1, "Unexpected character found when decoding 'null'");
+}
+
+static INLINE_PREFIX int IsWhitespace(char chr)
+{
+  return (chr == ' ' || chr == '\n' || chr == '\r' || chr == '\t');
+}
+
+static const char *SkipWhitespaceScalar(const char *offset, const char *end)
+{
+  while (offset < end && IsWhitespace(*offset))
+  {
+    offset ++;
+  }
+
+  return offset;
+}
+
+#ifdef JSON_SSE2
+/*
+Returns a bitmask with one bit set for each of the 16 bytes at offset that is not whitespace */
+static INLINE_PREFIX int NonWhitespaceMask16(const char *offset)
+{
+  __m128i chunk = _mm_loadu_si128((const __m128i *) offset);
+  __m128i ws = _mm_or_si128(
+    _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))),
+    _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))));
+
+  return ~_mm_movemask_epi8(ws) & 0xffff;
+}
+
+static const char *SkipWhitespaceSSE2(const char *offset, const char *end)
+{
+  while (end - offset >= 16)
+  {
+    int mask = NonWhitespaceMask16(offset);
+
+    if (mask)
+    {
+      return offset + CountTrailingZeros((JSUINT32) mask);
+    }
+
+    offset += 16;
+  }
+
+  return SkipWhitespaceScalar(offset, end);
+}
+#endif
+
+#ifdef JSON_AVX2
+JSON_TARGET_AVX2 static const char *SkipWhitespaceAVX2(const char *offset, const char *end)
+{
+  while (end - offset >= 32)
+  {
+    __m256i chunk = _mm256_loadu_si256((const __m256i *) offset);
+    __m256i ws = _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n'))),
+      _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t'))));
+    JSUINT32 mask = ~ (JSUINT32) _mm256_movemask_epi8(ws);
+
+    if (mask)
+    {
+      return offset + CountTrailingZeros(mask);
+    }
+
+    offset += 32;
+  }
+
+  return SkipWhitespaceSSE2(offset, end);
+}
+#endif
+
+/*
+Returns a pointer to the first non whitespace character in [offset, end) or end.
+Most calls land right in front of a token or a single separating space, those are answered
+by the scalar checks. Indentation runs are handled by one SSE2 load, longer runs go wide */
+static INLINE_PREFIX const char *SkipWhitespaceRun(const char *offset, const char *end)
+{
+  if (offset >= end || !IsWhitespace(offset[0]))
+  {
+    return offset;
+  }
+
+  if (end - offset < 2 || !IsWhitespace(offset[1]))
+  {
+    return offset + 1;
+  }
+
+#ifdef JSON_SSE2
+  if (end - offset >= 16)
+  {
+    int mask = NonWhitespaceMask16(offset);
+
+    if (mask)
+    {
+      return offset + CountTrailingZeros((JSUINT32) mask);
+    }
+
+    offset += 16;
+
+#ifdef JSON_AVX2
+    if (HasAVX2())
+    {
+      return SkipWhitespaceAVX2(offset, end);
+    }
+#endif
+    return SkipWhitespaceSSE2(offset, end);
+  }
+#endif
+
+  return SkipWhitespaceScalar(offset, end);
+}
+
+FASTCALL_ATTR void FASTCALL_MSVC SkipWhitespace(struct DecoderState *ds)
+{
+  ds->start = (char *) SkipWhitespaceRun(ds->start, ds->end);
+}
+
+enum DECODESTRINGSTATE
+{
+  DS_ISNULL = 0x32,
+  DS_ISQUOTE,
+  DS_ISESCAPE,
+  DS_UTFLENERROR,
+
+};
+
+static const JSUINT8 g_decoderLookup[256] =
+{
+  /* 0x00 */ DS_ISNULL, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  /* 0x10 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  /* 0x20 */ 1, 1, DS_ISQUOTE, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  /* 0x30 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  /* 0x40 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  /* 0x50 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, DS_ISESCAPE, 1, 1, 1,
+  /* 0x60 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  /* 0x70 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  /* 0x80 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  /* 0x90 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  /* 0xa0 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  /* 0xb0 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  /* 0xc0 */ 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+  /* 0xd0 */ 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+  /* 0xe0 */ 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+  /* 0xf0 */ 4, 4, 4, 4, 4, 4, 4, 4, DS_UTFLENERROR, DS_UTFLENERROR, DS_UTFLENERROR, DS_UTFLENERROR, DS_UTFLENERROR, DS_UTFLENERROR, DS_UTFLENERROR, DS_UTFLENERROR,
+};
+
+/*
+Plain ASCII string runs. The kernels below find the first byte in [inputOffset, end) that needs the
+decoder state machine, that is a quote, a backslash, a control character or a non ASCII byte, and widen
+everything before it to wchar_t in bulk. The output buffer always has room for one wchar_t per remaining
+input byte, so a full vector worth of characters may be stored even if only a part of it is consumed */
+#if WCHAR_MAX > 0xffff
+#define JSON_WCHAR_32
+#endif
+
+#ifdef JSON_SSE2
+static INLINE_PREFIX void WidenASCII16(wchar_t *escOffset, __m128i chunk)
+{
+  __m128i zero = _mm_setzero_si128();
+  __m128i lo = _mm_unpacklo_epi8(chunk, zero);
+  __m128i hi = _mm_unpackhi_epi8(chunk, zero);
+#ifdef JSON_WCHAR_32
+  _mm_storeu_si128((__m128i *) (escOffset + 0), _mm_unpacklo_epi16(lo, zero));
+  _mm_storeu_si128((__m128i *) (escOffset + 4), _mm_unpackhi_epi16(lo, zero));
+  _mm_storeu_si128((__m128i *) (escOffset + 8), _mm_unpacklo_epi16(hi, zero));
+  _mm_storeu_si128((__m128i *) (escOffset + 12), _mm_unpackhi_epi16(hi, zero));
+#else
+  _mm_storeu_si128((__m128i *) (escOffset + 0), lo);
+  _mm_storeu_si128((__m128i *) (escOffset + 8), hi);
+#endif
+}
+
+static INLINE_PREFIX int StringSpecialMask16(__m128i chunk)
+{
+  // Signed compare, catches both control characters and bytes with the high bit set
+  __m128i special = _mm_or_si128(
+    _mm_cmplt_epi8(chunk, _mm_set1_epi8(0x20)),
+    _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\"')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))));
+
+  return _mm_movemask_epi8(special);
+}
+
+static const JSUINT8 *DecodeASCIIRunSSE2(const JSUINT8 *inputOffset, const JSUINT8 *end, wchar_t **pescOffset)
+{
+  wchar_t *escOffset = *pescOffset;
+
+  while (end - inputOffset >= 16)
+  {
+    __m128i chunk = _mm_loadu_si128((const __m128i *) inputOffset);
+    int mask = StringSpecialMask16(chunk);
+
+    WidenASCII16(escOffset, chunk);
+
+    if (mask)
+    {
+      int count = CountTrailingZeros((JSUINT32) mask);
+      *pescOffset = escOffset + count;
+      return inputOffset + count;
+    }
+
+    inputOffset += 16;
+    escOffset += 16;
+  }
+
+  *pescOffset = escOffset;
+  return inputOffset;
+}
+#endif
+
+#ifdef JSON_AVX2
+JSON_TARGET_AVX2 static const JSUINT8 *DecodeASCIIRunAVX2(const JSUINT8 *inputOffset, const JSUINT8 *end, wchar_t **pescOffset)
+{
+  wchar_t *escOffset = *pescOffset;
+
+  while (end - inputOffset >= 32)
+  {
+    __m256i chunk = _mm256_loadu_si256((const __m256i *) inputOffset);
+    __m256i special = _mm256_or_si256(
+      _mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), chunk),
+      _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\"')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'))));
+    JSUINT32 mask = (JSUINT32) _mm256_movemask_epi8(special);
+    __m128i lo = _mm256_castsi256_si128(chunk);
+    __m128i hi = _mm256_extracti128_si256(chunk, 1);
+
+#ifdef JSON_WCHAR_32
+    _mm256_storeu_si256((__m256i *) (escOffset + 0), _mm256_cvtepu8_epi32(lo));
+    _mm256_storeu_si256((__m256i *) (escOffset + 8), _mm256_cvtepu8_epi32(_mm_srli_si128(lo, 8)));
+    _mm256_storeu_si256((__m256i *) (escOffset + 16), _mm256_cvtepu8_epi32(hi));
+    _mm256_storeu_si256((__m256i *) (escOffset + 24), _mm256_cvtepu8_epi32(_mm_srli_si128(hi, 8)));
+#else
+    _mm256_storeu_si256((__m256i *) (escOffset + 0), _mm256_cvtepu8_epi16(lo));
+    _mm256_storeu_si256((__m256i *) (escOffset + 16), _mm256_cvtepu8_epi16(hi));
+#endif
+
+    if (mask)
+    {
+      int count = CountTrailingZeros(mask);
+      *pescOffset = escOffset + count;
+      return inputOffset + count;
+    }
+
+    inputOffset += 32;
+    escOffset += 32;
+  }
+
+  *pescOffset = escOffset;
+  return DecodeASCIIRunSSE2(inputOffset, end, pescOffset);
+}
+#endif
+
+#ifndef JSON_SSE2
+#define SWAR_ONES 0x0101010101010101ULL
+#define SWAR_HIGH 0x8080808080808080ULL
+
+/*
+Word at a time variant for targets without SSE2. Only the lowest flagged byte is exact,
+which is all that is needed to find the end of the run */
+static INLINE_PREFIX JSUINT64 StringSpecialMaskSWAR(JSUINT64 word)
+{
+  JSUINT64 quote = word ^ (SWAR_ONES * '\"');
+  JSUINT64 escape = word ^ (SWAR_ONES * '\\');
+
+  return (word | ((word - SWAR_ONES * 0x20) & ~word) |
+    ((quote - SWAR_ONES) & ~quote) |
+    ((escape - SWAR_ONES) & ~escape)) & SWAR_HIGH;
+}
+#endif
+
+static INLINE_PREFIX const JSUINT8 *DecodeASCIIRun(const JSUINT8 *inputOffset, const JSUINT8 *end, wchar_t **pescOffset)
+{
+#if defined(JSON_SSE2)
+  if (end - inputOffset < 16)
+  {
+    return inputOffset;
+  }
+
+#ifdef JSON_AVX2
+  if (end - inputOffset >= 32 && HasAVX2())
+  {
+    return DecodeASCIIRunAVX2(inputOffset, end, pescOffset);
+  }
+#endif
+  return DecodeASCIIRunSSE2(inputOffset, end, pescOffset);
+
+#elif defined(__LITTLE_ENDIAN__)
+  wchar_t *escOffset = *pescOffset;
+
+  while (end - inputOffset >= 8)
+  {
+    JSUINT64 word;
+    JSUINT64 mask;
+    int count;
+    int index;
+
+    memcpy(&word, inputOffset, sizeof(word));
+    mask = StringSpecialMaskSWAR(word);
+    count = mask ? (CountTrailingZeros64(mask) >> 3) : 8;
+
+    for (index = 0; index < count; index ++)
+    {
+      escOffset[index] = (wchar_t) inputOffset[index];
+    }
+
+    inputOffset += count;
+    escOffset += count;
+
+    if (count < 8)
+    {
+      break;
+    }
+  }
+
+  *pescOffset = escOffset;
+  return inputOffset;
+
+#else
+  return inputOffset;
+#endif
+}
+
+/*
+Grows the unescape buffer to hold at least newSize wchar_t. Moves it from the stack to the heap on first growth */
+static int ReserveEscBuffer(struct DecoderState *ds, size_t newSize)
+{
+  wchar_t *escStart;
+  size_t escLen = (ds->escEnd - ds->escStart);
+
+  if (newSize <= escLen)
+  {
+    return 1;
+  }
+
+  if (newSize > (UINT_MAX / sizeof(wchar_t)))
+  {
+    SetError(ds, -1, "Could not reserve memory block");
+    return 0;
+  }
+
+  if (ds->escHeap)
+  {
+    escStart = (wchar_t *)ds->dec->realloc(ds->escStart, newSize * sizeof(wchar_t));
+    if (!escStart)
+    {
+      ds->dec->free(ds->escStart);
+      ds->escStart = NULL;
+      ds->escEnd = NULL;
+      ds->escHeap = 0;
+      SetError(ds, -1, "Could not reserve memory block");
+      return 0;
+    }
+    ds->escStart = escStart;
+  }
+  else
+  {
+    wchar_t *oldStart = ds->escStart;
+    escStart = (wchar_t *) ds->dec->malloc(newSize * sizeof(wchar_t));
+    if (!escStart)
+    {
+      SetError(ds, -1, "Could not reserve memory block");
+      return 0;
+    }
+    memcpy(escStart, oldStart, escLen * sizeof(wchar_t));
+    ds->escStart = escStart;
+    ds->escHeap = 1;
+  }
+
+  ds->escEnd = ds->escStart + newSize;
+  return 1;
+}
+
+#ifdef JSON_SSE2
+static const JSUINT8 *FindStringSpecialSSE2(const JSUINT8 *inputOffset, const JSUINT8 *end)
+{
+  while (end - inputOffset >= 16)
+  {
+    int mask = StringSpecialMask16(_mm_loadu_si128((const __m128i *) inputOffset));
+
+    if (mask)
+    {
+      return inputOffset + CountTrailingZeros((JSUINT32) mask);
+    }
+
+    inputOffset += 16;
+  }
+
+  return inputOffset;
+}
+#endif
+
+#ifdef JSON_AVX2
+JSON_TARGET_AVX2 static const JSUINT8 *FindStringSpecialAVX2(const JSUINT8 *inputOffset, const JSUINT8 *end)
+{
+  while (end - inputOffset >= 32)
+  {
+    __m256i chunk = _mm256_loadu_si256((const __m256i *) inputOffset);
+    __m256i special = _mm256_or_si256(
+      _mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), chunk),
+      _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\"')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'))));
+    JSUINT32 mask = (JSUINT32) _mm256_movemask_epi8(special);
+
+    if (mask)
+    {
+      return inputOffset + CountTrailingZeros(mask);
+    }
+
+    inputOffset += 32;
+  }
+
+  return FindStringSpecialSSE2(inputOffset, end);
+}
+#endif
+
+/*
+Returns a pointer to the first quote, backslash, control character or non ASCII byte in [inputOffset, end),
+or end if there is none */
+static INLINE_PREFIX const JSUINT8 *FindStringSpecial(const JSUINT8 *inputOffset, const JSUINT8 *end)
+{
+#if defined(JSON_SSE2)
+#ifdef JSON_AVX2
+  if (end - inputOffset >= 32 && HasAVX2())
+  {
+    inputOffset = FindStringSpecialAVX2(inputOffset, end);
+  }
+  else
+#endif
+  inputOffset = FindStringSpecialSSE2(inputOffset, end);
+#elif defined(__LITTLE_ENDIAN__)
+  while (end - inputOffset >= 8)
+  {
+    JSUINT64 word;
+    JSUINT64 mask;
+
+    memcpy(&word, inputOffset, sizeof(word));
+    mask = StringSpecialMaskSWAR(word);
+
+    if (mask)
+    {
+      return inputOffset + (CountTrailingZeros64(mask) >> 3);
+    }
+
+    inputOffset += 8;
+  }
+#endif
+
+  while (inputOffset < end && *inputOffset >= 0x20 && *inputOffset < 0x80 && g_decoderLookup[*inputOffset] == 1)
+  {
+    inputOffset ++;
+  }
+
+  return inputOffset;
+}
+
+static INLINE_PREFIX int DecodeHexDigit(JSUINT8 chr)
+{
+  if (chr >= '0' && chr <= '9') return chr - '0';
+  if (chr >= 'a' && chr <= 'f') return 10 + chr - 'a';
+  if (chr >= 'A' && chr <= 'F') return 10 + chr - 'A';
+  return -1;
+}
+
+/*
+Decodes the four hex digits of a unicode escape. Returns -1 on error */
+static INLINE_PREFIX JSINT32 DecodeUnicodeEscape(struct DecoderState *ds, const JSUINT8 *inputOffset)
+{
+  JSINT32 value = 0;
+  int index;
+
+  for (index = 0; index < 4; index ++)
+  {
+    int digit = DecodeHexDigit(inputOffset[index]);
+
+    if (digit < 0)
+    {
+      SetError (ds, -1, inputOffset[index] == '\0' ?
+        "Unterminated unicode escape sequence when decoding 'string'" :
+        "Unexpected character in unicode escape sequence when decoding 'string'");
+      return -1;
+    }
+
+    value = (value << 4) | digit;
+  }
+
+  return value;
+}
+
+static INLINE_PREFIX char *EncodeUTF8(char *escOffset, JSUTF32 ucs)
+{
+  if (ucs < 0x80)
+  {
+    *(escOffset++) = (char) ucs;
+  }
+  else
+  if (ucs < 0x800)
+  {
+    *(escOffset++) = (char) (0xc0 | (ucs >> 6));
+    *(escOffset++) = (char) (0x80 | (ucs & 0x3f));
+  }
+  else
+  if (ucs < 0x10000)
+  {
+    *(escOffset++) = (char) (0xe0 | (ucs >> 12));
+    *(escOffset++) = (char) (0x80 | ((ucs >> 6) & 0x3f));
+    *(escOffset++) = (char) (0x80 | (ucs & 0x3f));
+  }
+  else
+  {
+    *(escOffset++) = (char) (0xf0 | (ucs >> 18));
+    *(escOffset++) = (char) (0x80 | ((ucs >> 12) & 0x3f));
+    *(escOffset++) = (char) (0x80 | ((ucs >> 6) & 0x3f));
+    *(escOffset++) = (char) (0x80 | (ucs & 0x3f));
+  }
+
+  return escOffset;
+}
+
+/*
+UTF-8 variant of decode_string used when JSONObjectDecoder.newUTF8String is set.
+Strings without escapes are validated in place and handed over as a range of the input buffer.
+The first escape moves the string into the unescape buffer, which is then used as a char buffer.
+Unescaped UTF-8 is never longer than its source so the buffer is reserved to the remaining input.
+In situ the input itself is the unescape buffer, the write offset trails the read offset */
+static JSOBJ decode_string_utf8 ( struct DecoderState *ds)
+{
+  const JSUINT8 *start = (const JSUINT8 *) ds->start + 1;
+  const JSUINT8 *end = (const JSUINT8 *) ds->end;
+  const JSUINT8 *inputOffset = start;
+  const JSUINT8 *copyOffset = start;
+  char *escStart = NULL;
+  char *escOffset = NULL;
+  JSUTF32 ucs;
+  int index;
+
+  ds->lastType = JT_INVALID;
+
+  for (;;)
+  {
+    inputOffset = FindStringSpecial(inputOffset, end);
+
+    switch (g_decoderLookup[*inputOffset])
+    {
+      case DS_ISNULL:
+      {
+        return SetError(ds, -1, "Unmatched ''\"' when when decoding 'string'");
+      }
+
+      case DS_ISQUOTE:
+      {
+        ds->lastType = JT_UTF8;
+        ds->start = (char *) inputOffset + 1;
+
+        if (escStart == NULL)
+        {
+          if (ds->dec->inSitu)
+          {
+            *((char *) inputOffset) = '\0';
+          }
+
+          return ds->dec->newUTF8String(ds->prv, (char *) start, (char *) inputOffset);
+        }
+
+        memmove(escOffset, copyOffset, inputOffset - copyOffset);
+        escOffset += inputOffset - copyOffset;
+
+        if (ds->dec->inSitu)
+        {
+          *escOffset = '\0';
+        }
+
+        return ds->dec->newUTF8String(ds->prv, escStart, escOffset);
+      }
+
+      case DS_UTFLENERROR:
+      {
+        return SetError (ds, -1, "Invalid UTF-8 sequence length when decoding 'string'");
+      }
+
+      case DS_ISESCAPE:
+      {
+        if (escStart == NULL)
+        {
+          if (ds->dec->inSitu)
+          {
+            escStart = escOffset = (char *) copyOffset;
+          }
+          else
+          {
+            if (!ReserveEscBuffer(ds, ((end - start) + sizeof(wchar_t) - 1) / sizeof(wchar_t)))
+            {
+              return NULL;
+            }
+
+            escStart = escOffset = (char *) ds->escStart;
+          }
+        }
+
+        memmove(escOffset, copyOffset, inputOffset - copyOffset);
+        escOffset += inputOffset - copyOffset;
+        inputOffset ++;
+
+        switch (*inputOffset)
+        {
+          case '\\': *(escOffset++) = '\\'; inputOffset++; break;
+          case '\"': *(escOffset++) = '\"'; inputOffset++; break;
+          case '/':  *(escOffset++) = '/';  inputOffset++; break;
+          case 'b':  *(escOffset++) = '\b'; inputOffset++; break;
+          case 'f':  *(escOffset++) = '\f'; inputOffset++; break;
+          case 'n':  *(escOffset++) = '\n'; inputOffset++; break;
+          case 'r':  *(escOffset++) = '\r'; inputOffset++; break;
+          case 't':  *(escOffset++) = '\t'; inputOffset++; break;
+
+          case 'u':
+          {
+            JSINT32 sur = DecodeUnicodeEscape(ds, inputOffset + 1);
+
+            if (sur < 0)
+            {
+              return NULL;
+            }
+
+            inputOffset += 5;
+            ucs = (JSUTF32) sur;
+
+            if ((sur & 0xfc00) == 0xd800)
+            {
+              JSINT32 low;
+
+              if (inputOffset[0] != '\\' || inputOffset[1] != 'u')
+              {
+                return SetError (ds, -1, "Unpaired high surrogate when decoding 'string'");
+              }
+
+              low = DecodeUnicodeEscape(ds, inputOffset + 2);
+
+              if (low < 0)
+              {
+                return NULL;
+              }
+
+              if ((low & 0xfc00) != 0xdc00)
+              {
+                return SetError (ds, -1, "Unpaired high surrogate when decoding 'string'");
+              }
+
+              inputOffset += 6;
+              ucs = 0x10000 + (((JSUTF32) (sur - 0xd800) << 10) | (JSUTF32) (low - 0xdc00));
+            }
+
+            escOffset = EncodeUTF8(escOffset, ucs);
+            break;
+          }
+
+          case '\0': return SetError(ds, -1, "Unterminated escape sequence when decoding 'string'");
+          default: return SetError(ds, -1, "Unrecognized escape sequence when decoding 'string'");
+        }
+
+        copyOffset = inputOffset;
+        break;
+      }
+
+      case 1:
+      {
+        // Control characters are accepted as is, a continuation byte without a lead byte is not
+        if (*inputOffset >= 0x80)
+        {
+          return SetError(ds, -1, "Invalid octet in UTF-8 sequence when decoding 'string'");
+        }
+
+        inputOffset ++;
+        break;
+      }
+
+      case 2:
+      {
+        if ((inputOffset[1] & 0xc0) != 0x80)
+        {
+          return SetError(ds, -1, "Invalid octet in UTF-8 sequence when decoding 'string'");
+        }
+
+        ucs = ((inputOffset[0] & 0x1f) << 6) | (inputOffset[1] & 0x3f);
+        if (ucs < 0x80) return SetError (ds, -1, "Overlong 2 byte UTF-8 sequence detected when decoding 'string'");
+        inputOffset += 2;
+        break;
+      }
+
+      case 3:
+      case 4:
+      {
+        int count = g_decoderLookup[*inputOffset];
+        ucs = inputOffset[0] & (count == 3 ? 0x0f : 0x07);
+
+        for (index = 1; index < count; index ++)
+        {
+          if ((inputOffset[index] & 0xc0) != 0x80)
+          {
+            return SetError(ds, -1, "Invalid octet in UTF-8 sequence when decoding 'string'");
+          }
+
+          ucs = (ucs << 6) | (inputOffset[index] & 0x3f);
+        }
+
+        if (count == 3 && ucs < 0x800) return SetError (ds, -1, "Overlong 3 byte UTF-8 sequence detected when encoding string");
+        if (count == 4 && ucs < 0x10000) return SetError (ds, -1, "Overlong 4 byte UTF-8 sequence detected when decoding 'string'");
+        inputOffset += count;
+        break;
+      }
+    }
+  }
+}
+
+FASTCALL_ATTR JSOBJ FASTCALL_MSVC decode_string ( struct DecoderState *ds)
+{
+  JSUTF16 sur[2] = { 0 };
+  int iSur = 0;
+  int index;
+  wchar_t *escOffset;
+  JSUINT8 *inputOffset;
+  JSUINT8 oct;
+  JSUTF32 ucs;
+
+  if (ds->dec->newUTF8String)
+  {
+    return decode_string_utf8(ds);
+  }
+
+  ds->lastType = JT_INVALID;
+  ds->start ++;
+
+  if (!ReserveEscBuffer(ds, ds->end - ds->start))
+  {
+    return NULL;
+  }
+
+  escOffset = ds->escStart;
+  inputOffset = (JSUINT8 *) ds->start;
+
+  for (;;)
+  {
+    switch (g_decoderLookup[(JSUINT8)(*inputOffset)])
+    {
+      case DS_ISNULL:
+      {
+        return SetError(ds, -1, "Unmatched ''\"' when when decoding 'string'");
+      }
+      case DS_ISQUOTE:
+      {
+        ds->lastType = JT_UTF8;
+        inputOffset ++;
+        ds->start += ( (char *) inputOffset - (ds->start));
+        return ds->dec->newString(ds->prv, ds->escStart, escOffset);
+      }
+      case DS_UTFLENERROR:
+      {
+        return SetError (ds, -1, "Invalid UTF-8 sequence length when decoding 'string'");
+      }
+      case DS_ISESCAPE:
+        inputOffset ++;
+        switch (*inputOffset)
+        {
+          case '\\': *(escOffset++) = L'\\'; inputOffset++; continue;
+          case '\"': *(escOffset++) = L'\"'; inputOffset++; continue;
+          case '/':  *(escOffset++) = L'/';  inputOffset++; continue;
+          case 'b':  *(escOffset++) = L'\b'; inputOffset++; continue;
+          case 'f':  *(escOffset++) = L'\f'; inputOffset++; continue;
+          case 'n':  *(escOffset++) = L'\n'; inputOffset++; continue;
+          case 'r':  *(escOffset++) = L'\r'; inputOffset++; continue;
+          case 't':  *(escOffset++) = L'\t'; inputOffset++; continue;
+
+          case 'u':
+          {
+            int index;
+            inputOffset ++;
+
+            for (index = 0; index < 4; index ++)
+            {
+              switch (*inputOffset)
+              {
+                case '\0': return SetError (ds, -1, "Unterminated unicode escape sequence when decoding 'string'");
+                default: return SetError (ds, -1, "Unexpected character in unicode escape sequence when decoding 'string'");
+
+                case '0':
+                case '1':
+                case '2':
+                case '3':
+                case '4':
+                case '5':
+                case '6':
+                case '7':
+                case '8':
+                case '9':
+                  sur[iSur] = (sur[iSur] << 4) + (JSUTF16) (*inputOffset - '0');
+                  break;
+
+                case 'a':
+                case 'b':
+                case 'c':
+                case 'd':
+                case 'e':
+                case 'f':
+                  sur[iSur] = (sur[iSur] << 4) + 10 + (JSUTF16) (*inputOffset - 'a');
+                  break;
+
+                case 'A':
+                case 'B':
+                case 'C':
+                case 'D':
+                case 'E':
+                case 'F':
+                  sur[iSur] = (sur[iSur] << 4) + 10 + (JSUTF16) (*inputOffset - 'A');
+                  break;
+              }
+
+              inputOffset ++;
+            }
+
+            if (iSur == 0)
+            {
+              if((sur[iSur] & 0xfc00) == 0xd800)
+              {
+                // First of a surrogate pair, continue parsing
+                iSur ++;
+                break;
+              }
+              (*escOffset++) = (wchar_t) sur[iSur];
+              iSur = 0;
+            }
+            else
+            {
+              // Decode pair
+              if ((sur[1] & 0xfc00) != 0xdc00)
+              {
+                return SetError (ds, -1, "Unpaired high surrogate when decoding 'string'");
+              }
+#if WCHAR_MAX == 0xffff
+              (*escOffset++) = (wchar_t) sur[0];
+              (*escOffset++) = (wchar_t) sur[1];
+#else
+              (*escOffset++) = (wchar_t) 0x10000 + (((sur[0] - 0xd800) << 10) | (sur[1] - 0xdc00));
+#endif
+              iSur = 0;
+            }
+          break;
+        }
+
+        case '\0': return SetError(ds, -1, "Unterminated escape sequence when decoding 'string'");
+        default: return SetError(ds, -1, "Unrecognized escape sequence when decoding 'string'");
+      }
+      break;
+
+      case 1:
+      {
+        *(escOffset++) = (wchar_t) (*inputOffset++);
+        inputOffset = (JSUINT8 *) DecodeASCIIRun(inputOffset, (JSUINT8 *) ds->end, &escOffset);
+        break;
+      }
+
+      case 2:
+      {
+        ucs = (*inputOffset++) & 0x1f;
+        ucs <<= 6;
+        if (((*inputOffset) & 0x80) != 0x80)
+        {
+          return SetError(ds, -1, "Invalid octet in UTF-8 sequence when decoding 'string'");
+        }
+        ucs |= (*inputOffset++) & 0x3f;
+        if (ucs < 0x80) return SetError (ds, -1, "Overlong 2 byte UTF-8 sequence detected when decoding 'string'");
+        *(escOffset++) = (wchar_t) ucs;
+        break;
+      }
+
+      case 3:
+      {
+        JSUTF32 ucs = 0;
+        ucs |= (*inputOffset++) & 0x0f;
+
+        for (index = 0; index < 2; index ++)
+        {
+          ucs <<= 6;
+          oct = (*inputOffset++);
+
+          if ((oct & 0x80) != 0x80)
+          {
+            return SetError(ds, -1, "Invalid octet in UTF-8 sequence when decoding 'string'");
+          }
+
+          ucs |= oct & 0x3f;
+        }
+
+        if (ucs < 0x800) return SetError (ds, -1, "Overlong 3 byte UTF-8 sequence detected when encoding string");
+        *(escOffset++) = (wchar_t) ucs;
+        break;
+      }
+
+      case 4:
+      {
+        JSUTF32 ucs = 0;
+        ucs |= (*inputOffset++) & 0x07;
+
+        for (index = 0; index < 3; index ++)
+        {
+          ucs <<= 6;
+          oct = (*inputOffset++);
+
+          if ((oct & 0x80) != 0x80)
+          {
+            return SetError(ds, -1, "Invalid octet in UTF-8 sequence when decoding 'string'");
+          }
+
+          ucs |= oct & 0x3f;
+        }
+
+        if (ucs < 0x10000) return SetError (ds, -1, "Overlong 4 byte UTF-8 sequence detected when decoding 'string'");
+
+#if WCHAR_MAX == 0xffff
+        if (ucs >= 0x10000)
+        {
+          ucs -= 0x10000;
+          *(escOffset++) = (wchar_t) (ucs >> 10) + 0xd800;
+          *(escOffset++) = (wchar_t) (ucs & 0x3ff) + 0xdc00;
+        }
+        else
+        {
+          *(escOffset++) = (wchar_t) ucs;
+        }
+#else
+        *(escOffset++) = (wchar_t) ucs;
+#endif
+        break;
+      }
+    }
+  }
+}
+
+/*
+Tell the decoder that an array or object is complete, after its last element or member and before it
+is added to its parent */
+static INLINE_PREFIX JSOBJ EndArray(struct DecoderState *ds, JSOBJ obj)
+{
+  if (ds->dec->endArray)
+  {
+    ds->dec->endArray(ds->prv, obj);
+  }
+
+  return obj;
+}
+
+static INLINE_PREFIX JSOBJ EndObject(struct DecoderState *ds, JSOBJ obj)
+{
+  if (ds->dec->endObject)
+  {
+    ds->dec->endObject(ds->prv, obj);
+  }
+
+  return obj;
+}
+
+/*
+Lets the decoder replace a key that was just decoded, before its value is */
+static INLINE_PREFIX JSOBJ ObjectKey(struct DecoderState *ds, JSOBJ name)
+{
+  return ds->dec->objectKey ? ds->dec->objectKey(ds->prv, name) : name;
+}
+
+FASTCALL_ATTR JSOBJ FASTCALL_MSVC decode_array(struct DecoderState *ds)
+{
+  JSOBJ itemValue;
+  JSOBJ newObj;
+  int len;
+  ds->objDepth++;
+  if (ds->objDepth > ds->objDepthMax) {
+    return SetError(ds, -1, "Reached object decoding depth limit");
+  }
+
+  newObj = ds->dec->newArray(ds->prv);
+  len = 0;
+
+  ds->lastType = JT_INVALID;
+  ds->start ++;
+
+  for (;;)
+  {
+    SkipWhitespace(ds);
+
+    if ((*ds->start) == ']')
+    {
+      ds->objDepth--;
+      if (len == 0)
+      {
+        ds->start ++;
+        return EndArray(ds, newObj);
+      }
+
+      ds->dec->releaseObject(ds->prv, newObj);
+      return SetError(ds, -1, "Unexpected character found when decoding array value (1)");
+    }
+
+    itemValue = decode_any(ds);
+
+    if (itemValue == NULL)
+    {
+      ds->dec->releaseObject(ds->prv, newObj);
+      return NULL;
+    }
+
+    ds->dec->arrayAddItem (ds->prv, newObj, itemValue);
+
+    SkipWhitespace(ds);
+
+    switch (*(ds->start++))
+    {
+    case ']':
+    {
+      ds->objDepth--;
+      return EndArray(ds, newObj);
+    }
+    case ',':
+      break;
+
+    default:
+      ds->dec->releaseObject(ds->prv, newObj);
+      return SetError(ds, -1, "Unexpected character found when decoding array value (2)");
+    }
+
+    len ++;
+  }
+}
+
+FASTCALL_ATTR JSOBJ FASTCALL_MSVC decode_object( struct DecoderState *ds)
+{
+  JSOBJ itemName;
+  JSOBJ itemValue;
+  JSOBJ newObj;
+
+  ds->objDepth++;
+  if (ds->objDepth > ds->objDepthMax) {
+    return SetError(ds, -1, "Reached object decoding depth limit");
+  }
+
+  newObj = ds->dec->newObject(ds->prv);
+
+  ds->start ++;
+
+  for (;;)
+  {
+    SkipWhitespace(ds);
+
+    if ((*ds->start) == '}')
+    {
+      ds->objDepth--;
+      ds->start ++;
+      return EndObject(ds, newObj);
+    }
+
+    if ((*ds->start) == '[' || (*ds->start) == '{')
+    {
+      // Would be decoded as a value, and a nested string could leave lastType at JT_UTF8
+      ds->dec->releaseObject(ds->prv, newObj);
+      return SetError(ds, -1, "Key name of object must be 'string' when decoding 'object'");
+    }
+
+    ds->lastType = JT_INVALID;
+    itemName = decode_any(ds);
+
+    if (itemName == NULL)
+    {
+      ds->dec->releaseObject(ds->prv, newObj);
+      return NULL;
+    }
+
+    if (ds->lastType != JT_UTF8)
+    {
+      ds->dec->releaseObject(ds->prv, newObj);
+      ds->dec->releaseObject(ds->prv, itemName);
+      return SetError(ds, -1, "Key name of object must be 'string' when decoding 'object'");
+    }
+
+    itemName = ObjectKey(ds, itemName);
+
+    SkipWhitespace(ds);
+
+    if (*(ds->start++) != ':')
+    {
+      ds->dec->releaseObject(ds->prv, newObj);
+      ds->dec->releaseObject(ds->prv, itemName);
+      return SetError(ds, -1, "No ':' found when decoding object value");
+    }
+
+    SkipWhitespace(ds);
+
+    itemValue = decode_any(ds);
+
+    if (itemValue == NULL)
+    {
+      ds->dec->releaseObject(ds->prv, newObj);
+      ds->dec->releaseObject(ds->prv, itemName);
+      return NULL;
+    }
+
+    ds->dec->objectAddKey (ds->prv, newObj, itemName, itemValue);
+
+    SkipWhitespace(ds);
+
+    switch (*(ds->start++))
+    {
+      case '}':
+      {
+        ds->objDepth--;
+        return EndObject(ds, newObj);
+      }
+      case ',':
+        break;
+
+      default:
+        ds->dec->releaseObject(ds->prv, newObj);
+        return SetError(ds, -1, "Unexpected character in found when decoding object value");
+    }
+  }
+}
+
+FASTCALL_ATTR JSOBJ FASTCALL_MSVC decode_any(struct DecoderState *ds)
+{
+  for (;;)
+  {
+    switch (*ds->start)
+    {
+      case '\"':
+        return decode_string (ds);
+      case '0':
+      case '1':
+      case '2':
+      case '3':
+      case '4':
+      case '5':
+      case '6':
+      case '7':
+      case '8':
+      case '9':
+      case '-':
+        return decode_numeric (ds);
+
+      case '[': return decode_array (ds);
+      case '{': return decode_object (ds);
+      case 't': return decode_true (ds);
+      case 'f': return decode_false (ds);
+      case 'n': return decode_null (ds);
+
+      case ' ':
+      case '\t':
+      case '\r':
+      case '\n':
+        // White space
+        SkipWhitespace(ds);
+
+        if (ds->start >= ds->end)
+        {
+          return SetError(ds, -1, "Expected object or value");
+        }
+        break;
+
+      default:
+        return SetError(ds, -1, "Expected object or value");
+    }
+  }
+}
+
+/*
+Open container of the iterative decoder. name is the pending key of an object, NULL for arrays
+and between the members of an object */
+typedef struct __DecodeFrame
+{
+  JSOBJ obj;
+  JSOBJ name;
+  int isObject;
+} DecodeFrame;
+
+/*
+Doubles the capacity of a frame stack, moving it off the C stack the first time. On failure the
+error is set and NULL is returned, the old frames stay valid */
+static DecodeFrame *GrowFrames(struct DecoderState *ds, DecodeFrame *frames, DecodeFrame *stackFrames, JSUINT32 *capacity)
+{
+  DecodeFrame *newFrames;
+
+  if (frames == stackFrames)
+  {
+    newFrames = (DecodeFrame *) ds->dec->malloc(*capacity * 2 * sizeof(DecodeFrame));
+
+    if (newFrames)
+    {
+      memcpy(newFrames, frames, *capacity * sizeof(DecodeFrame));
+    }
+  }
+  else
+  {
+    newFrames = (DecodeFrame *) ds->dec->realloc(frames, *capacity * 2 * sizeof(DecodeFrame));
+  }
+
+  if (!newFrames)
+  {
+    SetError(ds, -1, "Could not reserve memory block");
+    return NULL;
+  }
+
+  *capacity *= 2;
+  return newFrames;
+}
+
+/*
+Decodes a scalar value, anything but an array or object */
+static JSOBJ decode_scalar(struct DecoderState *ds)
+{
+  switch (*ds->start)
+  {
+    case '\"':
+      return decode_string (ds);
+    case '0':
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+    case '-':
+      return decode_numeric (ds);
+
+    case 't': return decode_true (ds);
+    case 'f': return decode_false (ds);
+    case 'n': return decode_null (ds);
+
+    default:
+      return SetError(ds, -1, "Expected object or value");
+  }
+}
+
+/*
+Non-recursive variant of decode_any used when JSONObjectDecoder.iterative is set. Open arrays and objects
+are kept on an explicit stack, starting out on the C stack and moving to the heap when it runs full, so
+the nesting depth is only limited by objDepthMax. Accepts and rejects exactly what decode_any does */
+static JSOBJ decode_iterative(struct DecoderState *ds)
+{
+  DecodeFrame stackFrames[JSON_ITERATIVE_STACK_FRAMES];
+  DecodeFrame *frames = stackFrames;
+  DecodeFrame *top;
+  JSUINT32 capacity = JSON_ITERATIVE_STACK_FRAMES;
+  JSUINT32 depth = 0;
+  JSOBJ value;
+  JSOBJ ret = NULL;
+  char chr;
+
+  for (;;)
+  {
+    // Decode a value, descending into any arrays and objects it starts with
+    SkipWhitespace(ds);
+
+    if (ds->start >= ds->end)
+    {
+      SetError(ds, -1, "Expected object or value");
+      goto ERROR;
+    }
+
+    chr = *ds->start;
+
+    if (chr == '[' || chr == '{')
+    {
+      if (depth >= ds->objDepthMax)
+      {
+        SetError(ds, -1, "Reached object decoding depth limit");
+        goto ERROR;
+      }
+
+      if (depth == capacity)
+      {
+        DecodeFrame *newFrames = GrowFrames(ds, frames, stackFrames, &capacity);
+
+        if (!newFrames)
+        {
+          goto ERROR;
+        }
+
+        frames = newFrames;
+      }
+
+      top = &frames[depth++];
+      top->isObject = (chr == '{');
+      top->obj = top->isObject ? ds->dec->newObject(ds->prv) : ds->dec->newArray(ds->prv);
+      top->name = NULL;
+
+      ds->lastType = JT_INVALID;
+      ds->start ++;
+      SkipWhitespace(ds);
+
+      if (*ds->start == (top->isObject ? '}' : ']'))
+      {
+        ds->start ++;
+        value = top->isObject ? EndObject(ds, top->obj) : EndArray(ds, top->obj);
+        depth --;
+        goto HAVE_VALUE;
+      }
+
+      if (top->isObject)
+      {
+        goto DECODE_KEY;
+      }
+
+      continue;
+    }
+
+    value = decode_scalar(ds);
+
+    if (value == NULL)
+    {
+      goto ERROR;
+    }
+
+HAVE_VALUE:
+    // Add the value to its parent and close every container that ends right after it
+    for (;;)
+    {
+      if (depth == 0)
+      {
+        ret = value;
+        goto DONE;
+      }
+
+      top = &frames[depth - 1];
+
+      if (top->isObject)
+      {
+        ds->dec->objectAddKey (ds->prv, top->obj, top->name, value);
+        top->name = NULL;
+      }
+      else
+      {
+        ds->dec->arrayAddItem (ds->prv, top->obj, value);
+      }
+
+      SkipWhitespace(ds);
+      chr = *(ds->start++);
+
+      if (chr == (top->isObject ? '}' : ']'))
+      {
+        value = top->isObject ? EndObject(ds, top->obj) : EndArray(ds, top->obj);
+        depth --;
+        continue;
+      }
+
+      if (chr != ',')
+      {
+        SetError(ds, -1, top->isObject ? "Unexpected character in found when decoding object value" :
+          "Unexpected character found when decoding array value (2)");
+        goto ERROR;
+      }
+
+      break;
+    }
+
+    if (!top->isObject)
+    {
+      SkipWhitespace(ds);
+
+      if (*ds->start == ']')
+      {
+        SetError(ds, -1, "Unexpected character found when decoding array value (1)");
+        goto ERROR;
+      }
+
+      continue;
+    }
+
+    SkipWhitespace(ds);
+
+    if (*ds->start == '}')
+    {
+      ds->start ++;
+      value = EndObject(ds, top->obj);
+      depth --;
+      goto HAVE_VALUE;
+    }
+
+DECODE_KEY:
+    ds->lastType = JT_INVALID;
+
+    if (*ds->start == '[' || *ds->start == '{')
+    {
+      SetError(ds, -1, "Key name of object must be 'string' when decoding 'object'");
+      goto ERROR;
+    }
+
+    top->name = decode_scalar(ds);
+
+    if (top->name == NULL)
+    {
+      goto ERROR;
+    }
+
+    if (ds->lastType != JT_UTF8)
+    {
+      SetError(ds, -1, "Key name of object must be 'string' when decoding 'object'");
+      goto ERROR;
+    }
+
+    top->name = ObjectKey(ds, top->name);
+
+    SkipWhitespace(ds);
+
+    if (*(ds->start++) != ':')
+    {
+      SetError(ds, -1, "No ':' found when decoding object value");
+      goto ERROR;
+    }
+  }
+
+ERROR:
+  while (depth > 0)
+  {
+    top = &frames[--depth];
+
+    if (top->name)
+    {
+      ds->dec->releaseObject(ds->prv, top->name);
+    }
+
+    ds->dec->releaseObject(ds->prv, top->obj);
+  }
+
+DONE:
+  if (frames != stackFrames)
+  {
+    ds->dec->free(frames);
+  }
+
+  return ret;
+}
+
+/*
+Reports an event, failing with an error if the handler stops decoding */
+static int emit_event(struct DecoderState *ds, int type, JSOBJ obj)
+{
+  if (ds->dec->event(ds->prv, type, obj))
+  {
+    SetError(ds, -1, "Decoding stopped by event handler");
+    return 0;
+  }
+
+  return 1;
+}
+
+/*
+Walks the document like decode_iterative but reports it through JSONObjectDecoder.event instead of
+adding values to their containers. Containers are only kept on the frame stack while they are open */
+static JSOBJ decode_events(struct DecoderState *ds)
+{
+  DecodeFrame stackFrames[JSON_ITERATIVE_STACK_FRAMES];
+  DecodeFrame *frames = stackFrames;
+  DecodeFrame *top;
+  JSUINT32 capacity = JSON_ITERATIVE_STACK_FRAMES;
+  JSUINT32 depth = 0;
+  JSOBJ value;
+  JSOBJ ret = NULL;
+  char chr;
+
+  for (;;)
+  {
+    SkipWhitespace(ds);
+
+    if (ds->start >= ds->end)
+    {
+      SetError(ds, -1, "Expected object or value");
+      goto DONE;
+    }
+
+    chr = *ds->start;
+
+    if (chr == '[' || chr == '{')
+    {
+      if (depth >= ds->objDepthMax)
+      {
+        SetError(ds, -1, "Reached object decoding depth limit");
+        goto DONE;
+      }
+
+      if (depth == capacity)
+      {
+        DecodeFrame *newFrames = GrowFrames(ds, frames, stackFrames, &capacity);
+
+        if (!newFrames)
+        {
+          goto DONE;
+        }
+
+        frames = newFrames;
+      }
+
+      top = &frames[depth++];
+      top->isObject = (chr == '{');
+      top->obj = top->isObject ? ds->dec->newObject(ds->prv) : ds->dec->newArray(ds->prv);
+
+      if (!emit_event(ds, top->isObject ? JE_BEGIN_OBJECT : JE_BEGIN_ARRAY, top->obj))
+      {
+        goto DONE;
+      }
+
+      ds->lastType = JT_INVALID;
+      ds->start ++;
+      SkipWhitespace(ds);
+
+      if (*ds->start == (top->isObject ? '}' : ']'))
+      {
+        ds->start ++;
+        goto END_CONTAINER;
+      }
+
+      if (top->isObject)
+      {
+        goto DECODE_KEY;
+      }
+
+      continue;
+    }
+
+    value = decode_scalar(ds);
+
+    if (value == NULL || !emit_event(ds, JE_VALUE, value))
+    {
+      goto DONE;
+    }
+
+    if (depth == 0)
+    {
+      ret = value;
+      goto DONE;
+    }
+
+    // Close every container that ends right after the value
+    for (;;)
+    {
+      top = &frames[depth - 1];
+      SkipWhitespace(ds);
+      chr = *(ds->start++);
+
+      if (chr == ',')
+      {
+        break;
+      }
+
+      if (chr != (top->isObject ? '}' : ']'))
+      {
+        SetError(ds, -1, top->isObject ? "Unexpected character in found when decoding object value" :
+          "Unexpected character found when decoding array value (2)");
+        goto DONE;
+      }
+
+END_CONTAINER:
+      top = &frames[--depth];
+
+      if (!emit_event(ds, top->isObject ? JE_END_OBJECT : JE_END_ARRAY, top->obj))
+      {
+        goto DONE;
+      }
+
+      if (depth == 0)
+      {
+        ret = top->obj;
+        goto DONE;
+      }
+    }
+
+    if (!top->isObject)
+    {
+      SkipWhitespace(ds);
+
+      if (*ds->start == ']')
+      {
+        SetError(ds, -1, "Unexpected character found when decoding array value (1)");
+        goto DONE;
+      }
+
+      continue;
+    }
+
+    SkipWhitespace(ds);
+
+    if (*ds->start == '}')
+    {
+      ds->start ++;
+      goto END_CONTAINER;
+    }
+
+DECODE_KEY:
+    ds->lastType = JT_INVALID;
+
+    if (*ds->start == '[' || *ds->start == '{')
+    {
+      SetError(ds, -1, "Key name of object must be 'string' when decoding 'object'");
+      goto DONE;
+    }
+
+    value = decode_scalar(ds);
+
+    if (value == NULL)
+    {
+      goto DONE;
+    }
+
+    if (ds->lastType != JT_UTF8)
+    {
+      SetError(ds, -1, "Key name of object must be 'string' when decoding 'object'");
+      goto DONE;
+    }
+
+    if (!emit_event(ds, JE_KEY, value))
+    {
+      goto DONE;
+    }
+
+    SkipWhitespace(ds);
+
+    if (*(ds->start++) != ':')
+    {
+      SetError(ds, -1, "No ':' found when decoding object value");
+      goto DONE;
+    }
+  }
+
+DONE:
+  if (frames != stackFrames)
+  {
+    ds->dec->free(frames);
+  }
+
+  return ret;
+}
+
+/*
+Two stage decoding. Stage 1 scans the input 64 bytes at a time and records the offset of every
+structural character ({}[]:,), every opening quote and the first byte of every other value in an
+index. Quotes preceded by an odd run of backslashes are escaped and everything from an opening to a
+closing quote is masked out, so the index never points into a string. Stage 2 walks the index and
+only reads the bytes of the tokens it points at, whitespace is never looked at.
+
+See "Parsing Gigabytes of JSON per Second", Geoff Langdale and Daniel Lemire, 2019 */
+
+/*
+Character classes of a 64 byte block, bit N stands for byte N */
+struct StructuralMasks
+{
+  JSUINT64 backslash;
+  JSUINT64 quote;
+  JSUINT64 whitespace;
+  JSUINT64 op;
+};
+
+/*
+Carried from one block to the next. escaped is 1 if the first byte of the next block is escaped,
+inString all ones if the next block starts inside a string and scalar 1 if the last byte was part of
+a value other than a string */
+struct StructuralScanner
+{
+  JSUINT64 escaped;
+  JSUINT64 inString;
+  JSUINT64 scalar;
+};
+
+#ifndef JSON_SSE2
+static void StructuralMasksScalar(const char *block, struct StructuralMasks *masks)
+{
+  int index;
+
+  masks->backslash = masks->quote = masks->whitespace = masks->op = 0;
+
+  for (index = 0; index < 64; index ++)
+  {
+    JSUINT64 bit = 1ULL << index;
+
+    switch (block[index])
+    {
+      case '\\': masks->backslash |= bit; break;
+      case '\"': masks->quote |= bit; break;
+
+      case ' ':
+      case '\t':
+      case '\r':
+      case '\n':
+        masks->whitespace |= bit;
+        break;
+
+      case '{':
+      case '}':
+      case '[':
+      case ']':
+      case ':':
+      case ',':
+        masks->op |= bit;
+        break;
+    }
+  }
+}
+
+#endif
+
+#ifdef JSON_SSE2
+static INLINE_PREFIX void StructuralMasksSSE2(const char *block, struct StructuralMasks *masks)
+{
+  int index;
+
+  masks->backslash = masks->quote = masks->whitespace = masks->op = 0;
+
+  for (index = 0; index < 4; index ++)
+  {
+    __m128i chunk = _mm_loadu_si128((const __m128i *) (block + index * 16));
+    // Setting bit 5 folds '[' and ']' onto '{' and '}'
+    __m128i folded = _mm_or_si128(chunk, _mm_set1_epi8(0x20));
+    __m128i ws = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))),
+      _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))));
+    __m128i op = _mm_or_si128(
+      _mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')), _mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))),
+      _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(':')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8(','))));
+    int shift = index * 16;
+
+    masks->backslash |= (JSUINT64) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))) << shift;
+    masks->quote |= (JSUINT64) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\"'))) << shift;
+    masks->whitespace |= (JSUINT64) _mm_movemask_epi8(ws) << shift;
+    masks->op |= (JSUINT64) _mm_movemask_epi8(op) << shift;
+  }
+}
+#endif
+
+#ifdef JSON_AVX2
+JSON_TARGET_AVX2 static INLINE_PREFIX void StructuralMasksAVX2(const char *block, struct StructuralMasks *masks)
+{
+  int index;
+
+  masks->backslash = masks->quote = masks->whitespace = masks->op = 0;
+
+  for (index = 0; index < 2; index ++)
+  {
+    __m256i chunk = _mm256_loadu_si256((const __m256i *) (block + index * 32));
+    __m256i folded = _mm256_or_si256(chunk, _mm256_set1_epi8(0x20));
+    __m256i ws = _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n'))),
+      _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t'))));
+    __m256i op = _mm256_or_si256(
+      _mm256_or_si256(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{')), _mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}'))),
+      _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(':')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(','))));
+    int shift = index * 32;
+
+    masks->backslash |= (JSUINT64) (JSUINT32) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'))) << shift;
+    masks->quote |= (JSUINT64) (JSUINT32) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\"'))) << shift;
+    masks->whitespace |= (JSUINT64) (JSUINT32) _mm256_movemask_epi8(ws) << shift;
+    masks->op |= (JSUINT64) (JSUINT32) _mm256_movemask_epi8(op) << shift;
+  }
+}
+#endif
+
+/*
+Each bit becomes the xor of itself and all lower bits, turning quote positions into a mask that is
+set from each opening quote up to but not including its closing quote */
+static INLINE_PREFIX JSUINT64 PrefixXor(JSUINT64 bits)
+{
+  bits ^= bits << 1;
+  bits ^= bits << 2;
+  bits ^= bits << 4;
+  bits ^= bits << 8;
+  bits ^= bits << 16;
+  bits ^= bits << 32;
+  return bits;
+}
+
+/*
+Returns the bytes escaped by a backslash, those right after an odd length run of backslashes.
+Adding the odd positioned run starts to the backslashes carries those runs away, the runs left
+over started on an even position and flip which positions after a backslash are escaped */
+static INLINE_PREFIX JSUINT64 FindEscaped(struct StructuralScanner *sc, JSUINT64 backslash)
+{
+  const JSUINT64 evenBits = 0x5555555555555555ULL;
+  JSUINT64 followsEscape;
+  JSUINT64 oddStarts;
+  JSUINT64 evenRuns;
+
+  // A backslash escaped by the previous block starts no run
+  backslash &= ~sc->escaped;
+  followsEscape = (backslash << 1) | sc->escaped;
+  oddStarts = backslash & ~evenBits & ~followsEscape;
+  evenRuns = oddStarts + backslash;
+  sc->escaped = evenRuns < backslash ? 1 : 0;
+
+  return (evenBits ^ (evenRuns << 1)) & followsEscape;
+}
+
+static INLINE_PREFIX JSUINT32 *IndexBlock(struct StructuralScanner *sc, const struct StructuralMasks *masks, JSUINT32 offset, JSUINT32 *out)
+{
+  JSUINT64 quote = masks->quote & ~FindEscaped(sc, masks->backslash);
+  JSUINT64 inString = PrefixXor(quote) ^ sc->inString;
+  JSUINT64 scalar = ~(masks->op | masks->whitespace | masks->quote);
+  JSUINT64 starts = scalar & ~((scalar << 1) | sc->scalar);
+  JSUINT64 structurals = ((masks->op | starts) & ~inString) | (quote & inString);
+
+  sc->inString = (JSUINT64) ((JSINT64) inString >> 63);
+  sc->scalar = scalar >> 63;
+
+  while (structurals)
+  {
+    *(out++) = offset + (JSUINT32) CountTrailingZeros64(structurals);
+    structurals &= structurals - 1;
+  }
+
+  return out;
+}
+
+#ifndef JSON_SSE2
+static JSUINT32 *IndexBlocksScalar(struct StructuralScanner *sc, const char *buffer, size_t cbBlocks, JSUINT32 offset, JSUINT32 *out)
+{
+  struct StructuralMasks masks;
+  size_t index;
+
+  for (index = 0; index < cbBlocks; index += 64)
+  {
+    StructuralMasksScalar(buffer + index, &masks);
+    out = IndexBlock(sc, &masks, offset + (JSUINT32) index, out);
+  }
+
+  return out;
+}
+#endif
+
+#ifdef JSON_SSE2
+static JSUINT32 *IndexBlocksSSE2(struct StructuralScanner *sc, const char *buffer, size_t cbBlocks, JSUINT32 offset, JSUINT32 *out)
+{
+  struct StructuralMasks masks;
+  size_t index;
+
+  for (index = 0; index < cbBlocks; index += 64)
+  {
+    StructuralMasksSSE2(buffer + index, &masks);
+    out = IndexBlock(sc, &masks, offset + (JSUINT32) index, out);
+  }
+
+  return out;
+}
+#endif
+
+#ifdef JSON_AVX2
+JSON_TARGET_AVX2 static JSUINT32 *IndexBlocksAVX2(struct StructuralScanner *sc, const char *buffer, size_t cbBlocks, JSUINT32 offset, JSUINT32 *out)
+{
+  struct StructuralMasks masks;
+  size_t index;
+
+  for (index = 0; index < cbBlocks; index += 64)
+  {
+    StructuralMasksAVX2(buffer + index, &masks);
+    out = IndexBlock(sc, &masks, offset + (JSUINT32) index, out);
+  }
+
+  return out;
+}
+#endif
+
+/*
+Stage 1. Writes at most cbBuffer entries to out and returns the end of the index. The last partial
+block is padded with whitespace, which never adds an entry */
+static JSUINT32 *IndexStructurals(const char *buffer, size_t cbBuffer, JSUINT32 *out)
+{
+  struct StructuralScanner sc = { 0, 0, 0 };
+  size_t cbBlocks = cbBuffer & ~(size_t) 63;
+  char tail[64];
+
+  memset(tail, ' ', sizeof(tail));
+  memcpy(tail, buffer + cbBlocks, cbBuffer - cbBlocks);
+
+#ifdef JSON_AVX2
+  if (HasAVX2())
+  {
+    out = IndexBlocksAVX2(&sc, buffer, cbBlocks, 0, out);
+    return IndexBlocksAVX2(&sc, tail, sizeof(tail), (JSUINT32) cbBlocks, out);
+  }
+#endif
+
+#ifdef JSON_SSE2
+  out = IndexBlocksSSE2(&sc, buffer, cbBlocks, 0, out);
+  return IndexBlocksSSE2(&sc, tail, sizeof(tail), (JSUINT32) cbBlocks, out);
+#else
+  out = IndexBlocksScalar(&sc, buffer, cbBlocks, 0, out);
+  return IndexBlocksScalar(&sc, tail, sizeof(tail), (JSUINT32) cbBlocks, out);
+#endif
+}
+
+/*
+Bracket matching for skipping a whole array or object. Uses the quote masks of stage 1 to ignore
+brackets inside strings and only looks at the structural characters left over. Returns the offset of
+the bracket closing the container within the block, or -1 if it is still open after the block */
+static INLINE_PREFIX int SkipBlock(struct StructuralScanner *sc, const struct StructuralMasks *masks, const char *block, int *depth)
+{
+  JSUINT64 quote = masks->quote & ~FindEscaped(sc, masks->backslash);
+  JSUINT64 inString = PrefixXor(quote) ^ sc->inString;
+  JSUINT64 op = masks->op & ~inString;
+  int index;
+  char chr;
+
+  sc->inString = (JSUINT64) ((JSINT64) inString >> 63);
+
+  while (op)
+  {
+    index = CountTrailingZeros64(op);
+    // Setting bit 5 folds '[' and ']' onto '{' and '}' and leaves ':' and ','
+    chr = (char) (block[index] | 0x20);
+
+    if (chr == '{')
+    {
+      (*depth) ++;
+    }
+    else
+    if (chr == '}' && -- (*depth) == 0)
+    {
+      return index;
+    }
+
+    op &= op - 1;
+  }
+
+  return -1;
+}
+
+#ifndef JSON_SSE2
+static const char *SkipBlocksScalar(struct StructuralScanner *sc, const char *buffer, size_t cbBlocks, int *depth)
+{
+  struct StructuralMasks masks;
+  size_t index;
+  int close;
+
+  for (index = 0; index < cbBlocks; index += 64)
+  {
+    StructuralMasksScalar(buffer + index, &masks);
+    close = SkipBlock(sc, &masks, buffer + index, depth);
+
+    if (close >= 0)
+    {
+      return buffer + index + close;
+    }
+  }
+
+  return NULL;
+}
+#endif
+
+#ifdef JSON_SSE2
+static const char *SkipBlocksSSE2(struct StructuralScanner *sc, const char *buffer, size_t cbBlocks, int *depth)
+{
+  struct StructuralMasks masks;
+  size_t index;
+  int close;
+
+  for (index = 0; index < cbBlocks; index += 64)
+  {
+    StructuralMasksSSE2(buffer + index, &masks);
+    close = SkipBlock(sc, &masks, buffer + index, depth);
+
+    if (close >= 0)
+    {
+      return buffer + index + close;
+    }
+  }
+
+  return NULL;
+}
+#endif
+
+#ifdef JSON_AVX2
+JSON_TARGET_AVX2 static const char *SkipBlocksAVX2(struct StructuralScanner *sc, const char *buffer, size_t cbBlocks, int *depth)
+{
+  struct StructuralMasks masks;
+  size_t index;
+  int close;
+
+  for (index = 0; index < cbBlocks; index += 64)
+  {
+    StructuralMasksAVX2(buffer + index, &masks);
+    close = SkipBlock(sc, &masks, buffer + index, depth);
+
+    if (close >= 0)
+    {
+      return buffer + index + close;
+    }
+  }
+
+  return NULL;
+}
+#endif
+
+/*
+Returns one past the bracket closing the array or object opened at start, or NULL if it is not closed
+before end. Nothing in between is validated */
+static const char *SkipContainer(const char *start, const char *end)
+{
+  struct StructuralScanner sc = { 0, 0, 0 };
+  const char *(*skipBlocks)(struct StructuralScanner *sc, const char *buffer, size_t cbBlocks, int *depth);
+  size_t cbBlocks = (size_t) (end - start) & ~(size_t) 63;
+  const char *close;
+  char tail[64];
+  int depth = 0;
+
+#if defined(JSON_SSE2)
+  skipBlocks = SkipBlocksSSE2;
+#ifdef JSON_AVX2
+  if (HasAVX2())
+  {
+    skipBlocks = SkipBlocksAVX2;
+  }
+#endif
+#else
+  skipBlocks = SkipBlocksScalar;
+#endif
+
+  close = skipBlocks(&sc, start, cbBlocks, &depth);
+
+  if (close == NULL)
+  {
+    memset(tail, ' ', sizeof(tail));
+    memcpy(tail, start + cbBlocks, (size_t) (end - start) - cbBlocks);
+    close = skipBlocks(&sc, tail, sizeof(tail), &depth);
+
+    if (close == NULL)
+    {
+      return NULL;
+    }
+
+    close = start + cbBlocks + (close - tail);
+  }
+
+  return close + 1;
+}
+
+/*
+True if a scalar value ended where it should, at the end of input, whitespace or a structural character.
+Anything else is the rest of a malformed token, which stage 1 didn't index */
+static INLINE_PREFIX int IsValueEnd(struct DecoderState *ds)
+{
+  if (ds->start >= ds->end)
+  {
+    return 1;
+  }
+
+  switch (*ds->start)
+  {
+    case ' ':
+    case '\t':
+    case '\r':
+    case '\n':
+    case '{':
+    case '}':
+    case '[':
+    case ']':
+    case ':':
+    case ',':
+      return 1;
+
+    default:
+      return 0;
+  }
+}
+
+#define INDEX_NEXT(ds) ((ds)->start = token < tokenEnd ? base + *(token++) : (ds)->end)
+#define INDEX_CHAR(ds) ((ds)->start < (ds)->end ? *(ds)->start : '\0')
+
+/*
+Stage 2. Same loop as decode_iterative, but every SkipWhitespace is a step to the next index entry.
+Accepts and rejects exactly what decode_any does */
+static JSOBJ decode_indexed(struct DecoderState *ds, const JSUINT32 *token, const JSUINT32 *tokenEnd)
+{
+  DecodeFrame stackFrames[JSON_ITERATIVE_STACK_FRAMES];
+  DecodeFrame *frames = stackFrames;
+  DecodeFrame *top;
+  JSUINT32 capacity = JSON_ITERATIVE_STACK_FRAMES;
+  JSUINT32 depth = 0;
+  char *base = ds->start;
+  JSOBJ value;
+  JSOBJ ret = NULL;
+  char chr;
+
+  INDEX_NEXT(ds);
+
+  for (;;)
+  {
+    // ds->start is at the first token of a value
+    if (ds->start >= ds->end)
+    {
+      SetError(ds, -1, "Expected object or value");
+      goto ERROR;
+    }
+
+    chr = *ds->start;
+
+    if (chr == '[' || chr == '{')
+    {
+      if (depth >= ds->objDepthMax)
+      {
+        SetError(ds, -1, "Reached object decoding depth limit");
+        goto ERROR;
+      }
+
+      if (depth == capacity)
+      {
+        DecodeFrame *newFrames = GrowFrames(ds, frames, stackFrames, &capacity);
+
+        if (!newFrames)
+        {
+          goto ERROR;
+        }
+
+        frames = newFrames;
+      }
+
+      top = &frames[depth++];
+      top->isObject = (chr == '{');
+      top->obj = top->isObject ? ds->dec->newObject(ds->prv) : ds->dec->newArray(ds->prv);
+      top->name = NULL;
+
+      ds->lastType = JT_INVALID;
+      INDEX_NEXT(ds);
+
+      if (INDEX_CHAR(ds) == (top->isObject ? '}' : ']'))
+      {
+        ds->start ++;
+        value = top->isObject ? EndObject(ds, top->obj) : EndArray(ds, top->obj);
+        depth --;
+        goto HAVE_VALUE;
+      }
+
+      if (top->isObject)
+      {
+        goto DECODE_KEY;
+      }
+
+      continue;
+    }
+
+    value = decode_scalar(ds);
+
+    if (value == NULL)
+    {
+      goto ERROR;
+    }
+
+    if (!IsValueEnd(ds))
+    {
+      ds->dec->releaseObject(ds->prv, value);
+      SetError(ds, -1, "Unexpected character found after value");
+      goto ERROR;
+    }
+
+HAVE_VALUE:
+    // Add the value to its parent and close every container that ends right after it
+    for (;;)
+    {
+      if (depth == 0)
+      {
+        ret = value;
+        goto DONE;
+      }
+
+      top = &frames[depth - 1];
+
+      if (top->isObject)
+      {
+        ds->dec->objectAddKey (ds->prv, top->obj, top->name, value);
+        top->name = NULL;
+      }
+      else
+      {
+        ds->dec->arrayAddItem (ds->prv, top->obj, value);
+      }
+
+      INDEX_NEXT(ds);
+      chr = INDEX_CHAR(ds);
+
+      if (chr == (top->isObject ? '}' : ']'))
+      {
+        ds->start ++;
+        value = top->isObject ? EndObject(ds, top->obj) : EndArray(ds, top->obj);
+        depth --;
+        continue;
+      }
+
+      if (chr != ',')
+      {
+        SetError(ds, 0, top->isObject ? "Unexpected character in found when decoding object value" :
+          "Unexpected character found when decoding array value (2)");
+        goto ERROR;
+      }
+
+      break;
+    }
+
+    INDEX_NEXT(ds);
+
+    if (!top->isObject)
+    {
+      if (INDEX_CHAR(ds) == ']')
+      {
+        SetError(ds, -1, "Unexpected character found when decoding array value (1)");
+        goto ERROR;
+      }
+
+      continue;
+    }
+
+    if (INDEX_CHAR(ds) == '}')
+    {
+      ds->start ++;
+      value = EndObject(ds, top->obj);
+      depth --;
+      goto HAVE_VALUE;
+    }
+
+DECODE_KEY:
+    ds->lastType = JT_INVALID;
+    chr = INDEX_CHAR(ds);
+
+    if (chr == '[' || chr == '{' || ds->start >= ds->end)
+    {
+      SetError(ds, -1, "Key name of object must be 'string' when decoding 'object'");
+      goto ERROR;
+    }
+
+    top->name = decode_scalar(ds);
+
+    if (top->name == NULL)
+    {
+      goto ERROR;
+    }
+
+    if (ds->lastType != JT_UTF8)
+    {
+      SetError(ds, -1, "Key name of object must be 'string' when decoding 'object'");
+      goto ERROR;
+    }
+
+    top->name = ObjectKey(ds, top->name);
+
+    INDEX_NEXT(ds);
+
+    if (INDEX_CHAR(ds) != ':')
+    {
+      SetError(ds, 0, "No ':' found when decoding object value");
+      goto ERROR;
+    }
+
+    INDEX_NEXT(ds);
+  }
+
+ERROR:
+  while (depth > 0)
+  {
+    top = &frames[--depth];
+
+    if (top->name)
+    {
+      ds->dec->releaseObject(ds->prv, top->name);
+    }
+
+    ds->dec->releaseObject(ds->prv, top->obj);
+  }
+
+DONE:
+  if (frames != stackFrames)
+  {
+    ds->dec->free(frames);
+  }
+
+  return ret;
+}
+
+#undef INDEX_NEXT
+#undef INDEX_CHAR
+
+/*
+Runs both stages. The index is kept in dec->indexBuffer for decoders with heapEscBuffer set */
+static JSOBJ decode_structural(struct DecoderState *ds)
+{
+  JSONObjectDecoder *dec = ds->dec;
+  size_t cbBuffer = (size_t) (ds->end - ds->start);
+  size_t cIndex = cbBuffer + 1;
+  JSUINT32 *index = dec->indexBuffer;
+  JSUINT32 *indexEnd;
+  JSOBJ ret;
+
+  if (!dec->heapEscBuffer || dec->indexBufferLen < cIndex)
+  {
+    if (dec->heapEscBuffer && index)
+    {
+      dec->free(index);
+      dec->indexBuffer = NULL;
+      dec->indexBufferLen = 0;
+    }
+
+    index = (JSUINT32 *) dec->malloc(cIndex * sizeof(JSUINT32));
+
+    if (!index)
+    {
+      return SetError(ds, -1, "Could not reserve memory block");
+    }
+
+    if (dec->heapEscBuffer)
+    {
+      dec->indexBuffer = index;
+      dec->indexBufferLen = cIndex;
+    }
+  }
+
+  indexEnd = IndexStructurals(ds->start, cbBuffer, index);
+  ret = decode_indexed(ds, index, indexEnd);
+
+  if (!dec->heapEscBuffer)
+  {
+    dec->free(index);
+  }
+
+  return ret;
+}
+
+/*
+Push decoding. Tokens are decoded straight out of each fed buffer, only a string or scalar cut off
+by the end of a buffer is copied into pending and completed from the following buffers */
+enum JSONSTREAMSTATE
+{
+  SS_VALUE,
+  SS_FIRST_ELEMENT,
+  SS_ELEMENT,
+  SS_KEY,
+  SS_COLON,
+  SS_NEXT,
+  SS_DONE,
+  SS_ERROR
+};
+
+enum JSONSTREAMTOKEN
+{
+  ST_NONE,
+  ST_STRING,
+  ST_SCALAR
+};
+
+struct __JSONStreamDecoder
+{
+  struct DecoderState ds;
+  DecodeFrame *frames;
+  JSUINT32 capacity;
+  JSUINT32 depth;
+  int state;
+
+  // Kind of the incomplete token in pending, and if a pending string ends within an escape
+  int token;
+  int escape;
+  char *pending;
+  size_t pendingLen;
+  size_t pendingCap;
+  JSOBJ root;
+};
+
+/*
+Returns the end of the string whose contents start at offset, one past its closing quote, or NULL if
+it continues past end. escape carries a backslash ending one buffer over to the next */
+static const char *FindStringEnd(const char *offset, const char *end, int *escape)
+{
+  const char *quote = NULL;
+  const char *backslash;
+
+  if (*escape)
+  {
+    if (offset == end)
+    {
+      return NULL;
+    }
+
+    offset ++;
+    *escape = 0;
+  }
+
+  for (;;)
+  {
+    if (quote < offset)
+    {
+      quote = (const char *) memchr(offset, '\"', (size_t) (end - offset));
+    }
+
+    backslash = (const char *) memchr(offset, '\\', (size_t) ((quote ? quote : end) - offset));
+
+    if (backslash == NULL)
+    {
+      return quote ? quote + 1 : NULL;
+    }
+
+    if (backslash + 1 == end)
+    {
+      *escape = 1;
+      return NULL;
+    }
+
+    offset = backslash + 2;
+  }
+}
+
+/*
+Returns the end of the number or literal starting at offset or NULL if it may continue past end */
+static const char *FindScalarEnd(const char *offset, const char *end)
+{
+  for (; offset < end; offset ++)
+  {
+    switch (*offset)
+    {
+      case ' ':
+      case '\t':
+      case '\r':
+      case '\n':
+      case '{':
+      case '}':
+      case '[':
+      case ']':
+      case ':':
+      case ',':
+      case '\"':
+        return offset;
+    }
+  }
+
+  return NULL;
+}
+
+static int StreamFail(JSONStreamDecoder *stream)
+{
+  struct DecoderState *ds = &stream->ds;
+
+  while (stream->depth > 0)
+  {
+    DecodeFrame *top = &stream->frames[--stream->depth];
+
+    if (top->name)
+    {
+      ds->dec->releaseObject(ds->prv, top->name);
+    }
+
+    ds->dec->releaseObject(ds->prv, top->obj);
+  }
+
+  if (stream->root)
+  {
+    ds->dec->releaseObject(ds->prv, stream->root);
+    stream->root = NULL;
+  }
+
+  stream->state = SS_ERROR;
+  return 0;
+}
+
+static int StreamValue(JSONStreamDecoder *stream, JSOBJ value)
+{
+  DecodeFrame *top;
+
+  if (stream->depth == 0)
+  {
+    stream->root = value;
+    stream->state = SS_DONE;
+    return 1;
+  }
+
+  top = &stream->frames[stream->depth - 1];
+
+  if (top->isObject)
+  {
+    stream->ds.dec->objectAddKey (stream->ds.prv, top->obj, top->name, value);
+    top->name = NULL;
+  }
+  else
+  {
+    stream->ds.dec->arrayAddItem (stream->ds.prv, top->obj, value);
+  }
+
+  stream->state = SS_NEXT;
+  return 1;
+}
+
+/*
+Decodes a complete string or scalar token in [start, end) as a key or value depending on the state.
+The byte at end must not continue the token, it is a delimiter or the terminator of pending */
+static int StreamToken(JSONStreamDecoder *stream, const char *start, const char *end)
+{
+  struct DecoderState *ds = &stream->ds;
+  JSOBJ value;
+
+  ds->start = (char *) start;
+  ds->end = (char *) end;
+  ds->lastType = JT_INVALID;
+
+  value = decode_scalar(ds);
+
+  if (value == NULL)
+  {
+    return StreamFail(stream);
+  }
+
+  if (ds->start != end)
+  {
+    ds->dec->releaseObject(ds->prv, value);
+    SetError(ds, 0, "Unexpected character found after value");
+    return StreamFail(stream);
+  }
+
+  if (stream->state == SS_KEY)
+  {
+    stream->frames[stream->depth - 1].name = ObjectKey(ds, value);
+    stream->state = SS_COLON;
+    return 1;
+  }
+
+  return StreamValue(stream, value);
+}
+
+/*
+Appends to pending, which is kept null terminated */
+static int StreamAppend(JSONStreamDecoder *stream, const char *buffer, size_t cbBuffer)
+{
+  if (stream->pendingLen + cbBuffer + 1 > stream->pendingCap)
+  {
+    size_t newCap = (stream->pendingLen + cbBuffer + 1) * 2;
+    char *pending = (char *) stream->ds.dec->realloc(stream->pending, newCap);
+
+    if (!pending)
+    {
+      SetError(&stream->ds, 0, "Could not reserve memory block");
+      return StreamFail(stream);
+    }
+
+    stream->pending = pending;
+    stream->pendingCap = newCap;
+  }
+
+  memcpy(stream->pending + stream->pendingLen, buffer, cbBuffer);
+  stream->pendingLen += cbBuffer;
+  stream->pending[stream->pendingLen] = '\0';
+  return 1;
+}
+
+JSONStreamDecoder *JSON_StreamCreate(JSONObjectDecoder *dec)
+{
+  JSONStreamDecoder *stream = (JSONStreamDecoder *) dec->malloc(sizeof(JSONStreamDecoder));
+
+  if (!stream)
+  {
+    return NULL;
+  }
+
+  memset(stream, 0, sizeof(JSONStreamDecoder));
+  stream->capacity = JSON_ITERATIVE_STACK_FRAMES;
+  stream->frames = (DecodeFrame *) dec->malloc(stream->capacity * sizeof(DecodeFrame));
+
+  if (!stream->frames)
+  {
+    dec->free(stream);
+    return NULL;
+  }
+
+  // Strings are unescaped into a heap buffer that grows to the longest string seen
+  stream->ds.escHeap = 1;
+  stream->ds.prv = dec->prv;
+  stream->ds.dec = dec;
+  stream->ds.objDepthMax = dec->objectDepthMax > 0 ? (JSUINT32) dec->objectDepthMax : JSON_MAX_OBJECT_DEPTH;
+  stream->state = SS_VALUE;
+
+  dec->errorStr = NULL;
+  dec->errorOffset = NULL;
+  return stream;
+}
+
+int JSON_StreamFeed(JSONStreamDecoder *stream, const char *buffer, size_t cbBuffer)
+{
+  struct DecoderState *ds = &stream->ds;
+  const char *offset = buffer;
+  const char *end = buffer + cbBuffer;
+  const char *tokenEnd;
+  DecodeFrame *top;
+  char chr;
+
+  if (stream->state == SS_ERROR)
+  {
+    return -1;
+  }
+
+  if (stream->token != ST_NONE)
+  {
+    tokenEnd = stream->token == ST_STRING ? FindStringEnd(offset, end, &stream->escape) : FindScalarEnd(offset, end);
+
+    if (!StreamAppend(stream, offset, (size_t) ((tokenEnd ? tokenEnd : end) - offset)))
+    {
+      return -1;
+    }
+
+    if (!tokenEnd)
+    {
+      return 0;
+    }
+
+    offset = tokenEnd;
+    stream->token = ST_NONE;
+
+    if (!StreamToken(stream, stream->pending, stream->pending + stream->pendingLen))
+    {
+      return -1;
+    }
+  }
+
+  for (;;)
+  {
+    offset = SkipWhitespaceRun(offset, end);
+
+    if (offset == end)
+    {
+      return stream->state == SS_DONE ? 1 : 0;
+    }
+
+    chr = *offset;
+    ds->start = (char *) offset + 1;
+
+    switch (stream->state)
+    {
+      case SS_DONE:
+        SetError(ds, -1, "Trailing data");
+        StreamFail(stream);
+        return -1;
+
+      case SS_COLON:
+        if (chr != ':')
+        {
+          SetError(ds, -1, "No ':' found when decoding object value");
+          StreamFail(stream);
+          return -1;
+        }
+
+        offset ++;
+        stream->state = SS_VALUE;
+        continue;
+
+      case SS_NEXT:
+        top = &stream->frames[stream->depth - 1];
+
+        if (chr == (top->isObject ? '}' : ']'))
+        {
+          offset ++;
+          stream->depth --;
+          StreamValue(stream, top->isObject ? EndObject(ds, top->obj) : EndArray(ds, top->obj));
+          continue;
+        }
 
-          ucs |= oct & 0x3f;
+        if (chr != ',')
+        {
+          SetError(ds, -1, top->isObject ? "Unexpected character in found when decoding object value" :
+            "Unexpected character found when decoding array value (2)");
+          StreamFail(stream);
+          return -1;
         }
 
-        if (ucs < 0x10000) return SetError (ds, -1, "Overlong 4 byte UTF-8 sequence detected when decoding 'string'");
+        offset ++;
+        stream->state = top->isObject ? SS_KEY : SS_ELEMENT;
+        continue;
 
-#if WCHAR_MAX == 0xffff
-        if (ucs >= 0x10000)
+      case SS_KEY:
+        if (chr == '}')
         {
-          ucs -= 0x10000;
-          *(escOffset++) = (wchar_t) (ucs >> 10) + 0xd800;
-          *(escOffset++) = (wchar_t) (ucs & 0x3ff) + 0xdc00;
+          offset ++;
+          stream->depth --;
+          StreamValue(stream, EndObject(ds, stream->frames[stream->depth].obj));
+          continue;
         }
-        else
+
+        if (chr != '\"')
         {
-          *(escOffset++) = (wchar_t) ucs;
+          SetError(ds, -1, "Key name of object must be 'string' when decoding 'object'");
+          StreamFail(stream);
+          return -1;
         }
-#else
-        *(escOffset++) = (wchar_t) ucs;
-#endif
+
         break;
-      }
-    }
-  }
-}
 
-FASTCALL_ATTR JSOBJ FASTCALL_MSVC decode_array(struct DecoderState *ds)
-{
-  JSOBJ itemValue;
-  JSOBJ newObj;
-  int len;
-  ds->objDepth++;
-  if (ds->objDepth > JSON_MAX_OBJECT_DEPTH) {
-    return SetError(ds, -1, "Reached object decoding depth limit");
-  }
+      case SS_FIRST_ELEMENT:
+        if (chr == ']')
+        {
+          offset ++;
+          stream->depth --;
+          StreamValue(stream, EndArray(ds, stream->frames[stream->depth].obj));
+          continue;
+        }
 
-  newObj = ds->dec->newArray(ds->prv);
-  len = 0;
+        // Fall through
+      case SS_ELEMENT:
+        if (chr == ']')
+        {
+          SetError(ds, -1, "Unexpected character found when decoding array value (1)");
+          StreamFail(stream);
+          return -1;
+        }
 
-  ds->lastType = JT_INVALID;
-  ds->start ++;
+        // Fall through
+      default:
+        if (chr == '[' || chr == '{')
+        {
+          if (stream->depth >= ds->objDepthMax)
+          {
+            SetError(ds, -1, "Reached object decoding depth limit");
+            StreamFail(stream);
+            return -1;
+          }
 
-  for (;;)
-  {
-    SkipWhitespace(ds);
+          if (stream->depth == stream->capacity)
+          {
+            DecodeFrame *newFrames = GrowFrames(ds, stream->frames, NULL, &stream->capacity);
 
-    if ((*ds->start) == ']')
-    {
-      ds->objDepth--;
-      if (len == 0)
-      {
-        ds->start ++;
-        return newObj;
-      }
+            if (!newFrames)
+            {
+              StreamFail(stream);
+              return -1;
+            }
 
-      ds->dec->releaseObject(ds->prv, newObj);
-      return SetError(ds, -1, "Unexpected character found when decoding array value (1)");
-    }
+            stream->frames = newFrames;
+          }
 
-    itemValue = decode_any(ds);
+          top = &stream->frames[stream->depth++];
+          top->isObject = (chr == '{');
+          top->obj = top->isObject ? ds->dec->newObject(ds->prv) : ds->dec->newArray(ds->prv);
+          top->name = NULL;
 
-    if (itemValue == NULL)
-    {
-      ds->dec->releaseObject(ds->prv, newObj);
-      return NULL;
-    }
+          offset ++;
+          stream->state = top->isObject ? SS_KEY : SS_FIRST_ELEMENT;
+          continue;
+        }
 
-    ds->dec->arrayAddItem (ds->prv, newObj, itemValue);
+        if (chr == '}' || chr == ']' || chr == ':' || chr == ',')
+        {
+          SetError(ds, -1, "Expected object or value");
+          StreamFail(stream);
+          return -1;
+        }
 
-    SkipWhitespace(ds);
+        break;
+    }
 
-    switch (*(ds->start++))
+    // A string or scalar starts at offset
+    if (chr == '\"')
     {
-    case ']':
+      stream->escape = 0;
+      tokenEnd = FindStringEnd(offset + 1, end, &stream->escape);
+      stream->token = ST_STRING;
+    }
+    else
     {
-      ds->objDepth--;
-      return newObj;
+      tokenEnd = FindScalarEnd(offset, end);
+      stream->token = ST_SCALAR;
     }
-    case ',':
-      break;
 
-    default:
-      ds->dec->releaseObject(ds->prv, newObj);
-      return SetError(ds, -1, "Unexpected character found when decoding array value (2)");
+    if (!tokenEnd)
+    {
+      stream->pendingLen = 0;
+      return StreamAppend(stream, offset, (size_t) (end - offset)) ? 0 : -1;
     }
 
-    len ++;
+    stream->token = ST_NONE;
+
+    if (!StreamToken(stream, offset, tokenEnd))
+    {
+      return -1;
+    }
+
+    offset = tokenEnd;
   }
 }
 
-FASTCALL_ATTR JSOBJ FASTCALL_MSVC decode_object( struct DecoderState *ds)
+JSOBJ JSON_StreamFinish(JSONStreamDecoder *stream)
 {
-  JSOBJ itemName;
-  JSOBJ itemValue;
-  JSOBJ newObj;
+  struct DecoderState *ds = &stream->ds;
+  JSONObjectDecoder *dec = ds->dec;
+  JSOBJ ret = NULL;
 
-  ds->objDepth++;
-  if (ds->objDepth > JSON_MAX_OBJECT_DEPTH) {
-    return SetError(ds, -1, "Reached object decoding depth limit");
+  if (stream->state != SS_ERROR)
+  {
+    if (stream->token == ST_STRING)
+    {
+      SetError(ds, 0, "Unmatched ''\"' when when decoding 'string'");
+      StreamFail(stream);
+    }
+    else
+    if (stream->token == ST_SCALAR)
+    {
+      StreamToken(stream, stream->pending, stream->pending + stream->pendingLen);
+    }
   }
 
-  newObj = ds->dec->newObject(ds->prv);
-
-  ds->start ++;
+  if (stream->state != SS_ERROR && dec->errorStr)
+  {
+    // A callback without a return value failed and left the document incomplete
+    StreamFail(stream);
+  }
 
-  for (;;)
+  if (stream->state == SS_DONE)
   {
-    SkipWhitespace(ds);
+    ret = stream->root;
+  }
+  else
+  if (stream->state != SS_ERROR)
+  {
+    ds->start = NULL;
+    SetError(ds, 0, "Unexpected end of input");
+    StreamFail(stream);
+  }
 
-    if ((*ds->start) == '}')
-    {
-      ds->objDepth--;
-      ds->start ++;
-      return newObj;
-    }
+  if (ds->escHeap && ds->escStart)
+  {
+    dec->free(ds->escStart);
+  }
 
-    ds->lastType = JT_INVALID;
-    itemName = decode_any(ds);
+  if (stream->pending)
+  {
+    dec->free(stream->pending);
+  }
 
-    if (itemName == NULL)
-    {
-      ds->dec->releaseObject(ds->prv, newObj);
-      return NULL;
-    }
+  dec->free(stream->frames);
+  dec->free(stream);
+  return ret;
+}
 
-    if (ds->lastType != JT_UTF8)
-    {
-      ds->dec->releaseObject(ds->prv, newObj);
-      ds->dec->releaseObject(ds->prv, itemName);
-      return SetError(ds, -1, "Key name of object must be 'string' when decoding 'object'");
-    }
+/*
+Decodes the root value with the engine selected by the decoder */
+static JSOBJ decode_root(struct DecoderState *ds)
+{
+  if (ds->dec->structuralIndex && (size_t) (ds->end - ds->start) < 0xffffffff)
+  {
+    return decode_structural (ds);
+  }
 
-    SkipWhitespace(ds);
+  return ds->dec->iterative ? decode_iterative (ds) : decode_any (ds);
+}
 
-    if (*(ds->start++) != ':')
-    {
-      ds->dec->releaseObject(ds->prv, newObj);
-      ds->dec->releaseObject(ds->prv, itemName);
-      return SetError(ds, -1, "No ':' found when decoding object value");
-    }
+/*
+Decodes the elements of an array without its brackets, values separated by commas up to the end of
+the input, into a new array. The array counts as one level of nesting */
+static JSOBJ decode_elements(struct DecoderState *ds)
+{
+  JSOBJ newObj;
+  JSOBJ itemValue;
 
-    SkipWhitespace(ds);
+  ds->objDepthMax --;
+  newObj = ds->dec->newArray(ds->prv);
 
-    itemValue = decode_any(ds);
+  for (;;)
+  {
+    itemValue = ds->dec->iterative ? decode_iterative (ds) : decode_any (ds);
 
     if (itemValue == NULL)
     {
       ds->dec->releaseObject(ds->prv, newObj);
-      ds->dec->releaseObject(ds->prv, itemName);
       return NULL;
     }
 
-    ds->dec->objectAddKey (ds->prv, newObj, itemName, itemValue);
-
+    ds->dec->arrayAddItem (ds->prv, newObj, itemValue);
     SkipWhitespace(ds);
 
-    switch (*(ds->start++))
+    // A value running past the end is caught by the trailing data check
+    if (ds->start >= ds->end)
     {
-      case '}':
-      {
-        ds->objDepth--;
-        return newObj;
-      }
-      case ',':
-        break;
-
-      default:
-        ds->dec->releaseObject(ds->prv, newObj);
-        return SetError(ds, -1, "Unexpected character in found when decoding object value");
+      return EndArray(ds, newObj);
     }
-  }
-}
 
-FASTCALL_ATTR JSOBJ FASTCALL_MSVC decode_any(struct DecoderState *ds)
-{
-  for (;;)
-  {
-    switch (*ds->start)
+    if (*(ds->start++) != ',')
     {
-      case '\"':
-        return decode_string (ds);
-      case '0':
-      case '1':
-      case '2':
-      case '3':
-      case '4':
-      case '5':
-      case '6':
-      case '7':
-      case '8':
-      case '9':
-      case '-':
-        return decode_numeric (ds);
-
-      case '[': return decode_array (ds);
-      case '{': return decode_object (ds);
-      case 't': return decode_true (ds);
-      case 'f': return decode_false (ds);
-      case 'n': return decode_null (ds);
-
-      case ' ':
-      case '\t':
-      case '\r':
-      case '\n':
-        // White space
-        ds->start ++;
-        break;
-
-      default:
-        return SetError(ds, -1, "Expected object or value");
+      ds->dec->releaseObject(ds->prv, newObj);
+      return SetError(ds, -1, "Unexpected character found when decoding array value (2)");
     }
   }
 }
 
-JSOBJ JSON_DecodeObject(JSONObjectDecoder *dec, const char *buffer, size_t cbBuffer)
+static JSOBJ DecodeObject(JSONObjectDecoder *dec, const char *buffer, size_t cbBuffer, wchar_t *escBuffer, size_t escLen, int escHeap, PFN_DECODER decoder)
 {
-  /*
-  FIXME: Base the size of escBuffer of that of cbBuffer so that the unicode escaping doesn't run into the wall each time */
   struct DecoderState ds;
-  wchar_t escBuffer[(JSON_MAX_STACK_BUFFER_SIZE / sizeof(wchar_t))];
   JSOBJ ret;
 
   ds.start = (char *) buffer;
   ds.end = ds.start + cbBuffer;
 
   ds.escStart = escBuffer;
-  ds.escEnd = ds.escStart + (JSON_MAX_STACK_BUFFER_SIZE / sizeof(wchar_t));
-  ds.escHeap = 0;
+  ds.escEnd = ds.escStart + escLen;
+  ds.escHeap = escHeap;
   ds.prv = dec->prv;
   ds.dec = dec;
   ds.dec->errorStr = NULL;
   ds.dec->errorOffset = NULL;
   ds.objDepth = 0;
+  ds.objDepthMax = dec->objectDepthMax > 0 ? (JSUINT32) dec->objectDepthMax : JSON_MAX_OBJECT_DEPTH;
 
   ds.dec = dec;
 
-  ret = decode_any (&ds);
+  ret = decoder (&ds);
 
+  if (dec->heapEscBuffer)
+  {
+    // Hand the possibly grown buffer back for the next call
+    dec->escBuffer = ds.escStart;
+    dec->escBufferLen = (size_t) (ds.escEnd - ds.escStart);
+  }
+  else
   if (ds.escHeap)
   {
     dec->free(ds.escStart);
@@ -887,5 +4733,73 @@ JSOBJ JSON_DecodeObject(JSONObjectDecoder *dec, const char *buffer, size_t cbBuf
     return SetError(&ds, -1, "Trailing data");
   }
 
+  if (ret && dec->errorStr)
+  {
+    // A callback without a return value failed and left the document incomplete
+    dec->releaseObject(ds.prv, ret);
+    return NULL;
+  }
+
   return ret;
 }
+
+/*
+Kept out of line so the stack buffer is only reserved by decoders without heapEscBuffer */
+static JSON_NOINLINE JSOBJ DecodeObjectStackBuffer(JSONObjectDecoder *dec, const char *buffer, size_t cbBuffer, PFN_DECODER decoder)
+{
+  /*
+  FIXME: Base the size of escBuffer of that of cbBuffer so that the unicode escaping doesn't run into the wall each time */
+  wchar_t escBuffer[(JSON_MAX_STACK_BUFFER_SIZE / sizeof(wchar_t))];
+  return DecodeObject(dec, buffer, cbBuffer, escBuffer, JSON_MAX_STACK_BUFFER_SIZE / sizeof(wchar_t), 0, decoder);
+}
+
+static JSOBJ DecodeBuffer(JSONObjectDecoder *dec, const char *buffer, size_t cbBuffer, PFN_DECODER decoder)
+{
+  if (dec->heapEscBuffer)
+  {
+    return DecodeObject(dec, buffer, cbBuffer, dec->escBuffer, dec->escBufferLen, 1, decoder);
+  }
+
+  return DecodeObjectStackBuffer(dec, buffer, cbBuffer, decoder);
+}
+
+JSOBJ JSON_DecodeObject(JSONObjectDecoder *dec, const char *buffer, size_t cbBuffer)
+{
+  return DecodeBuffer(dec, buffer, cbBuffer, decode_root);
+}
+
+JSOBJ JSON_DecodeElements(JSONObjectDecoder *dec, const char *buffer, size_t cbBuffer)
+{
+  return DecodeBuffer(dec, buffer, cbBuffer, decode_elements);
+}
+
+JSOBJ JSON_DecodeEvents(JSONObjectDecoder *dec, const char *buffer, size_t cbBuffer)
+{
+  return DecodeBuffer(dec, buffer, cbBuffer, decode_events);
+}
+
+const char *JSON_SkipValue(const char *start, const char *end)
+{
+  const char *scalarEnd;
+  int escape = 0;
+
+  if (start >= end)
+  {
+    return NULL;
+  }
+
+  switch (*start)
+  {
+    case '{':
+    case '[':
+      return SkipContainer(start, end);
+
+    case '\"':
+      return FindStringEnd(start + 1, end, &escape);
+
+    default:
+      scalarEnd = FindScalarEnd(start, end);
+      scalarEnd = scalarEnd ? scalarEnd : end;
+      return scalarEnd != start ? scalarEnd : NULL;
+  }
+}
@@ -1,836 +1,4762 @@
-/*
-ujson4c decoder helper 1.0
-Developed by ESN, an Electronic Arts Inc. studio. 
-Copyright (c) 2013, Electronic Arts Inc.
-All rights reserved.
-
-Redistribution and use in source and binary forms, with or without
-modification, are permitted provided that the following conditions are met:
-* Redistributions of source code must retain the above copyright
-notice, this list of conditions and the following disclaimer.
-* Redistributions in binary form must reproduce the above copyright
-notice, this list of conditions and the following disclaimer in the
-documentation and/or other materials provided with the distribution.
-* Neither the name of ESN, Electronic Arts Inc. nor the
-names of its contributors may be used to endorse or promote products
-derived from this software without specific prior written permission.
-
-THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
-ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
-WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
-DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS INC. BE LIABLE 
-FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
-(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
-LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
-ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
-(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
-SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-
-Uses UltraJSON library:
-Copyright (c) 2013, Electronic Arts Inc.
-All rights reserved.
-www.github.com/esnme/ultrajson
-*/
-
-#include "ujdecode.h"
-#include "ultrajson.h"
-#include <math.h>
-#include <string.h>
-#include <stdlib.h>
-#include <stdarg.h>
-
-typedef struct __Item
-{
-	int type;
-} Item;
-
-typedef struct __StringItem
-{
-	Item item;
-	UJString str;
-} StringItem;
-
-typedef struct __KeyPair
-{
-	StringItem *name;
-	Item *value;
-	struct __KeyPair *next;
-} KeyPair;
-
-typedef struct __ObjectItem
-{
-	Item item;
-	KeyPair *head;
-	KeyPair *tail;
-} ObjectItem;
-
-typedef struct __ArrayEntry
-{
-	Item *item;
-	struct __ArrayEntry *next;
-} ArrayEntry;
-
-typedef struct __ArrayItem
-{
-	Item item;
-	ArrayEntry *head;
-	ArrayEntry *tail;
-} ArrayItem; 
-
-typedef struct __LongValue
-{
-	Item item;
-	long value;
-} LongValue;
-
-typedef struct __LongLongValue
-{
-	Item item;
-	long long value;
-} LongLongValue;
-
-typedef struct __DoubleValue
-{
-	Item item;
-	double value;
-} DoubleValue;
-
-typedef struct __NullValue
-{
-	Item item;
-} NullValue;
-
-typedef struct __FalseValue
-{
-	Item item;
-} FalseValue;
-
-typedef struct __TrueValue
-{
-	Item item;
-} TrueValue;
-
-typedef struct __HeapSlab
-{
-	unsigned char *start;
-	unsigned char *offset;
-	unsigned char *end;
-	size_t size;
-	char owned;
-	struct __HeapSlab *next;
-} HeapSlab;
-
-struct DecoderState
-{
-	HeapSlab *heap;
-	const char *error;
-	void *(*malloc)(size_t cbSize);
-	void (*free)(void *ptr);
-};
-
-
-static void *alloc(struct DecoderState *ds, size_t cbSize)
-{
-	unsigned char *ret;
-
-	if (ds->heap->offset + cbSize > ds->heap->end)
-	{
-		size_t newSize = ds->heap->size * 2;
-		HeapSlab *newSlab;
-
-		while (newSize < (cbSize + sizeof (HeapSlab)))
-			newSize *= 2;
-
-		newSlab = (HeapSlab *) ds->malloc(newSize);
-		newSlab->start = (unsigned char *) (newSlab + 1);
-		newSlab->end = (unsigned char *) newSlab + newSize;
-		newSlab->size = newSize;
-		newSlab->offset = newSlab->start;
-		newSlab->owned = 1;
-
-		newSlab->next = ds->heap;
-		ds->heap = newSlab;
-	}
-
-
-	ret = ds->heap->offset;
-	ds->heap->offset += cbSize;
-
-	return ret;
-}
-
-static JSOBJ newString(void* context, wchar_t *start, wchar_t *end)
-{
-	struct DecoderState *ds = context;
-	size_t len;
-	StringItem *si = (StringItem *) alloc(ds, sizeof(StringItem) + (end - start + 1) * sizeof(wchar_t));
-	len = end - start;
-
-	si->item.type = UJT_String;
-	si->str.ptr = (wchar_t *) (si + 1);
-	si->str.cchLen = len;
-
-	if (len < 4)
-	{
-		wchar_t *dst = si->str.ptr;
-		wchar_t *end = dst + len;
-
-		while (dst < end)
-		{
-			*(dst++) = *(start++);
-		}
-	}
-	else
-	{
-		memcpy (si->str.ptr, start, len * sizeof(wchar_t));
-	}
-	si->str.ptr[len] = '\0';
-	return (JSOBJ) si;
-}
-
-static void objectAddKey(void* context, JSOBJ obj, JSOBJ name, JSOBJ value)
-{
-	struct DecoderState *ds = context;
-	ObjectItem *oi = (ObjectItem *) obj;
-	KeyPair *kp = (KeyPair *) alloc(ds, sizeof(KeyPair));
-
-	kp->next = NULL;
-
-	kp->name = (StringItem *) name;
-	kp->value = (Item *) value;
-
-	if (oi->tail)
-	{
-		oi->tail->next = kp;
-	}
-	else
-	{
-		oi->head = kp;
-	}
-	oi->tail = kp;
-}
-
-static void arrayAddItem(void* context, JSOBJ obj, JSOBJ value)
-{
-	struct DecoderState *ds = context;
-	ArrayItem *ai = (ArrayItem *) obj;
-	ArrayEntry *ae = (ArrayEntry *) alloc(ds, sizeof(ArrayEntry));
-
-	ae->next = NULL;
-	ae->item = (Item *) value;
-
-	if (ai->tail)
-	{
-		ai->tail->next = ae;
-	}
-	else
-	{
-		ai->head = ae;
-	}
-	ai->tail = ae;
-
-}
-
-static JSOBJ newTrue(void* context)
-{
-	struct DecoderState *ds = context;
-	TrueValue *tv = (TrueValue *) alloc(ds, sizeof(TrueValue *));
-	tv->item.type = UJT_True;
-	return (JSOBJ) tv;
-}
-
-static JSOBJ newFalse(void *context)
-{
-	struct DecoderState *ds = context;
-	FalseValue *fv = (FalseValue *) alloc(ds, sizeof(FalseValue *));
-	fv->item.type = UJT_False;
-	return (JSOBJ) fv;
-}
-
-static JSOBJ newNull(void *context)
-{
-	struct DecoderState *ds = context;
-	NullValue *nv = (NullValue *) alloc(ds, sizeof(NullValue *));
-	nv->item.type = UJT_Null;
-	return (JSOBJ) nv;
-}
-
-static JSOBJ newObject(void *context)
-{
-	struct DecoderState *ds = context;
-	ObjectItem *oi = (ObjectItem *) alloc(ds, sizeof(ObjectItem));
-	oi->item.type = UJT_Object;
-	oi->head = NULL;
-	oi->tail = NULL;
-
-	return (JSOBJ) oi;
-}
-
-static JSOBJ newArray(void *context)
-{
-	struct DecoderState *ds = context;
-	ArrayItem *ai = (ArrayItem *) alloc(ds, sizeof(ArrayItem));
-	ai->head = NULL;
-	ai->tail = NULL;
-	ai->item.type = UJT_Array;
-	return (JSOBJ) ai;
-}
-
-static JSOBJ newInt(void *context, JSINT32 value)
-{
-	struct DecoderState *ds = context;
-	LongValue *lv = (LongValue *) alloc(ds, sizeof(LongValue));
-	lv->item.type = UJT_Long;
-	lv->value = (long) value;
-	return (JSOBJ) lv;
-}
-
-static JSOBJ newLong(void *context, JSINT64 value)
-{
-	struct DecoderState *ds = context;
-	LongLongValue *llv = (LongLongValue *) alloc(ds, sizeof(LongLongValue));
-	llv->item.type = UJT_LongLong;
-	llv->value = (long long) value;
-	return (JSOBJ) llv;
-}
-
-static JSOBJ newDouble(void *context, double value)
-{
-	struct DecoderState *ds = context;
-	DoubleValue *dv = (DoubleValue *) alloc(ds, sizeof(DoubleValue));
-	dv->item.type = UJT_Double;
-	dv->value = (double) value;
-	return (JSOBJ) dv;
-}
-
-static void releaseObject(void *context, JSOBJ obj)
-{
-	struct DecoderState *ds = context;
-	//NOTE: Fix for C4100 warning in L4 MSVC
-	ds = NULL;
-	obj = NULL;
-}
-
-static double GetDouble(UJObject obj)
-{
-	return ((DoubleValue *) obj)->value;
-}
-
-static long GetLong(UJObject obj)
-{
-	return ((LongValue *) obj)->value;
-}
-
-static long long GetLongLong(UJObject obj)
-{
-	return ((LongLongValue *) obj)->value;
-}
-
-void UJFree(void *state)
-{
-	struct DecoderState *ds = (struct DecoderState *) state;
-
-	HeapSlab *slab = ds->heap;
-	HeapSlab *next;
-	while (slab)
-	{
-		next = slab->next;
-
-		if (slab->owned)
-		{
-			ds->free(slab);
-		}
-
-		slab = next;
-	}
-}
-
-int UJIsNull(UJObject obj)
-{
-	if (((Item *) obj)->type == UJT_Null)
-	{
-		return 1;
-	}
-
-	return 0;
-}
-
-int UJIsTrue(UJObject obj)
-{
-	if (((Item *) obj)->type == UJT_True)
-	{
-		return 1;
-	}
-	
-	return 0;
-}
-
-int UJIsFalse(UJObject obj)
-{
-	if (((Item *) obj)->type == UJT_False)
-	{
-		return 1;
-	}
-	
-
-	return 0;
-}
-
-int UJIsLong(UJObject obj)
-{
-	if (((Item *) obj)->type == UJT_Long)
-	{
-		return 1;
-	}
-
-	return 0;
-}
-
-int UJIsLongLong(UJObject obj)
-{
-	if (((Item *) obj)->type == UJT_LongLong)
-	{
-		return 1;
-	}
-
-	return 0;
-}
-
-int UJIsInteger(UJObject *obj)
-{
-	if (((Item *) obj)->type == UJT_LongLong ||
-		((Item *) obj)->type == UJT_Long)
-	{
-		return 1;
-	}
-
-	return 0;
-}
-
-int UJIsDouble(UJObject obj)
-{
-	if (((Item *) obj)->type == UJT_Double)
-	{
-		return 1;
-	}
-
-	return 0;
-}
-
-int UJIsString(UJObject obj)
-{
-	if (((Item *) obj)->type == UJT_String)
-	{
-		return 1;
-	}
-
-	return 0;
-}
-
-int UJIsArray(UJObject obj)
-{
-	if (((Item *) obj)->type == UJT_Array)
-	{
-		return 1;
-	}
-
-	return 0;
-}
-
-int UJIsObject(UJObject obj)
-{
-	if (((Item *) obj)->type == UJT_Object)
-	{
-		return 1;
-	}
-
-	return 0;
-}
-
-void *UJBeginArray(UJObject arrObj)
-{
-	switch ( ((Item *) arrObj)->type)
-	{
-	case UJT_Array: return ((ObjectItem *) arrObj)->head;
-	default: break;
-	}
-
-	return NULL;
-}
-
-int UJIterArray(void **iter, UJObject *outObj)
-{
-	ArrayEntry *ae = (ArrayEntry *) *iter;
-
-	if (ae == NULL)
-	{
-		return 0;
-	}
-
-	*iter = ae->next;
-	*outObj = ae->item;
-
-	return 1;
-}
-
-void *UJBeginObject(UJObject objObj)
-{
-	switch ( ((Item *) objObj)->type)
-	{
-	case UJT_Object: return ((ObjectItem *) objObj)->head;
-	default: break;
-	}
-
-	return NULL;
-}
-
-int UJIterObject(void **iter, UJString *outKey, UJObject *outValue)
-{
-	KeyPair *kp;
-
-	if (*iter == NULL)
-	{
-		return 0;
-	}
-
-	kp = (KeyPair *) *iter;
-
-	if (kp == NULL)
-	{
-		return 0;
-	}
-
-	*outKey = ((StringItem *) kp->name)->str;
-	*outValue = kp->value;
-	*iter = kp->next;
-	return 1;
-}
-
-long long UJNumericLongLong(UJObject obj)
-{
-	switch ( ((Item *) obj)->type)
-	{
-	case UJT_Long: return (long long) GetLong(obj);
-	case UJT_LongLong: return (long long) GetLongLong(obj);
-	case UJT_Double: return (long long) GetDouble(obj);
-	default: break;
-	}
-
-	return 0;
-}
-
-int UJNumericInt(UJObject obj)
-{
-	switch ( ((Item *) obj)->type)
-	{
-	case UJT_Long: return (int) GetLong(obj);
-	case UJT_LongLong: return (int) GetLongLong(obj);
-	case UJT_Double: return (int) GetDouble(obj);
-	default: break;
-	}
-
-	return 0;
-}
-
-double UJNumericFloat(UJObject obj)
-{
-	switch ( ((Item *) obj)->type)
-	{
-	case UJT_Long: return (double) GetLong(obj);
-	case UJT_LongLong: return (double) GetLongLong(obj);
-	case UJT_Double: return (double) GetDouble(obj);
-	default: break;
-	}
-
-	return 0.0;
-}
-
-const wchar_t *UJReadString(UJObject obj, size_t *cchOutBuffer)
-{
-	switch ( ((Item *) obj)->type)
-	{
-	case UJT_String:
-		if (cchOutBuffer)
-			*cchOutBuffer = ( (StringItem *) obj)->str.cchLen;
-		return ( (StringItem *) obj)->str.ptr;
-
-	default:
-		break;
-	}
-
-	if (cchOutBuffer)
-		*cchOutBuffer = 0;
-	return L"";
-}
-
-const char *UJGetError(void *state)
-{
-	if (state == NULL)
-		return NULL;
-
-	return ( (struct DecoderState *) state)->error;
-}
-
-int UJGetType(UJObject obj)
-{
-	return ((Item *) obj)->type;
-}
-
-static int checkType(int ki, const char *format, UJObject obj)
-{
-	int c = (unsigned char) format[ki];
-	int type = UJGetType(obj);
-	int allowNull = 0;
-
-	switch (c)
-	{
-	case 'b':
-		allowNull = 1;
-	case 'B':
-		switch (type)
-		{
-			case UJT_Null:
-				if (!allowNull)
-					return 0;
-			case UJT_True:
-			case UJT_False:
-				return 1;
-
-			default:
-				return 0;
-		}
-		break;
-
-	case 'n':
-		allowNull = 1;
-	case 'N':
-		switch (type)
-		{
-			case UJT_Null:
-				if (!allowNull)
-					return 0;
-			case UJT_Long:
-			case UJT_LongLong:
-			case UJT_Double:
-				return 1;
-
-			default:
-				return 0;
-		}
-		break;
-
-	case 's':
-		allowNull = 1;
-	case 'S':
-		switch (type)
-		{
-			case UJT_Null:
-				if (!allowNull)
-					return 0;
-			case UJT_String:
-				return 1;
-
-			default:
-				return 0;
-		}
-		break;
-
-	case 'a':
-		allowNull = 1;
-	case 'A':
-		switch (type)
-		{
-			case UJT_Null:
-				if (!allowNull)
-					return 0;
-			case UJT_Array:
-				return 1;
-
-			default:
-				return 0;
-		}
-		break;
-
-	case 'o':
-		allowNull = 1;
-	case 'O':
-		switch (type)
-		{
-			case UJT_Null:
-				if (!allowNull)
-					return 0;
-			case UJT_Object:
-				return 1;
-			default:
-				return 0;
-		}
-
-		break;
-
-	case 'u':
-		allowNull = 1;
-	case 'U':
-		return 1;
-		break;
-	}
-
-	return 0;
-}
-
-int UJObjectUnpack(UJObject objObj, int keys, const char *format, const wchar_t **_keyNames, ...)
-{
-	void *iter;
-	UJString key;
-	UJObject value;
-	int found = 0;
-	int ki;
-	int ks = 0;
-	const wchar_t *keyNames[64];
-  va_list args;
-  UJObject *outValue;
-
-  va_start(args, _keyNames);
-
-  if (!UJIsObject(objObj))
-	{
-		return 0;
-	}
-  
-	iter = UJBeginObject(objObj);
-
-	if (keys > 64)
-	{
-		return -1;
-	}
-
-	for (ki = 0; ki < keys; ki ++)
-	{
-		keyNames[ki] = _keyNames[ki];
-	}
-	
-	while (UJIterObject(&iter, &key, &value))
-	{
-		for (ki = ks; ki < keys; ki ++)
-		{
-			const wchar_t *kn = keyNames[ki];
-
-			if (kn == NULL)
-			{
-				continue;
-			}
-
-			if (wcscmp(key.ptr, kn) != 0)
-			{
-				continue;
-			}
-
-			if (!checkType(ki, format, value))
-			{
-				continue;
-			}
-
-			found ++;
-
-      outValue = va_arg(args, UJObject);
-
-      if (outValue != NULL)
-      {
-  			*outValue = value;
-      }
-			keyNames[ki] = NULL;
-
-			if (ki == ks)
-			{
-				ks ++;
-			}
-		}
-	}
-
-  va_end(args);
-
-	return found;
-}
-
-UJObject UJDecode(const char *input, size_t cbInput, UJHeapFuncs *hf, void **outState)
-{
-	UJObject ret;
-	struct DecoderState *ds;
-	void *initialHeap;
-	size_t cbInitialHeap;
-	HeapSlab *slab;
-
-	JSONObjectDecoder decoder = {
-		newString,
-		objectAddKey,
-		arrayAddItem,
-		newTrue,
-		newFalse,
-		newNull,
-		newObject,
-		newArray,
-		newInt,
-		newLong,
-		newDouble,
-		releaseObject,
-		NULL,
-		NULL,
-		NULL,
-		NULL,
-		NULL,
-		0, 
-		NULL
-	};
-
-	if (hf == NULL)
-	{
-		decoder.malloc = malloc;
-		decoder.free = free;
-		decoder.realloc = realloc;
-		cbInitialHeap = 16384;
-		initialHeap = malloc(cbInitialHeap);
-	}
-	else
-	{
-		decoder.malloc = hf->malloc;
-		decoder.free = hf->free;
-		decoder.realloc = hf->realloc;
-		initialHeap = hf->initalHeap;
-		cbInitialHeap = hf->cbInitialHeap;
-	
-		if (cbInitialHeap < sizeof(HeapSlab) + sizeof(struct DecoderState))
-		{
-			return NULL;
-		}
-	}
-
-	*outState = NULL;
-
-	slab = (HeapSlab * ) initialHeap;
-	slab->start = (unsigned char *) (slab + 1);
-	slab->offset = slab->start;
-	slab->end = (unsigned char *) initialHeap + cbInitialHeap;
-	slab->size = cbInitialHeap;
-	slab->owned = hf == NULL ? 1 : 0;
-	slab->next = NULL;
-
-	ds = (struct DecoderState *) slab->offset;
-	slab->offset += sizeof(struct DecoderState);
-	*outState = (void *) ds;
-
-	ds->heap = slab;
-	
-	ds->malloc = decoder.malloc;
-	ds->free = decoder.free;
-	ds->error = NULL; 
-
-	decoder.prv = (void *) ds;
-
-	ret = (UJObject) JSON_DecodeObject(&decoder, input, cbInput);
-
-	if (ret == NULL)
-	{
-		ds->error = decoder.errorStr;
-	}
-
-	return ret;
-}
+/*
+ujson4c decoder helper 1.0
+Developed by ESN, an Electronic Arts Inc. studio. 
+Copyright (c) 2013, Electronic Arts Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of ESN, Electronic Arts Inc. nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS INC. BE LIABLE 
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Uses UltraJSON library:
+Copyright (c) 2013, Electronic Arts Inc.
+All rights reserved.
+www.github.com/esnme/ultrajson
+*/
+
+#include "ujdecode.h"
+#include "ultrajson.h"
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <limits.h>
+#include <stddef.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/*
+Item flags, set on representations that share a public type */
+#define ITEM_UTF8 0x0001
+#define ITEM_RAW 0x0002
+#define ITEM_INDEXED 0x0004
+#define ITEM_INTERNED 0x0008
+
+typedef struct __Item
+{
+	int type;
+	int flags;
+} Item;
+
+typedef struct __StringItem
+{
+	Item item;
+	UJString str;
+} StringItem;
+
+typedef struct __UTF8StringItem
+{
+	Item item;
+	UJUTF8String str;
+} UTF8StringItem;
+
+typedef struct __KeyPair
+{
+	StringItem *name;
+	Item *value;
+	struct __KeyPair *next;
+} KeyPair;
+
+typedef struct __ObjectItem
+{
+	Item item;
+	KeyPair *head;
+	KeyPair *tail;
+
+	// The decoder state until UJObjectGet builds a KeyIndex, which ITEM_INDEXED tells
+	void *lookup;
+} ObjectItem;
+
+typedef struct __ArrayItem
+{
+	Item item;
+
+	// Null terminated, NULL while the array is open
+	Item **items;
+
+	// While the array is open, the position of its first element on the element stack
+	size_t count;
+} ArrayItem; 
+
+typedef struct __LongValue
+{
+	Item item;
+	long value;
+} LongValue;
+
+typedef struct __LongLongValue
+{
+	Item item;
+	long long value;
+} LongLongValue;
+
+typedef struct __DoubleValue
+{
+	Item item;
+	double value;
+} DoubleValue;
+
+typedef struct __RawNumberItem
+{
+	Item item;
+	const char *start;
+	const char *end;
+} RawNumberItem;
+
+/*
+Scalars that fit in a pointer are not allocated but carried in the handle stored in their parent.
+Items are 8 byte aligned, which leaves the low bits of a handle free for a tag:
+...1  an integer, shifted left by one
+.100  null, true or false, the type shifted left by three
+..10  a word on the tape of a UJF_TAPE document */
+#define IS_ITEM(obj) (((size_t) (obj) & 7) == 0)
+#define IS_INLINE_INT(obj) ((size_t) (obj) & 1)
+#define IS_INLINE_CONST(obj) (((size_t) (obj) & 7) == 4)
+#define INLINE_INT(value) ((JSOBJ) (((size_t) (value) << 1) | 1))
+#define INLINE_INT_VALUE(obj) ((long) ((ptrdiff_t) (obj) >> 1))
+#define INLINE_CONST(type) ((JSOBJ) (((size_t) (type) << 3) | 4))
+#define INLINE_CONST_TYPE(obj) ((int) ((size_t) (obj) >> 3))
+
+// Only 31 bits are left for the integer with 32-bit pointers
+#define INLINE_INT_FITS(value) (sizeof(size_t) > 4 || ((value) >= -0x40000000 && (value) < 0x40000000))
+
+typedef struct __HeapSlab
+{
+	unsigned char *start;
+	unsigned char *offset;
+	unsigned char *end;
+	size_t size;
+	char owned;
+	struct __HeapSlab *next;
+} HeapSlab;
+
+struct DecoderState
+{
+	HeapSlab *heap;
+	const char *error;
+	const char *input;
+	const char *inputEnd;
+	void *(*malloc)(size_t cbSize);
+	void (*free)(void *ptr);
+
+	// Slab holding this state, and an empty slab kept by resetHeap for the next document
+	HeapSlab *base;
+	HeapSlab *spare;
+	JSONObjectDecoder decoder;
+	int flags;
+
+	// Set between UJStreamCreate and UJStreamFinish
+	JSONStreamDecoder *stream;
+
+	// State of the document the slabs of this one were handed over to by adoptSlice
+	struct DecoderState *owner;
+
+	// Elements of the open arrays, innermost last, moved into the arena as each array closes
+	Item **elements;
+	size_t cElements;
+	size_t cElementsMax;
+
+	// The document with UJF_TAPE
+	JSUINT64 *tape;
+	size_t cTape;
+	size_t cTapeMax;
+
+	// Keys shared by the documents of a UJF_INTERNKEYS decoder
+	struct KeyIntern *interned;
+
+	// Threads used by UJF_PARALLEL, 0 for one per processor
+	int threads;
+};
+
+
+/*
+All arena allocations are kept 8 byte aligned */
+#define ARENA_ALIGN(cbSize) (((cbSize) + 7) & ~((size_t) 7))
+
+static void *alloc(struct DecoderState *ds, size_t cbSize)
+{
+	unsigned char *ret;
+
+	cbSize = ARENA_ALIGN(cbSize);
+
+	if (ds->heap->offset + cbSize > ds->heap->end)
+	{
+		size_t newSize = ds->heap->size * 2;
+		HeapSlab *newSlab;
+
+		if (ds->spare && ds->spare->offset + cbSize <= ds->spare->end)
+		{
+			newSlab = ds->spare;
+			ds->spare = NULL;
+		}
+		else
+		{
+			while (newSize < (cbSize + sizeof (HeapSlab)))
+				newSize *= 2;
+
+			newSlab = (HeapSlab *) ds->malloc(newSize);
+			newSlab->start = (unsigned char *) (newSlab + 1);
+			newSlab->end = (unsigned char *) newSlab + newSize;
+			newSlab->size = newSize;
+			newSlab->offset = newSlab->start;
+			newSlab->owned = 1;
+		}
+
+		newSlab->next = ds->heap;
+		ds->heap = newSlab;
+	}
+
+
+	ret = ds->heap->offset;
+	ds->heap->offset += cbSize;
+
+	return ret;
+}
+
+static JSOBJ newString(void* context, wchar_t *start, wchar_t *end)
+{
+	struct DecoderState *ds = context;
+	size_t len;
+	StringItem *si = (StringItem *) alloc(ds, sizeof(StringItem) + (end - start + 1) * sizeof(wchar_t));
+	len = end - start;
+
+	si->item.type = UJT_String;
+	si->item.flags = 0;
+	si->str.ptr = (wchar_t *) (si + 1);
+	si->str.cchLen = len;
+
+	if (len < 4)
+	{
+		wchar_t *dst = si->str.ptr;
+		wchar_t *end = dst + len;
+
+		while (dst < end)
+		{
+			*(dst++) = *(start++);
+		}
+	}
+	else
+	{
+		memcpy (si->str.ptr, start, len * sizeof(wchar_t));
+	}
+	si->str.ptr[len] = '\0';
+	return (JSOBJ) si;
+}
+
+static JSOBJ newUTF8String(void *context, char *start, char *end)
+{
+	struct DecoderState *ds = context;
+	size_t len = end - start;
+	UTF8StringItem *si = (UTF8StringItem *) alloc(ds, sizeof(UTF8StringItem) + len + 1);
+	char *ptr = (char *) (si + 1);
+
+	si->item.type = UJT_String;
+	si->item.flags = ITEM_UTF8;
+	memcpy (ptr, start, len);
+	ptr[len] = '\0';
+	si->str.ptr = ptr;
+	si->str.cbLen = len;
+	return (JSOBJ) si;
+}
+
+/*
+UJF_ZEROCOPY variant. Ranges of the input buffer are referenced instead of copied,
+strings with escapes arrive in the decoders scratch buffer and are copied as usual */
+static JSOBJ newUTF8StringView(void *context, char *start, char *end)
+{
+	struct DecoderState *ds = context;
+	UTF8StringItem *si;
+
+	if (start < ds->input || end > ds->inputEnd)
+	{
+		return newUTF8String(context, start, end);
+	}
+
+	si = (UTF8StringItem *) alloc(ds, sizeof(UTF8StringItem));
+	si->item.type = UJT_String;
+	si->item.flags = ITEM_UTF8;
+	si->str.ptr = start;
+	si->str.cbLen = end - start;
+	return (JSOBJ) si;
+}
+
+static void objectAddKey(void* context, JSOBJ obj, JSOBJ name, JSOBJ value)
+{
+	struct DecoderState *ds = context;
+	ObjectItem *oi = (ObjectItem *) obj;
+	KeyPair *kp = (KeyPair *) alloc(ds, sizeof(KeyPair));
+
+	kp->next = NULL;
+
+	kp->name = (StringItem *) name;
+	kp->value = (Item *) value;
+
+	if (oi->tail)
+	{
+		oi->tail->next = kp;
+	}
+	else
+	{
+		oi->head = kp;
+	}
+	oi->tail = kp;
+}
+
+static void arrayAddItem(void* context, JSOBJ obj, JSOBJ value)
+{
+	struct DecoderState *ds = context;
+	//NOTE: Fix for C4100 warning in L4 MSVC
+	(void) obj;
+
+	if (ds->cElements == ds->cElementsMax)
+	{
+		size_t cElementsMax = ds->cElementsMax ? ds->cElementsMax * 2 : 256;
+		Item **elements = (Item **) ds->decoder.realloc(ds->elements, cElementsMax * sizeof(Item *));
+
+		if (elements == NULL)
+		{
+			// Fails the decode once it returns
+			ds->decoder.errorStr = (char *) "Could not reserve memory block";
+			return;
+		}
+
+		ds->elements = elements;
+		ds->cElementsMax = cElementsMax;
+	}
+
+	ds->elements[ds->cElements ++] = (Item *) value;
+}
+
+/*
+Shared by all empty arrays */
+static Item *emptyItems[1] = { NULL };
+
+static void endArray(void *context, JSOBJ obj)
+{
+	struct DecoderState *ds = context;
+	ArrayItem *ai = (ArrayItem *) obj;
+	size_t count = ds->cElements - ai->count;
+
+	if (count == 0)
+	{
+		ai->items = emptyItems;
+		ai->count = 0;
+		return;
+	}
+
+	ai->items = (Item **) alloc(ds, (count + 1) * sizeof(Item *));
+	memcpy(ai->items, ds->elements + ai->count, count * sizeof(Item *));
+	ai->items[count] = NULL;
+
+	ds->cElements = ai->count;
+	ai->count = count;
+}
+
+static JSOBJ newTrue(void* context)
+{
+	//NOTE: Fix for C4100 warning in L4 MSVC
+	(void) context;
+	return INLINE_CONST(UJT_True);
+}
+
+static JSOBJ newFalse(void *context)
+{
+	//NOTE: Fix for C4100 warning in L4 MSVC
+	(void) context;
+	return INLINE_CONST(UJT_False);
+}
+
+static JSOBJ newNull(void *context)
+{
+	//NOTE: Fix for C4100 warning in L4 MSVC
+	(void) context;
+	return INLINE_CONST(UJT_Null);
+}
+
+static JSOBJ newObject(void *context)
+{
+	struct DecoderState *ds = context;
+	ObjectItem *oi = (ObjectItem *) alloc(ds, sizeof(ObjectItem));
+	oi->item.type = UJT_Object;
+	oi->item.flags = 0;
+	oi->head = NULL;
+	oi->tail = NULL;
+	oi->lookup = ds;
+
+	return (JSOBJ) oi;
+}
+
+static JSOBJ newArray(void *context)
+{
+	struct DecoderState *ds = context;
+	ArrayItem *ai = (ArrayItem *) alloc(ds, sizeof(ArrayItem));
+	ai->items = NULL;
+	ai->count = ds->cElements;
+	ai->item.type = UJT_Array;
+	ai->item.flags = 0;
+	return (JSOBJ) ai;
+}
+
+static JSOBJ newInt(void *context, JSINT32 value)
+{
+	struct DecoderState *ds = context;
+	LongValue *lv;
+
+	if (INLINE_INT_FITS(value))
+	{
+		return INLINE_INT(value);
+	}
+
+	lv = (LongValue *) alloc(ds, sizeof(LongValue));
+	lv->item.type = UJT_Long;
+	lv->item.flags = 0;
+	lv->value = (long) value;
+	return (JSOBJ) lv;
+}
+
+static JSOBJ newLong(void *context, JSINT64 value)
+{
+	struct DecoderState *ds = context;
+	LongLongValue *llv = (LongLongValue *) alloc(ds, sizeof(LongLongValue));
+	llv->item.type = UJT_LongLong;
+	llv->item.flags = 0;
+	llv->value = (long long) value;
+	return (JSOBJ) llv;
+}
+
+static JSOBJ newDouble(void *context, double value)
+{
+	struct DecoderState *ds = context;
+	DoubleValue *dv = (DoubleValue *) alloc(ds, sizeof(DoubleValue));
+	dv->item.type = UJT_Double;
+	dv->item.flags = 0;
+	dv->value = (double) value;
+	return (JSOBJ) dv;
+}
+
+/*
+UJF_LAZYNUMBERS variant. The range of the number is kept and converted on every access */
+static JSOBJ newRawNumber(void *context, char *start, char *end, int type)
+{
+	struct DecoderState *ds = context;
+	RawNumberItem *rn = (RawNumberItem *) alloc(ds, sizeof(RawNumberItem));
+	rn->item.type = type == JT_DOUBLE ? UJT_Double : (type == JT_LONG ? UJT_LongLong : UJT_Long);
+	rn->item.flags = ITEM_RAW;
+	rn->start = start;
+	rn->end = end;
+	return (JSOBJ) rn;
+}
+
+static void releaseObject(void *context, JSOBJ obj)
+{
+	struct DecoderState *ds = context;
+	//NOTE: Fix for C4100 warning in L4 MSVC
+	ds = NULL;
+	obj = NULL;
+}
+
+/*
+UJF_TAPE. The document is one array of 64-bit words in document order. The top byte of a word tells
+its kind, the rest holds a payload:
+'n', 't', 'f'  null, true and false
+'i'            an integer of 32 bits, sign extended in the payload
+'l', 'd'       a 64-bit integer or a double, in the word that follows
+'"'            a UTF-8 string of payload bytes, null terminated in the words that follow
+'[', '{'       a container. The low 32 bits of the payload hold the offset in words to its closing word,
+               the 24 above the number of elements or members, saturated at TAPE_COUNT_MAX
+']', '}'       the closing word of a container, holding the offset back to its opening word
+Objects hold each key as a string followed by its value.
+
+While decoding, values are referred to by their index as the tape moves when it grows. Handed out are
+pointers to the words tagged with TAPE_HANDLE, which the 8 byte aligned Item pointers never carry */
+#define TAPE_HANDLE 2
+#define TAPE_COUNT_MAX 0xffffff
+#define TAPE_KIND(word) ((int) ((word) >> 56))
+#define TAPE_PAYLOAD(word) ((word) & 0x00ffffffffffffffULL)
+#define TAPE_MAKE(kind, payload) (((JSUINT64) (kind) << 56) | (payload))
+#define TAPE_OFFSET(word) ((size_t) ((word) & 0xffffffffU))
+#define TAPE_COUNT(word) ((size_t) (((word) >> 32) & TAPE_COUNT_MAX))
+
+#define IS_TAPE(obj) (((size_t) (obj) & 3) == TAPE_HANDLE)
+#define TAPE_PTR(obj) ((const JSUINT64 *) ((size_t) (obj) & ~(size_t) 3))
+#define TAPE_REF(word) ((UJObject) ((size_t) (word) | TAPE_HANDLE))
+#define TAPE_AT(index) ((JSOBJ) (((index) << 2) | TAPE_HANDLE))
+#define TAPE_INDEX(obj) ((size_t) (obj) >> 2)
+
+/*
+Reserves cWords at the end of the tape and points outIndex at the first. Returns 0 and fails the decode
+if the tape can not grow */
+static int tapeAppend(struct DecoderState *ds, size_t cWords, size_t *outIndex)
+{
+	size_t cTapeMax = ds->cTapeMax;
+	JSUINT64 *tape;
+
+	if (ds->cTape + cWords > cTapeMax)
+	{
+		while (ds->cTape + cWords > cTapeMax)
+		{
+			cTapeMax = cTapeMax ? cTapeMax * 2 : 1024;
+		}
+
+		tape = (JSUINT64 *) ds->decoder.realloc(ds->tape, cTapeMax * sizeof(JSUINT64));
+
+		if (tape == NULL)
+		{
+			ds->decoder.errorStr = (char *) "Could not reserve memory block";
+			return 0;
+		}
+
+		ds->tape = tape;
+		ds->cTapeMax = cTapeMax;
+	}
+
+	*outIndex = ds->cTape;
+	ds->cTape += cWords;
+	return 1;
+}
+
+static JSOBJ tapeWord(struct DecoderState *ds, int kind, JSUINT64 payload)
+{
+	size_t index;
+
+	if (!tapeAppend(ds, 1, &index))
+	{
+		return NULL;
+	}
+
+	ds->tape[index] = TAPE_MAKE(kind, payload);
+	return TAPE_AT(index);
+}
+
+static JSOBJ tapeWords(struct DecoderState *ds, int kind, JSUINT64 value)
+{
+	size_t index;
+
+	if (!tapeAppend(ds, 2, &index))
+	{
+		return NULL;
+	}
+
+	ds->tape[index] = TAPE_MAKE(kind, 0);
+	ds->tape[index + 1] = value;
+	return TAPE_AT(index);
+}
+
+static JSOBJ tapeString(void *context, char *start, char *end)
+{
+	struct DecoderState *ds = context;
+	size_t cbString = (size_t) (end - start);
+	size_t index;
+
+	if (!tapeAppend(ds, cbString / 8 + 2, &index))
+	{
+		return NULL;
+	}
+
+	// Clearing the last word terminates and pads the string
+	ds->tape[index] = TAPE_MAKE('\"', (JSUINT64) cbString);
+	ds->tape[index + 1 + cbString / 8] = 0;
+	memcpy(ds->tape + index + 1, start, cbString);
+	return TAPE_AT(index);
+}
+
+static JSOBJ tapeTrue(void *context)
+{
+	return tapeWord((struct DecoderState *) context, 't', 0);
+}
+
+static JSOBJ tapeFalse(void *context)
+{
+	return tapeWord((struct DecoderState *) context, 'f', 0);
+}
+
+static JSOBJ tapeNull(void *context)
+{
+	return tapeWord((struct DecoderState *) context, 'n', 0);
+}
+
+static JSOBJ tapeObject(void *context)
+{
+	return tapeWord((struct DecoderState *) context, '{', 0);
+}
+
+static JSOBJ tapeArray(void *context)
+{
+	return tapeWord((struct DecoderState *) context, '[', 0);
+}
+
+static JSOBJ tapeInt(void *context, JSINT32 value)
+{
+	return tapeWord((struct DecoderState *) context, 'i', TAPE_PAYLOAD((JSUINT64) (JSINT64) value));
+}
+
+static JSOBJ tapeLong(void *context, JSINT64 value)
+{
+	return tapeWords((struct DecoderState *) context, 'l', (JSUINT64) value);
+}
+
+static JSOBJ tapeDouble(void *context, double value)
+{
+	JSUINT64 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return tapeWords((struct DecoderState *) context, 'd', bits);
+}
+
+static void tapeCount(struct DecoderState *ds, JSOBJ obj)
+{
+	JSUINT64 *word;
+
+	if (ds->decoder.errorStr)
+	{
+		// The tape could not grow, obj may not be on it
+		return;
+	}
+
+	word = ds->tape + TAPE_INDEX(obj);
+
+	if (TAPE_COUNT(*word) != TAPE_COUNT_MAX)
+	{
+		*word += (JSUINT64) 1 << 32;
+	}
+}
+
+static void tapeAddKey(void *context, JSOBJ obj, JSOBJ name, JSOBJ value)
+{
+	//NOTE: Fix for C4100 warning in L4 MSVC
+	(void) name;
+	(void) value;
+	tapeCount((struct DecoderState *) context, obj);
+}
+
+static void tapeAddItem(void *context, JSOBJ obj, JSOBJ value)
+{
+	//NOTE: Fix for C4100 warning in L4 MSVC
+	(void) value;
+	tapeCount((struct DecoderState *) context, obj);
+}
+
+static void tapeEnd(void *context, JSOBJ obj)
+{
+	struct DecoderState *ds = context;
+	size_t open = TAPE_INDEX(obj);
+	size_t close;
+
+	// Once the tape could not grow, obj may not be on it
+	if (ds->decoder.errorStr || !tapeAppend(ds, 1, &close))
+	{
+		return;
+	}
+
+	ds->tape[open] |= (JSUINT64) (close - open);
+	ds->tape[close] = TAPE_MAKE(TAPE_KIND(ds->tape[open]) == '[' ? ']' : '}', (JSUINT64) (close - open));
+}
+
+static UJObject tapeRoot(struct DecoderState *ds, JSOBJ obj)
+{
+	return obj ? TAPE_REF(ds->tape + TAPE_INDEX(obj)) : NULL;
+}
+
+static int tapeType(const JSUINT64 *word)
+{
+	switch (TAPE_KIND(*word))
+	{
+	case 'n': return UJT_Null;
+	case 't': return UJT_True;
+	case 'f': return UJT_False;
+	case 'i': return UJT_Long;
+	case 'l': return UJT_LongLong;
+	case 'd': return UJT_Double;
+	case '\"': return UJT_String;
+	case '[': return UJT_Array;
+	default: break;
+	}
+
+	return UJT_Object;
+}
+
+/*
+Returns the word following the value at word */
+static const JSUINT64 *tapeSkip(const JSUINT64 *word)
+{
+	switch (TAPE_KIND(*word))
+	{
+	case 'l':
+	case 'd': return word + 2;
+	case '\"': return word + 2 + TAPE_PAYLOAD(*word) / 8;
+	case '[':
+	case '{': return word + TAPE_OFFSET(*word) + 1;
+	default: break;
+	}
+
+	return word + 1;
+}
+
+static void tapeView(const JSUINT64 *word, UJUTF8String *outView)
+{
+	outView->ptr = (const char *) (word + 1);
+	outView->cbLen = (size_t) TAPE_PAYLOAD(*word);
+}
+
+static double GetDouble(UJObject obj)
+{
+	double value;
+
+	if (IS_TAPE(obj))
+	{
+		memcpy(&value, TAPE_PTR(obj) + 1, sizeof(value));
+		return value;
+	}
+
+	if (((Item *) obj)->flags & ITEM_RAW)
+		return JSON_DecodeRawDouble(((RawNumberItem *) obj)->start, ((RawNumberItem *) obj)->end);
+
+	return ((DoubleValue *) obj)->value;
+}
+
+static long GetLong(UJObject obj)
+{
+	if (IS_INLINE_INT(obj))
+		return INLINE_INT_VALUE(obj);
+
+	if (IS_TAPE(obj))
+		return (long) ((JSINT64) (TAPE_PAYLOAD(*TAPE_PTR(obj)) ^ 0x0080000000000000ULL) - 0x0080000000000000LL);
+
+	if (((Item *) obj)->flags & ITEM_RAW)
+		return (long) JSON_DecodeRawInteger(((RawNumberItem *) obj)->start, ((RawNumberItem *) obj)->end);
+
+	return ((LongValue *) obj)->value;
+}
+
+static long long GetLongLong(UJObject obj)
+{
+	if (IS_TAPE(obj))
+		return (long long) TAPE_PTR(obj)[1];
+
+	if (((Item *) obj)->flags & ITEM_RAW)
+		return (long long) JSON_DecodeRawInteger(((RawNumberItem *) obj)->start, ((RawNumberItem *) obj)->end);
+
+	return ((LongLongValue *) obj)->value;
+}
+
+static void freeInterned(struct DecoderState *ds);
+
+void UJFree(void *state)
+{
+	struct DecoderState *ds = (struct DecoderState *) state;
+
+	HeapSlab *slab = ds->heap;
+	HeapSlab *next;
+
+	if (ds->stream)
+	{
+		JSON_StreamFinish(ds->stream);
+	}
+
+	if (ds->spare)
+	{
+		ds->free(ds->spare);
+	}
+
+	if (ds->elements)
+	{
+		ds->free(ds->elements);
+	}
+
+	if (ds->tape)
+	{
+		ds->free(ds->tape);
+	}
+
+	if (ds->interned)
+	{
+		freeInterned(ds);
+	}
+
+	while (slab)
+	{
+		next = slab->next;
+
+		if (slab->owned)
+		{
+			ds->free(slab);
+		}
+
+		slab = next;
+	}
+}
+
+/*
+Drops the previous document. The slabs it grew are replaced by a single spare slab of their combined
+size, so a decoder settles on two slabs and stops allocating once it has seen its largest document */
+static void resetHeap(struct DecoderState *ds)
+{
+	HeapSlab *slab = ds->heap;
+	HeapSlab *next;
+	size_t cbTotal = 0;
+	int count = 0;
+
+	// Arrays left open by a failed decode
+	ds->cElements = 0;
+	ds->cTape = 0;
+
+	while (slab != ds->base)
+	{
+		next = slab->next;
+		cbTotal += slab->size;
+		count ++;
+
+		if (count == 1 && next == ds->base && ds->spare == NULL)
+		{
+			// A single grown slab is kept as it is
+			ds->spare = slab;
+			break;
+		}
+
+		ds->free(slab);
+		slab = next;
+	}
+
+	if (count > 1 || (count == 1 && ds->spare != ds->heap))
+	{
+		if (ds->spare)
+		{
+			cbTotal += ds->spare->size;
+			ds->free(ds->spare);
+		}
+
+		ds->spare = (HeapSlab *) ds->malloc(cbTotal);
+
+		if (ds->spare)
+		{
+			ds->spare->start = (unsigned char *) (ds->spare + 1);
+			ds->spare->end = (unsigned char *) ds->spare + cbTotal;
+			ds->spare->size = cbTotal;
+			ds->spare->owned = 1;
+		}
+	}
+
+	if (ds->spare)
+	{
+		ds->spare->offset = ds->spare->start;
+		ds->spare->next = NULL;
+	}
+
+	ds->base->offset = ds->base->start + ARENA_ALIGN(sizeof(struct DecoderState));
+	ds->base->next = NULL;
+	ds->heap = ds->base;
+	ds->error = NULL;
+}
+
+int UJIsNull(UJObject obj)
+{
+	if (UJGetType(obj) == UJT_Null)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+int UJIsTrue(UJObject obj)
+{
+	if (UJGetType(obj) == UJT_True)
+	{
+		return 1;
+	}
+	
+	return 0;
+}
+
+int UJIsFalse(UJObject obj)
+{
+	if (UJGetType(obj) == UJT_False)
+	{
+		return 1;
+	}
+	
+
+	return 0;
+}
+
+int UJIsLong(UJObject obj)
+{
+	if (UJGetType(obj) == UJT_Long)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+int UJIsLongLong(UJObject obj)
+{
+	if (UJGetType(obj) == UJT_LongLong)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+int UJIsInteger(UJObject *obj)
+{
+	if (UJGetType(obj) == UJT_LongLong ||
+		UJGetType(obj) == UJT_Long)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+int UJIsDouble(UJObject obj)
+{
+	if (UJGetType(obj) == UJT_Double)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+int UJIsString(UJObject obj)
+{
+	if (UJGetType(obj) == UJT_String)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+int UJIsArray(UJObject obj)
+{
+	if (UJGetType(obj) == UJT_Array)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+int UJIsObject(UJObject obj)
+{
+	if (UJGetType(obj) == UJT_Object)
+	{
+		return 1;
+	}
+
+	return 0;
+}
+
+void *UJBeginArray(UJObject arrObj)
+{
+	if (IS_TAPE(arrObj))
+	{
+		return UJIsArray(arrObj) ? TAPE_REF(TAPE_PTR(arrObj) + 1) : NULL;
+	}
+
+	switch (UJGetType(arrObj))
+	{
+	case UJT_Array: return ((ArrayItem *) arrObj)->items;
+	default: break;
+	}
+
+	return NULL;
+}
+
+int UJIterArray(void **iter, UJObject *outObj)
+{
+	Item **item = (Item **) *iter;
+	const JSUINT64 *word;
+
+	if (IS_TAPE(item))
+	{
+		word = TAPE_PTR(item);
+
+		if (TAPE_KIND(*word) == ']')
+		{
+			return 0;
+		}
+
+		*iter = TAPE_REF(tapeSkip(word));
+		*outObj = TAPE_REF(word);
+		return 1;
+	}
+
+	if (item == NULL || *item == NULL)
+	{
+		return 0;
+	}
+
+	*iter = item + 1;
+	*outObj = *item;
+
+	return 1;
+}
+
+size_t UJArraySize(UJObject arrObj)
+{
+	void *iter;
+	UJObject item;
+	size_t count;
+
+	if (!UJIsArray(arrObj))
+	{
+		return 0;
+	}
+
+	if (!IS_TAPE(arrObj))
+	{
+		return ((ArrayItem *) arrObj)->count;
+	}
+
+	count = TAPE_COUNT(*TAPE_PTR(arrObj));
+
+	if (count == TAPE_COUNT_MAX)
+	{
+		for (iter = UJBeginArray(arrObj), count = 0; UJIterArray(&iter, &item); count ++);
+	}
+
+	return count;
+}
+
+UJObject UJArrayGet(UJObject arrObj, size_t index)
+{
+	void *iter;
+	UJObject item;
+
+	if (!UJIsArray(arrObj))
+	{
+		return NULL;
+	}
+
+	if (IS_TAPE(arrObj))
+	{
+		// The tape only links elements to their next sibling
+		for (iter = UJBeginArray(arrObj); UJIterArray(&iter, &item); index --)
+		{
+			if (index == 0)
+			{
+				return item;
+			}
+		}
+
+		return NULL;
+	}
+
+	if (index >= ((ArrayItem *) arrObj)->count)
+	{
+		return NULL;
+	}
+
+	return ((ArrayItem *) arrObj)->items[index];
+}
+
+void *UJBeginObject(UJObject objObj)
+{
+	if (IS_TAPE(objObj))
+	{
+		return UJIsObject(objObj) ? TAPE_REF(TAPE_PTR(objObj) + 1) : NULL;
+	}
+
+	switch (UJGetType(objObj))
+	{
+	case UJT_Object: return ((ObjectItem *) objObj)->head;
+	default: break;
+	}
+
+	return NULL;
+}
+
+/*
+Steps iter over the members of an object. The key is set as name for tree objects and as key for tape
+objects, whose keys are always UTF-8 */
+static int nextMember(void **iter, StringItem **outName, UJUTF8String *outKey, UJObject *outValue)
+{
+	const JSUINT64 *word;
+	KeyPair *kp;
+
+	if (IS_TAPE(*iter))
+	{
+		word = TAPE_PTR(*iter);
+
+		if (TAPE_KIND(*word) == '}')
+		{
+			return 0;
+		}
+
+		*outName = NULL;
+		tapeView(word, outKey);
+		word = tapeSkip(word);
+		*outValue = TAPE_REF(word);
+		*iter = TAPE_REF(tapeSkip(word));
+		return 1;
+	}
+
+	kp = (KeyPair *) *iter;
+
+	if (kp == NULL)
+	{
+		return 0;
+	}
+
+	*outName = kp->name;
+	*outValue = kp->value;
+	*iter = kp->next;
+	return 1;
+}
+
+int UJIterObject(void **iter, UJString *outKey, UJObject *outValue)
+{
+	StringItem *name;
+	UJUTF8String key;
+
+	if (*iter == NULL || !nextMember(iter, &name, &key, outValue))
+	{
+		return 0;
+	}
+
+	if (name == NULL || (name->item.flags & ITEM_UTF8))
+	{
+		outKey->ptr = (wchar_t *) L"";
+		outKey->cchLen = 0;
+	}
+	else
+	{
+		*outKey = name->str;
+	}
+
+	return 1;
+}
+
+int UJIterObjectUTF8(void **iter, UJUTF8String *outKey, UJObject *outValue)
+{
+	StringItem *name;
+
+	if (*iter == NULL || !nextMember(iter, &name, outKey, outValue))
+	{
+		return 0;
+	}
+
+	if (name == NULL)
+	{
+		return 1;
+	}
+
+	if (name->item.flags & ITEM_UTF8)
+	{
+		*outKey = ((UTF8StringItem *) name)->str;
+	}
+	else
+	{
+		outKey->ptr = "";
+		outKey->cbLen = 0;
+	}
+
+	return 1;
+}
+
+long long UJNumericLongLong(UJObject obj)
+{
+	switch (UJGetType(obj))
+	{
+	case UJT_Long: return (long long) GetLong(obj);
+	case UJT_LongLong: return (long long) GetLongLong(obj);
+	case UJT_Double: return (long long) GetDouble(obj);
+	default: break;
+	}
+
+	return 0;
+}
+
+int UJNumericInt(UJObject obj)
+{
+	switch (UJGetType(obj))
+	{
+	case UJT_Long: return (int) GetLong(obj);
+	case UJT_LongLong: return (int) GetLongLong(obj);
+	case UJT_Double: return (int) GetDouble(obj);
+	default: break;
+	}
+
+	return 0;
+}
+
+double UJNumericFloat(UJObject obj)
+{
+	switch (UJGetType(obj))
+	{
+	case UJT_Long: return (double) GetLong(obj);
+	case UJT_LongLong: return (double) GetLongLong(obj);
+	case UJT_Double: return (double) GetDouble(obj);
+	default: break;
+	}
+
+	return 0.0;
+}
+
+const wchar_t *UJReadString(UJObject obj, size_t *cchOutBuffer)
+{
+	switch (IS_ITEM(obj) ? ((Item *) obj)->type : UJT_Null)
+	{
+	case UJT_String:
+		if (((Item *) obj)->flags & ITEM_UTF8)
+			break;
+
+		if (cchOutBuffer)
+			*cchOutBuffer = ( (StringItem *) obj)->str.cchLen;
+		return ( (StringItem *) obj)->str.ptr;
+
+	default:
+		break;
+	}
+
+	if (cchOutBuffer)
+		*cchOutBuffer = 0;
+	return L"";
+}
+
+const char *UJReadStringUTF8(UJObject obj, size_t *cbOutBuffer)
+{
+	UJUTF8String view;
+
+	if (UJReadStringView(obj, &view))
+	{
+		if (cbOutBuffer)
+			*cbOutBuffer = view.cbLen;
+		return view.ptr;
+	}
+
+	if (cbOutBuffer)
+		*cbOutBuffer = 0;
+	return "";
+}
+
+int UJReadStringView(UJObject obj, UJUTF8String *outView)
+{
+	if (IS_TAPE(obj) && UJIsString(obj))
+	{
+		tapeView(TAPE_PTR(obj), outView);
+		return 1;
+	}
+
+	if (!IS_ITEM(obj) || ((Item *) obj)->type != UJT_String || !(((Item *) obj)->flags & ITEM_UTF8))
+	{
+		outView->ptr = "";
+		outView->cbLen = 0;
+		return 0;
+	}
+
+	*outView = ((UTF8StringItem *) obj)->str;
+	return 1;
+}
+
+int UJReadNumberSpan(UJObject obj, UJUTF8String *outSpan)
+{
+	RawNumberItem *rn = (RawNumberItem *) obj;
+
+	if (!IS_ITEM(obj) || !(rn->item.flags & ITEM_RAW))
+	{
+		return 0;
+	}
+
+	outSpan->ptr = rn->start;
+	outSpan->cbLen = (size_t) (rn->end - rn->start);
+	return 1;
+}
+
+const char *UJGetError(void *state)
+{
+	if (state == NULL)
+		return NULL;
+
+	return ( (struct DecoderState *) state)->error;
+}
+
+int UJGetType(UJObject obj)
+{
+	if (IS_ITEM(obj))
+	{
+		return ((Item *) obj)->type;
+	}
+
+	if (IS_INLINE_INT(obj))
+	{
+		return UJT_Long;
+	}
+
+	if (IS_INLINE_CONST(obj))
+	{
+		return INLINE_CONST_TYPE(obj);
+	}
+
+	return tapeType(TAPE_PTR(obj));
+}
+
+static int checkType(int ki, const char *format, UJObject obj)
+{
+	int c = (unsigned char) format[ki];
+	int type = UJGetType(obj);
+	int allowNull = 0;
+
+	switch (c)
+	{
+	case 'b':
+		allowNull = 1;
+	case 'B':
+		switch (type)
+		{
+			case UJT_Null:
+				if (!allowNull)
+					return 0;
+			case UJT_True:
+			case UJT_False:
+				return 1;
+
+			default:
+				return 0;
+		}
+		break;
+
+	case 'n':
+		allowNull = 1;
+	case 'N':
+		switch (type)
+		{
+			case UJT_Null:
+				if (!allowNull)
+					return 0;
+			case UJT_Long:
+			case UJT_LongLong:
+			case UJT_Double:
+				return 1;
+
+			default:
+				return 0;
+		}
+		break;
+
+	case 's':
+		allowNull = 1;
+	case 'S':
+		switch (type)
+		{
+			case UJT_Null:
+				if (!allowNull)
+					return 0;
+			case UJT_String:
+				return 1;
+
+			default:
+				return 0;
+		}
+		break;
+
+	case 'a':
+		allowNull = 1;
+	case 'A':
+		switch (type)
+		{
+			case UJT_Null:
+				if (!allowNull)
+					return 0;
+			case UJT_Array:
+				return 1;
+
+			default:
+				return 0;
+		}
+		break;
+
+	case 'o':
+		allowNull = 1;
+	case 'O':
+		switch (type)
+		{
+			case UJT_Null:
+				if (!allowNull)
+					return 0;
+			case UJT_Object:
+				return 1;
+			default:
+				return 0;
+		}
+
+		break;
+
+	case 'u':
+		allowNull = 1;
+	case 'U':
+		return 1;
+		break;
+	}
+
+	return 0;
+}
+
+/*
+Reads one UTF-8 sequence, leniently as keys have been checked by the decoder already */
+static unsigned long readUTF8Char(const unsigned char **utf8, const unsigned char *end)
+{
+	unsigned long ucs = *((*utf8)++);
+	int extra = 0;
+
+	if (ucs >= 0xf0)
+	{
+		ucs &= 0x07;
+		extra = 3;
+	}
+	else
+	if (ucs >= 0xe0)
+	{
+		ucs &= 0x0f;
+		extra = 2;
+	}
+	else
+	if (ucs >= 0xc0)
+	{
+		ucs &= 0x1f;
+		extra = 1;
+	}
+
+	for (; extra > 0 && *utf8 < end; extra --)
+	{
+		ucs = (ucs << 6) | (*((*utf8)++) & 0x3f);
+	}
+
+	return ucs;
+}
+
+/*
+Converts a UTF-8 key to wide characters, of which it takes up no more than it has bytes. Returns the
+number of wide characters written */
+static size_t widenUTF8(const char *utf8, size_t cbUtf8, wchar_t *wide)
+{
+	const unsigned char *ptr = (const unsigned char *) utf8;
+	const unsigned char *end = ptr + cbUtf8;
+	wchar_t *start = wide;
+	unsigned long ucs;
+
+	while (ptr < end)
+	{
+		ucs = readUTF8Char(&ptr, end);
+
+#if WCHAR_MAX == 0xffff
+		if (ucs >= 0x10000)
+		{
+			ucs -= 0x10000;
+			*(wide++) = (wchar_t) (0xd800 + (ucs >> 10));
+			ucs = 0xdc00 + (ucs & 0x3ff);
+		}
+#endif
+		*(wide++) = (wchar_t) ucs;
+	}
+
+	return (size_t) (wide - start);
+}
+
+/*
+Compares a UTF-8 key against a wide character string */
+static int compareUTF8Wide(const unsigned char *utf8, size_t cbLen, const wchar_t *wide)
+{
+	const unsigned char *end = utf8 + cbLen;
+
+	while (utf8 < end)
+	{
+		unsigned long ucs;
+
+		// A key holding U+0000 would otherwise match the terminator and read past it
+		if (*wide == 0)
+		{
+			return 0;
+		}
+
+		ucs = readUTF8Char(&utf8, end);
+
+#if WCHAR_MAX == 0xffff
+		if (ucs >= 0x10000)
+		{
+			ucs -= 0x10000;
+
+			if (*(wide++) != (wchar_t) (0xd800 + (ucs >> 10)))
+			{
+				return 0;
+			}
+
+			ucs = 0xdc00 + (ucs & 0x3ff);
+		}
+#endif
+		if ((unsigned long) *(wide++) != ucs)
+		{
+			return 0;
+		}
+	}
+
+	return *wide == 0;
+}
+
+/*
+Matches an object key against a requested key name given either as wide characters or as UTF-8.
+Tape objects have no name item and pass their UTF-8 key as view instead */
+static int keyEquals(StringItem *name, const UJUTF8String *view, const void *keyName, size_t cbKeyName, int utf8)
+{
+	if (name == NULL || (name->item.flags & ITEM_UTF8))
+	{
+		const UJUTF8String *str = name ? &((UTF8StringItem *) name)->str : view;
+
+		if (utf8)
+		{
+			return str->cbLen == cbKeyName && memcmp(str->ptr, keyName, cbKeyName) == 0;
+		}
+
+		return compareUTF8Wide((const unsigned char *) str->ptr, str->cbLen, (const wchar_t *) keyName);
+	}
+
+	if (utf8)
+	{
+		return compareUTF8Wide((const unsigned char *) keyName, cbKeyName, name->str.ptr);
+	}
+
+	return wcscmp(name->str.ptr, (const wchar_t *) keyName) == 0;
+}
+
+static StringItem *findInterned(UJObject objObj, const void *keyName, size_t cbKeyName, int utf8);
+
+static int objectUnpack(UJObject objObj, int keys, const char *format, const void **_keyNames, int utf8, va_list args)
+{
+	void *iter;
+	StringItem *name;
+	UJUTF8String key;
+	UJObject value;
+	int found = 0;
+	int ki;
+	int ks = 0;
+	int interned = 0;
+	const void *keyNames[64];
+	size_t keyLengths[64];
+	StringItem *internedNames[64];
+	UJObject *outValues[64];
+
+	if (!UJIsObject(objObj))
+	{
+		return 0;
+	}
+
+	if (keys > 64)
+	{
+		return -1;
+	}
+
+	for (ki = 0; ki < keys; ki ++)
+	{
+		keyNames[ki] = _keyNames[ki];
+		keyLengths[ki] = (utf8 && keyNames[ki]) ? strlen((const char *) keyNames[ki]) : 0;
+		outValues[ki] = va_arg(args, UJObject *);
+	}
+
+	iter = UJBeginObject(objObj);
+
+	while (iter != NULL && nextMember(&iter, &name, &key, &value))
+	{
+		// Interned keys of the requested form are matched by identity, the wanted keys are looked up once
+		if (name && (name->item.flags & ITEM_INTERNED) && !(name->item.flags & ITEM_UTF8) == !utf8 && !interned)
+		{
+			for (ki = 0; ki < keys; ki ++)
+			{
+				internedNames[ki] = keyNames[ki] ? findInterned(objObj, keyNames[ki], keyLengths[ki], utf8) : NULL;
+			}
+
+			interned = 1;
+		}
+
+		for (ki = ks; ki < keys; ki ++)
+		{
+			const void *kn = keyNames[ki];
+
+			if (kn == NULL)
+			{
+				continue;
+			}
+
+			if (name && (name->item.flags & ITEM_INTERNED) && !(name->item.flags & ITEM_UTF8) == !utf8)
+			{
+				if (name != internedNames[ki])
+				{
+					continue;
+				}
+			}
+			else
+			if (!keyEquals(name, &key, kn, keyLengths[ki], utf8))
+			{
+				continue;
+			}
+
+			if (!checkType(ki, format, value))
+			{
+				continue;
+			}
+
+			found ++;
+
+			if (outValues[ki] != NULL)
+			{
+				*outValues[ki] = value;
+			}
+			keyNames[ki] = NULL;
+
+			if (ki == ks)
+			{
+				ks ++;
+			}
+		}
+	}
+
+	return found;
+}
+
+int UJObjectUnpack(UJObject objObj, int keys, const char *format, const wchar_t **keyNames, ...)
+{
+	int ret;
+	va_list args;
+
+	va_start(args, keyNames);
+	ret = objectUnpack(objObj, keys, format, (const void **) keyNames, 0, args);
+	va_end(args);
+
+	return ret;
+}
+
+int UJObjectUnpackUTF8(UJObject objObj, int keys, const char *format, const char **keyNames, ...)
+{
+	int ret;
+	va_list args;
+
+	va_start(args, keyNames);
+	ret = objectUnpack(objObj, keys, format, (const void **) keyNames, 1, args);
+	va_end(args);
+
+	return ret;
+}
+
+/*
+UJKeySet. Every key is kept both as UTF-8 and as wide characters, each form with its own hash table,
+so that the keys of either kind of document are hashed and compared as they are. The seeds are picked
+such that no two keys share a slot, which makes a lookup a single probe and compare */
+typedef struct __KeySetEntry
+{
+	const char *utf8;
+	size_t cbUtf8;
+	const wchar_t *wide;
+	size_t cchWide;
+} KeySetEntry;
+
+struct KeySet
+{
+	int keys;
+	const char *format;
+	KeySetEntry *entries;
+	JSUINT32 utf8Seed;
+	JSUINT32 wideSeed;
+	JSUINT32 mask;
+
+	// Entry index plus one per slot, 0 for empty slots
+	int *utf8Slots;
+	int *wideSlots;
+};
+
+#define KEYSET_SEEDS 64
+#define KEYSET_MAX_SLOTS (1 << 20)
+
+static JSUINT32 hashBytes(const void *data, size_t cbData, JSUINT32 seed)
+{
+	const unsigned char *ptr = (const unsigned char *) data;
+	const unsigned char *end = ptr + cbData;
+	JSUINT32 hash = 2166136261U ^ (seed * 0x9e3779b9U);
+
+	while (ptr < end)
+	{
+		hash = (hash ^ *(ptr++)) * 16777619U;
+	}
+
+	return hash ^ (hash >> 15);
+}
+
+/*
+Finds a seed under which the keys in one form fill distinct slots, or returns 0 if there is none */
+static int seedSlots(struct KeySet *set, int *slots, int wide, JSUINT32 *outSeed)
+{
+	const KeySetEntry *entry;
+	JSUINT32 seed;
+	JSUINT32 slot;
+	int ki;
+
+	for (seed = 0; seed < KEYSET_SEEDS; seed ++)
+	{
+		memset(slots, 0, (set->mask + 1) * sizeof(int));
+
+		for (ki = 0, entry = set->entries; ki < set->keys; ki ++, entry ++)
+		{
+			slot = (wide ? hashBytes(entry->wide, entry->cchWide * sizeof(wchar_t), seed) : hashBytes(entry->utf8, entry->cbUtf8, seed)) & set->mask;
+
+			if (slots[slot])
+			{
+				break;
+			}
+
+			slots[slot] = ki + 1;
+		}
+
+		if (ki == set->keys)
+		{
+			*outSeed = seed;
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+UJKeySet UJKeySetCompile(const char **keyNames, int keys, const char *format)
+{
+	struct KeySet *set;
+	KeySetEntry *entry;
+	wchar_t *wide;
+	char *chars;
+	size_t cbChars = (size_t) keys + 1;
+	size_t cchWide = 0;
+	size_t cbSet;
+	JSUINT32 size = 4;
+	int ki;
+	int kj;
+
+	if (keys < 0 || keys > KEYSET_MAX_SLOTS / 4 || strlen(format) < (size_t) keys)
+	{
+		return NULL;
+	}
+
+	for (ki = 0; ki < keys; ki ++)
+	{
+		// Equal keys would never hash apart, neither would keys that only widen equal
+		for (kj = 0; kj < ki; kj ++)
+		{
+			if (strcmp(keyNames[ki], keyNames[kj]) == 0)
+			{
+				return NULL;
+			}
+		}
+
+		cbChars += strlen(keyNames[ki]);
+	}
+
+	// No key takes up more wide characters than bytes, counting a surrogate pair as two
+	cchWide = cbChars;
+
+	while (size < (JSUINT32) keys * 4)
+	{
+		size *= 2;
+	}
+
+	for (;;)
+	{
+		cbSet = sizeof(struct KeySet) + keys * sizeof(KeySetEntry) + 2 * size * sizeof(int) + cchWide * sizeof(wchar_t) + cbChars;
+
+		if ((set = (struct KeySet *) malloc(cbSet)) == NULL)
+		{
+			return NULL;
+		}
+
+		set->keys = keys;
+		set->mask = size - 1;
+		set->entries = (KeySetEntry *) (set + 1);
+		set->utf8Slots = (int *) (set->entries + keys);
+		set->wideSlots = set->utf8Slots + size;
+		wide = (wchar_t *) (set->wideSlots + size);
+		chars = (char *) (wide + cchWide);
+
+		memcpy(chars, format, keys);
+		chars[keys] = '\0';
+		set->format = chars;
+		chars += keys + 1;
+
+		for (ki = 0, entry = set->entries; ki < keys; ki ++, entry ++)
+		{
+			entry->cbUtf8 = strlen(keyNames[ki]);
+			entry->utf8 = (const char *) memcpy(chars, keyNames[ki], entry->cbUtf8);
+			entry->wide = wide;
+			chars += entry->cbUtf8;
+
+			entry->cchWide = widenUTF8(entry->utf8, entry->cbUtf8, wide);
+			wide += entry->cchWide;
+
+			for (kj = 0; kj < ki; kj ++)
+			{
+				if (set->entries[kj].cchWide == entry->cchWide && memcmp(set->entries[kj].wide, entry->wide, entry->cchWide * sizeof(wchar_t)) == 0)
+				{
+					free(set);
+					return NULL;
+				}
+			}
+		}
+
+		if (seedSlots(set, set->utf8Slots, 0, &set->utf8Seed) && seedSlots(set, set->wideSlots, 1, &set->wideSeed))
+		{
+			return (UJKeySet) set;
+		}
+
+		// Too crowded to find a seed, retry with a larger table
+		free(set);
+
+		if (size >= KEYSET_MAX_SLOTS)
+		{
+			return NULL;
+		}
+
+		size *= 2;
+	}
+}
+
+void UJKeySetFree(UJKeySet keySet)
+{
+	free(keySet);
+}
+
+static int keySetFind(const struct KeySet *set, const StringItem *name, const UJUTF8String *view)
+{
+	const KeySetEntry *entry;
+	int slot;
+
+	if (name == NULL || (name->item.flags & ITEM_UTF8))
+	{
+		const UJUTF8String *str = name ? &((const UTF8StringItem *) name)->str : view;
+
+		slot = set->utf8Slots[hashBytes(str->ptr, str->cbLen, set->utf8Seed) & set->mask] - 1;
+
+		if (slot < 0)
+		{
+			return -1;
+		}
+
+		entry = set->entries + slot;
+		return (entry->cbUtf8 == str->cbLen && memcmp(entry->utf8, str->ptr, str->cbLen) == 0) ? slot : -1;
+	}
+
+	slot = set->wideSlots[hashBytes(name->str.ptr, name->str.cchLen * sizeof(wchar_t), set->wideSeed) & set->mask] - 1;
+
+	if (slot < 0)
+	{
+		return -1;
+	}
+
+	entry = set->entries + slot;
+	return (entry->cchWide == name->str.cchLen && memcmp(entry->wide, name->str.ptr, name->str.cchLen * sizeof(wchar_t)) == 0) ? slot : -1;
+}
+
+int UJObjectUnpackSet(UJObject objObj, UJKeySet keySet, UJObject *outValues)
+{
+	const struct KeySet *set = (const struct KeySet *) keySet;
+	void *iter;
+	StringItem *name;
+	UJUTF8String key;
+	UJObject value;
+	int found = 0;
+	int ki;
+
+	if (!UJIsObject(objObj))
+	{
+		return 0;
+	}
+
+	memset(outValues, 0, set->keys * sizeof(UJObject));
+
+	iter = UJBeginObject(objObj);
+
+	while (found < set->keys && iter != NULL && nextMember(&iter, &name, &key, &value))
+	{
+		ki = keySetFind(set, name, &key);
+
+		if (ki < 0 || outValues[ki] != NULL || !checkType(ki, set->format, value))
+		{
+			continue;
+		}
+
+		outValues[ki] = value;
+		found ++;
+	}
+
+	return found;
+}
+
+/*
+UJObjectGet. Objects of up to KEYINDEX_MIN_KEYS members are searched linearly. Larger ones get an
+open addressing table of their members in the document arena on the first lookup, hashed in the form
+the keys were decoded in. Of equal keys only the first is entered, as a linear search would find */
+#define KEYINDEX_MIN_KEYS 16
+
+typedef struct __KeyIndex
+{
+	// Replaces the decoder state in ObjectItem.lookup
+	struct DecoderState *ds;
+	JSUINT32 mask;
+	KeyPair *slots[1];
+} KeyIndex;
+
+static JSUINT32 hashKey(const StringItem *name)
+{
+	if (name->item.flags & ITEM_UTF8)
+	{
+		const UJUTF8String *str = &((const UTF8StringItem *) name)->str;
+		return hashBytes(str->ptr, str->cbLen, 0);
+	}
+
+	return hashBytes(name->str.ptr, name->str.cchLen * sizeof(wchar_t), 0);
+}
+
+static int keysEqual(const StringItem *a, const StringItem *b)
+{
+	if (a->item.flags & ITEM_UTF8)
+	{
+		const UJUTF8String *strA = &((const UTF8StringItem *) a)->str;
+		const UJUTF8String *strB = &((const UTF8StringItem *) b)->str;
+		return strA->cbLen == strB->cbLen && memcmp(strA->ptr, strB->ptr, strA->cbLen) == 0;
+	}
+
+	return a->str.cchLen == b->str.cchLen && memcmp(a->str.ptr, b->str.ptr, a->str.cchLen * sizeof(wchar_t)) == 0;
+}
+
+static KeyIndex *buildKeyIndex(ObjectItem *oi, size_t count)
+{
+	struct DecoderState *ds = (struct DecoderState *) oi->lookup;
+	KeyIndex *index;
+	KeyPair *kp;
+	JSUINT32 size = 4;
+	JSUINT32 slot;
+
+	while (size < count * 2)
+	{
+		size *= 2;
+	}
+
+	// Allocate from the document the object ended up in, which is why lookups in a document are not thread safe
+	while (ds->owner)
+	{
+		ds = ds->owner;
+	}
+
+	index = (KeyIndex *) alloc(ds, sizeof(KeyIndex) + (size - 1) * sizeof(KeyPair *));
+	index->ds = ds;
+	index->mask = size - 1;
+	memset(index->slots, 0, size * sizeof(KeyPair *));
+
+	for (kp = oi->head; kp != NULL; kp = kp->next)
+	{
+		for (slot = hashKey(kp->name) & index->mask; index->slots[slot] != NULL; slot = (slot + 1) & index->mask)
+		{
+			if (keysEqual(index->slots[slot]->name, kp->name))
+			{
+				break;
+			}
+		}
+
+		if (index->slots[slot] == NULL)
+		{
+			index->slots[slot] = kp;
+		}
+	}
+
+	oi->lookup = index;
+	oi->item.flags |= ITEM_INDEXED;
+	return index;
+}
+
+UJObject UJObjectGet(UJObject objObj, const char *key, size_t cbKey)
+{
+	ObjectItem *oi = (ObjectItem *) objObj;
+	KeyIndex *index;
+	KeyPair *kp;
+	StringItem *name;
+	wchar_t buffer[256];
+	wchar_t *wide = buffer;
+	UJObject ret = NULL;
+	size_t count = 0;
+	size_t cchWide = 0;
+	JSUINT32 slot;
+	void *iter;
+	UJUTF8String view;
+
+	if (!UJIsObject(objObj))
+	{
+		return NULL;
+	}
+
+	if (IS_TAPE(objObj))
+	{
+		// Tape objects carry no room for an index, search them linearly
+		for (iter = UJBeginObject(objObj); nextMember(&iter, &name, &view, &ret); )
+		{
+			if (view.cbLen == cbKey && memcmp(view.ptr, key, cbKey) == 0)
+			{
+				return ret;
+			}
+		}
+
+		return NULL;
+	}
+
+	if (oi->head == NULL)
+	{
+		return NULL;
+	}
+
+	if (oi->item.flags & ITEM_INDEXED)
+	{
+		index = (KeyIndex *) oi->lookup;
+	}
+	else
+	{
+		for (kp = oi->head; kp != NULL && count <= KEYINDEX_MIN_KEYS; kp = kp->next)
+		{
+			count ++;
+		}
+
+		if (count <= KEYINDEX_MIN_KEYS)
+		{
+			for (kp = oi->head; kp != NULL; kp = kp->next)
+			{
+				if (keyEquals(kp->name, NULL, key, cbKey, 1))
+				{
+					return kp->value;
+				}
+			}
+
+			return NULL;
+		}
+
+		for (; kp != NULL; kp = kp->next)
+		{
+			count ++;
+		}
+
+		index = buildKeyIndex(oi, count);
+	}
+
+	// The keys of a document are all decoded the same way, hash the wanted one like the first
+	name = oi->head->name;
+
+	if (name->item.flags & ITEM_UTF8)
+	{
+		slot = hashBytes(key, cbKey, 0);
+	}
+	else
+	{
+		if (cbKey > sizeof(buffer) / sizeof(wchar_t) && (wide = (wchar_t *) malloc(cbKey * sizeof(wchar_t))) == NULL)
+		{
+			return NULL;
+		}
+
+		cchWide = widenUTF8(key, cbKey, wide);
+		slot = hashBytes(wide, cchWide * sizeof(wchar_t), 0);
+	}
+
+	for (slot &= index->mask; (kp = index->slots[slot]) != NULL; slot = (slot + 1) & index->mask)
+	{
+		name = kp->name;
+
+		if ((name->item.flags & ITEM_UTF8) ? (((UTF8StringItem *) name)->str.cbLen == cbKey && memcmp(((UTF8StringItem *) name)->str.ptr, key, cbKey) == 0) :
+			(name->str.cchLen == cchWide && memcmp(name->str.ptr, wide, cchWide * sizeof(wchar_t)) == 0))
+		{
+			ret = kp->value;
+			break;
+		}
+	}
+
+	if (wide != buffer)
+	{
+		free(wide);
+	}
+
+	return ret;
+}
+
+/*
+UJF_INTERNKEYS. Every key is looked up in a table kept by the decoder right after it is decoded. The
+first of equal keys is copied out of the document, later ones are dropped from the arena again and
+replaced by that copy, which ITEM_INTERNED marks. The table survives resetHeap, so the documents of a
+reused decoder share their keys too. Once it holds INTERN_MAX_KEYS keys new ones are kept as decoded */
+#define INTERN_MAX_KEYS 16384
+
+struct KeyIntern
+{
+	JSUINT32 mask;
+	JSUINT32 count;
+	StringItem *slots[1];
+};
+
+static StringItem *copyKey(struct DecoderState *ds, const StringItem *name)
+{
+	StringItem *copy;
+	size_t cbChars;
+
+	if (name->item.flags & ITEM_UTF8)
+	{
+		const UJUTF8String *str = &((const UTF8StringItem *) name)->str;
+		UTF8StringItem *utf8;
+
+		if ((utf8 = (UTF8StringItem *) ds->malloc(sizeof(UTF8StringItem) + str->cbLen + 1)) == NULL)
+		{
+			return NULL;
+		}
+
+		// Zero copy keys point into the input, which is gone with the document
+		utf8->str.ptr = (const char *) memcpy(utf8 + 1, str->ptr, str->cbLen);
+		utf8->str.cbLen = str->cbLen;
+		((char *) (utf8 + 1))[str->cbLen] = '\0';
+		copy = (StringItem *) utf8;
+	}
+	else
+	{
+		cbChars = (name->str.cchLen + 1) * sizeof(wchar_t);
+
+		if ((copy = (StringItem *) ds->malloc(sizeof(StringItem) + cbChars)) == NULL)
+		{
+			return NULL;
+		}
+
+		copy->str.ptr = (wchar_t *) memcpy(copy + 1, name->str.ptr, cbChars);
+		copy->str.cchLen = name->str.cchLen;
+	}
+
+	copy->item.type = UJT_String;
+	copy->item.flags = name->item.flags | ITEM_INTERNED;
+	return copy;
+}
+
+static struct KeyIntern *growInterned(struct DecoderState *ds)
+{
+	struct KeyIntern *table = ds->interned;
+	struct KeyIntern *grown;
+	JSUINT32 size = table ? (table->mask + 1) * 2 : 64;
+	JSUINT32 index;
+	JSUINT32 slot;
+
+	if ((grown = (struct KeyIntern *) ds->malloc(sizeof(struct KeyIntern) + (size - 1) * sizeof(StringItem *))) == NULL)
+	{
+		return table;
+	}
+
+	grown->mask = size - 1;
+	grown->count = 0;
+	memset(grown->slots, 0, size * sizeof(StringItem *));
+
+	for (index = 0; table && index <= table->mask; index ++)
+	{
+		if (table->slots[index] == NULL)
+		{
+			continue;
+		}
+
+		for (slot = hashKey(table->slots[index]) & grown->mask; grown->slots[slot] != NULL; slot = (slot + 1) & grown->mask);
+
+		grown->slots[slot] = table->slots[index];
+		grown->count ++;
+	}
+
+	if (table)
+	{
+		ds->free(table);
+	}
+
+	ds->interned = grown;
+	return grown;
+}
+
+static void freeInterned(struct DecoderState *ds)
+{
+	JSUINT32 index;
+
+	for (index = 0; index <= ds->interned->mask; index ++)
+	{
+		if (ds->interned->slots[index])
+		{
+			ds->free(ds->interned->slots[index]);
+		}
+	}
+
+	ds->free(ds->interned);
+	ds->interned = NULL;
+}
+
+static JSOBJ internKey(void *context, JSOBJ obj)
+{
+	struct DecoderState *ds = context;
+	StringItem *name = (StringItem *) obj;
+	struct KeyIntern *table = ds->interned;
+	StringItem *copy;
+	JSUINT32 slot;
+
+	// Keep the table at most half full
+	if (table == NULL || (table->count < INTERN_MAX_KEYS && (table->count + 1) * 2 > table->mask + 1))
+	{
+		if ((table = growInterned(ds)) == NULL)
+		{
+			return obj;
+		}
+	}
+
+	for (slot = hashKey(name) & table->mask; table->slots[slot] != NULL; slot = (slot + 1) & table->mask)
+	{
+		if (keysEqual(table->slots[slot], name))
+		{
+			copy = table->slots[slot];
+			goto DROP;
+		}
+	}
+
+	if (table->count >= INTERN_MAX_KEYS || (copy = copyKey(ds, name)) == NULL)
+	{
+		return obj;
+	}
+
+	table->slots[slot] = copy;
+	table->count ++;
+
+DROP:
+	// The key was the last allocation, hand its space back
+	if ((unsigned char *) name >= ds->heap->start && (unsigned char *) name < ds->heap->offset)
+	{
+		ds->heap->offset = (unsigned char *) name;
+	}
+
+	return (JSOBJ) copy;
+}
+
+/*
+The interned key of the document of objObj equal to keyName, NULL if there is none. keyName is
+looked up as UTF-8 or as wide characters, whichever the keys were decoded as */
+static StringItem *findInterned(UJObject objObj, const void *keyName, size_t cbKeyName, int utf8)
+{
+	ObjectItem *oi = (ObjectItem *) objObj;
+	struct DecoderState *ds = (oi->item.flags & ITEM_INDEXED) ? ((KeyIndex *) oi->lookup)->ds : (struct DecoderState *) oi->lookup;
+	struct KeyIntern *table;
+	StringItem *name;
+	JSUINT32 slot;
+
+	while (ds->owner)
+	{
+		ds = ds->owner;
+	}
+
+	if ((table = ds->interned) == NULL)
+	{
+		return NULL;
+	}
+
+	slot = utf8 ? hashBytes(keyName, cbKeyName, 0) : hashBytes(keyName, wcslen((const wchar_t *) keyName) * sizeof(wchar_t), 0);
+
+	for (slot &= table->mask; (name = table->slots[slot]) != NULL; slot = (slot + 1) & table->mask)
+	{
+		if (!(name->item.flags & ITEM_UTF8) == !utf8 && keyEquals(name, NULL, keyName, cbKeyName, utf8))
+		{
+			return name;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+Internal flags, kept clear of the public UJFlags */
+#define UJF_INSITU 0x10000
+
+static UJObject decode(const char *input, size_t cbInput, UJHeapFuncs *hf, int flags, void **outState);
+
+UJObject UJDecode(const char *input, size_t cbInput, UJHeapFuncs *hf, void **outState)
+{
+	return decode(input, cbInput, hf, 0, outState);
+}
+
+UJObject UJDecodeEx(const char *input, size_t cbInput, UJHeapFuncs *hf, int flags, void **outState)
+{
+	return decode(input, cbInput, hf, flags & ~UJF_INSITU, outState);
+}
+
+UJObject UJDecodeInSitu(char *buffer, size_t cbBuffer, UJHeapFuncs *hf, int flags, void **outState)
+{
+	return decode(buffer, cbBuffer, hf, flags | UJF_ZEROCOPY | UJF_INSITU, outState);
+}
+
+/*
+Sets up the first slab, either the caller provided initial heap or a fresh one, with the decoder state
+at its start */
+static struct DecoderState *createState(UJHeapFuncs *hf, int flags)
+{
+	struct DecoderState *ds;
+	void *initialHeap;
+	size_t cbInitialHeap;
+	HeapSlab *slab;
+
+	JSONObjectDecoder decoder = {
+		newString,
+		objectAddKey,
+		arrayAddItem,
+		newTrue,
+		newFalse,
+		newNull,
+		newObject,
+		newArray,
+		newInt,
+		newLong,
+		newDouble,
+		releaseObject,
+		NULL,
+		NULL,
+		NULL,
+		NULL,
+		NULL,
+		0, 
+		NULL,
+		NULL,
+		0,
+		NULL,
+		0,
+		NULL,
+		0,
+		0,
+		0,
+		0,
+		NULL,
+		0,
+		NULL,
+		endArray,
+		NULL,
+		NULL
+	};
+
+	if (hf == NULL)
+	{
+		decoder.malloc = malloc;
+		decoder.free = free;
+		decoder.realloc = realloc;
+		cbInitialHeap = 16384;
+		initialHeap = malloc(cbInitialHeap);
+	}
+	else
+	{
+		decoder.malloc = hf->malloc;
+		decoder.free = hf->free;
+		decoder.realloc = hf->realloc;
+		initialHeap = hf->initalHeap;
+		cbInitialHeap = hf->cbInitialHeap;
+	
+		if (cbInitialHeap < sizeof(HeapSlab) + sizeof(struct DecoderState) + 8)
+		{
+			return NULL;
+		}
+	}
+
+	slab = (HeapSlab * ) initialHeap;
+
+	if (hf != NULL)
+	{
+		// Align a caller provided heap, the slab header itself is a multiple of 8 bytes
+		size_t misalign = (size_t) initialHeap & 7;
+		slab = (HeapSlab *) ((unsigned char *) initialHeap + (misalign ? 8 - misalign : 0));
+	}
+
+	slab->start = (unsigned char *) (slab + 1);
+	slab->offset = slab->start;
+	slab->end = (unsigned char *) initialHeap + cbInitialHeap;
+	slab->size = cbInitialHeap;
+	slab->owned = hf == NULL ? 1 : 0;
+	slab->next = NULL;
+
+	ds = (struct DecoderState *) slab->offset;
+	slab->offset += ARENA_ALIGN(sizeof(struct DecoderState));
+
+	ds->heap = slab;
+	ds->base = slab;
+	ds->spare = NULL;
+	ds->stream = NULL;
+	ds->owner = NULL;
+	ds->elements = NULL;
+	ds->cElements = 0;
+	ds->cElementsMax = 0;
+	ds->tape = NULL;
+	ds->cTape = 0;
+	ds->cTapeMax = 0;
+	ds->interned = NULL;
+	ds->threads = 0;
+	
+	ds->malloc = decoder.malloc;
+	ds->free = decoder.free;
+	ds->error = NULL; 
+	ds->flags = flags;
+
+	decoder.prv = (void *) ds;
+
+	if (flags & UJF_ZEROCOPY)
+	{
+		decoder.newUTF8String = newUTF8StringView;
+		decoder.inSitu = (flags & UJF_INSITU) ? 1 : 0;
+	}
+	else
+	if (flags & UJF_UTF8)
+	{
+		decoder.newUTF8String = newUTF8String;
+	}
+
+	if (flags & UJF_LAZYNUMBERS)
+	{
+		decoder.newRawNumber = newRawNumber;
+	}
+
+	if (flags & UJF_TAPE)
+	{
+		decoder.newUTF8String = tapeString;
+		decoder.newRawNumber = NULL;
+		decoder.objectAddKey = tapeAddKey;
+		decoder.arrayAddItem = tapeAddItem;
+		decoder.newTrue = tapeTrue;
+		decoder.newFalse = tapeFalse;
+		decoder.newNull = tapeNull;
+		decoder.newObject = tapeObject;
+		decoder.newArray = tapeArray;
+		decoder.newInt = tapeInt;
+		decoder.newLong = tapeLong;
+		decoder.newDouble = tapeDouble;
+		decoder.endArray = tapeEnd;
+		decoder.endObject = tapeEnd;
+	}
+	else
+	if (flags & UJF_INTERNKEYS)
+	{
+		decoder.objectKey = internKey;
+	}
+
+	decoder.iterative = (flags & UJF_ITERATIVE) ? 1 : 0;
+	decoder.structuralIndex = (flags & UJF_STRUCTURAL) ? 1 : 0;
+
+	ds->decoder = decoder;
+	return ds;
+}
+
+static UJObject decodeParallel(struct DecoderState *ds, const char *input, size_t cbInput);
+
+/*
+Smallest input worth decoding with UJF_PARALLEL, and the smallest slice handed to a thread */
+#define PARALLEL_MIN_SLICE (1024 * 1024)
+
+static UJObject decodeSerial(struct DecoderState *ds, const char *input, size_t cbInput)
+{
+	UJObject ret = (UJObject) JSON_DecodeObject(&ds->decoder, input, cbInput);
+
+	if (ret == NULL)
+	{
+		ds->error = ds->decoder.errorStr;
+	}
+
+	return (ds->flags & UJF_TAPE) ? tapeRoot(ds, ret) : ret;
+}
+
+static UJObject decodeState(struct DecoderState *ds, const char *input, size_t cbInput)
+{
+	ds->input = input;
+	ds->inputEnd = input + cbInput;
+
+	if ((ds->flags & (UJF_PARALLEL | UJF_INSITU | UJF_TAPE)) == UJF_PARALLEL && cbInput >= 2 * PARALLEL_MIN_SLICE)
+	{
+		return decodeParallel(ds, input, cbInput);
+	}
+
+	return decodeSerial(ds, input, cbInput);
+}
+
+static UJObject decode(const char *input, size_t cbInput, UJHeapFuncs *hf, int flags, void **outState)
+{
+	struct DecoderState *ds = createState(hf, flags);
+
+	*outState = (void *) ds;
+
+	if (ds == NULL)
+	{
+		return NULL;
+	}
+
+	return decodeState(ds, input, cbInput);
+}
+
+UJDecoder UJDecoderCreate(UJHeapFuncs *hf, int flags)
+{
+	struct DecoderState *ds = createState(hf, flags & ~UJF_INSITU);
+
+	if (ds != NULL)
+	{
+		ds->decoder.heapEscBuffer = 1;
+	}
+
+	return (UJDecoder) ds;
+}
+
+UJObject UJDecoderDecode(UJDecoder decoder, const char *input, size_t cbInput)
+{
+	struct DecoderState *ds = (struct DecoderState *) decoder;
+
+	resetHeap(ds);
+	return decodeState(ds, input, cbInput);
+}
+
+/*
+True if a line that failed to decode is blank, which is skipped instead of reported */
+static int isBlankLine(const char *line, const char *end)
+{
+	for (; line < end; line ++)
+	{
+		if (*line != ' ' && *line != '\t' && *line != '\r')
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+size_t UJDecoderDecodeLines(UJDecoder decoder, const char *input, size_t cbInput, UJLineFunc callback, void *context)
+{
+	struct DecoderState *ds = (struct DecoderState *) decoder;
+	const char *end = input + cbInput;
+	const char *line;
+	const char *lineEnd;
+	size_t count = 0;
+	UJObject obj;
+
+	for (line = input; line < end; line = lineEnd + 1)
+	{
+		// Strings can't hold a raw newline, so every newline ends a record
+		lineEnd = (const char *) memchr(line, '\n', (size_t) (end - line));
+
+		if (lineEnd == NULL)
+		{
+			lineEnd = end;
+		}
+
+		resetHeap(ds);
+		obj = decodeState(ds, line, (size_t) (lineEnd - line));
+
+		if (obj == NULL && isBlankLine(line, lineEnd))
+		{
+			continue;
+		}
+
+		count ++;
+
+		if (callback(context, obj, line, (size_t) (lineEnd - line)))
+		{
+			break;
+		}
+	}
+
+	return count;
+}
+
+void UJDecoderSetMaxDepth(UJDecoder decoder, int maxDepth)
+{
+	((struct DecoderState *) decoder)->decoder.objectDepthMax = maxDepth;
+}
+
+void UJDecoderSetThreads(UJDecoder decoder, int threads)
+{
+	((struct DecoderState *) decoder)->threads = threads;
+}
+
+void UJDecoderRelease(UJDecoder decoder)
+{
+	struct DecoderState *ds = (struct DecoderState *) decoder;
+
+	if (ds->decoder.escBuffer)
+	{
+		ds->decoder.free(ds->decoder.escBuffer);
+	}
+
+	if (ds->decoder.indexBuffer)
+	{
+		ds->decoder.free(ds->decoder.indexBuffer);
+	}
+
+	UJFree(ds);
+}
+
+UJStream UJStreamCreate(UJHeapFuncs *hf, int flags)
+{
+	struct DecoderState *ds;
+
+	// Nothing can point into the chunks, they are gone by the time the document is complete
+	if (flags & UJF_ZEROCOPY)
+	{
+		flags |= UJF_UTF8;
+	}
+
+	ds = createState(hf, flags & ~(UJF_ZEROCOPY | UJF_LAZYNUMBERS | UJF_INSITU));
+
+	if (ds == NULL)
+	{
+		return NULL;
+	}
+
+	ds->stream = JSON_StreamCreate(&ds->decoder);
+
+	if (ds->stream == NULL)
+	{
+		UJFree(ds);
+		return NULL;
+	}
+
+	return (UJStream) ds;
+}
+
+int UJStreamFeed(UJStream stream, const char *chunk, size_t cbChunk)
+{
+	struct DecoderState *ds = (struct DecoderState *) stream;
+	int ret = JSON_StreamFeed(ds->stream, chunk, cbChunk);
+
+	if (ret < 0)
+	{
+		ds->error = ds->decoder.errorStr;
+	}
+
+	return ret;
+}
+
+UJObject UJStreamFinish(UJStream stream)
+{
+	struct DecoderState *ds = (struct DecoderState *) stream;
+	UJObject ret = (UJObject) JSON_StreamFinish(ds->stream);
+
+	ds->stream = NULL;
+
+	if (ret == NULL)
+	{
+		ds->error = ds->decoder.errorStr;
+	}
+
+	return (ds->flags & UJF_TAPE) ? tapeRoot(ds, ret) : ret;
+}
+
+/*
+UJDecodeEvents. The decoder callbacks only record the last key or value in the state and return the state
+itself as a placeholder, the event callback then hands it to the matching handler */
+struct EventState
+{
+	const UJEventHandlers *handlers;
+	void *context;
+	int type;
+	const char *start;
+	size_t cbString;
+	long long integer;
+	double real;
+	int stopped;
+};
+
+static JSOBJ eventString(void *context, char *start, char *end)
+{
+	struct EventState *es = (struct EventState *) context;
+	es->type = UJT_String;
+	es->start = start;
+	es->cbString = (size_t) (end - start);
+	return es;
+}
+
+static JSOBJ eventTrue(void *context)
+{
+	((struct EventState *) context)->type = UJT_True;
+	return context;
+}
+
+static JSOBJ eventFalse(void *context)
+{
+	((struct EventState *) context)->type = UJT_False;
+	return context;
+}
+
+static JSOBJ eventNull(void *context)
+{
+	((struct EventState *) context)->type = UJT_Null;
+	return context;
+}
+
+static JSOBJ eventContainer(void *context)
+{
+	return context;
+}
+
+static JSOBJ eventInt(void *context, JSINT32 value)
+{
+	struct EventState *es = (struct EventState *) context;
+	es->type = UJT_Long;
+	es->integer = value;
+	return es;
+}
+
+static JSOBJ eventLong(void *context, JSINT64 value)
+{
+	struct EventState *es = (struct EventState *) context;
+	es->type = UJT_LongLong;
+	es->integer = value;
+	return es;
+}
+
+static JSOBJ eventDouble(void *context, double value)
+{
+	struct EventState *es = (struct EventState *) context;
+	es->type = UJT_Double;
+	es->real = value;
+	return es;
+}
+
+static void eventRelease(void *context, JSOBJ obj)
+{
+	//NOTE: Fix for C4100 warning in L4 MSVC
+	(void) context;
+	(void) obj;
+}
+
+static int eventDispatch(void *context, int type, JSOBJ obj)
+{
+	struct EventState *es = (struct EventState *) context;
+	const UJEventHandlers *h = es->handlers;
+	int ret = 0;
+	//NOTE: Fix for C4100 warning in L4 MSVC
+	(void) obj;
+
+	switch (type)
+	{
+	case JE_BEGIN_OBJECT: ret = h->beginObject ? h->beginObject(es->context) : 0; break;
+	case JE_END_OBJECT: ret = h->endObject ? h->endObject(es->context) : 0; break;
+	case JE_BEGIN_ARRAY: ret = h->beginArray ? h->beginArray(es->context) : 0; break;
+	case JE_END_ARRAY: ret = h->endArray ? h->endArray(es->context) : 0; break;
+	case JE_KEY: ret = h->key ? h->key(es->context, es->start, es->cbString) : 0; break;
+
+	case JE_VALUE:
+		switch (es->type)
+		{
+		case UJT_String: ret = h->string ? h->string(es->context, es->start, es->cbString) : 0; break;
+		case UJT_Long:
+		case UJT_LongLong: ret = h->integer ? h->integer(es->context, es->integer) : 0; break;
+		case UJT_Double: ret = h->real ? h->real(es->context, es->real) : 0; break;
+		case UJT_True: ret = h->boolean ? h->boolean(es->context, 1) : 0; break;
+		case UJT_False: ret = h->boolean ? h->boolean(es->context, 0) : 0; break;
+		case UJT_Null: ret = h->null ? h->null(es->context) : 0; break;
+		}
+		break;
+	}
+
+	es->stopped = ret != 0;
+	return ret;
+}
+
+int UJDecodeEvents(const char *input, size_t cbInput, const UJEventHandlers *handlers, void *context, const char **outError)
+{
+	struct EventState es;
+	JSONObjectDecoder decoder;
+
+	memset(&decoder, 0, sizeof(decoder));
+	decoder.newUTF8String = eventString;
+	decoder.newTrue = eventTrue;
+	decoder.newFalse = eventFalse;
+	decoder.newNull = eventNull;
+	decoder.newObject = eventContainer;
+	decoder.newArray = eventContainer;
+	decoder.newInt = eventInt;
+	decoder.newLong = eventLong;
+	decoder.newDouble = eventDouble;
+	decoder.releaseObject = eventRelease;
+	decoder.event = eventDispatch;
+	decoder.malloc = malloc;
+	decoder.free = free;
+	decoder.realloc = realloc;
+	decoder.prv = &es;
+
+	es.handlers = handlers;
+	es.context = context;
+	es.stopped = 0;
+
+	if (outError)
+	{
+		*outError = NULL;
+	}
+
+	if (JSON_DecodeEvents(&decoder, input, cbInput))
+	{
+		return 1;
+	}
+
+	if (es.stopped)
+	{
+		return 0;
+	}
+
+	if (outError)
+	{
+		*outError = decoder.errorStr;
+	}
+
+	return -1;
+}
+
+/*
+Threads for the parallel decoders. Work is handed out under one mutex, which is only taken once per
+chunk of input, and a condition variable signals progress */
+#ifdef _WIN32
+typedef HANDLE ThreadHandle;
+typedef CRITICAL_SECTION ThreadMutex;
+typedef CONDITION_VARIABLE ThreadCond;
+
+static unsigned __stdcall threadEntry(void *arg);
+
+static int threadStart(ThreadHandle *thread, void *arg)
+{
+	*thread = (HANDLE) _beginthreadex(NULL, 0, threadEntry, arg, 0, NULL);
+	return *thread != 0;
+}
+
+static void threadJoin(ThreadHandle thread)
+{
+	WaitForSingleObject(thread, INFINITE);
+	CloseHandle(thread);
+}
+
+#define mutexInit(mutex) InitializeCriticalSection(mutex)
+#define mutexDestroy(mutex) DeleteCriticalSection(mutex)
+#define mutexLock(mutex) EnterCriticalSection(mutex)
+#define mutexUnlock(mutex) LeaveCriticalSection(mutex)
+#define condInit(cond) InitializeConditionVariable(cond)
+#define condDestroy(cond)
+#define condWait(cond, mutex) SleepConditionVariableCS(cond, mutex, INFINITE)
+#define condBroadcast(cond) WakeAllConditionVariable(cond)
+
+typedef volatile LONG ThreadFlag;
+#define flagGet(flag) InterlockedCompareExchange(flag, 0, 0)
+#define flagSet(flag) InterlockedExchange(flag, 1)
+
+static int cpuCount(void)
+{
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (int) info.dwNumberOfProcessors;
+}
+#else
+typedef pthread_t ThreadHandle;
+typedef pthread_mutex_t ThreadMutex;
+typedef pthread_cond_t ThreadCond;
+
+static void *threadEntry(void *arg);
+
+static int threadStart(ThreadHandle *thread, void *arg)
+{
+	return pthread_create(thread, NULL, threadEntry, arg) == 0;
+}
+
+static void threadJoin(ThreadHandle thread)
+{
+	pthread_join(thread, NULL);
+}
+
+#define mutexInit(mutex) pthread_mutex_init(mutex, NULL)
+#define mutexDestroy(mutex) pthread_mutex_destroy(mutex)
+#define mutexLock(mutex) pthread_mutex_lock(mutex)
+#define mutexUnlock(mutex) pthread_mutex_unlock(mutex)
+#define condInit(cond) pthread_cond_init(cond, NULL)
+#define condDestroy(cond) pthread_cond_destroy(cond)
+#define condWait(cond, mutex) pthread_cond_wait(cond, mutex)
+#define condBroadcast(cond) pthread_cond_broadcast(cond)
+
+typedef int ThreadFlag;
+#define flagGet(flag) __atomic_load_n(flag, __ATOMIC_ACQUIRE)
+#define flagSet(flag) __atomic_store_n(flag, 1, __ATOMIC_RELEASE)
+
+static int cpuCount(void)
+{
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (int) count : 1;
+}
+#endif
+
+/*
+Work run on a thread, the first member of each kind of worker */
+typedef struct __ThreadTask
+{
+	void (*run)(struct __ThreadTask *task);
+	ThreadHandle thread;
+} ThreadTask;
+
+#ifdef _WIN32
+static unsigned __stdcall threadEntry(void *arg)
+#else
+static void *threadEntry(void *arg)
+#endif
+{
+	((ThreadTask *) arg)->run((ThreadTask *) arg);
+	return 0;
+}
+
+/*
+Smallest chunk of lines handed to a thread at once */
+#define PARALLEL_MIN_CHUNK 65536
+
+typedef struct __LineRecord
+{
+	UJObject obj;
+	const char *error;
+	const char *line;
+	size_t cbLine;
+} LineRecord;
+
+struct ParallelLines
+{
+	const char *cursor;
+	const char *end;
+	size_t cbChunk;
+	size_t nextChunk;
+	size_t delivered;
+	int ordered;
+	int flags;
+	// Set by any thread, read by all of them outside of mutex
+	ThreadFlag stop;
+	ThreadMutex mutex;
+	ThreadCond cond;
+	UJRecordFunc callback;
+	void *context;
+};
+
+typedef struct __LineWorker
+{
+	ThreadTask task;
+	struct ParallelLines *pl;
+	size_t count;
+} LineWorker;
+
+/*
+Hands out the next chunk, ending it at the first newline after cbChunk bytes. Returns 0 once the input is used up */
+static int nextLineChunk(struct ParallelLines *pl, const char **outStart, const char **outEnd, size_t *outIndex)
+{
+	const char *end;
+	int ret = 0;
+
+	mutexLock(&pl->mutex);
+
+	if (pl->cursor < pl->end && !flagGet(&pl->stop))
+	{
+		end = pl->end;
+
+		if ((size_t) (pl->end - pl->cursor) > pl->cbChunk)
+		{
+			end = (const char *) memchr(pl->cursor + pl->cbChunk, '\n', (size_t) (pl->end - pl->cursor - pl->cbChunk));
+			end = end ? end + 1 : pl->end;
+		}
+
+		*outStart = pl->cursor;
+		*outEnd = end;
+		*outIndex = pl->nextChunk ++;
+		pl->cursor = end;
+		ret = 1;
+	}
+
+	mutexUnlock(&pl->mutex);
+	return ret;
+}
+
+static int deliverLine(struct ParallelLines *pl, LineWorker *worker, LineRecord *record)
+{
+	if (flagGet(&pl->stop))
+	{
+		return 0;
+	}
+
+	worker->count ++;
+
+	if (pl->callback(pl->context, record->obj, record->error, record->line, record->cbLine))
+	{
+		flagSet(&pl->stop);
+		return 0;
+	}
+
+	return 1;
+}
+
+/*
+Decodes chunks until the input is used up. Unordered, each record is delivered as soon as it is decoded.
+Ordered, a whole chunk is decoded into the arena first, then delivered once all earlier chunks are */
+static void decodeLineChunks(ThreadTask *task)
+{
+	LineWorker *worker = (LineWorker *) task;
+	struct ParallelLines *pl = worker->pl;
+	struct DecoderState *ds = (struct DecoderState *) UJDecoderCreate(NULL, pl->flags);
+	LineRecord *records = NULL;
+	size_t cRecords = 0;
+	size_t capacity = 0;
+	const char *start;
+	const char *end;
+	const char *lineEnd;
+	size_t index;
+	size_t chunk;
+	LineRecord record;
+
+	if (ds == NULL)
+	{
+		return;
+	}
+
+	while (nextLineChunk(pl, &start, &end, &chunk))
+	{
+		cRecords = 0;
+		resetHeap(ds);
+
+		for (; start < end && !flagGet(&pl->stop); start = lineEnd + 1)
+		{
+			lineEnd = (const char *) memchr(start, '\n', (size_t) (end - start));
+
+			if (lineEnd == NULL)
+			{
+				lineEnd = end;
+			}
+
+			if (!pl->ordered)
+			{
+				resetHeap(ds);
+			}
+
+			record.obj = decodeState(ds, start, (size_t) (lineEnd - start));
+			record.error = record.obj ? NULL : ds->error;
+			record.line = start;
+			record.cbLine = (size_t) (lineEnd - start);
+
+			if (record.obj == NULL && isBlankLine(start, lineEnd))
+			{
+				continue;
+			}
+
+			if (!pl->ordered)
+			{
+				deliverLine(pl, worker, &record);
+				continue;
+			}
+
+			if (cRecords == capacity)
+			{
+				LineRecord *newRecords;
+
+				capacity = capacity ? capacity * 2 : 256;
+				newRecords = (LineRecord *) realloc(records, capacity * sizeof(LineRecord));
+
+				if (newRecords == NULL)
+				{
+					// Out of memory, end the whole batch rather than skip records
+					flagSet(&pl->stop);
+					break;
+				}
+
+				records = newRecords;
+			}
+
+			if (record.obj && (ds->flags & UJF_TAPE))
+			{
+				// The tape moves as it grows, keep the index of the root until the chunk is delivered
+				record.obj = (UJObject) TAPE_AT((size_t) (TAPE_PTR(record.obj) - ds->tape));
+			}
+
+			records[cRecords ++] = record;
+		}
+
+		if (!pl->ordered)
+		{
+			continue;
+		}
+
+		mutexLock(&pl->mutex);
+
+		while (pl->delivered != chunk)
+		{
+			condWait(&pl->cond, &pl->mutex);
+		}
+
+		mutexUnlock(&pl->mutex);
+
+		if (ds->flags & UJF_TAPE)
+		{
+			for (index = 0; index < cRecords; index ++)
+			{
+				records[index].obj = tapeRoot(ds, records[index].obj);
+			}
+		}
+
+		for (index = 0; index < cRecords && deliverLine(pl, worker, &records[index]); index ++);
+
+		mutexLock(&pl->mutex);
+		pl->delivered ++;
+		condBroadcast(&pl->cond);
+		mutexUnlock(&pl->mutex);
+	}
+
+	free(records);
+	UJDecoderRelease(ds);
+}
+
+size_t UJDecodeLinesParallel(const char *input, size_t cbInput, int flags, int threads, int ordered, UJRecordFunc callback, void *context)
+{
+	struct ParallelLines pl;
+	LineWorker *workers;
+	int started;
+	int index;
+	size_t count = 0;
+
+	if (threads <= 0)
+	{
+		threads = cpuCount();
+	}
+
+	workers = (LineWorker *) malloc(threads * sizeof(LineWorker));
+
+	if (workers == NULL)
+	{
+		return 0;
+	}
+
+	pl.cursor = input;
+	pl.end = input + cbInput;
+	// Several chunks per thread so threads that finish early can take over the rest
+	pl.cbChunk = cbInput / ((size_t) threads * 8);
+	pl.cbChunk = pl.cbChunk < PARALLEL_MIN_CHUNK ? PARALLEL_MIN_CHUNK : pl.cbChunk;
+	pl.nextChunk = 0;
+	pl.delivered = 0;
+	pl.ordered = ordered;
+	pl.flags = flags & ~(UJF_INSITU | UJF_PARALLEL);
+	pl.stop = 0;
+	pl.callback = callback;
+	pl.context = context;
+	mutexInit(&pl.mutex);
+	condInit(&pl.cond);
+
+	for (index = 0; index < threads; index ++)
+	{
+		workers[index].task.run = decodeLineChunks;
+		workers[index].pl = &pl;
+		workers[index].count = 0;
+	}
+
+	// The calling thread is the first worker
+	for (started = 1; started < threads; started ++)
+	{
+		if (!threadStart(&workers[started].task.thread, &workers[started].task))
+		{
+			break;
+		}
+	}
+
+	decodeLineChunks(&workers[0].task);
+
+	for (index = 0; index < started; index ++)
+	{
+		if (index > 0)
+		{
+			threadJoin(workers[index].task.thread);
+		}
+
+		count += workers[index].count;
+	}
+
+	condDestroy(&pl.cond);
+	mutexDestroy(&pl.mutex);
+	free(workers);
+	return count;
+}
+
+/*
+Longest element prefix compared at split points, and how far past a split point quotes are looked for */
+#define SPLIT_MAX_SIGNATURE 64
+#define SPLIT_QUOTE_WINDOW 4096
+
+typedef struct __SliceWorker
+{
+	ThreadTask task;
+	struct DecoderState *parent;
+	struct DecoderState *ds;
+	const char *start;
+	const char *end;
+	UJObject obj;
+	int started;
+} SliceWorker;
+
+static const char *skipSpace(const char *p, const char *end)
+{
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+		p ++;
+
+	return p;
+}
+
+/*
+Text the first element starts with, which the elements of a large array usually share. For objects
+that is everything up to the end of the first key. Returns its length, 0 if nothing is shared */
+static size_t elementSignature(const char *p, const char *end)
+{
+	const char *q;
+
+	if (*p == '[')
+	{
+		return 1;
+	}
+
+	if (*p != '{')
+	{
+		return 0;
+	}
+
+	q = skipSpace(p + 1, end);
+
+	if (q >= end || *q != '"')
+	{
+		return 1;
+	}
+
+	for (q ++; q < end && q - p < SPLIT_MAX_SIGNATURE; q ++)
+	{
+		if (*q == '\\')
+		{
+			break;
+		}
+
+		if (*q == '"')
+		{
+			return (size_t) (q + 1 - p);
+		}
+	}
+
+	return 1;
+}
+
+/*
+Quote parity at p. Outside a string the next unescaped quote opens one, inside it closes it and is
+followed by what may follow a string. False if p looks to be inside a string */
+static int outsideString(const char *p, const char *end)
+{
+	const char *q;
+	int backslashes = 0;
+
+	if (end - p > SPLIT_QUOTE_WINDOW)
+	{
+		end = p + SPLIT_QUOTE_WINDOW;
+	}
+
+	for (; p < end; p ++)
+	{
+		if (*p == '\\')
+		{
+			backslashes ++;
+			continue;
+		}
+
+		if (*p == '"' && (backslashes & 1) == 0)
+		{
+			q = skipSpace(p + 1, end);
+			return q >= end || (*q != ':' && *q != ',' && *q != '}' && *q != ']');
+		}
+
+		backslashes = 0;
+	}
+
+	return 1;
+}
+
+/*
+Finds the first comma at or after p that looks like it separates two elements of the root array: outside
+a string, after the closing bracket of the previous element and before the signature of the next one */
+static const char *findElementSplit(const char *p, const char *end, const char *sig, size_t cbSig)
+{
+	const char *q;
+	char close = cbSig ? (*sig == '{' ? '}' : ']') : 0;
+
+	for (; p < end; p ++)
+	{
+		p = (const char *) memchr(p, ',', (size_t) (end - p));
+
+		if (p == NULL)
+		{
+			return NULL;
+		}
+
+		if (close)
+		{
+			for (q = p - 1; *q == ' ' || *q == '\t' || *q == '\r' || *q == '\n'; q --);
+
+			if (*q != close)
+			{
+				continue;
+			}
+		}
+
+		q = skipSpace(p + 1, end);
+
+		if ((size_t) (end - q) < cbSig || memcmp(q, sig, cbSig) != 0)
+		{
+			continue;
+		}
+
+		if (outsideString(p + 1, end))
+		{
+			return p;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+Decodes one slice of elements into an arena of its own, grown with the allocator of the parent */
+static void decodeSlice(ThreadTask *task)
+{
+	SliceWorker *worker = (SliceWorker *) task;
+	struct DecoderState *parent = worker->parent;
+	struct DecoderState *ds;
+	UJHeapFuncs hf;
+
+	worker->ds = NULL;
+	worker->obj = NULL;
+
+	hf.malloc = parent->malloc;
+	hf.free = parent->free;
+	hf.realloc = parent->decoder.realloc;
+	hf.cbInitialHeap = 16384;
+	hf.initalHeap = hf.malloc(hf.cbInitialHeap);
+
+	if (hf.initalHeap == NULL)
+	{
+		return;
+	}
+
+	// Slices keep their keys, a table shared between threads would need a lock
+	ds = createState(&hf, parent->flags & ~(UJF_PARALLEL | UJF_INTERNKEYS));
+	ds->base->owned = 1;
+	ds->decoder.objectDepthMax = parent->decoder.objectDepthMax;
+	ds->input = parent->input;
+	ds->inputEnd = parent->inputEnd;
+
+	worker->ds = ds;
+	worker->obj = (UJObject) JSON_DecodeElements(&ds->decoder, worker->start, (size_t) (worker->end - worker->start));
+}
+
+/*
+Hands the slabs of a decoded slice over to ds */
+static void adoptSlice(struct DecoderState *ds, struct DecoderState *sliceState)
+{
+	sliceState->base->next = ds->heap;
+	ds->heap = sliceState->heap;
+	sliceState->owner = ds;
+
+	if (sliceState->elements)
+	{
+		sliceState->free(sliceState->elements);
+		sliceState->elements = NULL;
+	}
+}
+
+/*
+Stores the elements of the root array followed by those of the slices of count workers in one block */
+static void joinSlices(struct DecoderState *ds, ArrayItem *root, SliceWorker *workers, int count)
+{
+	ArrayItem *slice;
+	Item **items;
+	size_t total = root->count;
+	int index;
+
+	for (index = 0; index < count; index ++)
+	{
+		total += ((ArrayItem *) workers[index].obj)->count;
+	}
+
+	items = (Item **) alloc(ds, (total + 1) * sizeof(Item *));
+	memcpy(items, root->items, root->count * sizeof(Item *));
+	total = root->count;
+
+	for (index = 0; index < count; index ++)
+	{
+		slice = (ArrayItem *) workers[index].obj;
+		memcpy(items + total, slice->items, slice->count * sizeof(Item *));
+		total += slice->count;
+	}
+
+	items[total] = NULL;
+	root->items = items;
+	root->count = total;
+}
+
+/*
+UJF_PARALLEL. Splits the elements of a root array into slices, decodes slice 0 on the calling thread and
+the others on threads of their own. A slice only decodes if it holds whole elements, so every split
+is checked. From the first slice that fails the rest is decoded serially, and if that fails too the
+whole input is decoded again to report the same error as a serial decode */
+static UJObject decodeParallel(struct DecoderState *ds, const char *input, size_t cbInput)
+{
+	const char *start = skipSpace(input, input + cbInput);
+	const char *end = input + cbInput;
+	const char *split;
+	SliceWorker *workers;
+	ArrayItem *root;
+	ArrayItem *rest;
+	size_t cbSig;
+	int threads;
+	int count;
+	int failed;
+	int index;
+
+	while (end > start && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '\n'))
+		end --;
+
+	threads = ds->threads > 0 ? ds->threads : cpuCount();
+
+	if ((size_t) (end - start) / PARALLEL_MIN_SLICE < (size_t) threads)
+	{
+		threads = (int) ((size_t) (end - start) / PARALLEL_MIN_SLICE);
+	}
+
+	if (threads < 2 || *start != '[' || end[-1] != ']')
+	{
+		return decodeSerial(ds, input, cbInput);
+	}
+
+	workers = (SliceWorker *) malloc(threads * sizeof(SliceWorker));
+
+	if (workers == NULL)
+	{
+		return decodeSerial(ds, input, cbInput);
+	}
+
+	start = skipSpace(start + 1, end);
+	end --;
+	cbSig = elementSignature(start, end);
+
+	workers[0].start = start;
+
+	for (count = 1; count < threads; count ++)
+	{
+		split = start + (size_t) (end - start) / threads * count;
+
+		if (split <= workers[count - 1].start)
+		{
+			split = workers[count - 1].start + 1;
+		}
+
+		split = findElementSplit(split, end, start, cbSig);
+
+		if (split == NULL)
+		{
+			break;
+		}
+
+		workers[count - 1].end = split;
+		workers[count].start = split + 1;
+	}
+
+	workers[count - 1].end = end;
+
+	for (index = 1; index < count; index ++)
+	{
+		workers[index].task.run = decodeSlice;
+		workers[index].parent = ds;
+		workers[index].started = threadStart(&workers[index].task.thread, &workers[index].task);
+	}
+
+	root = (ArrayItem *) JSON_DecodeElements(&ds->decoder, workers[0].start, (size_t) (workers[0].end - workers[0].start));
+	failed = root ? count : 0;
+
+	for (index = 1; index < count; index ++)
+	{
+		if (workers[index].started)
+		{
+			threadJoin(workers[index].task.thread);
+		}
+		else
+		{
+			decodeSlice(&workers[index].task);
+		}
+
+		if (failed == count && workers[index].obj)
+		{
+			adoptSlice(ds, workers[index].ds);
+			continue;
+		}
+
+		if (failed == count)
+		{
+			failed = index;
+		}
+
+		if (workers[index].ds)
+		{
+			UJFree(workers[index].ds);
+		}
+	}
+
+	if (failed > 0 && failed < count)
+	{
+		// The rest decoded serially takes the place of the first failed slice
+		workers[failed].obj = rest = (ArrayItem *) JSON_DecodeElements(&ds->decoder, workers[failed].start, (size_t) (end - workers[failed].start));
+		failed = rest ? failed + 1 : 0;
+	}
+
+	if (failed > 1)
+	{
+		joinSlices(ds, root, workers + 1, failed - 1);
+	}
+
+	free(workers);
+
+	if (failed == 0)
+	{
+		resetHeap(ds);
+		root = (ArrayItem *) decodeSerial(ds, input, cbInput);
+	}
+
+	return (UJObject) root;
+}
+
+/*
+Resolves the escape sequences of the contents of a string into UTF-8 at out, which may be the same
+as start. Returns the length written or (size_t) -1 if an escape is invalid */
+static size_t unescapeString(const char *start, const char *end, char *out)
+{
+	char *offset = out;
+	unsigned long ucs;
+	unsigned long low;
+	int index;
+
+	while (start < end)
+	{
+		if (*start != '\\')
+		{
+			*(offset++) = *(start++);
+			continue;
+		}
+
+		if (end - start < 2)
+		{
+			return (size_t) -1;
+		}
+
+		start += 2;
+
+		switch (start[-1])
+		{
+		case '\"': *(offset++) = '\"'; continue;
+		case '\\': *(offset++) = '\\'; continue;
+		case '/': *(offset++) = '/'; continue;
+		case 'b': *(offset++) = '\b'; continue;
+		case 'f': *(offset++) = '\f'; continue;
+		case 'n': *(offset++) = '\n'; continue;
+		case 'r': *(offset++) = '\r'; continue;
+		case 't': *(offset++) = '\t'; continue;
+		case 'u': break;
+		default: return (size_t) -1;
+		}
+
+		ucs = 0;
+
+		for (index = 0; index < 4; index ++, start ++)
+		{
+			if (start >= end || !isxdigit((unsigned char) *start))
+			{
+				return (size_t) -1;
+			}
+
+			ucs = (ucs << 4) | (unsigned long) (*start <= '9' ? *start - '0' : (*start | 0x20) - 'a' + 10);
+		}
+
+		if (ucs >= 0xdc00 && ucs <= 0xdfff)
+		{
+			return (size_t) -1;
+		}
+
+		if (ucs >= 0xd800 && ucs <= 0xdbff)
+		{
+			// The low surrogate must follow as an escape of its own
+			if (end - start < 6 || start[0] != '\\' || start[1] != 'u')
+			{
+				return (size_t) -1;
+			}
+
+			low = 0;
+
+			for (index = 2; index < 6; index ++)
+			{
+				if (!isxdigit((unsigned char) start[index]))
+				{
+					return (size_t) -1;
+				}
+
+				low = (low << 4) | (unsigned long) (start[index] <= '9' ? start[index] - '0' : (start[index] | 0x20) - 'a' + 10);
+			}
+
+			if (low < 0xdc00 || low > 0xdfff)
+			{
+				return (size_t) -1;
+			}
+
+			ucs = 0x10000 + ((ucs - 0xd800) << 10) + (low - 0xdc00);
+			start += 6;
+		}
+
+		if (ucs < 0x80)
+		{
+			*(offset++) = (char) ucs;
+		}
+		else
+		if (ucs < 0x800)
+		{
+			*(offset++) = (char) (0xc0 | (ucs >> 6));
+			*(offset++) = (char) (0x80 | (ucs & 0x3f));
+		}
+		else
+		if (ucs < 0x10000)
+		{
+			*(offset++) = (char) (0xe0 | (ucs >> 12));
+			*(offset++) = (char) (0x80 | ((ucs >> 6) & 0x3f));
+			*(offset++) = (char) (0x80 | (ucs & 0x3f));
+		}
+		else
+		{
+			*(offset++) = (char) (0xf0 | (ucs >> 18));
+			*(offset++) = (char) (0x80 | ((ucs >> 12) & 0x3f));
+			*(offset++) = (char) (0x80 | ((ucs >> 6) & 0x3f));
+			*(offset++) = (char) (0x80 | (ucs & 0x3f));
+		}
+	}
+
+	return (size_t) (offset - out);
+}
+
+/*
+Reads the number at cursor, checking it against the JSON grammar. Returns the UJTypes type it would
+be decoded as, or -1 if it is no valid number. Integers are converted to outInteger on the way */
+static int readNumber(const UJCursor *cursor, long long *outInteger)
+{
+	const char *p = cursor->ptr;
+	const char *end = JSON_SkipValue(p, cursor->end);
+	unsigned long long value = 0;
+	int negative = 0;
+	int isDouble = 0;
+	int overflow = 0;
+
+	if (end == NULL)
+	{
+		return -1;
+	}
+
+	if (*p == '-')
+	{
+		negative = 1;
+		p ++;
+	}
+
+	if (p >= end || *p < '0' || *p > '9' || (*p == '0' && p + 1 < end && p[1] >= '0' && p[1] <= '9'))
+	{
+		return -1;
+	}
+
+	for (; p < end && *p >= '0' && *p <= '9'; p ++)
+	{
+		if (value > (ULLONG_MAX - 9) / 10)
+		{
+			overflow = 1;
+			continue;
+		}
+
+		value = value * 10 + (unsigned long long) (*p - '0');
+	}
+
+	if (p < end && *p == '.')
+	{
+		isDouble = 1;
+
+		if (++ p >= end || *p < '0' || *p > '9')
+		{
+			return -1;
+		}
+
+		while (p < end && *p >= '0' && *p <= '9')
+			p ++;
+	}
+
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		isDouble = 1;
+		p ++;
+
+		if (p < end && (*p == '+' || *p == '-'))
+			p ++;
+
+		if (p >= end || *p < '0' || *p > '9')
+		{
+			return -1;
+		}
+
+		while (p < end && *p >= '0' && *p <= '9')
+			p ++;
+	}
+
+	if (p != end)
+	{
+		return -1;
+	}
+
+	if (isDouble)
+	{
+		return UJT_Double;
+	}
+
+	if (overflow || value > (negative ? (unsigned long long) LLONG_MAX + 1 : (unsigned long long) LLONG_MAX))
+	{
+		return -1;
+	}
+
+	*outInteger = negative ? (long long) (0 - value) : (long long) value;
+	return (*outInteger >= INT_MIN && *outInteger <= INT_MAX) ? UJT_Long : UJT_LongLong;
+}
+
+/*
+Reads the key of a member starting at p and points cursor at its value */
+static int readMember(UJCursor *cursor, const char *p, UJUTF8String *outKey)
+{
+	const char *keyEnd;
+
+	if (p >= cursor->end || *p != '\"' || (keyEnd = JSON_SkipValue(p, cursor->end)) == NULL)
+	{
+		return -1;
+	}
+
+	if (outKey)
+	{
+		outKey->ptr = p + 1;
+		outKey->cbLen = (size_t) (keyEnd - p - 2);
+	}
+
+	p = skipSpace(keyEnd, cursor->end);
+
+	if (p >= cursor->end || *p != ':')
+	{
+		return -1;
+	}
+
+	p = skipSpace(p + 1, cursor->end);
+
+	if (p >= cursor->end)
+	{
+		return -1;
+	}
+
+	cursor->ptr = p;
+	return 1;
+}
+
+static int keyEqualsRaw(const UJUTF8String *rawKey, const char *key, size_t cbKey)
+{
+	char buffer[256];
+	char *unescaped = buffer;
+	size_t cbUnescaped;
+	int ret;
+
+	if (memchr(rawKey->ptr, '\\', rawKey->cbLen) == NULL)
+	{
+		return rawKey->cbLen == cbKey && memcmp(rawKey->ptr, key, cbKey) == 0;
+	}
+
+	// An escape takes up at least as many bytes as the UTF-8 it stands for
+	if (cbKey > rawKey->cbLen)
+	{
+		return 0;
+	}
+
+	if (rawKey->cbLen > sizeof(buffer) && (unescaped = (char *) malloc(rawKey->cbLen)) == NULL)
+	{
+		return 0;
+	}
+
+	cbUnescaped = unescapeString(rawKey->ptr, rawKey->ptr + rawKey->cbLen, unescaped);
+	ret = cbUnescaped == cbKey && memcmp(unescaped, key, cbKey) == 0;
+
+	if (unescaped != buffer)
+	{
+		free(unescaped);
+	}
+
+	return ret;
+}
+
+int UJCursorRoot(const char *input, size_t cbInput, UJCursor *outCursor)
+{
+	outCursor->end = input + cbInput;
+	outCursor->ptr = skipSpace(input, outCursor->end);
+	outCursor->inObject = 0;
+	return outCursor->ptr < outCursor->end;
+}
+
+int UJCursorType(const UJCursor *cursor)
+{
+	const char *p = cursor->ptr;
+	size_t cbLeft = (size_t) (cursor->end - p);
+	long long integer;
+
+	if (cbLeft == 0)
+	{
+		return -1;
+	}
+
+	switch (*p)
+	{
+	case '{': return UJT_Object;
+	case '[': return UJT_Array;
+	case '\"': return UJT_String;
+	case 't': return (cbLeft >= 4 && memcmp(p, "true", 4) == 0) ? UJT_True : -1;
+	case 'f': return (cbLeft >= 5 && memcmp(p, "false", 5) == 0) ? UJT_False : -1;
+	case 'n': return (cbLeft >= 4 && memcmp(p, "null", 4) == 0) ? UJT_Null : -1;
+	default: return readNumber(cursor, &integer);
+	}
+}
+
+int UJCursorFirst(const UJCursor *cursor, UJCursor *outChild, UJUTF8String *outKey)
+{
+	const char *p = cursor->ptr;
+
+	if (p >= cursor->end || (*p != '{' && *p != '['))
+	{
+		return -1;
+	}
+
+	outChild->end = cursor->end;
+	outChild->inObject = *p == '{';
+	p = skipSpace(p + 1, cursor->end);
+
+	if (p >= cursor->end)
+	{
+		return -1;
+	}
+
+	if (*p == (outChild->inObject ? '}' : ']'))
+	{
+		return 0;
+	}
+
+	if (outChild->inObject)
+	{
+		return readMember(outChild, p, outKey);
+	}
+
+	outChild->ptr = p;
+	return 1;
+}
+
+/*
+Moves cursor to the next element or member given the end of the current one at p */
+static int advanceCursor(UJCursor *cursor, const char *p, UJUTF8String *outKey)
+{
+	if (p == NULL || (p = skipSpace(p, cursor->end)) >= cursor->end)
+	{
+		return -1;
+	}
+
+	if (*p == (cursor->inObject ? '}' : ']'))
+	{
+		return 0;
+	}
+
+	if (*p != ',')
+	{
+		return -1;
+	}
+
+	p = skipSpace(p + 1, cursor->end);
+
+	if (cursor->inObject)
+	{
+		return readMember(cursor, p, outKey);
+	}
+
+	if (p >= cursor->end)
+	{
+		return -1;
+	}
+
+	cursor->ptr = p;
+	return 1;
+}
+
+int UJCursorNext(UJCursor *cursor, UJUTF8String *outKey)
+{
+	return advanceCursor(cursor, JSON_SkipValue(cursor->ptr, cursor->end), outKey);
+}
+
+int UJCursorFind(const UJCursor *cursor, const char *key, size_t cbKey, UJCursor *outValue)
+{
+	UJCursor child;
+	UJUTF8String rawKey;
+	int ret;
+
+	if (cursor->ptr >= cursor->end || *cursor->ptr != '{')
+	{
+		return -1;
+	}
+
+	for (ret = UJCursorFirst(cursor, &child, &rawKey); ret == 1; ret = UJCursorNext(&child, &rawKey))
+	{
+		if (keyEqualsRaw(&rawKey, key, cbKey))
+		{
+			*outValue = child;
+			return 1;
+		}
+	}
+
+	return ret;
+}
+
+int UJCursorReadLongLong(const UJCursor *cursor, long long *outValue)
+{
+	int type = readNumber(cursor, outValue);
+	return type == UJT_Long || type == UJT_LongLong;
+}
+
+int UJCursorReadDouble(const UJCursor *cursor, double *outValue)
+{
+	long long integer;
+
+	switch (readNumber(cursor, &integer))
+	{
+	case UJT_Long:
+	case UJT_LongLong:
+		*outValue = (double) integer;
+		return 1;
+
+	case UJT_Double:
+		*outValue = JSON_DecodeRawDouble(cursor->ptr, JSON_SkipValue(cursor->ptr, cursor->end));
+		return 1;
+	}
+
+	return 0;
+}
+
+int UJCursorReadString(const UJCursor *cursor, char *buffer, size_t cbBuffer, UJUTF8String *outString)
+{
+	const char *end;
+	const char *start = cursor->ptr + 1;
+
+	if (cursor->ptr >= cursor->end || *cursor->ptr != '\"' || (end = JSON_SkipValue(cursor->ptr, cursor->end)) == NULL)
+	{
+		return 0;
+	}
+
+	end --;
+
+	if (memchr(start, '\\', (size_t) (end - start)) == NULL)
+	{
+		outString->ptr = start;
+		outString->cbLen = (size_t) (end - start);
+		return 1;
+	}
+
+	if (cbBuffer < (size_t) (end - start))
+	{
+		return 0;
+	}
+
+	outString->ptr = buffer;
+	outString->cbLen = unescapeString(start, end, buffer);
+	return outString->cbLen != (size_t) -1;
+}
+
+UJObject UJCursorDecode(const UJCursor *cursor, UJHeapFuncs *hf, int flags, void **outState)
+{
+	const char *end = JSON_SkipValue(cursor->ptr, cursor->end);
+	return UJDecodeEx(cursor->ptr, (size_t) ((end ? end : cursor->end) - cursor->ptr), hf, flags, outState);
+}
+
+/*
+UJDecodePaths. The key paths are merged into a tree of steps, one level per key or array index. A value
+is decoded in full where a path ends, containers on the way only get the members and elements some
+path continues into, everything else is skipped like by a cursor */
+typedef struct __PathStep
+{
+	// NULL for an array step, index is then the element or -1 for all of them
+	const char *key;
+	size_t cbKey;
+	long index;
+	int leaf;
+	struct __PathStep *children;
+	struct __PathStep *next;
+} PathStep;
+
+struct PathSelection
+{
+	struct DecoderState *ds;
+	// Steps matching the values of one level, cPaths for each level of depth
+	PathStep **scratch;
+	int cPaths;
+};
+
+static PathStep *addStep(struct DecoderState *ds, PathStep *parent, const char *key, size_t cbKey, long index)
+{
+	PathStep *step;
+
+	for (step = parent->children; step; step = step->next)
+	{
+		if (key ? (step->key && step->cbKey == cbKey && memcmp(step->key, key, cbKey) == 0) : (!step->key && step->index == index))
+		{
+			return step;
+		}
+	}
+
+	step = (PathStep *) alloc(ds, sizeof(PathStep));
+	step->key = key;
+	step->cbKey = cbKey;
+	step->index = index;
+	step->leaf = 0;
+	step->children = NULL;
+	step->next = parent->children;
+	parent->children = step;
+	return step;
+}
+
+/*
+Adds a path like "items[*].id" to the tree below root and returns its number of steps, or -1 if it is
+malformed */
+static int addPath(struct DecoderState *ds, PathStep *root, const char *path)
+{
+	PathStep *step = root;
+	const char *end;
+	char *indexEnd;
+	long index;
+	int depth = 0;
+
+	while (*path)
+	{
+		if (*path == '[')
+		{
+			if (path[1] == '*' && path[2] == ']')
+			{
+				index = -1;
+				path += 3;
+			}
+			else
+			{
+				if (path[1] < '0' || path[1] > '9')
+				{
+					return -1;
+				}
+
+				index = strtol(path + 1, &indexEnd, 10);
+
+				if (*indexEnd != ']' || index < 0)
+				{
+					return -1;
+				}
+
+				path = indexEnd + 1;
+			}
+
+			step = addStep(ds, step, NULL, 0, index);
+		}
+		else
+		{
+			if (*path == '.' && depth > 0)
+			{
+				path ++;
+			}
+
+			for (end = path; *end && *end != '.' && *end != '['; end ++);
+
+			if (end == path)
+			{
+				return -1;
+			}
+
+			step = addStep(ds, step, path, (size_t) (end - path), 0);
+			path = end;
+		}
+
+		depth ++;
+	}
+
+	if (depth == 0)
+	{
+		return -1;
+	}
+
+	step->leaf = 1;
+	return depth;
+}
+
+/*
+Points cursor at the root of a document that is to be walked by cursor, checking that the root ends
+before the input and only whitespace follows. Returns an error message or NULL */
+static const char *cursorDocument(const char *input, size_t cbInput, UJCursor *cursor)
+{
+	const char *end;
+
+	if (!UJCursorRoot(input, cbInput, cursor))
+	{
+		return "Expected object or value";
+	}
+
+	end = JSON_SkipValue(cursor->ptr, cursor->end);
+
+	if (end == NULL)
+	{
+		return "Unexpected end of input";
+	}
+
+	if (skipSpace(end, cursor->end) != cursor->end)
+	{
+		return "Trailing data";
+	}
+
+	return NULL;
+}
+
+static UJObject decodeRange(struct DecoderState *ds, const char *start, const char *end)
+{
+	UJObject ret = (UJObject) JSON_DecodeObject(&ds->decoder, start, (size_t) (end - start));
+
+	if (ret == NULL)
+	{
+		ds->error = ds->decoder.errorStr;
+	}
+
+	return ret;
+}
+
+/*
+Returns whether any of the steps leading to the value at cursor selects it, or continues into it with
+a key for an object or an index for an array. Paths that continue past anything else are dropped */
+static int stepsReach(const UJCursor *cursor, PathStep **steps, int cSteps)
+{
+	PathStep *child;
+	int n;
+
+	for (n = 0; n < cSteps; n ++)
+	{
+		if (steps[n]->leaf)
+		{
+			return 1;
+		}
+
+		for (child = steps[n]->children; child; child = child->next)
+		{
+			if (*cursor->ptr == (child->key ? '{' : '['))
+			{
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/*
+Decodes the value at cursor as selected by the steps leading to it, any of which may be a leaf. The
+value must be reached by the steps */
+static UJObject selectValue(struct PathSelection *sel, const UJCursor *cursor, PathStep **steps, int cSteps, int depth)
+{
+	struct DecoderState *ds = sel->ds;
+	PathStep **matches = sel->scratch + (size_t) (depth + 1) * sel->cPaths;
+	PathStep *child;
+	UJCursor item;
+	UJUTF8String key;
+	UJObject container;
+	UJObject value;
+	UJObject name;
+	const char *end;
+	long index;
+	long lastIndex = -1;
+	int cMatches;
+	int isObject;
+	int ret;
+	int n;
+
+	for (n = 0; n < cSteps; n ++)
+	{
+		if (steps[n]->leaf)
+		{
+			end = JSON_SkipValue(cursor->ptr, cursor->end);
+			return decodeRange(ds, cursor->ptr, end ? end : cursor->end);
+		}
+
+		for (child = steps[n]->children; child; child = child->next)
+		{
+			if (!child->key && (child->index < 0 || child->index > lastIndex))
+			{
+				lastIndex = child->index < 0 ? LONG_MAX : child->index;
+			}
+		}
+	}
+
+	isObject = *cursor->ptr == '{';
+	container = (UJObject) (isObject ? ds->decoder.newObject(ds->decoder.prv) : ds->decoder.newArray(ds->decoder.prv));
+
+	for (ret = UJCursorFirst(cursor, &item, &key), index = 0; ret == 1; ret = UJCursorNext(&item, &key), index ++)
+	{
+		if (!isObject && index > lastIndex)
+		{
+			// The rest is skipped together with the array
+			ds->decoder.endArray(ds->decoder.prv, container);
+			return container;
+		}
+
+		cMatches = 0;
+
+		for (n = 0; n < cSteps; n ++)
+		{
+			for (child = steps[n]->children; child; child = child->next)
+			{
+				if (isObject ? (child->key && keyEqualsRaw(&key, child->key, child->cbKey)) : (!child->key && (child->index < 0 || child->index == index)))
+				{
+					matches[cMatches ++] = child;
+				}
+			}
+		}
+
+		if (cMatches == 0 || !stepsReach(&item, matches, cMatches))
+		{
+			continue;
+		}
+
+		value = selectValue(sel, &item, matches, cMatches, depth + 1);
+
+		if (value == NULL)
+		{
+			return NULL;
+		}
+
+		if (!isObject)
+		{
+			ds->decoder.arrayAddItem(ds->decoder.prv, container, value);
+
+			if (ds->decoder.errorStr)
+			{
+				ds->error = ds->decoder.errorStr;
+				return NULL;
+			}
+
+			continue;
+		}
+
+		// The key is decoded with its quotes like a string value
+		name = decodeRange(ds, key.ptr - 1, key.ptr + key.cbLen + 1);
+
+		if (name == NULL)
+		{
+			return NULL;
+		}
+
+		ds->decoder.objectAddKey(ds->decoder.prv, container, name, value);
+	}
+
+	if (ret < 0)
+	{
+		ds->error = isObject ? "Malformed object" : "Malformed array";
+		return NULL;
+	}
+
+	if (!isObject)
+	{
+		ds->decoder.endArray(ds->decoder.prv, container);
+	}
+
+	return container;
+}
+
+UJObject UJDecodePaths(const char *input, size_t cbInput, UJHeapFuncs *hf, int flags, const char **paths, int cPaths, void **outState)
+{
+	// Selected values are attached after their keys are read, out of the order a tape needs
+	struct DecoderState *ds = createState(hf, flags & ~(UJF_INSITU | UJF_PARALLEL | UJF_TAPE));
+	struct PathSelection sel;
+	PathStep root;
+	PathStep *rootStep = &root;
+	UJCursor cursor;
+	UJObject ret;
+	int maxDepth = 0;
+	int depth;
+	int index;
+
+	*outState = (void *) ds;
+
+	if (ds == NULL)
+	{
+		return NULL;
+	}
+
+	ds->input = input;
+	ds->inputEnd = input + cbInput;
+
+	root.key = NULL;
+	root.leaf = 0;
+	root.children = NULL;
+
+	for (index = 0; index < cPaths; index ++)
+	{
+		depth = addPath(ds, &root, paths[index]);
+
+		if (depth < 0)
+		{
+			ds->error = "Invalid key path";
+			return NULL;
+		}
+
+		maxDepth = depth > maxDepth ? depth : maxDepth;
+	}
+
+	ds->error = cursorDocument(input, cbInput, &cursor);
+
+	if (ds->error)
+	{
+		return NULL;
+	}
+
+	if (*cursor.ptr != '{' && *cursor.ptr != '[')
+	{
+		// Every path continues past a scalar root
+		return (UJObject) ds->decoder.newObject(ds->decoder.prv);
+	}
+
+	sel.ds = ds;
+	sel.cPaths = cPaths;
+	sel.scratch = (PathStep **) malloc((size_t) (maxDepth + 2) * (cPaths ? cPaths : 1) * sizeof(PathStep *));
+
+	if (sel.scratch == NULL)
+	{
+		ds->error = "Could not reserve memory block";
+		return NULL;
+	}
+
+	ret = selectValue(&sel, &cursor, &rootStep, 1, 0);
+	free(sel.scratch);
+	return ret;
+}
+
+/*
+UJQuery. A JSONPath expression is compiled to a list of steps, each of which is a state of an automaton
+run over the document. The states a value is reached in are kept as bits, state i meaning the first i
+steps matched. A child of the value is reached in state i + 1 if step i matches it and, for recursive
+descent steps, stays in state i. Values in the last state are matches, children reached in no state at
+all are skipped without being read */
+#define QUERY_MAX_STEPS 63
+
+enum QueryStepKind
+{
+	QS_KEY,
+	QS_ANY,
+	QS_INDEX,
+	QS_SLICE
+};
+
+typedef struct __QueryStep
+{
+	int kind;
+	int recursive;
+	const char *key;
+	size_t cbKey;
+	long start;
+	long end;
+	long step;
+} QueryStep;
+
+struct Query
+{
+	int cSteps;
+	QueryStep steps[1];
+};
+
+struct QueryRun
+{
+	struct Query *query;
+	struct DecoderState *ds;
+	UJMatchFunc callback;
+	void *context;
+	size_t count;
+	const char *error;
+};
+
+static int queryStepMatches(const QueryStep *step, const UJUTF8String *key, long index)
+{
+	switch (step->kind)
+	{
+	case QS_ANY: return 1;
+	case QS_KEY: return key && keyEqualsRaw(key, step->key, step->cbKey);
+	case QS_INDEX: return !key && index == step->start;
+	case QS_SLICE: return !key && index >= step->start && index < step->end && (index - step->start) % step->step == 0;
+	}
+
+	return 0;
+}
+
+/*
+Parses a bracketed index or slice like [2], [1:5] or [::2] at path, which points past the bracket */
+static const char *parseQueryIndex(const char *path, QueryStep *step)
+{
+	long values[3] = {0, LONG_MAX, 1};
+	char *end;
+	int count = 0;
+
+	for (;;)
+	{
+		if (*path >= '0' && *path <= '9')
+		{
+			values[count] = strtol(path, &end, 10);
+			path = end;
+		}
+		else
+		if (*path == '-')
+		{
+			// Negative positions count from the end, which isn't known while streaming
+			return NULL;
+		}
+
+		if (*path == ']')
+		{
+			break;
+		}
+
+		if (*path != ':' || ++ count > 2)
+		{
+			return NULL;
+		}
+
+		path ++;
+	}
+
+	if (count == 0)
+	{
+		if (path[-1] == '[')
+		{
+			return NULL;
+		}
+
+		step->kind = QS_INDEX;
+		step->start = values[0];
+	}
+	else
+	{
+		if (values[2] <= 0)
+		{
+			return NULL;
+		}
+
+		step->kind = QS_SLICE;
+		step->start = values[0];
+		step->end = values[1];
+		step->step = values[2];
+	}
+
+	return path + 1;
+}
+
+UJQuery UJQueryCompile(const char *expression, const char **outError)
+{
+	QueryStep steps[QUERY_MAX_STEPS];
+	QueryStep *step;
+	struct Query *query;
+	const char *path = expression;
+	const char *keyEnd;
+	char quote;
+	char *keys;
+	int cSteps = 0;
+	int index;
+
+	*outError = NULL;
+
+	if (*(path++) != '$')
+	{
+		*outError = "Expression must start with '$'";
+		return NULL;
+	}
+
+	while (*path)
+	{
+		if (cSteps == QUERY_MAX_STEPS)
+		{
+			*outError = "Expression has too many steps";
+			return NULL;
+		}
+
+		step = &steps[cSteps ++];
+		step->recursive = 0;
+		step->key = NULL;
+		step->cbKey = 0;
+
+		if (*path == '.')
+		{
+			path ++;
+
+			if (*path == '.')
+			{
+				step->recursive = 1;
+				path ++;
+			}
+
+			if (*path == '*')
+			{
+				step->kind = QS_ANY;
+				path ++;
+				continue;
+			}
+
+			if (*path != '[')
+			{
+				for (keyEnd = path; *keyEnd && *keyEnd != '.' && *keyEnd != '['; keyEnd ++);
+
+				if (keyEnd == path)
+				{
+					*outError = "Expected key after '.'";
+					return NULL;
+				}
+
+				step->kind = QS_KEY;
+				step->key = path;
+				step->cbKey = (size_t) (keyEnd - path);
+				path = keyEnd;
+				continue;
+			}
+
+			if (!step->recursive)
+			{
+				*outError = "Unexpected '[' after '.'";
+				return NULL;
+			}
+		}
+
+		if (*path != '[')
+		{
+			*outError = "Expected '.' or '['";
+			return NULL;
+		}
+
+		path ++;
+
+		if (path[0] == '*' && path[1] == ']')
+		{
+			step->kind = QS_ANY;
+			path += 2;
+		}
+		else
+		if (*path == '\'' || *path == '"')
+		{
+			quote = *(path++);
+
+			for (keyEnd = path; *keyEnd && *keyEnd != quote; keyEnd ++);
+
+			if (keyEnd[0] != quote || keyEnd[1] != ']')
+			{
+				*outError = "Unterminated key in brackets";
+				return NULL;
+			}
+
+			step->kind = QS_KEY;
+			step->key = path;
+			step->cbKey = (size_t) (keyEnd - path);
+			path = keyEnd + 2;
+		}
+		else
+		if ((path = parseQueryIndex(path, step)) == NULL)
+		{
+			*outError = "Invalid index or slice, negative positions are not supported";
+			return NULL;
+		}
+	}
+
+	// The keys are copied behind the steps
+	query = (struct Query *) malloc(sizeof(struct Query) + cSteps * sizeof(QueryStep) + strlen(expression));
+
+	if (query == NULL)
+	{
+		*outError = "Could not reserve memory block";
+		return NULL;
+	}
+
+	query->cSteps = cSteps;
+	keys = (char *) (query->steps + cSteps + 1);
+
+	for (index = 0; index < cSteps; index ++)
+	{
+		query->steps[index] = steps[index];
+
+		if (steps[index].key)
+		{
+			memcpy(keys, steps[index].key, steps[index].cbKey);
+			query->steps[index].key = keys;
+			keys += steps[index].cbKey;
+		}
+	}
+
+	return (UJQuery) query;
+}
+
+void UJQueryFree(UJQuery query)
+{
+	free(query);
+}
+
+static int queryEmit(struct QueryRun *run, const UJCursor *cursor, const char *end)
+{
+	UJObject obj = NULL;
+
+	if (run->ds)
+	{
+		resetHeap(run->ds);
+		obj = decodeState(run->ds, cursor->ptr, (size_t) (end - cursor->ptr));
+
+		if (obj == NULL)
+		{
+			run->error = run->ds->error;
+			return 0;
+		}
+	}
+
+	run->count ++;
+	return run->callback(run->context, obj, cursor->ptr, (size_t) (end - cursor->ptr)) == 0;
+}
+
+/*
+Runs the automaton over the value at cursor reached in states. Returns the end of the value, so that the
+parent carries on from there rather than skipping the value again, or NULL to end the query */
+static const char *queryValue(struct QueryRun *run, const UJCursor *cursor, JSUINT64 states, int depth)
+{
+	struct Query *query = run->query;
+	JSUINT64 accept = (JSUINT64) 1 << query->cSteps;
+	JSUINT64 childStates;
+	JSUINT64 pending;
+	UJCursor child;
+	UJUTF8String key;
+	UJUTF8String *keyRef;
+	const char *end = NULL;
+	long index;
+	int state;
+	int ret;
+
+	if (states & accept)
+	{
+		if ((end = JSON_SkipValue(cursor->ptr, cursor->end)) == NULL)
+		{
+			run->error = "Malformed value";
+			return NULL;
+		}
+
+		if (!queryEmit(run, cursor, end))
+		{
+			return NULL;
+		}
+	}
+
+	states &= ~accept;
+
+	if (states == 0 || (*cursor->ptr != '{' && *cursor->ptr != '['))
+	{
+		if (end == NULL && (end = JSON_SkipValue(cursor->ptr, cursor->end)) == NULL)
+		{
+			run->error = "Malformed value";
+		}
+
+		return end;
+	}
+
+	if (depth >= JSON_MAX_OBJECT_DEPTH)
+	{
+		run->error = "Reached object decoding depth limit";
+		return NULL;
+	}
+
+	keyRef = *cursor->ptr == '{' ? &key : NULL;
+	end = cursor->ptr + 1;
+
+	for (ret = UJCursorFirst(cursor, &child, keyRef), index = 0; ret == 1; ret = advanceCursor(&child, end, keyRef), index ++)
+	{
+		childStates = 0;
+
+		for (pending = states; pending; pending &= pending - 1)
+		{
+			for (state = 0; !((pending >> state) & 1); state ++);
+
+			if (query->steps[state].recursive)
+			{
+				childStates |= (JSUINT64) 1 << state;
+			}
+
+			if (queryStepMatches(&query->steps[state], keyRef, index))
+			{
+				childStates |= (JSUINT64) 1 << (state + 1);
+			}
+		}
+
+		if (childStates == 0)
+		{
+			end = JSON_SkipValue(child.ptr, child.end);
+		}
+		else
+		if ((end = queryValue(run, &child, childStates, depth + 1)) == NULL)
+		{
+			return NULL;
+		}
+	}
+
+	if (ret < 0)
+	{
+		run->error = keyRef ? "Malformed object" : "Malformed array";
+		return NULL;
+	}
+
+	// The closing bracket follows the last value, it has been checked to be there
+	return skipSpace(end, cursor->end) + 1;
+}
+
+size_t UJQuerySelect(UJQuery query, const char *input, size_t cbInput, UJDecoder decoder, UJMatchFunc callback, void *context, const char **outError)
+{
+	struct QueryRun run;
+	UJCursor cursor;
+
+	run.query = (struct Query *) query;
+	run.ds = (struct DecoderState *) decoder;
+	run.callback = callback;
+	run.context = context;
+	run.count = 0;
+	run.error = cursorDocument(input, cbInput, &cursor);
+
+	if (run.error == NULL)
+	{
+		queryValue(&run, &cursor, 1, 0);
+	}
+
+	if (outError)
+	{
+		*outError = run.error;
+	}
+
+	return run.count;
+}
@@ -1,261 +1,781 @@
-/*
-ujson4c decoder helper 1.0
-Developed by ESN, an Electronic Arts Inc. studio. 
-Copyright (c) 2013, Electronic Arts Inc.
-All rights reserved.
-
-Redistribution and use in source and binary forms, with or without
-modification, are permitted provided that the following conditions are met:
-* Redistributions of source code must retain the above copyright
-notice, this list of conditions and the following disclaimer.
-* Redistributions in binary form must reproduce the above copyright
-notice, this list of conditions and the following disclaimer in the
-documentation and/or other materials provided with the distribution.
-* Neither the name of ESN, Electronic Arts Inc. nor the
-names of its contributors may be used to endorse or promote products
-derived from this software without specific prior written permission.
-
-THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
-ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
-WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
-DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS INC. BE LIABLE 
-FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
-(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
-LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
-ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
-(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
-SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-
-Uses UltraJSON library:
-Copyright (c) 2013, Electronic Arts Inc.
-All rights reserved.
-www.github.com/esnme/ultrajson
-*/
-
-#pragma once
-
-#ifdef __cplusplus 
-extern "C" {
-#endif
-
-	enum UJTypes
-	{
-		UJT_Null,
-		UJT_True,
-		UJT_False,
-		UJT_Long,
-		UJT_LongLong,
-		UJT_Double,
-		UJT_String,
-		UJT_Array,
-		UJT_Object
-	};
-
-#include <wchar.h>
-	typedef void * UJObject;
-
-	typedef struct __UJString
-	{
-		wchar_t *ptr;
-		size_t cchLen;
-	} UJString;
-
-	typedef struct __UJHeapFuncs
-	{
-		void *initalHeap;
-		size_t cbInitialHeap;
-		void *(*malloc)(size_t cbSize);
-		void (*free)(void *ptr);
-		void *(*realloc)(void *ptr, size_t cbSize);
-	} UJHeapFuncs;
-
-	/*
-	===============================================================================
-	Decodes an input text octet stream into a JSON object structure
-
-	Arguments:
-	input - JSON data to decode in ANSI or UTF-8 format
-	cbInput - Length of input in bytes
-	hf - Heap functions, see UJHeapFuncs. Optional may be NULL
-	outState - Outputs the decoder state.
-
-	Not about heap functions:
-	Declare a UJHeapFuncs structure on the stack if you want to manage your own heap
-	and pass it as the hf argument to UJDecode.
-	initalHeap    - Pointer to a buffer for the initial heap handled by the caller. 
-	Preferably stored on the stack. MUST not be smaller than 1024 bytes
-	cbInitialHeap - Size of the initial heap in bytes
-	malloc        - Pointer to malloc function  
-	free          - Pointer to free function
-	realloc       - Pointer to realloc function  
-
-	Returns a JSON object structure representation or NULL in case of error.
-	Use UJGetError get obtain error message.
-
-	Example usage:
-
-	const char *input;
-	size_t cbInput;
-	void *state;
-
-	obj = UJDecode(input, cbInput, NULL, &state);
-
-	if (obj == NULL)
-	printf ("Error: %s\n", UJGetError(state));
-
-	...Poke around in returned obj...
-
-	UJFree(state);
-	===============================================================================
-	*/
-	UJObject UJDecode(const char *input, size_t cbInput, UJHeapFuncs *hf, void **outState);
-
-	/*
-	===============================================================================
-	Called to free the decoder state
-	===============================================================================
-	*/
-	void UJFree(void *state);
-
-	/*
-	===============================================================================
-	Check if object is of certain type 
-	===============================================================================
-	*/
-	int UJIsNull(UJObject obj);
-	int UJIsTrue(UJObject obj);
-	int UJIsFalse(UJObject obj);
-	int UJIsLong(UJObject obj);
-	int UJIsLongLong(UJObject obj);
-	int UJIsInteger(UJObject *obj);
-	int UJIsDouble(UJObject obj);
-	int UJIsString(UJObject obj);
-	int UJIsArray(UJObject obj);
-	int UJIsObject(UJObject obj);
-
-	/*
-	===============================================================================
-	See UJTypes enum for possible return values
-	===============================================================================
-	*/
-	int UJGetType(UJObject obj);
-
-	/*
-	===============================================================================
-	Called to initiate the iterator of an array object
-	May return NULL in case array is empty
-	===============================================================================
-	*/
-	void *UJBeginArray(UJObject arrObj);
-
-	/*
-	===============================================================================
-	Iterates an array object
-
-	Arguments:
-	iter   - Anonymous iterator
-	outObj - Object in array
-
-	Usage:
-	Get initial iterator from call to UJBeginArray. 
-	Call this function until it returns 0
-	===============================================================================
-	*/
-	int UJIterArray(void **iter, UJObject *outObj);
-
-	/*
-	===============================================================================
-	Called to initiate the iterator of an Object (key-value structure)
-	May return NULL in case Object is empty
-
-	===============================================================================
-	*/
-	void *UJBeginObject(UJObject objObj);
-
-	/*
-	===============================================================================
-	Iterates an Object
-
-	Arguments:
-	iter     - Anonymous iterator
-	outKey   - Key name
-	outValue - Value object
-
-	Usage:
-	Get initial iterator from call to UJBeginObject
-	Call this function until it returns 0
-	===============================================================================
-	*/
-	int UJIterObject(void **iter, UJString *outKey, UJObject *outValue);
-
-	/*
-	===============================================================================
-	Unpacks an Object by matching the key name with the requested format 
-
-	Each key name needs to be matched by the character in the format string 
-	representing the desired type of the value for that key
-	B - Boolean 
-	N - Numeric 
-	S - String
-	A - Array
-	O - Object
-	U - Unknown/any
-
-	Use lower case to accept JSON Null in place of the expected value.
-
-	Arguments:
-	objObj     - The object to unpack (JSON Object)
-	keys       - Number of keys to match. Keys can not exceed 64.
-	format     - Specified the expected types for the key value. 
-	keyNames   - An array of key names
-	...        - Output value objects (as UJObject *)
-
-	Return value:
-	Returns number of key pairs matched or -1 on error
-	===============================================================================
-	*/
-	int UJObjectUnpack(UJObject objObj, int keys, const char *format, const wchar_t **keyNames, ...);
-
-	/*
-	===============================================================================
-	Returns the value of a double, long or long long value as a double. 
-	If value is not any of these 0.0 is returned.
-	===============================================================================
-	*/
-	double UJNumericFloat(UJObject obj);
-
-	/*
-	===============================================================================
-	Returns the value of a double, long or long long value as an integer.
-	If value is not any of these types 0 is returned.
-
-	Truncation may arrise from word sizes and the presence of decimals when 
-	converting doubles to integers.
-	===============================================================================
-	*/
-	long long UJNumericLongLong(UJObject obj);
-	int UJNumericInt(UJObject obj);
-
-	
-
-	/*
-	===============================================================================
-	Returns the value of a string value as a wide character string pointer. Caller must NOT free returned pointer.
-	cchOutBuffer contains the character length of the returned string. 
-
-	If the value is not a string an empty string is returned.
-	===============================================================================
-	*/
-	const wchar_t *UJReadString(UJObject obj, size_t *cchOutBuffer);
-
-	/*
-	===============================================================================
-	Returns last error message if any as a string or NULL. 
-	Caller must NOT free returned pointer.
-	===============================================================================
-	*/
-	const char *UJGetError(void *state);
-
-#ifdef __cplusplus 
-}
-#endif
+/*
+ujson4c decoder helper 1.0
+Developed by ESN, an Electronic Arts Inc. studio. 
+Copyright (c) 2013, Electronic Arts Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of ESN, Electronic Arts Inc. nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS INC. BE LIABLE 
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Uses UltraJSON library:
+Copyright (c) 2013, Electronic Arts Inc.
+All rights reserved.
+www.github.com/esnme/ultrajson
+*/
+
+#pragma once
+
+#ifdef __cplusplus 
+extern "C" {
+#endif
+
+	enum UJTypes
+	{
+		UJT_Null,
+		UJT_True,
+		UJT_False,
+		UJT_Long,
+		UJT_LongLong,
+		UJT_Double,
+		UJT_String,
+		UJT_Array,
+		UJT_Object
+	};
+
+	/*
+	Decoding options, combined and passed as the flags argument of UJDecodeEx
+	UJF_UTF8     - Keep strings as UTF-8. Read them with UJReadStringUTF8, UJIterObjectUTF8 and UJObjectUnpackUTF8
+	UJF_ZEROCOPY - Implies UJF_UTF8. Strings without escape sequences are not copied but point into the input
+	               buffer, which must be kept alive and unmodified until UJFree is called. Such strings are
+	               not null terminated, always use the returned byte lengths
+	UJF_LAZYNUMBERS - Numbers are only classified while decoding and converted on first access. Like with
+	               UJF_ZEROCOPY the input buffer must be kept alive and unmodified until UJFree is called.
+	               The text of a number is available through UJReadNumberSpan
+	UJF_ITERATIVE - Decode with a loop and a heap allocated stack of open arrays and objects instead of
+	               recursion, using the same small amount of C stack whatever the nesting depth
+	UJF_STRUCTURAL - Decode in two stages, a SIMD scan indexing the structural characters of the whole input
+	               followed by a pass over that index which never reads whitespace. Pays off on large and
+	               pretty printed documents. Costs up to 4 bytes of temporary memory per input byte and
+	               uses as little C stack as UJF_ITERATIVE
+	UJF_PARALLEL - Decode a large top-level array on several threads. The elements are split into one slice
+	               per processor at commas that look like element boundaries, each slice is decoded into
+	               its own arena and the slices are joined into one array. A wrong guess makes its slice fail,
+	               which is then decoded on the calling thread, so results and errors match a serial decode.
+	               Ignored for documents under 2 MB, other top-level values and UJDecodeInSitu
+	UJF_TAPE     - Implies UJF_UTF8. Decode into one flat array of 64-bit words in document order instead
+	               of a tree of nodes, which is smaller and faster to build and walk. Arrays and objects
+	               know where they end, so skipping one is a single step, but UJArrayGet and UJObjectGet
+	               search them linearly. UJF_ZEROCOPY, UJF_LAZYNUMBERS and UJF_PARALLEL are ignored,
+	               UJDecodePaths ignores the flag altogether
+	UJF_INTERNKEYS - Equal object keys share one string, kept by the decoder state rather than the document.
+	               A UJDecoder keeps its keys from one document to the next until UJDecoderRelease, up to
+	               16384 distinct keys. UJObjectUnpack and UJObjectUnpackUTF8 then match keys by identity.
+	               Ignored with UJF_TAPE, and by the threads of UJF_PARALLEL other than the calling one
+	*/
+	enum UJFlags
+	{
+		UJF_UTF8 = 0x0001,
+		UJF_ZEROCOPY = 0x0002,
+		UJF_LAZYNUMBERS = 0x0004,
+		UJF_ITERATIVE = 0x0008,
+		UJF_STRUCTURAL = 0x0010,
+		UJF_PARALLEL = 0x0020,
+		UJF_TAPE = 0x0040,
+		UJF_INTERNKEYS = 0x0080
+	};
+
+#include <wchar.h>
+	typedef void * UJObject;
+	typedef void * UJDecoder;
+	typedef void * UJStream;
+
+	/*
+	Called by UJDecoderDecodeLines for each record. obj is NULL if the record is
+	malformed, UJGetError with the decoder as state tells why. obj is freed when 
+	the next record is decoded. Return 0 to continue or anything else to stop */
+	typedef int (*UJLineFunc)(void *context, UJObject obj, const char *line, size_t cbLine);
+
+	/*
+	Called by UJDecodeLinesParallel for each record, possibly from several threads
+	at once. obj is NULL if the record is malformed and error then tells why. obj
+	is freed when the callback returns. Return 0 to continue or anything else to
+	stop */
+	typedef int (*UJRecordFunc)(void *context, UJObject obj, const char *error, const char *line, size_t cbLine);
+
+	typedef struct __UJString
+	{
+		wchar_t *ptr;
+		size_t cchLen;
+	} UJString;
+
+	typedef struct __UJUTF8String
+	{
+		const char *ptr;
+		size_t cbLen;
+	} UJUTF8String;
+
+	typedef struct __UJHeapFuncs
+	{
+		void *initalHeap;
+		size_t cbInitialHeap;
+		void *(*malloc)(size_t cbSize);
+		void (*free)(void *ptr);
+		void *(*realloc)(void *ptr, size_t cbSize);
+	} UJHeapFuncs;
+
+	/*
+	===============================================================================
+	Decodes an input text octet stream into a JSON object structure
+
+	Arguments:
+	input - JSON data to decode in ANSI or UTF-8 format
+	cbInput - Length of input in bytes
+	hf - Heap functions, see UJHeapFuncs. Optional may be NULL
+	outState - Outputs the decoder state.
+
+	Not about heap functions:
+	Declare a UJHeapFuncs structure on the stack if you want to manage your own heap
+	and pass it as the hf argument to UJDecode.
+	initalHeap    - Pointer to a buffer for the initial heap handled by the caller. 
+	Preferably stored on the stack. MUST not be smaller than 1024 bytes
+	cbInitialHeap - Size of the initial heap in bytes
+	malloc        - Pointer to malloc function  
+	free          - Pointer to free function
+	realloc       - Pointer to realloc function  
+
+	Returns a JSON object structure representation or NULL in case of error.
+	Use UJGetError get obtain error message.
+
+	Example usage:
+
+	const char *input;
+	size_t cbInput;
+	void *state;
+
+	obj = UJDecode(input, cbInput, NULL, &state);
+
+	if (obj == NULL)
+	printf ("Error: %s\n", UJGetError(state));
+
+	...Poke around in returned obj...
+
+	UJFree(state);
+	===============================================================================
+	*/
+	UJObject UJDecode(const char *input, size_t cbInput, UJHeapFuncs *hf, void **outState);
+
+	/*
+	===============================================================================
+	Same as UJDecode but takes a combination of UJFlags controlling how the 
+	document is decoded and stored
+	===============================================================================
+	*/
+	UJObject UJDecodeEx(const char *input, size_t cbInput, UJHeapFuncs *hf, int flags, void **outState);
+
+	/*
+	===============================================================================
+	Destructive variant of UJDecodeEx for buffers the caller is going to throw
+	away after decoding. Implies UJF_ZEROCOPY. 
+	
+	Strings are unescaped in place inside buffer and every returned string points
+	into it, no string data is copied to the decoder heap and no unescape scratch 
+	buffer is used. Strings are null terminated.
+	The contents of buffer are destroyed and it must be kept alive until UJFree 
+	is called.
+	===============================================================================
+	*/
+	UJObject UJDecodeInSitu(char *buffer, size_t cbBuffer, UJHeapFuncs *hf, int flags, void **outState);
+
+	/*
+	===============================================================================
+	Called to free the decoder state
+	===============================================================================
+	*/
+	void UJFree(void *state);
+
+	/*
+	===============================================================================
+	Check if object is of certain type 
+	===============================================================================
+	*/
+	int UJIsNull(UJObject obj);
+	int UJIsTrue(UJObject obj);
+	int UJIsFalse(UJObject obj);
+	int UJIsLong(UJObject obj);
+	int UJIsLongLong(UJObject obj);
+	int UJIsInteger(UJObject *obj);
+	int UJIsDouble(UJObject obj);
+	int UJIsString(UJObject obj);
+	int UJIsArray(UJObject obj);
+	int UJIsObject(UJObject obj);
+
+	/*
+	===============================================================================
+	See UJTypes enum for possible return values
+	===============================================================================
+	*/
+	int UJGetType(UJObject obj);
+
+	/*
+	===============================================================================
+	Called to initiate the iterator of an array object
+	May return NULL in case array is empty
+	===============================================================================
+	*/
+	void *UJBeginArray(UJObject arrObj);
+
+	/*
+	===============================================================================
+	Iterates an array object
+
+	Arguments:
+	iter   - Anonymous iterator
+	outObj - Object in array
+
+	Usage:
+	Get initial iterator from call to UJBeginArray. 
+	Call this function until it returns 0
+	===============================================================================
+	*/
+	int UJIterArray(void **iter, UJObject *outObj);
+
+	/*
+	===============================================================================
+	Returns the number of elements of an array object, or 0 if arrObj is not an
+	array. Elements are stored contiguously, this takes constant time
+	===============================================================================
+	*/
+	size_t UJArraySize(UJObject arrObj);
+
+	/*
+	===============================================================================
+	Returns the element at index of an array object in constant time, or NULL if
+	index is out of range or arrObj is not an array
+	===============================================================================
+	*/
+	UJObject UJArrayGet(UJObject arrObj, size_t index);
+
+	/*
+	===============================================================================
+	Called to initiate the iterator of an Object (key-value structure)
+	May return NULL in case Object is empty
+
+	===============================================================================
+	*/
+	void *UJBeginObject(UJObject objObj);
+
+	/*
+	===============================================================================
+	Iterates an Object
+
+	Arguments:
+	iter     - Anonymous iterator
+	outKey   - Key name
+	outValue - Value object
+
+	Usage:
+	Get initial iterator from call to UJBeginObject
+	Call this function until it returns 0
+	===============================================================================
+	*/
+	int UJIterObject(void **iter, UJString *outKey, UJObject *outValue);
+
+	/*
+	===============================================================================
+	Same as UJIterObject but outputs the key name as UTF-8. 
+	Use for documents decoded with UJF_UTF8
+	===============================================================================
+	*/
+	int UJIterObjectUTF8(void **iter, UJUTF8String *outKey, UJObject *outValue);
+
+	/*
+	===============================================================================
+	Unpacks an Object by matching the key name with the requested format 
+
+	Each key name needs to be matched by the character in the format string 
+	representing the desired type of the value for that key
+	B - Boolean 
+	N - Numeric 
+	S - String
+	A - Array
+	O - Object
+	U - Unknown/any
+
+	Use lower case to accept JSON Null in place of the expected value.
+
+	Arguments:
+	objObj     - The object to unpack (JSON Object)
+	keys       - Number of keys to match. Keys can not exceed 64.
+	format     - Specified the expected types for the key value. 
+	keyNames   - An array of key names
+	...        - Output value objects (as UJObject *)
+
+	Return value:
+	Returns number of key pairs matched or -1 on error
+	===============================================================================
+	*/
+	int UJObjectUnpack(UJObject objObj, int keys, const char *format, const wchar_t **keyNames, ...);
+
+	/*
+	===============================================================================
+	Same as UJObjectUnpack but with key names given as null terminated UTF-8. 
+	Both variants match keys of documents decoded with and without UJF_UTF8
+	===============================================================================
+	*/
+	int UJObjectUnpackUTF8(UJObject objObj, int keys, const char *format, const char **keyNames, ...);
+
+	typedef void * UJKeySet;
+
+	/*
+	===============================================================================
+	Compiles key names given as null terminated UTF-8 and their format, as for
+	UJObjectUnpack, into a key set for UJObjectUnpackSet. The keys are hashed
+	once here, so that unpacking looks up each key of the object in a single
+	probe. Up to 262144 keys are supported.
+
+	Returns NULL if format is shorter than keys, if a key name is given twice,
+	also when spelled with different bytes that decode to the same characters,
+	if there are too many keys or if out of memory. Release the key set with UJKeySetFree
+	===============================================================================
+	*/
+	UJKeySet UJKeySetCompile(const char **keyNames, int keys, const char *format);
+
+	/*
+	===============================================================================
+	Unpacks an Object like UJObjectUnpack in a single pass over its keys,
+	filling outValues, which holds one entry per key of the set, in the order
+	the key names were given. Keys that are missing or don't match the format
+	are set to NULL. Matches keys of documents decoded with and without UJF_UTF8
+
+	Returns number of key pairs matched
+	===============================================================================
+	*/
+	int UJObjectUnpackSet(UJObject objObj, UJKeySet keySet, UJObject *outValues);
+
+	/*
+	===============================================================================
+	Releases a compiled key set
+	===============================================================================
+	*/
+	void UJKeySetFree(UJKeySet keySet);
+
+	/*
+	===============================================================================
+	Looks up the value of a key, given as UTF-8 of cbKey bytes, in an Object.
+	Matches keys of documents decoded with and without UJF_UTF8, and finds the
+	first of equal keys.
+
+	Small objects are searched member by member. On the first lookup in an
+	object of more than 16 members a hash index of its keys is built in the
+	memory of the document, later lookups take constant time. Building it
+	changes the object and allocates from the document, so UJObjectGet must
+	not be called on the same document from several threads at once.
+
+	Returns the value or NULL if the key is missing or objObj is not an Object
+	===============================================================================
+	*/
+	UJObject UJObjectGet(UJObject objObj, const char *key, size_t cbKey);
+
+	/*
+	===============================================================================
+	Returns the value of a double, long or long long value as a double. 
+	If value is not any of these 0.0 is returned.
+	===============================================================================
+	*/
+	double UJNumericFloat(UJObject obj);
+
+	/*
+	===============================================================================
+	Returns the value of a double, long or long long value as an integer.
+	If value is not any of these types 0 is returned.
+
+	Truncation may arrise from word sizes and the presence of decimals when 
+	converting doubles to integers.
+	===============================================================================
+	*/
+	long long UJNumericLongLong(UJObject obj);
+	int UJNumericInt(UJObject obj);
+
+	
+
+	/*
+	===============================================================================
+	Returns the value of a string value as a wide character string pointer. Caller must NOT free returned pointer.
+	cchOutBuffer contains the character length of the returned string. 
+
+	If the value is not a string an empty string is returned.
+	===============================================================================
+	*/
+	const wchar_t *UJReadString(UJObject obj, size_t *cchOutBuffer);
+
+	/*
+	===============================================================================
+	Returns the value of a string value as a null terminated UTF-8 string pointer. 
+	Caller must NOT free returned pointer.
+	cbOutBuffer contains the byte length of the returned string. 
+	In documents decoded with UJF_ZEROCOPY the string is not null terminated,
+	unless it was decoded by UJDecodeInSitu.
+
+	Strings are only available as UTF-8 in documents decoded with UJF_UTF8 and only
+	as wide characters otherwise. If the value is not a string of the requested 
+	kind an empty string is returned.
+	===============================================================================
+	*/
+	const char *UJReadStringUTF8(UJObject obj, size_t *cbOutBuffer);
+
+	/*
+	===============================================================================
+	Outputs a string value of a document decoded with UJF_UTF8 or UJF_ZEROCOPY as 
+	a pointer and byte length pair without any termination guarantee. The view
+	points into the input buffer unless the string contained escape sequences.
+
+	Returns 1 if obj is such a string or 0 otherwise
+	===============================================================================
+	*/
+	int UJReadStringView(UJObject obj, UJUTF8String *outView);
+
+	/*
+	===============================================================================
+	Outputs the text of a number as it appeared in the input of a document decoded
+	with UJF_LAZYNUMBERS, for passing the number through exactly. 
+
+	Returns 1 if obj is such a number or 0 otherwise
+	===============================================================================
+	*/
+	int UJReadNumberSpan(UJObject obj, UJUTF8String *outSpan);
+
+	/*
+	===============================================================================
+	Creates a decoder for decoding any number of documents one after another, 
+	taking the same hf and flags arguments as UJDecodeEx.
+
+	The decoder keeps its heap slabs and string scratch buffer between documents
+	and reserves no large buffer on the stack. Once it has seen its largest 
+	document it decodes without calling malloc or free.
+
+	Returns NULL if the initial heap is too small
+	===============================================================================
+	*/
+	UJDecoder UJDecoderCreate(UJHeapFuncs *hf, int flags);
+
+	/*
+	===============================================================================
+	Decodes a document with a decoder from UJDecoderCreate. The document returned
+	by the previous call on the same decoder is freed and must no longer be used.
+	On error use UJGetError with the decoder as state.
+	===============================================================================
+	*/
+	UJObject UJDecoderDecode(UJDecoder decoder, const char *input, size_t cbInput);
+
+	/*
+	===============================================================================
+	Decodes newline delimited JSON (JSON Lines), one document per line, with a
+	decoder from UJDecoderCreate. callback is called with each decoded document 
+	in order. The arena is reset between records instead of being freed, so a 
+	warmed up decoder decodes a batch without calling malloc.
+
+	Malformed records are reported to callback with a NULL document and skipped,
+	decoding continues with the next line. Blank lines are skipped silently.
+
+	Returns the number of records passed to callback
+	===============================================================================
+	*/
+	size_t UJDecoderDecodeLines(UJDecoder decoder, const char *input, size_t cbInput, UJLineFunc callback, void *context);
+
+	/*
+	===============================================================================
+	Decodes newline delimited JSON like UJDecoderDecodeLines, spread over threads. 
+	The input is split into chunks at newlines. threads, or one per CPU if 0,
+	take chunks as they go until the input is used up, each thread with its own
+	decoder. The calling thread is one of them.
+
+	If ordered is 0, callback is called from any thread as soon as a record is 
+	decoded and must be thread safe. Otherwise callback is called for one record
+	at a time in input order; a thread holds a decoded chunk until all earlier
+	chunks are delivered. After callback asks to stop, records decoded 
+	concurrently by other threads may still be delivered when unordered.
+
+	Returns the number of records passed to callback
+	===============================================================================
+	*/
+	size_t UJDecodeLinesParallel(const char *input, size_t cbInput, int flags, int threads, int ordered, UJRecordFunc callback, void *context);
+
+	/*
+	===============================================================================
+	Sets the max nesting depth of arrays and objects for documents decoded by
+	decoder, 0 restores the default of JSON_MAX_OBJECT_DEPTH. Deeper documents 
+	fail to decode. Only raise it for decoders created with UJF_ITERATIVE, the 
+	recursive decoder uses C stack for every level.
+	===============================================================================
+	*/
+	void UJDecoderSetMaxDepth(UJDecoder decoder, int maxDepth);
+
+	/*
+	===============================================================================
+	Sets the number of threads a decoder created with UJF_PARALLEL splits a large
+	array over, 0 restores the default of one per processor. Fewer are used for
+	arrays too small to give each thread a slice of at least 1 MB.
+	===============================================================================
+	*/
+	void UJDecoderSetThreads(UJDecoder decoder, int threads);
+
+	/*
+	===============================================================================
+	Frees a decoder and the last document decoded with it. Use instead of UJFree
+	===============================================================================
+	*/
+	void UJDecoderRelease(UJDecoder decoder);
+
+	/*
+	===============================================================================
+	Creates a stream for decoding a document that arrives in chunks, such as the 
+	body of a network request, taking the same hf and flags arguments as 
+	UJDecodeEx. Decoding overlaps with receiving and the full document is never
+	buffered. UJF_ZEROCOPY is treated as UJF_UTF8 and UJF_LAZYNUMBERS is ignored
+	since chunks don't have to be kept alive.
+
+	Returns NULL if the initial heap is too small or memory runs out
+	===============================================================================
+	*/
+	UJStream UJStreamCreate(UJHeapFuncs *hf, int flags);
+
+	/*
+	===============================================================================
+	Decodes the next chunk of a document. Chunks may be split anywhere, also 
+	within strings and numbers, and can be reused once the call returns.
+
+	Returns 1 once the document is complete, 0 if more chunks are needed and -1 
+	on error, use UJGetError with the stream as state then
+	===============================================================================
+	*/
+	int UJStreamFeed(UJStream stream, const char *chunk, size_t cbChunk);
+
+	/*
+	===============================================================================
+	Ends the input of a stream and returns the decoded document, or NULL if the
+	input was invalid or incomplete. A number at the very end of the input is 
+	only decoded here. The stream then acts like the state returned by UJDecode,
+	use it with UJGetError and release it with UJFree.
+	===============================================================================
+	*/
+	UJObject UJStreamFinish(UJStream stream);
+
+	/*
+	===============================================================================
+	Handlers called by UJDecodeEvents in document order. Any of them may be NULL
+	to ignore that kind of event. Keys and strings are UTF-8 and not null 
+	terminated, the range is only valid during the call. Numbers are passed to 
+	integer if they have no fraction or exponent, otherwise to real.
+	Return 0 to continue or anything else to stop decoding.
+	===============================================================================
+	*/
+	typedef struct __UJEventHandlers
+	{
+		int (*beginObject)(void *context);
+		int (*endObject)(void *context);
+		int (*beginArray)(void *context);
+		int (*endArray)(void *context);
+		int (*key)(void *context, const char *key, size_t cbKey);
+		int (*string)(void *context, const char *value, size_t cbValue);
+		int (*integer)(void *context, long long value);
+		int (*real)(void *context, double value);
+		int (*boolean)(void *context, int value);
+		int (*null)(void *context);
+	} UJEventHandlers;
+
+	/*
+	===============================================================================
+	Decodes a document without building it, reporting each array and object as 
+	it begins and ends and each key and value to handlers instead. Nothing is 
+	allocated for keys, strings or numbers, so documents of any size are walked
+	in constant memory. Nesting is not limited by the C stack. 
+
+	Handlers see everything up to an error, the document is not validated ahead
+	of them. Returns 1 if the whole document was decoded, 0 if a handler stopped
+	decoding and -1 on error. outError may be NULL, otherwise it is set to the 
+	error message or NULL. The message must not be freed.
+	===============================================================================
+	*/
+	int UJDecodeEvents(const char *input, size_t cbInput, const UJEventHandlers *handlers, void *context, const char **outError);
+
+	/*
+	===============================================================================
+	On-demand access to a document without decoding it. A cursor points at a 
+	value in the input and is moved into it or on to the value after it. Every
+	value stepped over, however large, is skipped by matching brackets and 
+	quotes without building anything. The input is only checked as far as it 
+	is read and must be kept alive while cursors into it are used.
+
+	Keys are returned as they appear between the quotes, escapes not resolved.
+	The members of UJCursor are private.
+	===============================================================================
+	*/
+	typedef struct __UJCursor
+	{
+		const char *ptr;
+		const char *end;
+		int inObject;
+	} UJCursor;
+
+	/*
+	===============================================================================
+	Points outCursor at the root value of the input.
+	Returns 1 on success or 0 if the input holds only whitespace
+	===============================================================================
+	*/
+	int UJCursorRoot(const char *input, size_t cbInput, UJCursor *outCursor);
+
+	/*
+	===============================================================================
+	Returns the type of the value at cursor as one of UJTypes, or -1 if there 
+	is no valid value. Numbers are read to tell their type
+	===============================================================================
+	*/
+	int UJCursorType(const UJCursor *cursor);
+
+	/*
+	===============================================================================
+	Points outChild at the first element of the array or the value of the first
+	member of the object at cursor. outKey, if not NULL, receives its key.
+	Returns 1 on success, 0 if the container is empty and -1 if cursor is not at
+	an array or object or the input is malformed
+	===============================================================================
+	*/
+	int UJCursorFirst(const UJCursor *cursor, UJCursor *outChild, UJUTF8String *outKey);
+
+	/*
+	===============================================================================
+	Moves a cursor from UJCursorFirst over its value to the next element or 
+	member, skipping the value without decoding it. outKey, if not NULL, 
+	receives the key of the member. Returns 1 on success, 0 at the end of the
+	container and -1 if the input is malformed
+	===============================================================================
+	*/
+	int UJCursorNext(UJCursor *cursor, UJUTF8String *outKey);
+
+	/*
+	===============================================================================
+	Points outValue at the value of the first member of the object at cursor 
+	whose key is the UTF-8 string key. Members before it are skipped. Returns 1
+	if found, 0 if not and -1 if cursor is not at an object or the input is 
+	malformed
+	===============================================================================
+	*/
+	int UJCursorFind(const UJCursor *cursor, const char *key, size_t cbKey, UJCursor *outValue);
+
+	/*
+	===============================================================================
+	Read the number at cursor. UJCursorReadLongLong only accepts integers, 
+	UJCursorReadDouble any number. Return 1 on success and 0 if the value is not
+	a number of that kind
+	===============================================================================
+	*/
+	int UJCursorReadLongLong(const UJCursor *cursor, long long *outValue);
+	int UJCursorReadDouble(const UJCursor *cursor, double *outValue);
+
+	/*
+	===============================================================================
+	Reads the string at cursor as UTF-8. A string without escape sequences is 
+	returned as a range of the input, otherwise it is unescaped into buffer, 
+	which never needs more bytes than the string takes up in the input. Neither
+	is null terminated. Returns 1 on success and 0 if the value is not a valid
+	string or buffer is too small
+	===============================================================================
+	*/
+	int UJCursorReadString(const UJCursor *cursor, char *buffer, size_t cbBuffer, UJUTF8String *outString);
+
+	/*
+	===============================================================================
+	Decodes the value at cursor with UJDecodeEx, for subtrees that are needed in
+	full. Release outState with UJFree
+	===============================================================================
+	*/
+	UJObject UJCursorDecode(const UJCursor *cursor, UJHeapFuncs *hf, int flags, void **outState);
+
+	/*
+	===============================================================================
+	Decodes only the parts of a document on the given key paths, like UJDecodeEx
+	otherwise. A path names object members by key, separated by dots, and array
+	elements by index or all of them with [*], like "address.city", 
+	"items[*].id" or "[0].name". Keys can not contain '.' or '['.
+
+	The value at the end of a path is decoded in full. Arrays and objects on the
+	way to it only hold the members and elements that some path continues into,
+	in document order, so the elements of a partially selected array are 
+	renumbered. A path that continues past a scalar, into an array by key or
+	into an object by index selects nothing there. Everything else is skipped
+	without being decoded or validated.
+	Keys are compared as UTF-8 with escapes resolved.
+
+	Returns the root, holding nothing if no path matched, or NULL on error
+	===============================================================================
+	*/
+	UJObject UJDecodePaths(const char *input, size_t cbInput, UJHeapFuncs *hf, int flags, const char **paths, int cPaths, void **outState);
+
+	typedef void * UJQuery;
+
+	/*
+	Called by UJQuerySelect for each match with the value as a range of the
+	input. obj is the decoded value if a decoder was given and NULL otherwise, it
+	is freed when the next match is decoded. Return 0 to continue or anything
+	else to stop */
+	typedef int (*UJMatchFunc)(void *context, UJObject obj, const char *value, size_t cbValue);
+
+	/*
+	===============================================================================
+	Compiles a JSONPath expression for UJQuerySelect. Supported are the root $,
+	child keys as .key or ['key'], wildcards .* and [*], array indices [n],
+	slices [start:end:step] with any part left out, and recursive descent ..
+	before a key, wildcard or bracket, like "$.store..price" or "$..items[1:]".
+	Negative indices and filters are not supported, as the length of an array
+	is not known when its elements are passed. At most 63 steps.
+
+	Returns NULL and sets outError if the expression is invalid. Release the
+	query with UJQueryFree
+	===============================================================================
+	*/
+	UJQuery UJQueryCompile(const char *expression, const char **outError);
+
+	/*
+	===============================================================================
+	Runs a query over a document in one pass, passing every matched value to
+	callback in document order. A value matched by several paths is passed once,
+	a value inside another match is passed after it. Subtrees no path can match
+	in are skipped without being decoded or validated.
+
+	If decoder is not NULL each match is also decoded with it, a malformed match
+	ends the query with the decoder's error.
+
+	Returns the number of matches passed to callback. outError, if not NULL, is
+	set to the error that ended the query early or NULL
+	===============================================================================
+	*/
+	size_t UJQuerySelect(UJQuery query, const char *input, size_t cbInput, UJDecoder decoder, UJMatchFunc callback, void *context, const char **outError);
+
+	/*
+	===============================================================================
+	Releases a compiled query
+	===============================================================================
+	*/
+	void UJQueryFree(UJQuery query);
+
+	/*
+	===============================================================================
+	Returns last error message if any as a string or NULL. 
+	Caller must NOT free returned pointer.
+	===============================================================================
+	*/
+	const char *UJGetError(void *state);
+
+#ifdef __cplusplus 
+}
+#endif
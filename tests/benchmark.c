@@ -1,225 +1,960 @@
-/*
-ujson4c decoder helper 1.0
-Developed by ESN, an Electronic Arts Inc. studio. 
-Copyright (c) 2013, Electronic Arts Inc.
-All rights reserved.
-
-Redistribution and use in source and binary forms, with or without
-modification, are permitted provided that the following conditions are met:
-* Redistributions of source code must retain the above copyright
-notice, this list of conditions and the following disclaimer.
-* Redistributions in binary form must reproduce the above copyright
-notice, this list of conditions and the following disclaimer in the
-documentation and/or other materials provided with the distribution.
-* Neither the name of ESN, Electronic Arts Inc. nor the
-names of its contributors may be used to endorse or promote products
-derived from this software without specific prior written permission.
-
-THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
-ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
-WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
-DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS INC. BE LIABLE 
-FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
-(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
-LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
-ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
-(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
-SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-
-Uses UltraJSON library:
-Copyright (c) 2013, Electronic Arts Inc.
-All rights reserved.
-www.github.com/esnme/ultrajson
-*/
-
-#include <stdio.h>
-#include "ujdecode.h"
-#include <stdlib.h>
-#include <stdio.h>
-#include <time.h>
-#include <string.h>
-
-void prefixLine(int level)
-{
-	int index;
-	for (index = 0; index < level; index ++)
-	{
-		fputc(' ', stdout);
-		fputc(' ', stdout);
-	}
-}
-
-
-void dumpObject(int level, void *state, UJObject obj)
-{
-	switch (UJGetType(obj))
-	{
-	case UJT_Null:
-		{
-#ifdef VERBOSE_DUMP
-			prefixLine(level);
-			fprintf (stdout, "NULL\n");
-#endif
-			break;
-		}
-	case UJT_True:
-		{
-#ifdef VERBOSE_DUMP
-			prefixLine(level);
-			fprintf (stdout, "True\n");
-#endif
-			break;
-		}
-	case UJT_False:
-		{
-#ifdef VERBOSE_DUMP
-			prefixLine(level);
-			fprintf (stdout, "False\n");
-#endif
-			break;
-		}
-	case UJT_Long:
-		{
-			long value = (long) UJNumericLongLong(obj);
-
-#ifdef VERBOSE_DUMP
-			prefixLine(level);
-			fprintf (stdout, "%ld\n", value);
-#endif
-			break;
-		}
-	case UJT_LongLong:
-		{
-			long long value = UJNumericLongLong(obj);
-
-#ifdef VERBOSE_DUMP
-			prefixLine(level);
-			fprintf (stdout, "%lld\n", value);
-#endif
-			break;
-		}
-	case UJT_Double:
-		{
-			double value = UJNumericFloat(obj);
-
-#ifdef VERBOSE_DUMP
-			prefixLine(level);
-			fprintf (stdout, "%f\n", value);
-#endif
-			break;
-		}
-	case UJT_String:
-		{
-			size_t len;
-			const wchar_t *value;
-			value = UJReadString(obj, &len);
-
-#ifdef VERBOSE_DUMP
-			fwprintf (stdout, L"%s\n", value);
-#endif
-			break;
-		}
-	case UJT_Array:
-		{
-			void *iter = NULL;
-			UJObject objiter = NULL;
-
-#ifdef VERBOSE_DUMP
-			fputc('[', stdout);
-#endif
-
-			iter = UJBeginArray(obj);
-
-			while(UJIterArray(&iter, &objiter))
-			{
-				dumpObject(level + 1, state, objiter);
-			}
-
-#ifdef VERBOSE_DUMP
-			fputc(']', stdout);
-#endif
-
-			break;
-		}
-	case UJT_Object:
-		{
-			void *iter = NULL;
-			UJObject objiter = NULL;
-			UJString key;
-
-#ifdef VERBOSE_DUMP
-			prefixLine(level);
-			fputc('{', stdout);
-#endif
-
-			iter = UJBeginObject(obj);
-
-			while(UJIterObject(&iter, &key, &objiter))
-			{
-#ifdef VERBOSE_DUMP
-				fwprintf (stdout, L"%s: ", key.ptr);
-#endif
-				dumpObject(level + 1, state, objiter);
-			}
-
-#ifdef VERBOSE_DUMP
-			fputc('}', stdout);
-#endif
-			break;
-		}
-	}
-
-}
-
-#ifdef __BENCHMARK__
-int main ()
-{
-	const char *input;
-	size_t cbInput;
-	void *state;
-	FILE *file;
-	char buffer[32768];
-	time_t tsNow;
-	int count;
-	size_t bytesDecoded;
-
-	UJHeapFuncs hf;
-	hf.cbInitialHeap = sizeof(buffer);
-	hf.initalHeap = buffer;
-	hf.free = free;
-	hf.malloc = malloc;
-	hf.realloc = realloc;
-
-	file = fopen("./sample.json", "rb");
-	input = (char *) malloc(1024 * 1024);
-	cbInput = fread ( (void *) input, 1, 1024 * 1024, file);
-	fclose(file);
-	
-	tsNow = time(0);
-	count = 0;
-	bytesDecoded = 0;
-
-	for (;;)
-	{
-		UJObject obj;
-
-		obj = UJDecode(input, cbInput, &hf, &state);
-		dumpObject(0, state, obj);
-
-		UJFree(state);
-
-		count ++;
-		bytesDecoded += cbInput;
-
-		if (tsNow != time(0))
-		{
-			float bps = (float) bytesDecoded;
-			fprintf (stderr, "Count %d, MBps: %f\n", count, bps / 1000000.0f);
-			
-			count = 0;
-			bytesDecoded = 0;
-			tsNow = time(0);
-		}
-	}
-}
+/*
+ujson4c decoder helper 1.0
+Developed by ESN, an Electronic Arts Inc. studio. 
+Copyright (c) 2013, Electronic Arts Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of ESN, Electronic Arts Inc. nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS INC. BE LIABLE 
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Uses UltraJSON library:
+Copyright (c) 2013, Electronic Arts Inc.
+All rights reserved.
+www.github.com/esnme/ultrajson
+*/
+
+#include <stdio.h>
+#include "ujdecode.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <string.h>
+
+void prefixLine(int level)
+{
+	int index;
+	for (index = 0; index < level; index ++)
+	{
+		fputc(' ', stdout);
+		fputc(' ', stdout);
+	}
+}
+
+
+void dumpObject(int level, void *state, UJObject obj)
+{
+	switch (UJGetType(obj))
+	{
+	case UJT_Null:
+		{
+#ifdef VERBOSE_DUMP
+			prefixLine(level);
+			fprintf (stdout, "NULL\n");
+#endif
+			break;
+		}
+	case UJT_True:
+		{
+#ifdef VERBOSE_DUMP
+			prefixLine(level);
+			fprintf (stdout, "True\n");
+#endif
+			break;
+		}
+	case UJT_False:
+		{
+#ifdef VERBOSE_DUMP
+			prefixLine(level);
+			fprintf (stdout, "False\n");
+#endif
+			break;
+		}
+	case UJT_Long:
+		{
+			long value = (long) UJNumericLongLong(obj);
+
+#ifdef VERBOSE_DUMP
+			prefixLine(level);
+			fprintf (stdout, "%ld\n", value);
+#endif
+			break;
+		}
+	case UJT_LongLong:
+		{
+			long long value = UJNumericLongLong(obj);
+
+#ifdef VERBOSE_DUMP
+			prefixLine(level);
+			fprintf (stdout, "%lld\n", value);
+#endif
+			break;
+		}
+	case UJT_Double:
+		{
+			double value = UJNumericFloat(obj);
+
+#ifdef VERBOSE_DUMP
+			prefixLine(level);
+			fprintf (stdout, "%f\n", value);
+#endif
+			break;
+		}
+	case UJT_String:
+		{
+			size_t len;
+			const wchar_t *value;
+			value = UJReadString(obj, &len);
+
+#ifdef VERBOSE_DUMP
+			fwprintf (stdout, L"%s\n", value);
+#endif
+			break;
+		}
+	case UJT_Array:
+		{
+			void *iter = NULL;
+			UJObject objiter = NULL;
+
+#ifdef VERBOSE_DUMP
+			fputc('[', stdout);
+#endif
+
+			iter = UJBeginArray(obj);
+
+			while(UJIterArray(&iter, &objiter))
+			{
+				dumpObject(level + 1, state, objiter);
+			}
+
+#ifdef VERBOSE_DUMP
+			fputc(']', stdout);
+#endif
+
+			break;
+		}
+	case UJT_Object:
+		{
+			void *iter = NULL;
+			UJObject objiter = NULL;
+			UJString key;
+
+#ifdef VERBOSE_DUMP
+			prefixLine(level);
+			fputc('{', stdout);
+#endif
+
+			iter = UJBeginObject(obj);
+
+			while(UJIterObject(&iter, &key, &objiter))
+			{
+#ifdef VERBOSE_DUMP
+				fwprintf (stdout, L"%s: ", key.ptr);
+#endif
+				dumpObject(level + 1, state, objiter);
+			}
+
+#ifdef VERBOSE_DUMP
+			fputc('}', stdout);
+#endif
+			break;
+		}
+	}
+
+}
+
+#ifdef __BENCHMARK__
+
+#ifndef BENCHMARK_SECONDS
+#define BENCHMARK_SECONDS 5
+#endif
+
+/*
+Strips all whitespace outside of strings, producing the minified form of the same document */
+size_t minifyInput(char *dst, const char *src, size_t cbSrc)
+{
+	const char *end = src + cbSrc;
+	char *offset = dst;
+	int inString = 0;
+
+	while (src < end)
+	{
+		char chr = *(src++);
+
+		if (inString)
+		{
+			*(offset++) = chr;
+
+			if (chr == '\\' && src < end)
+			{
+				*(offset++) = *(src++);
+			}
+			else
+			if (chr == '\"')
+			{
+				inString = 0;
+			}
+			continue;
+		}
+
+		switch (chr)
+		{
+		case ' ':
+		case '\t':
+		case '\r':
+		case '\n':
+			break;
+
+		case '\"':
+			inString = 1;
+		default:
+			*(offset++) = chr;
+			break;
+		}
+	}
+
+	*offset = '\0';
+	return (size_t) (offset - dst);
+}
+
+/*
+Decodes and walks the input for BENCHMARK_SECONDS and returns the number of documents decoded per second.
+Uses decoder if not NULL, otherwise a fresh state per document */
+float benchmarkInput(const char *name, const char *input, size_t cbInput, UJHeapFuncs *hf, UJDecoder decoder)
+{
+	void *state;
+	time_t tsNow;
+	int seconds = 0;
+	int count = 0;
+	int total = 0;
+	size_t bytesDecoded = 0;
+
+	tsNow = time(0);
+
+	// Synchronize with the start of a second
+	while (tsNow == time(0));
+	tsNow = time(0);
+
+	while (seconds < BENCHMARK_SECONDS)
+	{
+		UJObject obj;
+
+		if (decoder)
+		{
+			state = decoder;
+			obj = UJDecoderDecode(decoder, input, cbInput);
+		}
+		else
+		{
+			obj = UJDecode(input, cbInput, hf, &state);
+		}
+
+		if (obj == NULL)
+		{
+			fprintf (stderr, "%s: %s\n", name, UJGetError(state));
+
+			if (!decoder)
+			{
+				UJFree(state);
+			}
+			return 0.0f;
+		}
+
+		dumpObject(0, state, obj);
+
+		if (!decoder)
+		{
+			UJFree(state);
+		}
+
+		count ++;
+		bytesDecoded += cbInput;
+
+		if (tsNow != time(0))
+		{
+			float bps = (float) bytesDecoded;
+			fprintf (stderr, "%s: Count %d, MBps: %f\n", name, count, bps / 1000000.0f);
+
+			total += count;
+			count = 0;
+			bytesDecoded = 0;
+			tsNow = time(0);
+			seconds ++;
+		}
+	}
+
+	return (float) total / (float) seconds;
+}
+
+static int countKey(void *context, const char *key, size_t cbKey)
+{
+	//NOTE: Fix for C4100 warning in L4 MSVC
+	(void) key;
+	(void) cbKey;
+	(*(size_t *) context) ++;
+	return 0;
+}
+
+/*
+Walks the input with UJDecodeEvents for BENCHMARK_SECONDS, counting keys, and returns the number of
+documents walked per second */
+float benchmarkEvents(const char *name, const char *input, size_t cbInput)
+{
+	UJEventHandlers handlers;
+	time_t tsStart;
+	size_t keys = 0;
+	int count = 0;
+	int seconds;
+
+	memset(&handlers, 0, sizeof(handlers));
+	handlers.key = countKey;
+
+	tsStart = time(0);
+
+	while (tsStart == time(0));
+	tsStart = time(0);
+
+	do
+	{
+		if (UJDecodeEvents(input, cbInput, &handlers, &keys, NULL) != 1)
+		{
+			fprintf (stderr, "%s: failed\n", name);
+			return 0.0f;
+		}
+
+		count ++;
+		seconds = (int) (time(0) - tsStart);
+	}
+	while (seconds < BENCHMARK_SECONDS);
+
+	fprintf (stderr, "%s: Count %d, Keys %u\n", name, count, (unsigned) keys);
+	return (float) count / (float) seconds;
+}
+
+/*
+Looks up the last member of the root with a cursor for BENCHMARK_SECONDS, skipping the members before it,
+and returns the number of lookups per second */
+float benchmarkCursor(const char *name, const char *input, size_t cbInput, const char *key)
+{
+	UJCursor root;
+	UJCursor value;
+	time_t tsStart;
+	int count = 0;
+	int seconds;
+
+	tsStart = time(0);
+
+	while (tsStart == time(0));
+	tsStart = time(0);
+
+	do
+	{
+		if (!UJCursorRoot(input, cbInput, &root) || UJCursorFind(&root, key, strlen(key), &value) != 1 || UJCursorType(&value) < 0)
+		{
+			fprintf (stderr, "%s: failed\n", name);
+			return 0.0f;
+		}
+
+		count ++;
+		seconds = (int) (time(0) - tsStart);
+	}
+	while (seconds < BENCHMARK_SECONDS);
+
+	fprintf (stderr, "%s: Count %d\n", name, count);
+	return (float) count / (float) seconds;
+}
+
+/*
+Decodes only the given path with UJDecodePaths for BENCHMARK_SECONDS and returns the number of documents
+decoded per second */
+float benchmarkPaths(const char *name, const char *input, size_t cbInput, const char *path)
+{
+	void *state;
+	time_t tsStart;
+	int count = 0;
+	int seconds;
+
+	tsStart = time(0);
+
+	while (tsStart == time(0));
+	tsStart = time(0);
+
+	do
+	{
+		UJObject obj = UJDecodePaths(input, cbInput, NULL, 0, &path, 1, &state);
+
+		if (obj == NULL)
+		{
+			fprintf (stderr, "%s: %s\n", name, UJGetError(state));
+			UJFree(state);
+			return 0.0f;
+		}
+
+		dumpObject(0, state, obj);
+		UJFree(state);
+		count ++;
+		seconds = (int) (time(0) - tsStart);
+	}
+	while (seconds < BENCHMARK_SECONDS);
+
+	fprintf (stderr, "%s: Count %d\n", name, count);
+	return (float) count / (float) seconds;
+}
+
+static int countMatch(void *context, UJObject obj, const char *value, size_t cbValue)
+{
+	//NOTE: Fix for C4100 warning in L4 MSVC
+	(void) obj;
+	(void) value;
+	(*(size_t *) context) += cbValue;
+	return 0;
+}
+
+float benchmarkQuery(const char *name, const char *input, size_t cbInput, const char *expression)
+{
+	const char *error;
+	UJQuery query = UJQueryCompile(expression, &error);
+	size_t matched = 0;
+	time_t tsStart;
+	int count = 0;
+	int seconds;
+
+	tsStart = time(0);
+
+	while (tsStart == time(0));
+	tsStart = time(0);
+
+	do
+	{
+		UJQuerySelect(query, input, cbInput, NULL, countMatch, &matched, &error);
+
+		if (error)
+		{
+			fprintf (stderr, "%s: %s\n", name, error);
+			UJQueryFree(query);
+			return 0.0f;
+		}
+
+		count ++;
+		seconds = (int) (time(0) - tsStart);
+	}
+	while (seconds < BENCHMARK_SECONDS);
+
+	UJQueryFree(query);
+	fprintf (stderr, "%s: Count %d, %u bytes matched\n", name, count, (unsigned) matched);
+	return (float) count / (float) seconds;
+}
+
+#define UNPACK_KEYS 24
+
+/*
+Unpacks a record of UNPACK_KEYS members in shuffled order, with UJObjectUnpackUTF8 or a key set */
+float benchmarkUnpack(const char *name, int useSet, int flags)
+{
+	char keyNames[UNPACK_KEYS][16];
+	const char *keys[UNPACK_KEYS];
+	char format[UNPACK_KEYS + 1];
+	char record[1024];
+	size_t cbRecord = 0;
+	UJObject values[UNPACK_KEYS];
+	UJObject *v = values;
+	UJKeySet set;
+	UJObject obj;
+	void *state;
+	time_t tsStart;
+	int count = 0;
+	int seconds;
+	int index;
+
+	for (index = 0; index < UNPACK_KEYS; index ++)
+	{
+		sprintf(keyNames[index], "field_%02d", index);
+		keys[index] = keyNames[index];
+		format[index] = 'N';
+		cbRecord += sprintf(record + cbRecord, "%s\"field_%02d\": %d", index ? ", " : "{", (index * 7) % UNPACK_KEYS, index);
+	}
+
+	format[UNPACK_KEYS] = '\0';
+	cbRecord += sprintf(record + cbRecord, "}");
+
+	obj = UJDecodeEx(record, cbRecord, NULL, UJF_UTF8 | flags, &state);
+	set = UJKeySetCompile(keys, UNPACK_KEYS, format);
+
+	tsStart = time(0);
+
+	while (tsStart == time(0));
+	tsStart = time(0);
+
+	do
+	{
+		for (index = 0; index < 10000; index ++)
+		{
+			if (useSet)
+			{
+				UJObjectUnpackSet(obj, set, values);
+			}
+			else
+			{
+				UJObjectUnpackUTF8(obj, UNPACK_KEYS, format, keys, v, v + 1, v + 2, v + 3, v + 4, v + 5, v + 6, v + 7, v + 8, v + 9, v + 10, v + 11,
+					v + 12, v + 13, v + 14, v + 15, v + 16, v + 17, v + 18, v + 19, v + 20, v + 21, v + 22, v + 23);
+			}
+		}
+
+		count += 10000;
+		seconds = (int) (time(0) - tsStart);
+	}
+	while (seconds < BENCHMARK_SECONDS);
+
+	UJKeySetFree(set);
+	UJFree(state);
+	fprintf (stderr, "%s: Count %d\n", name, count);
+	return (float) count / (float) seconds;
+}
+
+#define DICTIONARY_KEYS 10000
+
+/*
+Looks up every key of an object of DICTIONARY_KEYS members, walking it with UJIterObjectUTF8 or with
+UJObjectGet */
+float benchmarkObjectGet(const char *name, int useGet)
+{
+	char *dictionary = (char *) malloc(DICTIONARY_KEYS * 32);
+	char key[16];
+	size_t cbDictionary = 0;
+	size_t cbKey;
+	UJUTF8String iterKey;
+	UJObject obj;
+	UJObject value;
+	void *state;
+	void *iter;
+	time_t tsStart;
+	int count = 0;
+	int seconds;
+	int index;
+
+	for (index = 0; index < DICTIONARY_KEYS; index ++)
+	{
+		cbDictionary += sprintf(dictionary + cbDictionary, "%s\"word%d\": %d", index ? ", " : "{", index, index);
+	}
+
+	cbDictionary += sprintf(dictionary + cbDictionary, "}");
+	obj = UJDecodeEx(dictionary, cbDictionary, NULL, UJF_UTF8, &state);
+
+	tsStart = time(0);
+
+	while (tsStart == time(0));
+	tsStart = time(0);
+
+	do
+	{
+		for (index = 0; index < 1000; index ++)
+		{
+			cbKey = sprintf(key, "word%d", (count + index * 7919) % DICTIONARY_KEYS);
+
+			if (useGet)
+			{
+				value = UJObjectGet(obj, key, cbKey);
+			}
+			else
+			{
+				iter = UJBeginObject(obj);
+
+				while (UJIterObjectUTF8(&iter, &iterKey, &value) && (iterKey.cbLen != cbKey || memcmp(iterKey.ptr, key, cbKey) != 0));
+			}
+
+			dumpObject(0, state, value);
+		}
+
+		count += 1000;
+		seconds = (int) (time(0) - tsStart);
+	}
+	while (seconds < BENCHMARK_SECONDS);
+
+	UJFree(state);
+	free(dictionary);
+	fprintf (stderr, "%s: Count %d\n", name, count);
+	return (float) count / (float) seconds;
+}
+
+#define MATRIX_ROWS 500
+#define MATRIX_COLUMNS 200
+
+/*
+Decodes a matrix of numbers and sums it column by column with UJArrayGet */
+float benchmarkMatrix(const char *name, UJDecoder decoder)
+{
+	char *matrix = (char *) malloc(MATRIX_ROWS * MATRIX_COLUMNS * 8 + MATRIX_ROWS * 4);
+	size_t cbMatrix = 0;
+	long long sum = 0;
+	UJObject obj;
+	time_t tsStart;
+	int count = 0;
+	int seconds;
+	int row;
+	int column;
+
+	for (row = 0; row < MATRIX_ROWS; row ++)
+	{
+		for (column = 0; column < MATRIX_COLUMNS; column ++)
+		{
+			cbMatrix += sprintf(matrix + cbMatrix, "%s%d", column ? ", " : (row ? "], [" : "[["), (row * column) % 1000);
+		}
+	}
+
+	cbMatrix += sprintf(matrix + cbMatrix, "]]");
+
+	tsStart = time(0);
+
+	while (tsStart == time(0));
+	tsStart = time(0);
+
+	do
+	{
+		obj = UJDecoderDecode(decoder, matrix, cbMatrix);
+
+		for (column = 0; column < MATRIX_COLUMNS; column ++)
+		{
+			for (row = 0; row < MATRIX_ROWS; row ++)
+			{
+				sum += UJNumericInt(UJArrayGet(UJArrayGet(obj, row), column));
+			}
+		}
+
+		count ++;
+		seconds = (int) (time(0) - tsStart);
+	}
+	while (seconds < BENCHMARK_SECONDS);
+
+	free(matrix);
+	fprintf (stderr, "%s: Count %d, sum %lld\n", name, count, sum);
+	return (float) count / (float) seconds;
+}
+
+static int countLine(void *context, UJObject obj, const char *line, size_t cbLine)
+{
+	//NOTE: Fix for C4100 warning in L4 MSVC
+	(void) line;
+	(void) cbLine;
+
+	if (obj)
+	{
+		dumpObject(0, NULL, obj);
+		(*(size_t *) context) ++;
+	}
+
+	return 0;
+}
+
+/*
+Writes count log records in JSON Lines format to a buffer the caller frees */
+char *createLines(int count, size_t *outLen)
+{
+	char *lines = (char *) malloc((size_t) count * 256);
+	size_t len = 0;
+	int index;
+
+	for (index = 0; index < count; index ++)
+	{
+		len += (size_t) sprintf(lines + len,
+			"{\"ts\":%d,\"level\":\"info\",\"host\":\"web-%02d\",\"msg\":\"request served\",\"status\":%d,\"ms\":%d.%02d,\"tags\":[\"a\",\"b\"]}\n",
+			1600000000 + index, index % 16, index % 7 ? 200 : 404, index % 300, index % 100);
+	}
+
+	*outLen = len;
+	return lines;
+}
+
+static int countRecord(void *context, UJObject obj, const char *error, const char *line, size_t cbLine)
+{
+	//NOTE: Fix for C4100 warning in L4 MSVC
+	(void) context;
+	(void) error;
+	(void) line;
+	(void) cbLine;
+	dumpObject(0, NULL, obj);
+	return 0;
+}
+
+/*
+Decodes the lines with UJDecodeLinesParallel for BENCHMARK_SECONDS and returns the number of records decoded per second */
+float benchmarkLinesParallel(const char *lines, size_t cbLines, int threads, int ordered)
+{
+	time_t tsStart;
+	size_t total = 0;
+	int seconds;
+
+	tsStart = time(0);
+
+	while (tsStart == time(0));
+	tsStart = time(0);
+
+	do
+	{
+		total += UJDecodeLinesParallel(lines, cbLines, 0, threads, ordered, countRecord, NULL);
+		seconds = (int) (time(0) - tsStart);
+	}
+	while (seconds < BENCHMARK_SECONDS);
+
+	fprintf (stderr, "lines %d threads%s: Records %u\n", threads, ordered ? " ordered" : "", (unsigned) total);
+	return (float) total / (float) seconds;
+}
+
+/*
+Decodes the lines for BENCHMARK_SECONDS and returns the number of records decoded per second. Uses
+UJDecoderDecodeLines on decoder if not NULL, otherwise splits the lines and decodes each with UJDecode */
+float benchmarkLines(const char *name, const char *lines, size_t cbLines, UJDecoder decoder)
+{
+	time_t tsNow;
+	int seconds = 0;
+	size_t count = 0;
+	size_t total = 0;
+
+	tsNow = time(0);
+
+	while (tsNow == time(0));
+	tsNow = time(0);
+
+	while (seconds < BENCHMARK_SECONDS)
+	{
+		if (decoder)
+		{
+			UJDecoderDecodeLines(decoder, lines, cbLines, countLine, &count);
+		}
+		else
+		{
+			const char *line = lines;
+			const char *end = lines + cbLines;
+
+			while (line < end)
+			{
+				const char *lineEnd = (const char *) memchr(line, '\n', (size_t) (end - line));
+				void *state;
+				UJObject obj = UJDecode(line, (size_t) (lineEnd - line), NULL, &state);
+
+				if (obj)
+				{
+					dumpObject(0, state, obj);
+					count ++;
+				}
+
+				UJFree(state);
+				line = lineEnd + 1;
+			}
+		}
+
+		if (tsNow != time(0))
+		{
+			fprintf (stderr, "%s: Records %u\n", name, (unsigned) count);
+
+			total += count;
+			count = 0;
+			tsNow = time(0);
+			seconds ++;
+		}
+	}
+
+	return (float) total / (float) seconds;
+}
+
+int main ()
+{
+	char *input;
+	char *minified;
+	size_t cbInput;
+	size_t cbMinified;
+	FILE *file;
+	char buffer[32768];
+	float prettyRate;
+	float minifiedRate;
+	float reusedRate;
+	float iterativeRate;
+	float structuralRate;
+	float utf8Rate;
+	float tapeRate;
+	float eventsRate;
+	float cursorRate;
+	float pathsRate;
+	float queryRate;
+	float unpackRate;
+	float unpackSetRate;
+	float unpackInternedRate;
+	float iterateRate;
+	float getRate;
+	float matrixRate;
+	float deepRate;
+	float deepIterativeRate;
+	float lineRate;
+	float batchRate;
+	float internedRate;
+	float parallelRates[4][2];
+	float arrayRate;
+	float arrayParallelRate;
+	int threads;
+	char *lines;
+	size_t cbLines;
+	size_t cbSerialLines;
+	char *array;
+	size_t index;
+	char deep[4096];
+	size_t cbDeep;
+	UJDecoder decoder;
+
+	UJHeapFuncs hf;
+	hf.cbInitialHeap = sizeof(buffer);
+	hf.initalHeap = buffer;
+	hf.free = free;
+	hf.malloc = malloc;
+	hf.realloc = realloc;
+
+	file = fopen("./sample.json", "rb");
+
+	if (file == NULL)
+	{
+		fprintf (stderr, "Could not open ./sample.json\n");
+		return 1;
+	}
+
+	input = (char *) malloc(1024 * 1024);
+	cbInput = fread ( (void *) input, 1, 1024 * 1024 - 1, file);
+	input[cbInput] = '\0';
+	fclose(file);
+
+	minified = (char *) malloc(cbInput + 1);
+	cbMinified = minifyInput(minified, input, cbInput);
+
+	prettyRate = benchmarkInput("pretty", input, cbInput, &hf, NULL);
+	minifiedRate = benchmarkInput("minified", minified, cbMinified, &hf, NULL);
+
+	decoder = UJDecoderCreate(NULL, 0);
+	reusedRate = benchmarkInput("reused", minified, cbMinified, NULL, decoder);
+	UJDecoderRelease(decoder);
+
+	decoder = UJDecoderCreate(NULL, UJF_ITERATIVE);
+	iterativeRate = benchmarkInput("iterative", minified, cbMinified, NULL, decoder);
+	UJDecoderRelease(decoder);
+
+	decoder = UJDecoderCreate(NULL, UJF_STRUCTURAL);
+	structuralRate = benchmarkInput("structural", minified, cbMinified, NULL, decoder);
+	UJDecoderRelease(decoder);
+
+	decoder = UJDecoderCreate(NULL, UJF_UTF8);
+	utf8Rate = benchmarkInput("utf8", minified, cbMinified, NULL, decoder);
+	UJDecoderRelease(decoder);
+
+	decoder = UJDecoderCreate(NULL, UJF_TAPE);
+	tapeRate = benchmarkInput("tape", minified, cbMinified, NULL, decoder);
+	UJDecoderRelease(decoder);
+
+	eventsRate = benchmarkEvents("events", minified, cbMinified);
+	cursorRate = benchmarkCursor("cursor", minified, cbMinified, "z");
+	pathsRate = benchmarkPaths("paths", minified, cbMinified, "z.obj.key");
+	queryRate = benchmarkQuery("query", minified, cbMinified, "$..obj.key");
+	unpackRate = benchmarkUnpack("unpack", 0, 0);
+	unpackSetRate = benchmarkUnpack("unpack set", 1, 0);
+	unpackInternedRate = benchmarkUnpack("unpack interned", 0, UJF_INTERNKEYS);
+	iterateRate = benchmarkObjectGet("iterate", 0);
+	getRate = benchmarkObjectGet("get", 1);
+
+	decoder = UJDecoderCreate(NULL, 0);
+	matrixRate = benchmarkMatrix("matrix", decoder);
+	UJDecoderRelease(decoder);
+
+	// Nested close to the depth limit, where recursion costs the most
+	for (cbDeep = 0; cbDeep < 1000; cbDeep ++)
+	{
+		deep[cbDeep] = '[';
+		deep[1999 - cbDeep] = ']';
+	}
+
+	cbDeep = 2000;
+	deep[cbDeep] = '\0';
+
+	decoder = UJDecoderCreate(NULL, 0);
+	deepRate = benchmarkInput("deep", deep, cbDeep, NULL, decoder);
+	UJDecoderRelease(decoder);
+
+	decoder = UJDecoderCreate(NULL, UJF_ITERATIVE);
+	deepIterativeRate = benchmarkInput("deep iterative", deep, cbDeep, NULL, decoder);
+	UJDecoderRelease(decoder);
+
+	lines = createLines(10000, &cbLines);
+	lineRate = benchmarkLines("lines", lines, cbLines, NULL);
+
+	decoder = UJDecoderCreate(NULL, 0);
+	batchRate = benchmarkLines("lines batch", lines, cbLines, decoder);
+	UJDecoderRelease(decoder);
+
+	decoder = UJDecoderCreate(NULL, UJF_INTERNKEYS);
+	internedRate = benchmarkLines("lines interned", lines, cbLines, decoder);
+	UJDecoderRelease(decoder);
+
+	free(lines);
+	cbSerialLines = cbLines;
+	lines = createLines(400000, &cbLines);
+
+	for (threads = 0; threads < 4; threads ++)
+	{
+		parallelRates[threads][0] = benchmarkLinesParallel(lines, cbLines, 1 << threads, 0);
+		parallelRates[threads][1] = benchmarkLinesParallel(lines, cbLines, 1 << threads, 1);
+	}
+
+	// The same records as one large root array
+	array = (char *) malloc(cbLines + 1);
+	array[0] = '[';
+
+	for (index = 0; index < cbLines; index ++)
+	{
+		array[index + 1] = lines[index] == '\n' ? ',' : lines[index];
+	}
+
+	array[cbLines] = ']';
+
+	decoder = UJDecoderCreate(NULL, 0);
+	arrayRate = benchmarkInput("array", array, cbLines + 1, NULL, decoder);
+	UJDecoderRelease(decoder);
+
+	decoder = UJDecoderCreate(NULL, UJF_PARALLEL);
+	arrayParallelRate = benchmarkInput("array parallel", array, cbLines + 1, NULL, decoder);
+	UJDecoderRelease(decoder);
+
+	fprintf (stderr, "pretty:   %u bytes, %.1f documents/s\n", (unsigned) cbInput, prettyRate);
+	fprintf (stderr, "minified: %u bytes, %.1f documents/s\n", (unsigned) cbMinified, minifiedRate);
+	fprintf (stderr, "reused:   %u bytes, %.1f documents/s (minified, one UJDecoder)\n", (unsigned) cbMinified, reusedRate);
+	fprintf (stderr, "iterative: %u bytes, %.1f documents/s (minified, UJF_ITERATIVE)\n", (unsigned) cbMinified, iterativeRate);
+	fprintf (stderr, "structural: %u bytes, %.1f documents/s (minified, UJF_STRUCTURAL)\n", (unsigned) cbMinified, structuralRate);
+	fprintf (stderr, "tape:     %u bytes, %.1f documents/s (minified, UJF_UTF8), %.1f documents/s (UJF_TAPE)\n", (unsigned) cbMinified, utf8Rate, tapeRate);
+	fprintf (stderr, "events:   %u bytes, %.1f documents/s (minified, UJDecodeEvents)\n", (unsigned) cbMinified, eventsRate);
+	fprintf (stderr, "cursor:   %u bytes, %.1f documents/s (minified, UJCursorFind of the last root member)\n", (unsigned) cbMinified, cursorRate);
+	fprintf (stderr, "paths:    %u bytes, %.1f documents/s (minified, UJDecodePaths of z.obj.key)\n", (unsigned) cbMinified, pathsRate);
+	fprintf (stderr, "query:    %u bytes, %.1f documents/s (minified, UJQuerySelect of $..obj.key)\n", (unsigned) cbMinified, queryRate);
+	fprintf (stderr, "unpack:   %d keys, %.1f objects/s (UJObjectUnpackUTF8), %.1f objects/s (UJObjectUnpackSet), %.1f objects/s (UJF_INTERNKEYS)\n", UNPACK_KEYS, unpackRate, unpackSetRate, unpackInternedRate);
+	fprintf (stderr, "get:      %d keys, %.1f lookups/s (UJIterObjectUTF8), %.1f lookups/s (UJObjectGet)\n", DICTIONARY_KEYS, iterateRate, getRate);
+	fprintf (stderr, "matrix:   %dx%d, %.1f documents/s (decoded and summed by column with UJArrayGet)\n", MATRIX_ROWS, MATRIX_COLUMNS, matrixRate);
+	fprintf (stderr, "deep:     %u bytes, %.1f documents/s (recursive), %.1f documents/s (UJF_ITERATIVE)\n", (unsigned) cbDeep, deepRate, deepIterativeRate);
+
+	fprintf (stderr, "lines:    %u bytes, %.1f records/s (UJDecode per line), %.1f records/s (UJDecoderDecodeLines), %.1f records/s (UJF_INTERNKEYS)\n", (unsigned) cbSerialLines, lineRate, batchRate, internedRate);
+
+
+	for (threads = 0; threads < 4; threads ++)
+	{
+		fprintf (stderr, "parallel: %u bytes, %d threads, %.1f records/s (unordered), %.1f records/s (ordered)\n",
+			(unsigned) cbLines, 1 << threads, parallelRates[threads][0], parallelRates[threads][1]);
+	}
+
+	fprintf (stderr, "array:    %u bytes, %.1f documents/s (serial), %.1f documents/s (UJF_PARALLEL)\n", (unsigned) (cbLines + 1), arrayRate, arrayParallelRate);
+
+	free(array);
+	free(lines);
+	free(minified);
+	free(input);
+	return 0;
+}
 #endif
\ No newline at end of file
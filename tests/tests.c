@@ -1,102 +1,1857 @@
-/*
-ujson4c decoder helper 1.0
-Developed by ESN, an Electronic Arts Inc. studio. 
-Copyright (c) 2013, Electronic Arts Inc.
-All rights reserved.
-
-Redistribution and use in source and binary forms, with or without
-modification, are permitted provided that the following conditions are met:
-* Redistributions of source code must retain the above copyright
-notice, this list of conditions and the following disclaimer.
-* Redistributions in binary form must reproduce the above copyright
-notice, this list of conditions and the following disclaimer in the
-documentation and/or other materials provided with the distribution.
-* Neither the name of ESN, Electronic Arts Inc. nor the
-names of its contributors may be used to endorse or promote products
-derived from this software without specific prior written permission.
-
-THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
-ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
-WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
-DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS INC. BE LIABLE 
-FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
-(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
-LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
-ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
-(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
-SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-
-Uses UltraJSON library:
-Copyright (c) 2013, Electronic Arts Inc.
-All rights reserved.
-www.github.com/esnme/ultrajson
-*/
-
-#include "ujdecode.h"
-#include <malloc.h>
-#include <assert.h>
-#include <limits.h>
-
-void test_unpackKeys()
-{
-	UJObject obj;
-	void *state;
-	char buffer[32768];
-	const char input[] = "{\"name\": \"John Doe\", \"age\": 31, \"number\": 1337.37, \"address\": { \"city\": \"Uppsala\", \"population\": 9223372036854775807 } }";
-	size_t cbInput = sizeof(input) - 1;
-
-	const wchar_t *personKeys[] = { L"name", L"age", L"number", L"address"};
-	UJObject oName, oAge, oNumber, oAddress;
-
-	UJHeapFuncs hf;
-	hf.cbInitialHeap = sizeof(buffer);
-	hf.initalHeap = buffer;
-	hf.free = free;
-	hf.malloc = malloc;
-	hf.realloc = realloc;
-
-	obj = UJDecode(input, cbInput, NULL, &state);
-
-	if (UJObjectUnpack(obj, 4, "SNNO", personKeys, &oName, &oAge, &oNumber, &oAddress) == 4)
-	{
-		const wchar_t *addressKeys[] = { L"city", L"population" };
-		UJObject oCity, oPopulation;
-
-		const wchar_t *name = UJReadString(oName, NULL);
-		int age = UJNumericInt(oAge);
-		double number = UJNumericFloat(oNumber);
-
-		assert(wcscmp(name, L"John Doe") == 0);
-		assert(age == 31);
-		assert(number == 1337.37);
-
-		if (UJObjectUnpack(oAddress, 2, "SN", addressKeys, &oCity, &oPopulation) == 2)
-		{
-			const wchar_t *city;
-			long long population;
-			city = UJReadString(oCity, NULL);
-			assert(wcscmp(city, L"Uppsala") == 0);
-			population = UJNumericLongLong(oPopulation);
-			assert(population == LLONG_MAX);
-		}
-		else
-		{
-			assert(0);
-		}
-	}
-	else
-	{
-		assert(0);
-	}
-
-
-	UJFree(state);
-}
-
-#ifndef __BENCHMARK__
-int main ()
-{
-	test_unpackKeys();
-	return 0;
-}
+/*
+ujson4c decoder helper 1.0
+Developed by ESN, an Electronic Arts Inc. studio. 
+Copyright (c) 2013, Electronic Arts Inc.
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+* Redistributions of source code must retain the above copyright
+notice, this list of conditions and the following disclaimer.
+* Redistributions in binary form must reproduce the above copyright
+notice, this list of conditions and the following disclaimer in the
+documentation and/or other materials provided with the distribution.
+* Neither the name of ESN, Electronic Arts Inc. nor the
+names of its contributors may be used to endorse or promote products
+derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL ELECTRONIC ARTS INC. BE LIABLE 
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+Uses UltraJSON library:
+Copyright (c) 2013, Electronic Arts Inc.
+All rights reserved.
+www.github.com/esnme/ultrajson
+*/
+
+#include "ujdecode.h"
+#include <malloc.h>
+#include <assert.h>
+#include <limits.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+void test_unpackKeys()
+{
+	UJObject obj;
+	void *state;
+	char buffer[32768];
+	const char input[] = "{\"name\": \"John Doe\", \"age\": 31, \"number\": 1337.37, \"address\": { \"city\": \"Uppsala\", \"population\": 9223372036854775807 } }";
+	size_t cbInput = sizeof(input) - 1;
+
+	const wchar_t *personKeys[] = { L"name", L"age", L"number", L"address"};
+	UJObject oName, oAge, oNumber, oAddress;
+
+	UJHeapFuncs hf;
+	hf.cbInitialHeap = sizeof(buffer);
+	hf.initalHeap = buffer;
+	hf.free = free;
+	hf.malloc = malloc;
+	hf.realloc = realloc;
+
+	obj = UJDecode(input, cbInput, NULL, &state);
+
+	if (UJObjectUnpack(obj, 4, "SNNO", personKeys, &oName, &oAge, &oNumber, &oAddress) == 4)
+	{
+		const wchar_t *addressKeys[] = { L"city", L"population" };
+		UJObject oCity, oPopulation;
+
+		const wchar_t *name = UJReadString(oName, NULL);
+		int age = UJNumericInt(oAge);
+		double number = UJNumericFloat(oNumber);
+
+		assert(wcscmp(name, L"John Doe") == 0);
+		assert(age == 31);
+		assert(number == 1337.37);
+
+		if (UJObjectUnpack(oAddress, 2, "SN", addressKeys, &oCity, &oPopulation) == 2)
+		{
+			const wchar_t *city;
+			long long population;
+			city = UJReadString(oCity, NULL);
+			assert(wcscmp(city, L"Uppsala") == 0);
+			population = UJNumericLongLong(oPopulation);
+			assert(population == LLONG_MAX);
+		}
+		else
+		{
+			assert(0);
+		}
+	}
+	else
+	{
+		assert(0);
+	}
+
+
+	UJFree(state);
+}
+
+void test_decodeStrings()
+{
+	UJObject obj;
+	void *state;
+	size_t len;
+	const wchar_t *str;
+	wchar_t expected[128];
+	int index;
+
+	// Long ASCII runs interrupted by escapes, control characters and multibyte sequences at varying offsets
+	const char input[] = "[\"0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ\", "
+		"\"0123456789abcdefghijklmnopq\\nrstuvwxyz0123456789abcdefghij\\u00e5klmnopqrstuvwxyz\", "
+		"\"0123456789abcdef\x01ghijklmnopqrstuvwxyz\xc3\xa5\xe2\x82\xac" "0123456789abcdefghijklmnopqrstuvwxyz\"]";
+
+	obj = UJDecode(input, sizeof(input) - 1, NULL, &state);
+	assert(obj != NULL);
+
+	{
+		void *iter = UJBeginArray(obj);
+		UJObject value;
+
+		assert(UJIterArray(&iter, &value));
+		str = UJReadString(value, &len);
+		assert(len == 62);
+		assert(wcscmp(str, L"0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ") == 0);
+
+		assert(UJIterArray(&iter, &value));
+		str = UJReadString(value, &len);
+		assert(len == 74);
+		assert(wcscmp(str, L"0123456789abcdefghijklmnopq\nrstuvwxyz0123456789abcdefghij\u00e5klmnopqrstuvwxyz") == 0);
+
+		assert(UJIterArray(&iter, &value));
+		str = UJReadString(value, &len);
+		assert(len == 75);
+
+		wcscpy(expected, L"0123456789abcdef\x01ghijklmnopqrstuvwxyz\u00e5\u20ac0123456789abcdefghijklmnopqrstuvwxyz");
+		for (index = 0; index < 75; index ++)
+		{
+			assert(str[index] == expected[index]);
+		}
+		assert(str[75] == 0);
+
+		assert(!UJIterArray(&iter, &value));
+	}
+
+	UJFree(state);
+
+	// Unterminated string inside a long run
+	obj = UJDecode("\"0123456789abcdefghijklmnopqrstuvwxyz", 37, NULL, &state);
+	assert(obj == NULL);
+	UJFree(state);
+}
+
+void test_decodeUTF8()
+{
+	UJObject obj;
+	void *state;
+	size_t len;
+	const char *str;
+	const char input[] = "{\"name\": \"J\\u00f6rgen \\\"Doe\\\"\", \"city\": \"G\xc3\xb6teborg\", "
+		"\"emoji\": \"\\ud83d\\ude00\xf0\x9f\x98\x80\", \"k\xc3\xa5y\": 1}";
+
+	const char *keys[] = { "city", "name", "emoji", "k\xc3\xa5y" };
+	const wchar_t *wideKeys[] = { L"k\u00e5y", L"city" };
+	UJObject oName, oCity, oEmoji, oKey;
+
+	obj = UJDecodeEx(input, sizeof(input) - 1, NULL, UJF_UTF8, &state);
+	assert(obj != NULL);
+
+	// Outputs follow the order of the key names, not the order of the keys in the object
+	assert(UJObjectUnpackUTF8(obj, 4, "SSSN", keys, &oCity, &oName, &oEmoji, &oKey) == 4);
+
+	str = UJReadStringUTF8(oName, &len);
+	assert(len == 13 && strcmp(str, "J\xc3\xb6rgen \"Doe\"") == 0);
+
+	str = UJReadStringUTF8(oCity, &len);
+	assert(len == 9 && strcmp(str, "G\xc3\xb6teborg") == 0);
+
+	str = UJReadStringUTF8(oEmoji, &len);
+	assert(len == 8 && strcmp(str, "\xf0\x9f\x98\x80\xf0\x9f\x98\x80") == 0);
+
+	assert(UJNumericInt(oKey) == 1);
+
+	// Wide strings are not available, wide key names still match
+	assert(wcscmp(UJReadString(oCity, &len), L"") == 0 && len == 0);
+	assert(UJObjectUnpack(obj, 2, "NS", wideKeys, &oKey, &oCity) == 2);
+	assert(UJNumericInt(oKey) == 1);
+
+	{
+		void *iter = UJBeginObject(obj);
+		UJUTF8String key;
+		UJObject value;
+
+		assert(UJIterObjectUTF8(&iter, &key, &value));
+		assert(key.cbLen == 4 && memcmp(key.ptr, "name", 4) == 0);
+		assert(value == oName);
+	}
+
+	UJFree(state);
+
+	// A UTF-8 key holding U+0000 ends no earlier than its bytes do
+	{
+		const wchar_t *shortKeys[] = { L"a" };
+		obj = UJDecodeEx("{\"a\\u0000b\": 1}", 15, NULL, UJF_UTF8, &state);
+		assert(obj != NULL);
+		assert(UJObjectUnpack(obj, 1, "N", shortKeys, &oKey) == 0);
+		UJFree(state);
+	}
+
+	// UTF-8 key names match documents decoded with wide strings
+	obj = UJDecode(input, sizeof(input) - 1, NULL, &state);
+	assert(obj != NULL);
+	assert(UJObjectUnpackUTF8(obj, 4, "SSSN", keys, &oCity, &oName, &oEmoji, &oKey) == 4);
+	assert(wcscmp(UJReadString(oCity, NULL), L"G\u00f6teborg") == 0);
+	assert(strcmp(UJReadStringUTF8(oCity, NULL), "") == 0);
+	UJFree(state);
+
+	obj = UJDecodeEx("[\"\\ud83d\"]", 10, NULL, UJF_UTF8, &state);
+	assert(obj == NULL);
+	assert(strcmp(UJGetError(state), "Unpaired high surrogate when decoding 'string'") == 0);
+	UJFree(state);
+
+	obj = UJDecodeEx("[\"\x80\"]", 5, NULL, UJF_UTF8, &state);
+	assert(obj == NULL);
+	UJFree(state);
+}
+
+void test_decodeZeroCopy()
+{
+	UJObject obj;
+	void *state;
+	UJUTF8String view;
+	const char input[] = "{\"plain\": \"Uppsala\", \"escaped\": \"a\\tb\", \"list\": [\"x\", 1]}";
+	const char *keys[] = { "plain", "escaped", "list" };
+	UJObject oPlain, oEscaped, oList;
+
+	obj = UJDecodeEx(input, sizeof(input) - 1, NULL, UJF_ZEROCOPY, &state);
+	assert(obj != NULL);
+	assert(UJObjectUnpackUTF8(obj, 3, "SSA", keys, &oPlain, &oEscaped, &oList) == 3);
+
+	// Strings without escapes are views into the input
+	assert(UJReadStringView(oPlain, &view));
+	assert(view.ptr == input + 11 && view.cbLen == 7);
+
+	// Escaped strings are materialized
+	assert(UJReadStringView(oEscaped, &view));
+	assert(view.ptr < input || view.ptr >= input + sizeof(input));
+	assert(view.cbLen == 3 && memcmp(view.ptr, "a\tb", 3) == 0);
+
+	{
+		void *iter = UJBeginObject(obj);
+		UJUTF8String key;
+		UJObject value;
+
+		assert(UJIterObjectUTF8(&iter, &key, &value));
+		assert(key.ptr == input + 2 && key.cbLen == 5);
+	}
+
+	assert(!UJReadStringView(oList, &view));
+
+	UJFree(state);
+}
+
+void test_decodeInSitu()
+{
+	UJObject obj;
+	void *state;
+	UJUTF8String view;
+	char input[] = "{\"plain\": \"Uppsala\", \"escaped\": \"a\\tb\\u00e5\\ud83d\\ude00c\"}";
+	const char *keys[] = { "plain", "escaped" };
+	UJObject oPlain, oEscaped;
+
+	obj = UJDecodeInSitu(input, sizeof(input) - 1, NULL, 0, &state);
+	assert(obj != NULL);
+	assert(UJObjectUnpackUTF8(obj, 2, "SS", keys, &oPlain, &oEscaped) == 2);
+
+	assert(UJReadStringView(oPlain, &view));
+	assert(view.ptr == input + 11 && view.cbLen == 7);
+	assert(strcmp(view.ptr, "Uppsala") == 0);
+
+	// Unescaped in place, starting where the string started
+	assert(UJReadStringView(oEscaped, &view));
+	assert(view.ptr == input + 33 && view.cbLen == 10);
+	assert(strcmp(view.ptr, "a\tb\xc3\xa5\xf0\x9f\x98\x80" "c") == 0);
+
+	UJFree(state);
+}
+
+void test_decodeDoubles()
+{
+	UJObject obj, value;
+	void *state;
+	void *iter;
+	size_t index;
+	const char input[] = "[1337.37, 0.1, -0.0, 1e23, 2.2250738585072014e-308, 5e-324, 1.7976931348623157e308, "
+		"9007199254740993.0, 9007199254740993.00000000000000000001, 0.30000000000000004441, "
+		"123456789012345678901234567890.5, 100000000000000000000.5, 2.4e-324, 1e-400]";
+	const double expected[] = { 1337.37, 0.1, -0.0, 1e23, 2.2250738585072014e-308, 5e-324, 1.7976931348623157e308,
+		9007199254740992.0, 9007199254740994.0, 0.30000000000000004, 123456789012345678901234567890.5,
+		100000000000000000000.5, 0.0, 0.0 };
+
+	obj = UJDecode(input, sizeof(input) - 1, NULL, &state);
+	assert(obj != NULL);
+
+	iter = UJBeginArray(obj);
+
+	for (index = 0; UJIterArray(&iter, &value); index ++)
+	{
+		double number = UJNumericFloat(value);
+		assert(UJGetType(value) == UJT_Double);
+		assert(index < sizeof(expected) / sizeof(expected[0]));
+		assert(memcmp(&number, &expected[index], sizeof(double)) == 0);
+	}
+
+	assert(index == sizeof(expected) / sizeof(expected[0]));
+	UJFree(state);
+
+	// Out of range for a double
+	obj = UJDecode("[1e400]", 7, NULL, &state);
+	assert(obj == NULL);
+	UJFree(state);
+}
+
+void test_decodeIntegers()
+{
+	UJObject obj, value;
+	void *state;
+	void *iter;
+	size_t index;
+	const char *overflows[] = { "[9223372036854775808]", "[-9223372036854775809]", "[20000000000000000000]", "[123456789012345678901234]" };
+	const char input[] = "[0, 7, -12345678, 123456789, 2147483647, 2147483648, 1234567890123456, "
+		"1234567890123456789, 9223372036854775807, -9223372036854775808, 00000000000000000000042]";
+	const long long expected[] = { 0, 7, -12345678, 123456789, 2147483647LL, 2147483648LL, 1234567890123456LL,
+		1234567890123456789LL, LLONG_MAX, LLONG_MIN, 42 };
+
+	obj = UJDecode(input, sizeof(input) - 1, NULL, &state);
+	assert(obj != NULL);
+
+	iter = UJBeginArray(obj);
+
+	for (index = 0; UJIterArray(&iter, &value); index ++)
+	{
+		assert(index < sizeof(expected) / sizeof(expected[0]));
+		assert(UJNumericLongLong(value) == expected[index]);
+	}
+
+	assert(index == sizeof(expected) / sizeof(expected[0]));
+	UJFree(state);
+
+	for (index = 0; index < sizeof(overflows) / sizeof(overflows[0]); index ++)
+	{
+		obj = UJDecode(overflows[index], strlen(overflows[index]), NULL, &state);
+		assert(obj == NULL);
+		UJFree(state);
+	}
+}
+
+void test_decodeLazyNumbers()
+{
+	UJObject obj, value;
+	void *state;
+	void *iter;
+	UJUTF8String span;
+	const char input[] = "[12, -2147483648, 1234567890123456789, 0.1, 1.50e2, -0.0, \"12\"]";
+	const int types[] = { UJT_Long, UJT_LongLong, UJT_LongLong, UJT_Double, UJT_Double, UJT_Double };
+	const char *spans[] = { "12", "-2147483648", "1234567890123456789", "0.1", "1.50e2", "-0.0" };
+	int index;
+
+	obj = UJDecodeEx(input, sizeof(input) - 1, NULL, UJF_LAZYNUMBERS, &state);
+	assert(obj != NULL);
+
+	iter = UJBeginArray(obj);
+
+	for (index = 0; index < 6; index ++)
+	{
+		assert(UJIterArray(&iter, &value));
+		assert(UJGetType(value) == types[index]);
+		assert(UJReadNumberSpan(value, &span));
+		assert(span.cbLen == strlen(spans[index]) && memcmp(span.ptr, spans[index], span.cbLen) == 0);
+	}
+
+	// Converted on access
+	iter = UJBeginArray(obj);
+	UJIterArray(&iter, &value);
+	assert(UJNumericInt(value) == 12 && UJNumericInt(value) == 12);
+	UJIterArray(&iter, &value);
+	assert(UJNumericLongLong(value) == -2147483647LL - 1);
+	UJIterArray(&iter, &value);
+	assert(UJNumericLongLong(value) == 1234567890123456789LL);
+	UJIterArray(&iter, &value);
+	assert(UJNumericFloat(value) == 0.1);
+	UJIterArray(&iter, &value);
+	assert(UJNumericFloat(value) == 150.0 && UJNumericInt(value) == 150);
+	UJIterArray(&iter, &value);
+	assert(UJNumericFloat(value) == 0.0);
+	UJIterArray(&iter, &value);
+	assert(!UJReadNumberSpan(value, &span));
+	UJFree(state);
+
+	// Range errors are still reported while decoding
+	obj = UJDecodeEx("[9223372036854775808]", 21, NULL, UJF_LAZYNUMBERS, &state);
+	assert(obj == NULL);
+	UJFree(state);
+
+	obj = UJDecodeEx("[1.5e308, 0.0e999, 18e307]", 26, NULL, UJF_LAZYNUMBERS, &state);
+	assert(obj == NULL);
+	UJFree(state);
+
+	obj = UJDecodeEx("[1.5e308, 0.0e999]", 18, NULL, UJF_LAZYNUMBERS, &state);
+	assert(obj != NULL);
+	UJFree(state);
+
+	// A negative exponent doesn't always bring a long integer part back into range
+	{
+		char digits[420];
+		UJUTF8String span;
+		UJObject value;
+
+		digits[0] = '[';
+		memset(digits + 1, '9', 400);
+		strcpy(digits + 401, "e-1]");
+		obj = UJDecodeEx(digits, strlen(digits), NULL, UJF_LAZYNUMBERS, &state);
+		assert(obj == NULL);
+		UJFree(state);
+
+		strcpy(digits + 401, "e-100]");
+		obj = UJDecodeEx(digits, strlen(digits), NULL, UJF_LAZYNUMBERS, &state);
+		assert(obj != NULL);
+		value = UJArrayGet(obj, 0);
+		assert(UJNumericFloat(value) > 9.9e299 && UJNumericFloat(value) <= 1e300);
+		assert(UJReadNumberSpan(value, &span) && span.cbLen == 405);
+		UJFree(state);
+	}
+}
+
+static int g_mallocCalls;
+
+static void *countingMalloc(size_t cbSize)
+{
+	g_mallocCalls ++;
+	return malloc(cbSize);
+}
+
+static void *countingRealloc(void *ptr, size_t cbSize)
+{
+	g_mallocCalls ++;
+	return realloc(ptr, cbSize);
+}
+
+void test_decoderReuse()
+{
+	UJDecoder decoder;
+	UJObject obj;
+	void *iter;
+	char heap[1024];
+	UJHeapFuncs hf;
+	const wchar_t *str;
+	size_t cchLen;
+	int round, index;
+	char large[8192];
+	const char small[] = "[\"caf\\u00e9\", 1, 2.5]";
+
+	hf.initalHeap = heap;
+	hf.cbInitialHeap = sizeof(heap);
+	hf.malloc = countingMalloc;
+	hf.free = free;
+	hf.realloc = countingRealloc;
+
+	// Large enough to need several slabs on top of the initial heap
+	strcpy(large, "[");
+
+	for (index = 0; index < 400; index ++)
+	{
+		strcat(large, index ? ",\"a\\tb\"" : "\"a\\tb\"");
+	}
+
+	strcat(large, "]");
+
+	decoder = UJDecoderCreate(&hf, 0);
+	assert(decoder != NULL);
+
+	for (round = 0; round < 3; round ++)
+	{
+		if (round == 2)
+		{
+			// Warmed up by the first two rounds
+			g_mallocCalls = 0;
+		}
+
+		obj = UJDecoderDecode(decoder, large, strlen(large));
+		assert(obj != NULL);
+		assert(UJGetType(obj) == UJT_Array);
+
+		obj = UJDecoderDecode(decoder, small, sizeof(small) - 1);
+		assert(obj != NULL);
+		iter = UJBeginArray(obj);
+		UJIterArray(&iter, &obj);
+		str = UJReadString(obj, &cchLen);
+		assert(cchLen == 4 && str[3] == 0xe9);
+	}
+
+	assert(g_mallocCalls == 0);
+
+	// Errors are reported on the decoder and it stays usable
+	assert(UJDecoderDecode(decoder, "[1,", 3) == NULL);
+	assert(UJGetError(decoder) != NULL);
+	assert(UJDecoderDecode(decoder, small, sizeof(small) - 1) != NULL);
+	assert(UJGetError(decoder) == NULL);
+
+	UJDecoderRelease(decoder);
+}
+
+static void *failingRealloc(void *ptr, size_t cbSize)
+{
+	//NOTE: Fix for C4100 warning in L4 MSVC
+	(void) ptr;
+	(void) cbSize;
+	return NULL;
+}
+
+void test_decodeOutOfMemory()
+{
+	UJHeapFuncs hf;
+	char heap[1024];
+	void *state;
+	int flags;
+
+	hf.initalHeap = heap;
+	hf.cbInitialHeap = sizeof(heap);
+	hf.malloc = malloc;
+	hf.free = free;
+	hf.realloc = failingRealloc;
+
+	// Growing the element stack fails the decode instead of writing through NULL
+	for (flags = 0; flags <= UJF_ITERATIVE; flags += UJF_ITERATIVE)
+	{
+		assert(UJDecodeEx("[1, [2, 3]]", 11, &hf, flags, &state) == NULL);
+		assert(UJGetError(state) != NULL);
+		UJFree(state);
+	}
+
+	// So does growing the tape, whether the first word is a container or a scalar
+	assert(UJDecodeEx("{\"a\": [1, \"b\"]}", 16, &hf, UJF_TAPE, &state) == NULL);
+	assert(UJGetError(state) != NULL);
+	UJFree(state);
+	assert(UJDecodeEx("\"a\"", 3, &hf, UJF_TAPE, &state) == NULL);
+	assert(UJGetError(state) != NULL);
+	UJFree(state);
+}
+
+void test_decodeIterative()
+{
+	UJDecoder decoder;
+	UJObject obj;
+	UJObject item;
+	UJString key;
+	void *state;
+	void *iter;
+	char *deep;
+	int index;
+	const int depth = 100000;
+	const char input[] = "{\"a\": [1, {\"b\": [], \"c\": {}}, [[\"x\"]], null], \"d\": true}";
+	const char *invalid[] = { "[1,]", "[1 2]", "{\"a\" 1}", "{\"a\": 1 \"b\": 2}", "{[]: 1}", "{1: 2}", "[[1]", "{\"a\": {}", "[", "" };
+
+	obj = UJDecodeEx(input, sizeof(input) - 1, NULL, UJF_ITERATIVE, &state);
+	assert(obj != NULL);
+	iter = UJBeginObject(obj);
+	assert(UJIterObject(&iter, &key, &item));
+	assert(wcscmp(key.ptr, L"a") == 0 && UJGetType(item) == UJT_Array);
+	assert(UJIterObject(&iter, &key, &item));
+	assert(wcscmp(key.ptr, L"d") == 0 && UJIsTrue(item));
+	assert(!UJIterObject(&iter, &key, &item));
+	UJFree(state);
+
+	// Both decoders reject the same documents
+	for (index = 0; index < (int) (sizeof(invalid) / sizeof(invalid[0])); index ++)
+	{
+		assert(UJDecodeEx(invalid[index], strlen(invalid[index]), NULL, UJF_ITERATIVE, &state) == NULL);
+		assert(UJGetError(state) != NULL);
+		UJFree(state);
+
+		assert(UJDecode(invalid[index], strlen(invalid[index]), NULL, &state) == NULL);
+		UJFree(state);
+	}
+
+	// Far deeper than the recursive decoder could go on the C stack
+	deep = (char *) malloc(depth * 2);
+
+	for (index = 0; index < depth; index ++)
+	{
+		deep[index] = '[';
+		deep[depth * 2 - 1 - index] = ']';
+	}
+
+	decoder = UJDecoderCreate(NULL, UJF_ITERATIVE);
+	assert(UJDecoderDecode(decoder, deep, depth * 2) == NULL);
+	assert(UJGetError(decoder) != NULL);
+
+	UJDecoderSetMaxDepth(decoder, depth);
+	obj = UJDecoderDecode(decoder, deep, depth * 2);
+	assert(obj != NULL);
+
+	for (index = 1; index < depth; index ++)
+	{
+		iter = UJBeginArray(obj);
+		assert(UJIterArray(&iter, &obj));
+	}
+
+	iter = UJBeginArray(obj);
+	assert(!UJIterArray(&iter, &item));
+
+	UJDecoderSetMaxDepth(decoder, depth - 1);
+	assert(UJDecoderDecode(decoder, deep, depth * 2) == NULL);
+
+	UJDecoderRelease(decoder);
+	free(deep);
+}
+
+void test_decodeStructural()
+{
+	UJObject obj;
+	UJObject item;
+	UJString key;
+	void *state;
+	void *iter;
+	const wchar_t *str;
+	size_t cchLen;
+	char input[256];
+	int index;
+	const char *invalid[] = { "[1,]", "[1 2]", "[1x]", "[truex]", "[\"a\"b]", "{\"a\" 1}", "{[]: 1}", "{1: 2}", "[[1]", "[\"a]", "[\\\"]", "" };
+
+	// Backslash runs and escaped quotes ending on every position around the 64 byte block boundary
+	for (index = 50; index < 70; index ++)
+	{
+		memset(input, 0, sizeof(input));
+		strcpy(input, "{\"");
+		memset(input + 2, 'a', index);
+		strcat(input, "\\\\\\\"\\\\\": [\"}\", 1, \"\\\\\"], \"b\" : null}");
+
+		obj = UJDecodeEx(input, strlen(input), NULL, UJF_STRUCTURAL, &state);
+		assert(obj != NULL);
+
+		iter = UJBeginObject(obj);
+		assert(UJIterObject(&iter, &key, &item));
+		assert(key.cchLen == (size_t) index + 3 && key.ptr[index] == L'\\' && key.ptr[index + 1] == L'\"');
+
+		iter = UJBeginArray(item);
+		assert(UJIterArray(&iter, &item));
+		str = UJReadString(item, &cchLen);
+		assert(cchLen == 1 && str[0] == L'}');
+		assert(UJIterArray(&iter, &item) && UJNumericInt(item) == 1);
+		assert(UJIterArray(&iter, &item));
+		str = UJReadString(item, &cchLen);
+		assert(cchLen == 1 && str[0] == L'\\');
+
+		iter = UJBeginObject(obj);
+		UJIterObject(&iter, &key, &item);
+		assert(UJIterObject(&iter, &key, &item));
+		assert(wcscmp(key.ptr, L"b") == 0 && UJIsNull(item));
+		UJFree(state);
+	}
+
+	for (index = 0; index < (int) (sizeof(invalid) / sizeof(invalid[0])); index ++)
+	{
+		assert(UJDecodeEx(invalid[index], strlen(invalid[index]), NULL, UJF_STRUCTURAL, &state) == NULL);
+		assert(UJGetError(state) != NULL);
+		UJFree(state);
+	}
+}
+
+void test_decodeStream()
+{
+	UJStream stream;
+	UJObject obj;
+	UJObject item;
+	UJString key;
+	void *iter;
+	const wchar_t *str;
+	size_t cchLen;
+	size_t index;
+	char chunk;
+	const char input[] = "{\"name\": \"caf\\u00e9 \\\"x\\\"\", \"ids\": [9223372036854775807, -1.5e3, true, null, {}]} ";
+
+	// One byte at a time, every string, number and literal is split
+	stream = UJStreamCreate(NULL, 0);
+	assert(stream != NULL);
+
+	for (index = 0; index < sizeof(input) - 1; index ++)
+	{
+		chunk = input[index];
+		assert(UJStreamFeed(stream, &chunk, 1) == (index >= sizeof(input) - 3 ? 1 : 0));
+	}
+
+	obj = UJStreamFinish(stream);
+	assert(obj != NULL);
+
+	iter = UJBeginObject(obj);
+	assert(UJIterObject(&iter, &key, &item));
+	str = UJReadString(item, &cchLen);
+	assert(cchLen == 8 && str[3] == 0xe9 && str[5] == L'\"');
+	assert(UJIterObject(&iter, &key, &item));
+	assert(wcscmp(key.ptr, L"ids") == 0);
+
+	iter = UJBeginArray(item);
+	assert(UJIterArray(&iter, &obj) && UJNumericLongLong(obj) == LLONG_MAX);
+	assert(UJIterArray(&iter, &obj) && UJNumericFloat(obj) == -1500.0);
+	assert(UJIterArray(&iter, &obj) && UJIsTrue(obj));
+	assert(UJIterArray(&iter, &obj) && UJIsNull(obj));
+	assert(UJIterArray(&iter, &obj) && UJIsObject(obj));
+	assert(!UJIterArray(&iter, &obj));
+	UJFree(stream);
+
+	// A root number is only known to be complete when the input ends
+	stream = UJStreamCreate(NULL, UJF_UTF8);
+	assert(UJStreamFeed(stream, "12", 2) == 0);
+	assert(UJStreamFeed(stream, "34", 2) == 0);
+	obj = UJStreamFinish(stream);
+	assert(obj != NULL && UJNumericInt(obj) == 1234);
+	UJFree(stream);
+
+	stream = UJStreamCreate(NULL, 0);
+	assert(UJStreamFeed(stream, "[1, ", 4) == 0);
+	assert(UJStreamFeed(stream, "]", 1) == -1);
+	assert(UJGetError(stream) != NULL);
+	assert(UJStreamFinish(stream) == NULL);
+	UJFree(stream);
+
+	stream = UJStreamCreate(NULL, 0);
+	assert(UJStreamFeed(stream, "[\"abc", 5) == 0);
+	assert(UJStreamFinish(stream) == NULL);
+	assert(UJGetError(stream) != NULL);
+	UJFree(stream);
+
+	// Released without finishing
+	stream = UJStreamCreate(NULL, 0);
+	assert(UJStreamFeed(stream, "[[\"a", 4) == 0);
+	UJFree(stream);
+}
+
+struct LineResults
+{
+	UJDecoder decoder;
+	int values[8];
+	int errors;
+	int count;
+};
+
+static int collectLine(void *context, UJObject obj, const char *line, size_t cbLine)
+{
+	struct LineResults *results = (struct LineResults *) context;
+	const wchar_t *keys[] = { L"v" };
+	UJObject value;
+
+	if (obj == NULL)
+	{
+		assert(UJGetError(results->decoder) != NULL);
+		assert(cbLine > 0 && line[0] == '{');
+		results->values[results->count ++] = -1;
+		results->errors ++;
+		return 0;
+	}
+
+	assert(UJObjectUnpack(obj, 1, "N", keys, &value) == 1);
+	results->values[results->count ++] = UJNumericInt(value);
+	return results->values[results->count - 1] == 99;
+}
+
+void test_decodeLines()
+{
+	struct LineResults results;
+	const char input[] = "{\"v\": 1}\n{\"v\": 2}\r\n\n{\"v\": \n{\"v\": 3}\n  \n{\"v\": 4}";
+	const char stop[] = "{\"v\": 1}\n{\"v\": 99}\n{\"v\": 3}\n";
+
+	memset(&results, 0, sizeof(results));
+	results.decoder = UJDecoderCreate(NULL, 0);
+
+	assert(UJDecoderDecodeLines(results.decoder, input, sizeof(input) - 1, collectLine, &results) == 5);
+	assert(results.count == 5 && results.errors == 1);
+	assert(results.values[0] == 1 && results.values[1] == 2 && results.values[2] == -1);
+	assert(results.values[3] == 3 && results.values[4] == 4);
+
+	// The callback stops the batch
+	memset(results.values, 0, sizeof(results.values));
+	results.count = results.errors = 0;
+	assert(UJDecoderDecodeLines(results.decoder, stop, sizeof(stop) - 1, collectLine, &results) == 2);
+	assert(results.count == 2 && results.values[1] == 99);
+
+	UJDecoderRelease(results.decoder);
+}
+
+struct ParallelResults
+{
+	int *seen;
+	int next;
+	int outOfOrder;
+	int errors;
+};
+
+static int collectRecord(void *context, UJObject obj, const char *error, const char *line, size_t cbLine)
+{
+	struct ParallelResults *results = (struct ParallelResults *) context;
+	const wchar_t *keys[] = { L"v" };
+	UJObject value;
+	int index;
+
+	if (obj == NULL)
+	{
+		assert(error != NULL && cbLine == 5 && memcmp(line, "{\"v\":", 5) == 0);
+		results->errors ++;
+		return 0;
+	}
+
+	assert(UJObjectUnpack(obj, 1, "N", keys, &value) == 1);
+	index = UJNumericInt(value);
+	results->seen[index] ++;
+
+	if (index != results->next)
+	{
+		results->outOfOrder = 1;
+	}
+
+	results->next = index + 1;
+	return 0;
+}
+
+static int markRecord(void *context, UJObject obj, const char *error, const char *line, size_t cbLine)
+{
+	const char *keys[] = { "v" };
+	UJObject value;
+	//NOTE: Fix for C4100 warning in L4 MSVC
+	(void) error;
+	(void) line;
+	(void) cbLine;
+
+	// Called concurrently, every record writes its own slot
+	if (obj)
+	{
+		assert(UJObjectUnpackUTF8(obj, 1, "N", keys, &value) == 1);
+		((struct ParallelResults *) context)->seen[UJNumericInt(value)] ++;
+	}
+
+	return 0;
+}
+
+void test_decodeLinesParallel()
+{
+	struct ParallelResults results;
+	const int count = 100000;
+	char *input = (char *) malloc(count * 32);
+	size_t cbInput = 0;
+	int index;
+
+	for (index = 0; index < count; index ++)
+	{
+		cbInput += sprintf(input + cbInput, "{\"v\": %d, \"s\": \"line\"}\n", index);
+
+		if (index == count / 2)
+		{
+			cbInput += sprintf(input + cbInput, "{\"v\":\n\n");
+		}
+	}
+
+	results.seen = (int *) calloc(count, sizeof(int));
+	results.next = 0;
+	results.outOfOrder = 0;
+	results.errors = 0;
+
+	assert(UJDecodeLinesParallel(input, cbInput, 0, 4, 1, collectRecord, &results) == (size_t) count + 1);
+	assert(results.outOfOrder == 0 && results.errors == 1 && results.next == count);
+
+	// Ordered records of a tape stay valid while the rest of their chunk grows the tape
+	results.next = 0;
+	assert(UJDecodeLinesParallel(input, cbInput, UJF_TAPE, 4, 1, collectRecord, &results) == (size_t) count + 1);
+	assert(results.outOfOrder == 0 && results.errors == 2 && results.next == count);
+
+	// Unordered, each record is still seen exactly once
+	assert(UJDecodeLinesParallel(input, cbInput, UJF_UTF8, 4, 0, markRecord, &results) == (size_t) count + 1);
+
+	for (index = 0; index < count; index ++)
+	{
+		assert(results.seen[index] == 3);
+	}
+
+	free(results.seen);
+	free(input);
+}
+
+/*
+Builds a large root array of objects whose strings look like element boundaries */
+static char *createArray(int count, size_t *cbOut)
+{
+	char *input = (char *) malloc(count * 64 + 16);
+	size_t cbInput = 0;
+	int index;
+
+	input[cbInput ++] = '[';
+
+	for (index = 0; index < count; index ++)
+	{
+		cbInput += sprintf(input + cbInput, "%s\n {\"id\": %d, \"s\": \"}, {\\\"id\\\": %d\", \"a\": [%d]}", index ? "," : "", index, index, index);
+	}
+
+	input[cbInput ++] = ']';
+	*cbOut = cbInput;
+	return input;
+}
+
+static int checkArray(UJObject obj, int count)
+{
+	const char *keys[] = {"id"};
+	void *iter = UJBeginArray(obj);
+	UJObject item;
+	UJObject oId;
+	int index = 0;
+
+	while (UJIterArray(&iter, &item))
+	{
+		if (UJObjectUnpackUTF8(item, 1, "N", keys, &oId) != 1 || UJNumericInt(oId) != index)
+		{
+			return 0;
+		}
+
+		index ++;
+	}
+
+	return index == count;
+}
+
+static int g_sliceMallocCalls;
+
+/*
+Counts allocations like countingMalloc, from any number of threads */
+static void *sliceMalloc(size_t cbSize)
+{
+#ifdef _WIN32
+	InterlockedIncrement((volatile LONG *) &g_sliceMallocCalls);
+#else
+	__atomic_fetch_add(&g_sliceMallocCalls, 1, __ATOMIC_RELAXED);
+#endif
+	return malloc(cbSize);
+}
+
+void test_decodeParallel()
+{
+	const int count = 100000;
+	size_t cbInput;
+	char *input = createArray(count, &cbInput);
+	const char *serialError;
+	void *state;
+	void *serialState;
+	UJDecoder decoder;
+	UJObject obj;
+	UJHeapFuncs hf;
+	char heap[16384];
+	int serialCalls;
+
+	obj = UJDecodeEx(input, cbInput, NULL, UJF_PARALLEL | UJF_UTF8, &state);
+	assert(obj != NULL && checkArray(obj, count));
+	UJFree(state);
+
+	// Fix the number of threads so the array is split whatever the number of processors. Each
+	// slice starts an arena of its own, which shows the split happened
+	hf.initalHeap = heap;
+	hf.cbInitialHeap = sizeof(heap);
+	hf.malloc = sliceMalloc;
+	hf.free = free;
+	hf.realloc = realloc;
+
+	g_sliceMallocCalls = 0;
+	decoder = UJDecoderCreate(&hf, UJF_UTF8);
+	assert(checkArray(UJDecoderDecode(decoder, input, cbInput), count));
+	UJDecoderRelease(decoder);
+	serialCalls = g_sliceMallocCalls;
+
+	g_sliceMallocCalls = 0;
+	decoder = UJDecoderCreate(&hf, UJF_PARALLEL | UJF_UTF8);
+	UJDecoderSetThreads(decoder, 4);
+	assert(checkArray(UJDecoderDecode(decoder, input, cbInput), count));
+	UJDecoderRelease(decoder);
+	assert(g_sliceMallocCalls >= serialCalls + 3);
+
+	decoder = UJDecoderCreate(NULL, UJF_PARALLEL | UJF_ZEROCOPY | UJF_LAZYNUMBERS);
+	UJDecoderSetThreads(decoder, 4);
+	assert(checkArray(UJDecoderDecode(decoder, input, cbInput), count));
+	assert(checkArray(UJDecoderDecode(decoder, input, cbInput), count));
+
+	// A broken element is reported like a serial decode reports it
+	input[cbInput * 3 / 4] = '#';
+	assert(UJDecoderDecode(decoder, input, cbInput) == NULL);
+	assert(UJDecodeEx(input, cbInput, NULL, UJF_UTF8, &serialState) == NULL);
+	serialError = UJGetError(serialState);
+	assert(strcmp(UJGetError(decoder), serialError) == 0);
+	UJFree(serialState);
+	UJDecoderRelease(decoder);
+
+	// Other root values decode serially
+	input[0] = '{';
+	assert(UJDecodeEx(input, cbInput, NULL, UJF_PARALLEL, &state) == NULL);
+	UJFree(state);
+
+	free(input);
+}
+
+/*
+Writes each event as a short token, stopping at a key named "stop" */
+static int logBegin(void *context) { strcat((char *) context, "{"); return 0; }
+static int logEnd(void *context) { strcat((char *) context, "}"); return 0; }
+static int logBeginArray(void *context) { strcat((char *) context, "["); return 0; }
+static int logEndArray(void *context) { strcat((char *) context, "]"); return 0; }
+static int logNull(void *context) { strcat((char *) context, "n "); return 0; }
+
+static int logKey(void *context, const char *key, size_t cbKey)
+{
+	strcat((char *) context, "k:");
+	strncat((char *) context, key, cbKey);
+	strcat((char *) context, " ");
+	return cbKey == 4 && memcmp(key, "stop", 4) == 0;
+}
+
+static int logString(void *context, const char *value, size_t cbValue)
+{
+	strcat((char *) context, "s:");
+	strncat((char *) context, value, cbValue);
+	strcat((char *) context, " ");
+	return 0;
+}
+
+static int logInteger(void *context, long long value)
+{
+	sprintf((char *) context + strlen((char *) context), "i:%lld ", value);
+	return 0;
+}
+
+static int logReal(void *context, double value)
+{
+	sprintf((char *) context + strlen((char *) context), "r:%g ", value);
+	return 0;
+}
+
+static int logBoolean(void *context, int value)
+{
+	strcat((char *) context, value ? "t " : "f ");
+	return 0;
+}
+
+void test_decodeEvents()
+{
+	UJEventHandlers handlers = {logBegin, logEnd, logBeginArray, logEndArray, logKey, logString, logInteger, logReal, logBoolean, logNull};
+	UJEventHandlers keysOnly = {NULL, NULL, NULL, NULL, logKey, NULL, NULL, NULL, NULL, NULL};
+	const char *doc = "{\"a\": [1, -2.5, \"x\\u00e9\\ny\", true, false, null, {}, []], \"b\": 9223372036854775807}";
+	const char *error;
+	char log[1024];
+	const int depth = 1024;
+	char *deep;
+	int index;
+
+	log[0] = '\0';
+	assert(UJDecodeEvents(doc, strlen(doc), &handlers, log, &error) == 1 && error == NULL);
+	assert(strcmp(log, "{k:a [i:1 r:-2.5 s:x\xc3\xa9\ny t f n {}[]]k:b i:9223372036854775807 }") == 0);
+
+	log[0] = '\0';
+	assert(UJDecodeEvents(doc, strlen(doc), &keysOnly, log, NULL) == 1);
+	assert(strcmp(log, "k:a k:b ") == 0);
+
+	// Scalars at the root
+	log[0] = '\0';
+	assert(UJDecodeEvents(" \"root\" ", 8, &handlers, log, &error) == 1);
+	assert(strcmp(log, "s:root ") == 0);
+
+	// A handler stops decoding, later errors are never reached
+	log[0] = '\0';
+	doc = "{\"a\": 1, \"stop\": 2, \"c\": x}";
+	assert(UJDecodeEvents(doc, strlen(doc), &handlers, log, &error) == 0 && error == NULL);
+	assert(strcmp(log, "{k:a i:1 k:stop ") == 0);
+
+	// Events up to the error are reported
+	log[0] = '\0';
+	doc = "[1, 2 3]";
+	assert(UJDecodeEvents(doc, strlen(doc), &handlers, log, &error) == -1 && error != NULL);
+	assert(strcmp(log, "[i:1 i:2 ") == 0);
+
+	log[0] = '\0';
+	assert(UJDecodeEvents("{\"a\":1} x", 9, &keysOnly, log, &error) == -1 && error != NULL);
+	assert(UJDecodeEvents("{1:1}", 5, &keysOnly, log, &error) == -1 && error != NULL);
+	assert(UJDecodeEvents("", 0, &keysOnly, log, &error) == -1 && error != NULL);
+
+	// Nesting to the default depth limit uses no C stack per level
+	deep = (char *) malloc(depth * 2 + 2);
+
+	for (index = 0; index <= depth; index ++)
+	{
+		deep[index] = '[';
+		deep[depth * 2 + 1 - index] = ']';
+	}
+
+	assert(UJDecodeEvents(deep + 1, depth * 2, &keysOnly, log, &error) == 1);
+	assert(UJDecodeEvents(deep, depth * 2 + 2, &keysOnly, log, &error) == -1);
+	free(deep);
+}
+
+void test_cursor()
+{
+	const char *doc = "{\"skip\": {\"a\": [1, \"]}\\\"\", {\"b\": \"[[\"}]}, \"id\": 42, \"big\": -9223372036854775808,"
+		" \"ratio\": 2.5e-1, \"name\": \"caf\\u00e9 \\ud83d\\ude00\", \"k\\u0065y\": true, \"list\": [null, false, \"x\"], \"empty\": {}}";
+	UJCursor root;
+	UJCursor value;
+	UJCursor item;
+	UJUTF8String key;
+	UJUTF8String str;
+	char buffer[64];
+	long long integer;
+	double real;
+	void *state;
+	UJObject obj;
+	int count;
+
+	assert(UJCursorRoot(doc, strlen(doc), &root) == 1);
+	assert(UJCursorType(&root) == UJT_Object);
+
+	// Members are found after a skipped subtree holding brackets and quotes in strings
+	assert(UJCursorFind(&root, "id", 2, &value) == 1);
+	assert(UJCursorType(&value) == UJT_Long && UJCursorReadLongLong(&value, &integer) && integer == 42);
+	assert(UJCursorFind(&root, "big", 3, &value) == 1);
+	assert(UJCursorType(&value) == UJT_LongLong && UJCursorReadLongLong(&value, &integer) && integer == LLONG_MIN);
+	assert(UJCursorFind(&root, "ratio", 5, &value) == 1);
+	assert(UJCursorType(&value) == UJT_Double && !UJCursorReadLongLong(&value, &integer));
+	assert(UJCursorReadDouble(&value, &real) && real == 0.25);
+
+	// Only integers are limited to 64 bits
+	assert(UJCursorRoot("12345678901234567890123.5", 25, &value) == 1);
+	assert(UJCursorType(&value) == UJT_Double && UJCursorReadDouble(&value, &real) && real > 1.2e22 && real < 1.3e22);
+	assert(UJCursorRoot("-100000000000000000000e-20", 26, &value) == 1);
+	assert(UJCursorType(&value) == UJT_Double && UJCursorReadDouble(&value, &real) && real == -1.0);
+
+	assert(UJCursorFind(&root, "name", 4, &value) == 1);
+	assert(UJCursorReadString(&value, buffer, sizeof(buffer), &str));
+	assert(str.cbLen == 10 && memcmp(str.ptr, "caf\xc3\xa9 \xf0\x9f\x98\x80", 10) == 0);
+	assert(!UJCursorReadString(&value, buffer, 4, &str));
+
+	// Escaped keys match their unescaped form
+	assert(UJCursorFind(&root, "key", 3, &value) == 1 && UJCursorType(&value) == UJT_True);
+	assert(UJCursorFind(&root, "missing", 7, &value) == 0);
+
+	assert(UJCursorFind(&root, "list", 4, &value) == 1);
+	assert(UJCursorFirst(&value, &item, NULL) == 1 && UJCursorType(&item) == UJT_Null);
+	assert(UJCursorNext(&item, NULL) == 1 && UJCursorType(&item) == UJT_False);
+	assert(UJCursorNext(&item, NULL) == 1 && UJCursorReadString(&item, NULL, 0, &str) && str.cbLen == 1);
+	assert(UJCursorNext(&item, NULL) == 0);
+
+	assert(UJCursorFind(&root, "empty", 5, &value) == 1 && UJCursorFirst(&value, &item, &key) == 0);
+
+	count = 0;
+
+	for (assert(UJCursorFirst(&root, &item, &key) == 1); ; count ++)
+	{
+		if (count == 0)
+		{
+			assert(key.cbLen == 4 && memcmp(key.ptr, "skip", 4) == 0);
+		}
+
+		if (UJCursorNext(&item, &key) != 1)
+		{
+			break;
+		}
+	}
+
+	assert(count == 7);
+
+	// A subtree can still be decoded in full
+	assert(UJCursorFind(&root, "skip", 4, &value) == 1);
+	obj = UJCursorDecode(&value, NULL, UJF_UTF8, &state);
+	assert(obj != NULL && UJIsObject(obj));
+	UJFree(state);
+
+	// Malformed input is reported where it is read
+	doc = "{\"a\": [1, 2}, \"b\": 1}";
+	assert(UJCursorRoot(doc, strlen(doc), &root) == 1);
+	assert(UJCursorFind(&root, "b", 1, &value) == 1);
+	doc = "{\"a\": [1, 2, \"b\": 1}";
+	assert(UJCursorRoot(doc, strlen(doc), &root) == 1);
+	assert(UJCursorFind(&root, "b", 1, &value) == -1);
+	doc = "[01, 1., -, 1e, 99999999999999999999]";
+	assert(UJCursorRoot(doc, strlen(doc), &root) == 1);
+
+	for (count = UJCursorFirst(&root, &item, NULL); count == 1; count = UJCursorNext(&item, NULL))
+	{
+		assert(UJCursorType(&item) == -1);
+	}
+
+	assert(count == 0);
+	assert(UJCursorRoot(" \n", 2, &root) == 0);
+}
+
+static int countMembers(UJObject obj)
+{
+	void *iter = UJBeginObject(obj);
+	UJString key;
+	UJObject value;
+	int count = 0;
+
+	while (UJIterObject(&iter, &key, &value))
+	{
+		count ++;
+	}
+
+	return count;
+}
+
+void test_decodePaths()
+{
+	const char *doc = "{\"blob\": [{\"x\": \"}]\"}, 1e5], \"address\": {\"street\": \"Main\", \"city\": \"Lund\"},"
+		" \"items\": [{\"id\": 1, \"name\": \"a\"}, {\"id\": 2, \"name\": \"b\"}, {\"name\": \"c\"}], \"m\\u0065ta\": {\"v\": [1, 2]}}";
+	const char *paths[] = {"address.city", "items[*].id", "items[1].name", "meta"};
+	const char *keys[] = {"address", "items", "meta"};
+	const char *cityKeys[] = {"city"};
+	const char *itemKeys[] = {"id", "name"};
+	UJObject obj;
+	UJObject oAddress;
+	UJObject oItems;
+	UJObject oMeta;
+	UJObject oCity;
+	UJObject oItem;
+	UJObject oId;
+	UJObject oName;
+	void *state;
+	void *iter;
+	int flags;
+	int index;
+
+	for (flags = 0; flags <= UJF_ZEROCOPY; flags += UJF_UTF8)
+	{
+		obj = UJDecodePaths(doc, strlen(doc), NULL, flags, paths, 4, &state);
+		assert(obj != NULL && countMembers(obj) == 3);
+		assert(UJObjectUnpackUTF8(obj, 3, "OAO", keys, &oAddress, &oItems, &oMeta) == 3);
+		assert(countMembers(oAddress) == 1 && UJObjectUnpackUTF8(oAddress, 1, "S", cityKeys, &oCity) == 1);
+		assert(countMembers(oMeta) == 1);
+
+		iter = UJBeginArray(oItems);
+
+		for (index = 0; UJIterArray(&iter, &oItem); index ++)
+		{
+			oId = oName = NULL;
+			UJObjectUnpackUTF8(oItem, 2, "ns", itemKeys, &oId, &oName);
+			assert(index != 1 ? countMembers(oItem) == (index < 2) : countMembers(oItem) == 2 && oName != NULL);
+			assert(index == 2 ? oId == NULL : UJNumericInt(oId) == index + 1);
+		}
+
+		assert(index == 3);
+		UJFree(state);
+	}
+
+	// Only the first element is wanted, the rest of the array is skipped
+	paths[0] = "items[0]";
+	obj = UJDecodePaths(doc, strlen(doc), NULL, 0, paths, 1, &state);
+	assert(obj != NULL && UJObjectUnpackUTF8(obj, 1, "A", keys + 1, &oItems) == 1);
+	iter = UJBeginArray(oItems);
+	assert(UJIterArray(&iter, &oItem) && countMembers(oItem) == 2 && !UJIterArray(&iter, &oItem));
+	UJFree(state);
+
+	// Nothing matches
+	paths[0] = "nothing.here";
+	obj = UJDecodePaths(doc, strlen(doc), NULL, 0, paths, 1, &state);
+	assert(obj != NULL && countMembers(obj) == 0);
+	UJFree(state);
+
+	// Paths continuing past a scalar or into the wrong kind of container select nothing
+	paths[0] = "address.city.x";
+	paths[1] = "address[0]";
+	paths[2] = "items.id";
+	paths[3] = "items[0].name[0]";
+	obj = UJDecodePaths(doc, strlen(doc), NULL, 0, paths, 4, &state);
+	assert(obj != NULL && UJObjectUnpackUTF8(obj, 2, "OA", keys, &oAddress, &oItems) == 2);
+	assert(countMembers(obj) == 2 && countMembers(oAddress) == 0);
+	iter = UJBeginArray(oItems);
+	assert(UJIterArray(&iter, &oItem) && countMembers(oItem) == 0 && !UJIterArray(&iter, &oItem));
+	UJFree(state);
+	obj = UJDecodePaths("5", 1, NULL, 0, paths, 1, &state);
+	assert(obj != NULL && UJIsObject(obj) && countMembers(obj) == 0);
+	UJFree(state);
+
+	// Errors in skipped parts go unnoticed, selected values are decoded and checked in full
+	doc = "{\"skipped\": [1, 2 x], \"a\": {\"b\": [1, 2 x]}}";
+	paths[0] = "a";
+	assert(UJDecodePaths(doc, strlen(doc), NULL, 0, paths, 1, &state) == NULL && UJGetError(state) != NULL);
+	UJFree(state);
+	paths[0] = "a.c";
+	assert(UJDecodePaths(doc, strlen(doc), NULL, 0, paths, 1, &state) != NULL);
+	UJFree(state);
+
+	paths[0] = "a[x]";
+	assert(UJDecodePaths(doc, strlen(doc), NULL, 0, paths, 1, &state) == NULL && UJGetError(state) != NULL);
+	UJFree(state);
+	paths[0] = "a";
+	assert(UJDecodePaths("{} {}", 5, NULL, 0, paths, 1, &state) == NULL && UJGetError(state) != NULL);
+	UJFree(state);
+	assert(UJDecodePaths("{\"a\": [", 7, NULL, 0, paths, 1, &state) == NULL && UJGetError(state) != NULL);
+	UJFree(state);
+}
+
+struct QueryMatches
+{
+	char text[512];
+	size_t count;
+	int stopAfter;
+};
+
+static int collectMatch(void *context, UJObject obj, const char *value, size_t cbValue)
+{
+	struct QueryMatches *matches = (struct QueryMatches *) context;
+	size_t length = strlen(matches->text);
+
+	assert(length + cbValue + 2 < sizeof(matches->text));
+
+	if (matches->count ++)
+	{
+		matches->text[length ++] = '|';
+	}
+
+	memcpy(matches->text + length, value, cbValue);
+	matches->text[length + cbValue] = '\0';
+
+	if (obj != NULL)
+	{
+		assert(UJIsArray(obj) || UJIsObject(obj) || UJIsString(obj) || UJIsInteger(obj) || UJIsDouble(obj) || UJIsNull(obj) || UJIsTrue(obj) || UJIsFalse(obj));
+	}
+
+	return matches->stopAfter && matches->count == (size_t) matches->stopAfter;
+}
+
+static const char *runQuery(const char *expression, const char *doc, UJDecoder decoder, int stopAfter, struct QueryMatches *matches)
+{
+	const char *error;
+	UJQuery query = UJQueryCompile(expression, &error);
+	size_t count;
+
+	assert(query != NULL && error == NULL);
+	matches->text[0] = '\0';
+	matches->count = 0;
+	matches->stopAfter = stopAfter;
+	count = UJQuerySelect(query, doc, strlen(doc), decoder, collectMatch, matches, &error);
+	assert(count == matches->count);
+	UJQueryFree(query);
+	return error;
+}
+
+void test_query()
+{
+	const char *doc = "{\"store\": {\"book\": [{\"title\": \"A\", \"price\": 8}, {\"title\": \"B\", \"price\": 12},"
+		" {\"title\": \"C\", \"price\": 9, \"extra\": {\"price\": 1}}, {\"title\": \"D\"}], \"bicycle\": {\"price\": 20}}, \"na\\u006de\": \"x\"}";
+	const char *invalid[] = {"", "store", "$.", "$[-1]", "$[1:-1]", "$[::0]", "$['a'", "$[]", "$[1:2:3:4]", "$x", "$.[0]"};
+	struct QueryMatches matches;
+	const char *error;
+	UJDecoder decoder = UJDecoderCreate(NULL, 0);
+	UJDecoder decoders[2] = {NULL, decoder};
+	int index;
+
+	for (index = 0; index < 2; index ++)
+	{
+		assert(runQuery("$.store.book[*].title", doc, decoders[index], 0, &matches) == NULL);
+		assert(strcmp(matches.text, "\"A\"|\"B\"|\"C\"|\"D\"") == 0);
+		assert(runQuery("$..price", doc, decoders[index], 0, &matches) == NULL);
+		assert(strcmp(matches.text, "8|12|9|1|20") == 0);
+		assert(runQuery("$.store.book[1:3].title", doc, decoders[index], 0, &matches) == NULL);
+		assert(strcmp(matches.text, "\"B\"|\"C\"") == 0);
+		assert(runQuery("$['store']['book'][::2]['title']", doc, decoders[index], 0, &matches) == NULL);
+		assert(strcmp(matches.text, "\"A\"|\"C\"") == 0);
+		assert(runQuery("$.store.book[3]", doc, decoders[index], 0, &matches) == NULL);
+		assert(strcmp(matches.text, "{\"title\": \"D\"}") == 0);
+		assert(runQuery("$.name", doc, decoders[index], 0, &matches) == NULL);
+		assert(strcmp(matches.text, "\"x\"") == 0);
+		assert(runQuery("$", doc, decoders[index], 0, &matches) == NULL);
+		assert(strcmp(matches.text, doc) == 0);
+		assert(runQuery("$.nothing..price", doc, decoders[index], 0, &matches) == NULL);
+		assert(matches.count == 0);
+	}
+
+	// Nested matches are passed after their parent and only once
+	assert(runQuery("$..*..price", "{\"a\": {\"price\": 1, \"b\": {\"price\": 2}}}", NULL, 0, &matches) == NULL);
+	assert(strcmp(matches.text, "1|2") == 0);
+	assert(runQuery("$..[*]", "[[1], 2]", NULL, 0, &matches) == NULL);
+	assert(strcmp(matches.text, "[1]|1|2") == 0);
+
+	// Stopping early
+	assert(runQuery("$..price", doc, NULL, 2, &matches) == NULL);
+	assert(strcmp(matches.text, "8|12") == 0);
+
+	// Skipped subtrees aren't validated, matched ones are when decoded
+	assert(runQuery("$.b", "{\"a\": [1 2 x], \"b\": 1}", NULL, 0, &matches) == NULL && matches.count == 1);
+	assert(runQuery("$.a", "{\"a\": [1 2 x], \"b\": 1}", decoder, 0, &matches) != NULL && matches.count == 0);
+	assert(runQuery("$.a", "{\"a\": [1, 2", NULL, 0, &matches) != NULL);
+	assert(runQuery("$.a", "{} {}", NULL, 0, &matches) != NULL);
+
+	for (index = 0; index < (int) (sizeof(invalid) / sizeof(invalid[0])); index ++)
+	{
+		assert(UJQueryCompile(invalid[index], &error) == NULL && error != NULL);
+	}
+
+	UJDecoderRelease(decoder);
+}
+
+void test_unpackSet()
+{
+	const char *doc = "{\"name\": \"John\", \"\\u00e5r\": 31, \"\\ud83d\\ude00\": true, \"age\": \"old\", \"age\": 32, \"extra\": null, \"nothing\": null}";
+	const char *keyNames[] = {"name", "age", "\xc3\xa5r", "\xf0\x9f\x98\x80", "nothing", "missing"};
+	const char *duplicates[] = {"a", "b", "a"};
+	char manyDoc[4096];
+	char manyNames[100][8];
+	const char *manyKeys[100];
+	char manyFormat[101];
+	UJObject values[100];
+	UJKeySet set;
+	UJObject obj;
+	void *state;
+	int flags;
+	int length;
+	int index;
+
+	set = UJKeySetCompile(keyNames, 6, "SNNBnO");
+	assert(set != NULL);
+
+	for (flags = 0; flags <= UJF_ZEROCOPY; flags += UJF_UTF8)
+	{
+		obj = UJDecodeEx(doc, strlen(doc), NULL, flags, &state);
+		assert(obj != NULL);
+
+		// The first age is a string, the second matches the format
+		assert(UJObjectUnpackSet(obj, set, values) == 5);
+		assert(UJIsString(values[0]) && UJNumericInt(values[1]) == 32 && UJNumericInt(values[2]) == 31);
+		assert(UJIsTrue(values[3]) && UJIsNull(values[4]) && values[5] == NULL);
+		assert(UJObjectUnpackSet(values[0], set, values) == 0);
+		UJFree(state);
+	}
+
+	UJKeySetFree(set);
+
+	// Beyond the 64 keys UJObjectUnpack takes
+	length = sprintf(manyDoc, "{");
+
+	for (index = 0; index < 100; index ++)
+	{
+		sprintf(manyNames[index], "k%d", index);
+		manyKeys[index] = manyNames[index];
+		manyFormat[index] = 'N';
+		length += sprintf(manyDoc + length, "%s\"k%d\": %d", index ? ", " : "", 99 - index, 99 - index);
+	}
+
+	manyFormat[100] = '\0';
+	sprintf(manyDoc + length, "}");
+	set = UJKeySetCompile(manyKeys, 100, manyFormat);
+	obj = UJDecode(manyDoc, strlen(manyDoc), NULL, &state);
+	assert(set != NULL && obj != NULL && UJObjectUnpackSet(obj, set, values) == 100);
+
+	for (index = 0; index < 100; index ++)
+	{
+		assert(UJNumericInt(values[index]) == index);
+	}
+
+	UJFree(state);
+	UJKeySetFree(set);
+
+	assert(UJKeySetCompile(duplicates, 3, "UUU") == NULL);
+	// An overlong encoding of 'a' is the same key once widened
+	duplicates[1] = "\xc1\xa1";
+	assert(UJKeySetCompile(duplicates, 2, "UU") == NULL);
+	assert(UJKeySetCompile(keyNames, 6, "SN") == NULL);
+	set = UJKeySetCompile(keyNames, 0, "");
+	assert(set != NULL && UJObjectUnpackSet(obj = UJDecode("{}", 2, NULL, &state), set, values) == 0);
+	UJFree(state);
+	UJKeySetFree(set);
+}
+
+void test_objectGet()
+{
+	const char *small = "{\"a\": 1, \"b\": 2, \"a\": 3, \"\\u00e5\": 4}";
+	char doc[65536];
+	char key[16];
+	UJObject obj;
+	void *state;
+	int flags;
+	int length;
+	int index;
+
+	for (flags = 0; flags <= UJF_ZEROCOPY; flags += UJF_UTF8)
+	{
+		obj = UJDecodeEx(small, strlen(small), NULL, flags, &state);
+		assert(UJNumericInt(UJObjectGet(obj, "a", 1)) == 1 && UJNumericInt(UJObjectGet(obj, "\xc3\xa5", 2)) == 4);
+		assert(UJObjectGet(obj, "c", 1) == NULL && UJObjectGet(obj, "ab", 1) != NULL);
+		UJFree(state);
+	}
+
+	// Large enough for an index, with a duplicate key at the end
+	length = sprintf(doc, "{\"\\u00e5\\ud83d\\ude00\": -1");
+
+	for (index = 0; index < 2000; index ++)
+	{
+		length += sprintf(doc + length, ", \"key%d\": %d", index, index);
+	}
+
+	sprintf(doc + length, ", \"key7\": 0, \"nested\": {}}");
+
+	for (flags = 0; flags <= UJF_ZEROCOPY; flags += UJF_UTF8)
+	{
+		obj = UJDecodeEx(doc, strlen(doc), NULL, flags, &state);
+		assert(obj != NULL);
+
+		for (index = 0; index < 2000; index ++)
+		{
+			sprintf(key, "key%d", index);
+			assert(UJNumericInt(UJObjectGet(obj, key, strlen(key))) == index);
+		}
+
+		assert(UJNumericInt(UJObjectGet(obj, "\xc3\xa5\xf0\x9f\x98\x80", 6)) == -1);
+		assert(UJObjectGet(obj, "key2000", 7) == NULL && UJObjectGet(obj, "", 0) == NULL);
+		assert(UJObjectGet(UJObjectGet(obj, "nested", 6), "key1", 4) == NULL);
+		assert(UJObjectGet(UJObjectGet(obj, "key1", 4), "key1", 4) == NULL);
+		UJFree(state);
+	}
+}
+
+static void checkMatrix(UJObject obj)
+{
+	UJObject row;
+	void *iter;
+	size_t index;
+	size_t column;
+
+	assert(UJArraySize(obj) == 4);
+
+	for (index = 0; index < 3; index ++)
+	{
+		row = UJArrayGet(obj, index);
+		assert(UJArraySize(row) == 3 && UJArrayGet(row, 3) == NULL);
+
+		for (column = 0; column < 3; column ++)
+		{
+			assert(UJNumericInt(UJArrayGet(row, column)) == (int) (index * 3 + column));
+		}
+	}
+
+	row = UJArrayGet(obj, 3);
+	assert(UJArraySize(UJArrayGet(row, 0)) == 0 && UJArraySize(UJArrayGet(row, 1)) == 1);
+	iter = UJBeginArray(UJArrayGet(row, 0));
+	assert(!UJIterArray(&iter, &row));
+	assert(UJArrayGet(obj, 4) == NULL);
+}
+
+void test_arrayIndex()
+{
+	const char *doc = "[[0, 1, 2], [3, 4, 5], [6, 7, 8], [[], [{\"a\": [1]}]]]";
+	const char *paths[] = {"[1]", "[3][1]"};
+	int flags[] = {0, UJF_ITERATIVE, UJF_STRUCTURAL, UJF_UTF8};
+	UJDecoder decoder;
+	UJStream stream;
+	UJObject obj;
+	void *state;
+	size_t index;
+
+	for (index = 0; index < sizeof(flags) / sizeof(flags[0]); index ++)
+	{
+		decoder = UJDecoderCreate(NULL, flags[index]);
+
+		// Arrays left open by a failed decode don't leak into the next one
+		assert(UJDecoderDecode(decoder, "[[1, 2], [3", 11) == NULL);
+		checkMatrix(UJDecoderDecode(decoder, doc, strlen(doc)));
+		UJDecoderRelease(decoder);
+	}
+
+	stream = UJStreamCreate(NULL, 0);
+
+	for (index = 0; doc[index]; index ++)
+	{
+		UJStreamFeed(stream, doc + index, 1);
+	}
+
+	checkMatrix(UJStreamFinish(stream));
+	UJFree(stream);
+
+	obj = UJDecodePaths(doc, strlen(doc), NULL, 0, paths, 2, &state);
+	assert(UJArraySize(obj) == 2 && UJNumericInt(UJArrayGet(UJArrayGet(obj, 0), 2)) == 5);
+	assert(UJArraySize(UJArrayGet(obj, 1)) == 1);
+	UJFree(state);
+
+	obj = UJDecode("{\"a\": 1}", 8, NULL, &state);
+	assert(UJArraySize(obj) == 0 && UJArrayGet(obj, 0) == NULL);
+	UJFree(state);
+}
+
+void test_tape()
+{
+	const char *doc = "{\"name\": \"caf\\u00e9\", \"n\": -17, \"big\": 5000000000, \"pi\": 3.5, \"flags\": [true, false, null], "
+		"\"nested\": {\"empty\": {}, \"list\": [], \"deep\": [[1], {\"x\": \"yy\"}]}, \"last\": \"\"}";
+	const char *keys[] = {"pi", "name", "nested"};
+	const char *numbers[] = {"name", "n", "big", "pi"};
+	const wchar_t *wideKeys[] = {L"n"};
+	int flags[] = {UJF_TAPE, UJF_TAPE | UJF_ITERATIVE, UJF_TAPE | UJF_STRUCTURAL, UJF_TAPE | UJF_ZEROCOPY | UJF_LAZYNUMBERS};
+	UJObject values[3];
+	UJObject obj, name, n, big, pi, nested, deep, item;
+	UJUTF8String key;
+	UJKeySet keySet;
+	UJDecoder decoder;
+	UJStream stream;
+	void *iter;
+	size_t cb;
+	size_t index;
+	int count;
+
+	for (index = 0; index < sizeof(flags) / sizeof(flags[0]); index ++)
+	{
+		decoder = UJDecoderCreate(NULL, flags[index]);
+
+		// A failed decode leaves nothing behind on the tape
+		assert(UJDecoderDecode(decoder, "[1, [2, ", 8) == NULL);
+		obj = UJDecoderDecode(decoder, doc, strlen(doc));
+		assert(UJIsObject(obj));
+
+		assert(UJObjectUnpackUTF8(obj, 4, "NNNN", numbers, &name, &n, &big, &pi) == 3);
+		assert(UJObjectUnpackUTF8(obj, 3, "NSO", keys, &pi, &name, &nested) == 3);
+		assert(strcmp(UJReadStringUTF8(name, &cb), "caf\xc3\xa9") == 0 && cb == 5);
+		assert(UJNumericFloat(pi) == 3.5);
+
+		n = UJObjectGet(obj, "n", 1);
+		big = UJObjectGet(obj, "big", 3);
+		assert(UJIsLong(n) && UJNumericInt(n) == -17 && UJNumericLongLong(n) == -17);
+		assert(UJIsLongLong(big) && UJNumericLongLong(big) == 5000000000LL);
+		assert(UJObjectGet(obj, "missing", 7) == NULL);
+		assert(UJReadStringUTF8(UJObjectGet(obj, "last", 4), &cb)[0] == '\0' && cb == 0);
+
+		item = UJObjectGet(obj, "flags", 5);
+		assert(UJArraySize(item) == 3);
+		assert(UJIsTrue(UJArrayGet(item, 0)) && UJIsFalse(UJArrayGet(item, 1)) && UJIsNull(UJArrayGet(item, 2)));
+		assert(UJArrayGet(item, 3) == NULL);
+
+		keySet = UJKeySetCompile(keys, 3, "NSO");
+		assert(UJObjectUnpackSet(obj, keySet, values) == 3 && values[2] == nested);
+		UJKeySetFree(keySet);
+
+		assert(UJArraySize(UJObjectGet(nested, "list", 4)) == 0);
+		iter = UJBeginObject(UJObjectGet(nested, "empty", 5));
+		assert(!UJIterObjectUTF8(&iter, &key, &item));
+
+		deep = UJObjectGet(nested, "deep", 4);
+		assert(UJNumericInt(UJArrayGet(UJArrayGet(deep, 0), 0)) == 1);
+		assert(strcmp(UJReadStringUTF8(UJObjectGet(UJArrayGet(deep, 1), "x", 1), NULL), "yy") == 0);
+
+		// Members come in document order, each value skipped in one step
+		iter = UJBeginObject(obj);
+		count = 0;
+
+		while (UJIterObjectUTF8(&iter, &key, &item))
+		{
+			count ++;
+		}
+
+		assert(count == 7 && key.cbLen == 4 && memcmp(key.ptr, "last", 4) == 0);
+		UJDecoderRelease(decoder);
+	}
+
+	stream = UJStreamCreate(NULL, UJF_TAPE);
+
+	for (index = 0; doc[index]; index ++)
+	{
+		UJStreamFeed(stream, doc + index, 1);
+	}
+
+	obj = UJStreamFinish(stream);
+	assert(UJObjectUnpack(obj, 1, "N", wideKeys, &n) == 1 && UJNumericInt(n) == -17);
+	assert(UJArraySize(UJObjectGet(obj, "flags", 5)) == 3);
+	UJFree(stream);
+
+	obj = UJDecodeEx("\"only\"", 6, NULL, UJF_TAPE, &iter);
+	assert(strcmp(UJReadStringUTF8(obj, NULL), "only") == 0);
+	UJFree(iter);
+}
+
+static void checkScalars(UJObject obj)
+{
+	const wchar_t *keys[] = {L"t", L"f", L"n", L"z"};
+	UJObject t, f, n, z, list;
+	UJUTF8String span;
+	size_t cch;
+
+	assert(UJObjectUnpack(obj, 4, "BBnN", keys, &t, &f, &n, &z) == 4);
+	assert(UJIsTrue(t) && !UJIsFalse(t) && UJIsFalse(f) && UJIsNull(n) && !UJIsNull(z));
+	assert(UJIsLong(z) && UJIsInteger(z) && UJNumericInt(z) == 0);
+
+	// Inline scalars are no containers, strings or number spans
+	assert(UJBeginArray(n) == NULL && UJBeginObject(t) == NULL && UJArraySize(z) == 0);
+	assert(UJObjectGet(f, "t", 1) == NULL && UJArrayGet(z, 0) == NULL);
+	assert(UJReadString(z, &cch)[0] == L'\0' && cch == 0);
+	assert(!UJReadNumberSpan(z, &span));
+
+	list = UJObjectGet(obj, "list", 4);
+	assert(UJArraySize(list) == 7);
+	assert(UJNumericInt(UJArrayGet(list, 0)) == -1);
+	assert(UJIsLong(UJArrayGet(list, 1)) && UJNumericInt(UJArrayGet(list, 1)) == 2147483647);
+	assert(UJIsInteger(UJArrayGet(list, 2)) && UJNumericLongLong(UJArrayGet(list, 2)) == -2147483647LL - 1);
+	assert(UJIsLongLong(UJArrayGet(list, 3)) && UJNumericLongLong(UJArrayGet(list, 3)) == 2147483648LL);
+	assert(UJNumericFloat(UJArrayGet(list, 4)) == 12.0);
+	assert(UJIsNull(UJArrayGet(list, 5)) && UJIsTrue(UJArrayGet(list, 6)));
+}
+
+void test_inlineScalars()
+{
+	const char *doc = "{\"t\": true, \"f\": false, \"n\": null, \"z\": 0, \"list\": [-1, 2147483647, -2147483648, 2147483648, 12, null, true]}";
+	int flags[] = {0, UJF_ITERATIVE, UJF_STRUCTURAL, UJF_UTF8};
+	UJStream stream;
+	void *state;
+	size_t index;
+
+	for (index = 0; index < sizeof(flags) / sizeof(flags[0]); index ++)
+	{
+		checkScalars(UJDecodeEx(doc, strlen(doc), NULL, flags[index], &state));
+		UJFree(state);
+	}
+
+	stream = UJStreamCreate(NULL, 0);
+
+	for (index = 0; doc[index]; index ++)
+	{
+		UJStreamFeed(stream, doc + index, 1);
+	}
+
+	checkScalars(UJStreamFinish(stream));
+	UJFree(stream);
+}
+
+static const void *firstKey(UJObject obj, int utf8)
+{
+	void *iter = UJBeginObject(obj);
+	UJString key;
+	UJUTF8String keyUTF8;
+	UJObject value;
+
+	if (utf8)
+	{
+		assert(UJIterObjectUTF8(&iter, &keyUTF8, &value));
+		return keyUTF8.ptr;
+	}
+
+	assert(UJIterObject(&iter, &key, &value));
+	return key.ptr;
+}
+
+void test_internKeys()
+{
+	const char *doc = "[{\"id\": 1, \"caf\\u00e9\": \"a\", \"id\": 5}, {\"id\": 2, \"caf\\u00e9\": \"b\"}, {\"caf\\u00e9\": \"c\", \"other\": null}]";
+	const wchar_t *wideKeys[] = {L"id", L"café", L"missing"};
+	const char *keys[] = {"id", "caf\xc3\xa9", "missing"};
+	int flags[] = {UJF_INTERNKEYS, UJF_INTERNKEYS | UJF_ITERATIVE, UJF_INTERNKEYS | UJF_STRUCTURAL, UJF_INTERNKEYS | UJF_UTF8, UJF_INTERNKEYS | UJF_ZEROCOPY};
+	const void *shared = NULL;
+	UJDecoder decoder;
+	UJStream stream;
+	UJObject obj, id, name;
+	char *big;
+	char *ptr;
+	void *state;
+	size_t index;
+	size_t doc2;
+	int key;
+
+	for (index = 0; index < sizeof(flags) / sizeof(flags[0]); index ++)
+	{
+		int utf8 = (flags[index] & (UJF_UTF8 | UJF_ZEROCOPY)) ? 1 : 0;
+		decoder = UJDecoderCreate(NULL, flags[index]);
+
+		for (doc2 = 0; doc2 < 2; doc2 ++)
+		{
+			obj = UJDecoderDecode(decoder, doc, strlen(doc));
+
+			// Equal keys are one string, also in the next document of the decoder
+			if (doc2 == 0)
+			{
+				shared = firstKey(UJArrayGet(obj, 0), utf8);
+				assert(shared < (const void *) doc || shared >= (const void *) (doc + strlen(doc)));
+			}
+
+			assert(firstKey(UJArrayGet(obj, 0), utf8) == shared && firstKey(UJArrayGet(obj, 1), utf8) == shared);
+
+			// Both forms of key names match, whichever form the keys were decoded in
+			assert(UJObjectUnpack(UJArrayGet(obj, 0), 3, "NSN", wideKeys, &id, &name, NULL) == 2);
+			assert(UJNumericInt(id) == 1 && (utf8 || wcscmp(UJReadString(name, NULL), L"a") == 0));
+			assert(UJObjectUnpackUTF8(UJArrayGet(obj, 1), 3, "NSN", keys, &id, &name, NULL) == 2);
+			assert(UJNumericInt(id) == 2);
+			assert(UJObjectUnpackUTF8(UJArrayGet(obj, 2), 2, "NS", keys, &id, &name) == 1);
+		}
+
+		// Failed documents leave the keys of the decoder intact
+		assert(UJDecoderDecode(decoder, "{\"id\": [", 8) == NULL);
+		obj = UJDecoderDecode(decoder, "{\"x\": 1, \"id\": 3}", 17);
+		assert(UJObjectUnpackUTF8(obj, 1, "N", keys, &id) == 1 && UJNumericInt(id) == 3);
+		UJDecoderRelease(decoder);
+	}
+
+	stream = UJStreamCreate(NULL, UJF_INTERNKEYS);
+
+	for (index = 0; doc[index]; index ++)
+	{
+		UJStreamFeed(stream, doc + index, 1);
+	}
+
+	obj = UJStreamFinish(stream);
+	assert(firstKey(UJArrayGet(obj, 0), 0) == firstKey(UJArrayGet(obj, 1), 0));
+	assert(UJObjectUnpack(UJArrayGet(obj, 1), 1, "N", wideKeys, &id) == 1 && UJNumericInt(id) == 2);
+	UJFree(stream);
+
+	// Keys past the size of the table are kept as decoded, and found through UJObjectGet's index too
+	big = (char *) malloc(20000 * 16);
+	ptr = big;
+	*(ptr++) = '{';
+
+	for (key = 0; key < 20000; key ++)
+	{
+		ptr += sprintf(ptr, "%s\"k%d\": %d", key ? ", " : "", key, key);
+	}
+
+	strcpy(ptr, "}");
+	obj = UJDecodeEx(big, strlen(big), NULL, UJF_INTERNKEYS | UJF_UTF8, &state);
+	assert(UJNumericInt(UJObjectGet(obj, "k19999", 6)) == 19999);
+	keys[0] = "k19999";
+	keys[1] = "k7";
+	assert(UJObjectUnpackUTF8(obj, 2, "NN", keys, &id, &name) == 2);
+	assert(UJNumericInt(id) == 19999 && UJNumericInt(name) == 7);
+	UJFree(state);
+	free(big);
+}
+
+#ifndef __BENCHMARK__
+int main ()
+{
+	test_unpackKeys();
+	test_decodeStrings();
+	test_decodeUTF8();
+	test_decodeZeroCopy();
+	test_decodeInSitu();
+	test_decodeDoubles();
+	test_decodeIntegers();
+	test_decodeLazyNumbers();
+	test_decoderReuse();
+	test_decodeOutOfMemory();
+	test_decodeIterative();
+	test_decodeStructural();
+	test_decodeStream();
+	test_decodeLines();
+	test_decodeLinesParallel();
+	test_decodeParallel();
+	test_decodeEvents();
+	test_cursor();
+	test_decodePaths();
+	test_query();
+	test_unpackSet();
+	test_objectGet();
+	test_arrayIndex();
+	test_tape();
+	test_inlineScalars();
+	test_internKeys();
+	return 0;
+}
 #endif
\ No newline at end of file